@@ -0,0 +1,78 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/Base64.h>
+#include <bmcl/Result.h>
+#include <bmcl/String.h>
+
+#include <vector>
+
+static std::vector<uint8_t> makeData(std::size_t size)
+{
+    std::vector<uint8_t> data(size);
+    for (std::size_t i = 0; i < size; i++) {
+        data[i] = uint8_t(i * 131 + 7);
+    }
+    return data;
+}
+
+template <std::size_t size>
+void hexEncode(benchmark::State& state)
+{
+    std::vector<uint8_t> data = makeData(size);
+    std::vector<char> dest(size * 2);
+    while (state.KeepRunning()) {
+        bmcl::bytesToHexLower(data.data(), data.size(), dest.data());
+        benchmark::DoNotOptimize(dest.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+template <std::size_t size>
+void hexDecode(benchmark::State& state)
+{
+    std::string encoded = bmcl::bytesToHexStringLower(makeData(size));
+    std::vector<uint8_t> dest(size);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::hexToBytes(encoded, dest.data()));
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+template <std::size_t size>
+void base64Encode(benchmark::State& state)
+{
+    std::vector<uint8_t> data = makeData(size);
+    std::vector<char> dest(bmcl::base64EncodedSize(size));
+    while (state.KeepRunning()) {
+        bmcl::base64Encode(data.data(), data.size(), dest.data());
+        benchmark::DoNotOptimize(dest.data());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+template <std::size_t size>
+void base64Decode(benchmark::State& state)
+{
+    std::string encoded = bmcl::base64Encode(makeData(size));
+    std::vector<uint8_t> dest(bmcl::base64MaxDecodedSize(encoded.size()));
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::base64Decode(encoded, dest.data()).isOk());
+    }
+    state.SetBytesProcessed(state.iterations() * size);
+}
+
+BENCHMARK_TEMPLATE(hexEncode, 16);
+BENCHMARK_TEMPLATE(hexEncode, 1024);
+BENCHMARK_TEMPLATE(hexEncode, 65536);
+
+BENCHMARK_TEMPLATE(hexDecode, 16);
+BENCHMARK_TEMPLATE(hexDecode, 1024);
+BENCHMARK_TEMPLATE(hexDecode, 65536);
+
+BENCHMARK_TEMPLATE(base64Encode, 16);
+BENCHMARK_TEMPLATE(base64Encode, 1024);
+BENCHMARK_TEMPLATE(base64Encode, 65536);
+
+BENCHMARK_TEMPLATE(base64Decode, 16);
+BENCHMARK_TEMPLATE(base64Decode, 1024);
+BENCHMARK_TEMPLATE(base64Decode, 65536);
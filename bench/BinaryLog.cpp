@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/BinaryLog.h>
+#include <bmcl/Logging.h>
+
+#include <cstdio>
+#include <string>
+
+static const char* benchLogPath = "binarylog_bench.blog";
+
+static void nullHandler(bmcl::LogLevel, const char*)
+{
+}
+
+static void logTextAsync(benchmark::State& state)
+{
+    bmcl::setLogHandler(nullHandler);
+    bmcl::enableAsyncLogging(1024 * 1024, bmcl::LogOverflowPolicy::Block);
+    std::string name = "device";
+    uint64_t i = 0;
+    while (state.KeepRunning()) {
+        BMCL_INFO() << "packet " << i << " from " << name << " size " << 1024 << " rssi " << -71.5;
+        i++;
+    }
+    bmcl::disableAsyncLogging();
+    bmcl::setDefaulLogHandler();
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void logBinary(benchmark::State& state)
+{
+    bmcl::startBinaryLog(benchLogPath, 1024 * 1024, bmcl::LogOverflowPolicy::Block);
+    std::string name = "device";
+    uint64_t i = 0;
+    while (state.KeepRunning()) {
+        BMCL_BINLOG(bmcl::LogLevel::Info, "packet {} from {} size {} rssi {}", i, name, 1024, -71.5);
+        i++;
+    }
+    bmcl::stopBinaryLog();
+    std::remove(benchLogPath);
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(logTextAsync)->UseRealTime();
+BENCHMARK(logBinary)->UseRealTime();
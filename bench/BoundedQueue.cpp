@@ -0,0 +1,144 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/BoundedQueue.h>
+#include <bmcl/SharedBytes.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// each iteration passes messageCount SharedBytes from state.range(0) producer threads to one consumer
+static const std::size_t messageCount = 1 << 16;
+static const std::size_t queueCapacity = 1024;
+
+// the std::mutex + std::deque handoff used before the lock free queues
+class MutexQueue {
+public:
+    void push(const bmcl::SharedBytes& value)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notFull.wait(lock, [this]() { return _queue.size() < queueCapacity; });
+            _queue.push_back(value);
+        }
+        _notEmpty.notify_one();
+    }
+
+    void pop(bmcl::SharedBytes* dest)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _notEmpty.wait(lock, [this]() { return !_queue.empty(); });
+            *dest = std::move(_queue.front());
+            _queue.pop_front();
+        }
+        _notFull.notify_one();
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _notFull;
+    std::condition_variable _notEmpty;
+    std::deque<bmcl::SharedBytes> _queue;
+};
+
+template <typename Q>
+static void pushSingle(Q* queue, const bmcl::SharedBytes& message, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        queue->push(message);
+    }
+}
+
+template <typename Q>
+static void pushBatched(Q* queue, const bmcl::SharedBytes& message, std::size_t count)
+{
+    bmcl::SharedBytes batch[32];
+    for (std::size_t i = 0; i < count; i += 32) {
+        for (bmcl::SharedBytes& item : batch) {
+            item = message;
+        }
+        queue->pushMany(batch, 32);
+    }
+}
+
+template <typename Q>
+static void popSingle(Q* queue)
+{
+    bmcl::SharedBytes dest;
+    for (std::size_t i = 0; i < messageCount; i++) {
+        queue->pop(&dest);
+    }
+}
+
+template <typename Q>
+static void popBatched(Q* queue)
+{
+    bmcl::SharedBytes dest[32];
+    for (std::size_t received = 0; received < messageCount;) {
+        received += queue->popMany(dest, 32);
+    }
+}
+
+template <typename Q, void (*pushAll)(Q*, const bmcl::SharedBytes&, std::size_t), void (*popAll)(Q*)>
+static void runProducers(benchmark::State& state, Q* queue)
+{
+    std::size_t producerCount = state.range(0);
+    bmcl::SharedBytes message = bmcl::SharedBytes::create(64);
+    while (state.KeepRunning()) {
+        std::vector<std::thread> producers;
+        for (std::size_t p = 0; p < producerCount; p++) {
+            producers.emplace_back([queue, &message, producerCount]() {
+                pushAll(queue, message, messageCount / producerCount);
+            });
+        }
+        popAll(queue);
+        for (std::thread& producer : producers) {
+            producer.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * messageCount);
+}
+
+static void mutexDeque(benchmark::State& state)
+{
+    using Q = MutexQueue;
+    Q queue;
+    runProducers<Q, pushSingle<Q>, popSingle<Q>>(state, &queue);
+}
+
+static void mpmc(benchmark::State& state)
+{
+    using Q = bmcl::MpmcQueue<bmcl::SharedBytes>;
+    Q queue(queueCapacity);
+    runProducers<Q, pushSingle<Q>, popSingle<Q>>(state, &queue);
+}
+
+static void mpmcBatched(benchmark::State& state)
+{
+    using Q = bmcl::MpmcQueue<bmcl::SharedBytes>;
+    Q queue(queueCapacity);
+    runProducers<Q, pushBatched<Q>, popBatched<Q>>(state, &queue);
+}
+
+static void spsc(benchmark::State& state)
+{
+    using Q = bmcl::SpscQueue<bmcl::SharedBytes>;
+    Q queue(queueCapacity);
+    runProducers<Q, pushSingle<Q>, popSingle<Q>>(state, &queue);
+}
+
+static void spscBatched(benchmark::State& state)
+{
+    using Q = bmcl::SpscQueue<bmcl::SharedBytes>;
+    Q queue(queueCapacity);
+    runProducers<Q, pushBatched<Q>, popBatched<Q>>(state, &queue);
+}
+
+BENCHMARK(mutexDeque)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(mpmc)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(mpmcBatched)->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+BENCHMARK(spsc)->Arg(1)->UseRealTime();
+BENCHMARK(spscBatched)->Arg(1)->UseRealTime();
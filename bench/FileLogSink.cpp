@@ -0,0 +1,58 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/FileLogSink.h>
+#include <bmcl/Result.h>
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+static const char* benchLogPath = "filelogsink_bench.log";
+static const char* benchMessage = "packet 123456 from device-01 size 1024 rssi -71.5 crc ok seq 99182 port 14550";
+
+// line size written by the sink, time (19) + ' ' + prefix (9) + ' ' + message + '\n'
+static std::size_t lineSize()
+{
+    return 19 + 1 + 9 + 1 + std::strlen(benchMessage) + 1;
+}
+
+// a write call per message, like a naive handler
+static void logFileUnbuffered(benchmark::State& state)
+{
+    int fd = open(benchLogPath, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    std::string line = std::string(19, '0') + " INFO:     " + benchMessage + '\n';
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(write(fd, line.data(), line.size()));
+    }
+    close(fd);
+    std::remove(benchLogPath);
+    state.SetBytesProcessed(state.iterations() * lineSize());
+}
+
+template <std::size_t bufferSize, int syncMsecs>
+void logFileSink(benchmark::State& state)
+{
+    std::remove(benchLogPath);
+    bmcl::FileLogSinkConfig config(benchLogPath);
+    config.bufferSize = bufferSize;
+    config.syncInterval = std::chrono::milliseconds(syncMsecs);
+    config.maxFileSize = 256 * 1024 * 1024;
+    config.maxRotatedFiles = 0;
+    auto sink = bmcl::FileLogSink::open(config);
+    std::size_t size = std::strlen(benchMessage);
+    while (state.KeepRunning()) {
+        sink.unwrap()->write(bmcl::LogLevel::Info, std::time(nullptr), benchMessage, size);
+    }
+    sink.unwrap()->flush();
+    std::remove(benchLogPath);
+    state.SetBytesProcessed(state.iterations() * lineSize());
+}
+
+BENCHMARK(logFileUnbuffered);
+BENCHMARK_TEMPLATE2(logFileSink, 64 * 1024, 0);
+BENCHMARK_TEMPLATE2(logFileSink, 1024 * 1024, 0);
+BENCHMARK_TEMPLATE2(logFileSink, 1024 * 1024, 100);
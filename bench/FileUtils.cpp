@@ -0,0 +1,139 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/FileUtils.h>
+#include <bmcl/Result.h>
+#include <bmcl/SharedBytes.h>
+#include <bmcl/ArrayView.h>
+#include <bmcl/Buffer.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::vector<std::string> createFiles(std::size_t count, std::size_t size)
+{
+    std::vector<std::string> paths;
+    std::vector<char> data(size, 'x');
+    for (std::size_t i = 0; i < count; i++) {
+        paths.push_back("fileutils_bench_" + std::to_string(i) + ".bin");
+        std::FILE* file = std::fopen(paths.back().c_str(), "wb");
+        std::fwrite(data.data(), 1, data.size(), file);
+        std::fclose(file);
+    }
+    return paths;
+}
+
+static void removeFiles(const std::vector<std::string>& paths)
+{
+    for (const std::string& path : paths) {
+        std::remove(path.c_str());
+    }
+}
+
+// previous stdio based implementation
+static bmcl::Buffer readFileStdio(const char* path)
+{
+    std::FILE* file = std::fopen(path, "rb");
+    std::fseek(file, 0, SEEK_END);
+    long size = std::ftell(file);
+    std::fseek(file, 0, SEEK_SET);
+    bmcl::Buffer buf = bmcl::Buffer::createWithUnitializedData(size);
+    std::size_t rv = std::fread(buf.data(), 1, size, file);
+    (void)rv;
+    std::fclose(file);
+    return buf;
+}
+
+template <std::size_t count, std::size_t size>
+void readBufferStdio(benchmark::State& state)
+{
+    std::vector<std::string> paths = createFiles(count, size);
+    while (state.KeepRunning()) {
+        for (const std::string& path : paths) {
+            benchmark::DoNotOptimize(readFileStdio(path.c_str()));
+        }
+    }
+    removeFiles(paths);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * size);
+}
+
+template <std::size_t count, std::size_t size>
+void readBuffer(benchmark::State& state)
+{
+    std::vector<std::string> paths = createFiles(count, size);
+    while (state.KeepRunning()) {
+        for (const std::string& path : paths) {
+            benchmark::DoNotOptimize(bmcl::readFileIntoBuffer(path.c_str()));
+        }
+    }
+    removeFiles(paths);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * size);
+}
+
+template <std::size_t count, std::size_t size>
+void readBufferReuse(benchmark::State& state)
+{
+    std::vector<std::string> paths = createFiles(count, size);
+    bmcl::Buffer buf;
+    while (state.KeepRunning()) {
+        for (const std::string& path : paths) {
+            benchmark::DoNotOptimize(bmcl::readFileIntoBuffer(path.c_str(), &buf));
+        }
+    }
+    removeFiles(paths);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * size);
+}
+
+template <std::size_t count, std::size_t size>
+void readFilesLoop(benchmark::State& state)
+{
+    std::vector<std::string> paths = createFiles(count, size);
+    while (state.KeepRunning()) {
+        for (const std::string& path : paths) {
+            benchmark::DoNotOptimize(bmcl::readFileIntoBytes(path.c_str()));
+        }
+    }
+    removeFiles(paths);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * size);
+}
+
+template <std::size_t count, std::size_t size>
+void readFilesBatched(benchmark::State& state)
+{
+    std::vector<std::string> paths = createFiles(count, size);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::readFilesIntoBytes(paths));
+    }
+    removeFiles(paths);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * size);
+}
+
+template <std::size_t count, std::size_t size>
+void readFilesThreaded(benchmark::State& state)
+{
+    std::vector<std::string> paths = createFiles(count, size);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::readFilesIntoBytesThreaded(paths));
+    }
+    removeFiles(paths);
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * count * size);
+}
+
+BENCHMARK_TEMPLATE2(readBufferStdio, 1000, 512)->UseRealTime();
+BENCHMARK_TEMPLATE2(readBuffer, 1000, 512)->UseRealTime();
+BENCHMARK_TEMPLATE2(readBufferReuse, 1000, 512)->UseRealTime();
+BENCHMARK_TEMPLATE2(readBufferStdio, 16, 4 * 1024 * 1024)->UseRealTime();
+BENCHMARK_TEMPLATE2(readBuffer, 16, 4 * 1024 * 1024)->UseRealTime();
+BENCHMARK_TEMPLATE2(readBufferReuse, 16, 4 * 1024 * 1024)->UseRealTime();
+BENCHMARK_TEMPLATE2(readFilesLoop, 1000, 512)->UseRealTime();
+BENCHMARK_TEMPLATE2(readFilesBatched, 1000, 512)->UseRealTime();
+BENCHMARK_TEMPLATE2(readFilesThreaded, 1000, 512)->UseRealTime();
+BENCHMARK_TEMPLATE2(readFilesLoop, 16, 4 * 1024 * 1024)->UseRealTime();
+BENCHMARK_TEMPLATE2(readFilesBatched, 16, 4 * 1024 * 1024)->UseRealTime();
+BENCHMARK_TEMPLATE2(readFilesThreaded, 16, 4 * 1024 * 1024)->UseRealTime();
@@ -0,0 +1,99 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/Logging.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static std::atomic<uint64_t> handledCount(0);
+
+static void countingHandler(bmcl::LogLevel, const char*)
+{
+    handledCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+static const std::size_t msgsPerThread = 10000;
+
+static void logFromThreads(std::size_t threadNum)
+{
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadNum; t++) {
+        threads.emplace_back([]() {
+            for (std::size_t i = 0; i < msgsPerThread; i++) {
+                bmcl::log(bmcl::LogLevel::Info, "benchmark message with some payload");
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+template <std::size_t threadNum>
+void logSync(benchmark::State& state)
+{
+    bmcl::setLogHandler(countingHandler);
+    while (state.KeepRunning()) {
+        logFromThreads(threadNum);
+    }
+    bmcl::setDefaulLogHandler();
+    state.SetItemsProcessed(state.iterations() * threadNum * msgsPerThread);
+}
+
+template <std::size_t threadNum, bmcl::LogOverflowPolicy policy>
+void logAsync(benchmark::State& state)
+{
+    bmcl::setLogHandler(countingHandler);
+    bmcl::enableAsyncLogging(1024 * 1024, policy);
+    while (state.KeepRunning()) {
+        logFromThreads(threadNum);
+        bmcl::flushLog();
+    }
+    bmcl::disableAsyncLogging();
+    bmcl::setDefaulLogHandler();
+    state.SetItemsProcessed(state.iterations() * threadNum * msgsPerThread);
+}
+
+BENCHMARK_TEMPLATE(logSync, 1)->UseRealTime();
+BENCHMARK_TEMPLATE(logSync, 2)->UseRealTime();
+BENCHMARK_TEMPLATE(logSync, 4)->UseRealTime();
+BENCHMARK_TEMPLATE(logSync, 8)->UseRealTime();
+
+BENCHMARK_TEMPLATE2(logAsync, 1, bmcl::LogOverflowPolicy::Block)->UseRealTime();
+BENCHMARK_TEMPLATE2(logAsync, 2, bmcl::LogOverflowPolicy::Block)->UseRealTime();
+BENCHMARK_TEMPLATE2(logAsync, 4, bmcl::LogOverflowPolicy::Block)->UseRealTime();
+BENCHMARK_TEMPLATE2(logAsync, 8, bmcl::LogOverflowPolicy::Block)->UseRealTime();
+
+BENCHMARK_TEMPLATE2(logAsync, 1, bmcl::LogOverflowPolicy::Drop)->UseRealTime();
+BENCHMARK_TEMPLATE2(logAsync, 4, bmcl::LogOverflowPolicy::Drop)->UseRealTime();
+BENCHMARK_TEMPLATE2(logAsync, 8, bmcl::LogOverflowPolicy::Drop)->UseRealTime();
+
+static void logFormatted(benchmark::State& state)
+{
+    bmcl::setLogHandler(countingHandler);
+    uint64_t i = 0;
+    while (state.KeepRunning()) {
+        BMCL_INFO() << "packet " << i << " from " << "device" << " size " << 1024;
+        i++;
+    }
+    bmcl::setDefaulLogHandler();
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void logDisabled(benchmark::State& state)
+{
+    bmcl::setLogHandler(countingHandler);
+    bmcl::setLogLevel(bmcl::LogLevel::Info);
+    uint64_t i = 0;
+    while (state.KeepRunning()) {
+        BMCL_DEBUG() << "packet " << i << " from " << "device" << " size " << 1024;
+        i++;
+    }
+    bmcl::setLogLevel(bmcl::LogLevel::Debug);
+    bmcl::setDefaulLogHandler();
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(logFormatted);
+BENCHMARK(logDisabled);
@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/MmapWriter.h>
+
+#include <cstdio>
+#include <vector>
+
+static const char* benchPath = "mmapwriter_bench.bin";
+static const std::size_t fileSize = 64 * 1024 * 1024;
+
+template <std::size_t chunkSize>
+void recordFwrite(benchmark::State& state)
+{
+    std::vector<uint8_t> chunk(chunkSize, 0xaa);
+    while (state.KeepRunning()) {
+        std::FILE* file = std::fopen(benchPath, "wb");
+        for (std::size_t i = 0; i < fileSize / chunkSize; i++) {
+            std::fwrite(chunk.data(), chunk.size(), 1, file);
+        }
+        std::fclose(file);
+    }
+    std::remove(benchPath);
+    state.SetBytesProcessed(state.iterations() * fileSize);
+}
+
+template <std::size_t chunkSize>
+void recordMmapWriter(benchmark::State& state)
+{
+    std::vector<uint8_t> chunk(chunkSize, 0xaa);
+    while (state.KeepRunning()) {
+        bmcl::MmapWriter writer;
+        writer.open(benchPath, 16 * 1024 * 1024);
+        for (std::size_t i = 0; i < fileSize / chunkSize; i++) {
+            writer.write(chunk.data(), chunk.size());
+        }
+        writer.close();
+    }
+    std::remove(benchPath);
+    state.SetBytesProcessed(state.iterations() * fileSize);
+}
+
+BENCHMARK_TEMPLATE(recordFwrite, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(recordFwrite, 4096)->UseRealTime();
+BENCHMARK_TEMPLATE(recordMmapWriter, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(recordMmapWriter, 4096)->UseRealTime();
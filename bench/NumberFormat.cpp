@@ -0,0 +1,170 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/Buffer.h>
+#include <bmcl/NumberFormat.h>
+#include <bmcl/Result.h>
+#include <bmcl/StringView.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+static std::vector<double> makeDoubles()
+{
+    std::vector<double> values(1000);
+    uint64_t state = 88172645463325252ull;
+    for (double& value : values) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        value = double(state % 100000000) / 1000.0;
+    }
+    return values;
+}
+
+static std::vector<int64_t> makeInts()
+{
+    std::vector<int64_t> values(1000);
+    int64_t value = 1;
+    for (int64_t& v : values) {
+        value = value * 6364136223846793005ll + 1442695040888963407ll;
+        v = value >> (value & 63);
+    }
+    return values;
+}
+
+static void formatIntBmcl(benchmark::State& state)
+{
+    std::vector<int64_t> values = makeInts();
+    bmcl::Buffer buf;
+    while (state.KeepRunning()) {
+        buf.resize(0);
+        for (int64_t value : values) {
+            bmcl::formatInt(value, &buf);
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void formatIntSnprintf(benchmark::State& state)
+{
+    std::vector<int64_t> values = makeInts();
+    bmcl::Buffer buf;
+    while (state.KeepRunning()) {
+        buf.resize(0);
+        for (int64_t value : values) {
+            char tmp[32];
+            int size = std::snprintf(tmp, sizeof(tmp), "%lld", (long long)value);
+            buf.write(tmp, size);
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void formatIntStream(benchmark::State& state)
+{
+    std::vector<int64_t> values = makeInts();
+    while (state.KeepRunning()) {
+        std::ostringstream stream;
+        for (int64_t value : values) {
+            stream << value;
+        }
+        benchmark::DoNotOptimize(stream.str());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void formatDoubleBmcl(benchmark::State& state)
+{
+    std::vector<double> values = makeDoubles();
+    bmcl::Buffer buf;
+    while (state.KeepRunning()) {
+        buf.resize(0);
+        for (double value : values) {
+            bmcl::formatDouble(value, &buf);
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void formatDoubleSnprintf(benchmark::State& state)
+{
+    std::vector<double> values = makeDoubles();
+    bmcl::Buffer buf;
+    while (state.KeepRunning()) {
+        buf.resize(0);
+        for (double value : values) {
+            char tmp[32];
+            int size = std::snprintf(tmp, sizeof(tmp), "%.17g", value);
+            buf.write(tmp, size);
+        }
+        benchmark::DoNotOptimize(buf.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static void formatDoubleStream(benchmark::State& state)
+{
+    std::vector<double> values = makeDoubles();
+    while (state.KeepRunning()) {
+        std::ostringstream stream;
+        stream.precision(17);
+        for (double value : values) {
+            stream << value;
+        }
+        benchmark::DoNotOptimize(stream.str());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+
+static std::vector<std::string> makeDoubleStrings()
+{
+    std::vector<std::string> strs;
+    for (double value : makeDoubles()) {
+        std::string str;
+        bmcl::formatDouble(value, &str);
+        strs.push_back(str);
+    }
+    return strs;
+}
+
+static void parseDoubleBmcl(benchmark::State& state)
+{
+    std::vector<std::string> strs = makeDoubleStrings();
+    while (state.KeepRunning()) {
+        double sum = 0;
+        for (const std::string& str : strs) {
+            sum += bmcl::parseDouble(str).unwrapOr(0.0);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * strs.size());
+}
+
+static void parseDoubleStrtod(benchmark::State& state)
+{
+    std::vector<std::string> strs = makeDoubleStrings();
+    while (state.KeepRunning()) {
+        double sum = 0;
+        for (const std::string& str : strs) {
+            sum += std::strtod(str.c_str(), nullptr);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * strs.size());
+}
+
+BENCHMARK(formatIntBmcl);
+BENCHMARK(formatIntSnprintf);
+BENCHMARK(formatIntStream);
+
+BENCHMARK(formatDoubleBmcl);
+BENCHMARK(formatDoubleSnprintf);
+BENCHMARK(formatDoubleStream);
+
+BENCHMARK(parseDoubleBmcl);
+BENCHMARK(parseDoubleStrtod);
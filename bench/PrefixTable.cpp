@@ -0,0 +1,180 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/PrefixTable.h>
+
+#include <random>
+#include <string>
+#include <vector>
+
+struct Ipv4Route {
+    uint32_t address;
+    unsigned size;
+};
+
+static uint32_t maskV4(uint32_t address, unsigned size)
+{
+    return size == 0 ? 0 : address & (0xffffffffu << (32 - size));
+}
+
+// roughly the shape of a bgp table, mostly /24 with a tail of shorter and longer prefixes
+static std::vector<Ipv4Route> makeV4Routes(std::size_t count)
+{
+    std::mt19937 gen(1);
+    std::vector<Ipv4Route> routes;
+    routes.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        unsigned r = gen() % 100;
+        unsigned size = r < 60 ? 24 : (r < 90 ? 16 + gen() % 8 : 25 + gen() % 8);
+        routes.push_back(Ipv4Route{maskV4(uint32_t(gen()), size), size});
+    }
+    return routes;
+}
+
+// addresses inside random routes so that most lookups walk the trie to a match
+static std::vector<bmcl::Ipv4Address> makeV4Queries(const std::vector<Ipv4Route>& routes, std::size_t count)
+{
+    std::mt19937 gen(2);
+    std::vector<bmcl::Ipv4Address> queries;
+    queries.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        const Ipv4Route& route = routes[gen() % routes.size()];
+        uint32_t host = route.size == 32 ? 0 : uint32_t(gen()) & (0xffffffffu >> route.size);
+        queries.push_back(bmcl::Ipv4Address(route.address | host));
+    }
+    return queries;
+}
+
+static void buildV4(const std::vector<Ipv4Route>& routes, bmcl::Ipv4PrefixTable* table)
+{
+    for (std::size_t i = 0; i < routes.size(); i++) {
+        table->insert(bmcl::Ipv4Address(routes[i].address), routes[i].size, uint32_t(i));
+    }
+}
+
+// what a vector of address/mask pairs gives
+template <std::size_t count>
+void lookupV4Linear(benchmark::State& state)
+{
+    std::vector<Ipv4Route> routes = makeV4Routes(count);
+    std::vector<bmcl::Ipv4Address> queries = makeV4Queries(routes, 1024);
+    while (state.KeepRunning()) {
+        for (bmcl::Ipv4Address address : queries) {
+            uint32_t value = address.toUint32();
+            unsigned bestSize = 0;
+            std::size_t best = routes.size();
+            for (std::size_t i = 0; i < routes.size(); i++) {
+                if (maskV4(value, routes[i].size) == routes[i].address && routes[i].size >= bestSize) {
+                    best = i;
+                    bestSize = routes[i].size;
+                }
+            }
+            benchmark::DoNotOptimize(best);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+template <std::size_t count>
+void lookupV4(benchmark::State& state)
+{
+    std::vector<Ipv4Route> routes = makeV4Routes(count);
+    bmcl::Ipv4PrefixTable table;
+    buildV4(routes, &table);
+    std::vector<bmcl::Ipv4Address> queries = makeV4Queries(routes, 1 << 16);
+    while (state.KeepRunning()) {
+        std::size_t found = 0;
+        for (bmcl::Ipv4Address address : queries) {
+            found += table.lookup(address).isSome();
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+    state.SetLabel(std::to_string(table.memoryUsage() >> 20) + " MiB");
+}
+
+template <std::size_t count>
+void lookupV4Bulk(benchmark::State& state)
+{
+    std::vector<Ipv4Route> routes = makeV4Routes(count);
+    bmcl::Ipv4PrefixTable table;
+    buildV4(routes, &table);
+    std::vector<bmcl::Ipv4Address> queries = makeV4Queries(routes, 1 << 16);
+    std::vector<uint32_t> values(queries.size());
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(table.lookup(queries.data(), queries.size(), values.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+template <std::size_t count>
+void insertV4(benchmark::State& state)
+{
+    std::vector<Ipv4Route> routes = makeV4Routes(count);
+    while (state.KeepRunning()) {
+        bmcl::Ipv4PrefixTable table;
+        buildV4(routes, &table);
+        benchmark::DoNotOptimize(table.size());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+// allocations of /32 under 2000::/3 with most routes being /48 inside them and some /56 - /64
+static std::vector<std::pair<bmcl::Ipv6Address, unsigned>> makeV6Routes(std::size_t count)
+{
+    std::mt19937 gen(3);
+    std::vector<bmcl::Ipv6Address::Data> allocations(count / 8 + 1);
+    for (bmcl::Ipv6Address::Data& data : allocations) {
+        data.fill(0);
+        data[0] = uint8_t(0x20 | (gen() % 2));
+        data[1] = uint8_t(gen());
+        data[2] = uint8_t(gen());
+        data[3] = uint8_t(gen());
+    }
+    std::vector<std::pair<bmcl::Ipv6Address, unsigned>> routes;
+    routes.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        bmcl::Ipv6Address::Data data = allocations[gen() % allocations.size()];
+        unsigned r = gen() % 100;
+        unsigned size = r < 15 ? 32 : (r < 85 ? 48 : 56 + gen() % 2 * 8);
+        for (unsigned j = 4; j < size / 8; j++) {
+            data[j] = uint8_t(gen());
+        }
+        routes.emplace_back(bmcl::Ipv6Address(data), size);
+    }
+    return routes;
+}
+
+template <std::size_t count>
+void lookupV6Bulk(benchmark::State& state)
+{
+    auto routes = makeV6Routes(count);
+    bmcl::Ipv6PrefixTable table;
+    for (std::size_t i = 0; i < routes.size(); i++) {
+        table.insert(routes[i].first, routes[i].second, uint32_t(i));
+    }
+    std::mt19937 gen(4);
+    std::vector<bmcl::Ipv6Address> queries;
+    for (std::size_t i = 0; i < (1 << 16); i++) {
+        bmcl::Ipv6Address::Data data = routes[gen() % routes.size()].first.data();
+        for (unsigned j = 8; j < 16; j++) {
+            data[j] = uint8_t(gen());
+        }
+        queries.emplace_back(data);
+    }
+    std::vector<uint32_t> values(queries.size());
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(table.lookup(queries.data(), queries.size(), values.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+    state.SetLabel(std::to_string(table.memoryUsage() >> 20) + " MiB");
+}
+
+BENCHMARK_TEMPLATE(lookupV4Linear, 10000);
+BENCHMARK_TEMPLATE(lookupV4, 10000);
+BENCHMARK_TEMPLATE(lookupV4Bulk, 10000);
+BENCHMARK_TEMPLATE(lookupV4, 1000000);
+BENCHMARK_TEMPLATE(lookupV4Bulk, 1000000);
+BENCHMARK_TEMPLATE(insertV4, 10000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(insertV4, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(lookupV6Bulk, 10000);
+BENCHMARK_TEMPLATE(lookupV6Bulk, 100000);
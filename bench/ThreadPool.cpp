@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/Sha3.h>
+#include <bmcl/ThreadPool.h>
+
+#include <atomic>
+#include <vector>
+
+// hashes 1mb in 4k blocks, the way a sha3 tree hash would split its leaves
+static const std::size_t blockSize = 4096;
+static const std::size_t blockCount = 256;
+
+static std::vector<uint8_t> makeData()
+{
+    std::vector<uint8_t> data(blockSize * blockCount);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = uint8_t(i);
+    }
+    return data;
+}
+
+static void hashBlocksSerial(benchmark::State& state)
+{
+    std::vector<uint8_t> data = makeData();
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < blockCount; i++) {
+            auto hash = bmcl::Sha3<256>::calcInOneStep(data.data() + i * blockSize, blockSize);
+            benchmark::DoNotOptimize(hash);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+static void hashBlocksParallel(benchmark::State& state)
+{
+    std::vector<uint8_t> data = makeData();
+    bmcl::ThreadPool pool(state.range(0));
+    while (state.KeepRunning()) {
+        pool.parallelFor(0, blockCount, 4, [&data](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                auto hash = bmcl::Sha3<256>::calcInOneStep(data.data() + i * blockSize, blockSize);
+                benchmark::DoNotOptimize(hash);
+            }
+        });
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+// overhead of small tasks
+static void submitWait(benchmark::State& state)
+{
+    bmcl::ThreadPool pool(state.range(0));
+    while (state.KeepRunning()) {
+        bmcl::TaskHandle<int, void> handle = pool.submit([]() -> bmcl::Result<int, void> {
+            return 1;
+        });
+        benchmark::DoNotOptimize(handle.wait());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void postFromWorker(benchmark::State& state)
+{
+    bmcl::ThreadPool pool(state.range(0));
+    std::atomic<std::size_t> count(0);
+    while (state.KeepRunning()) {
+        count.store(0);
+        pool.parallelFor(0, 64, 1, [&pool, &count](std::size_t, std::size_t) {
+            for (std::size_t i = 0; i < 256; i++) {
+                pool.post([&count]() {
+                    count.fetch_add(1, std::memory_order_relaxed);
+                });
+            }
+        });
+        while (count.load() != 64 * 256) {
+            pool.runOne();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 64 * 256);
+}
+
+BENCHMARK(hashBlocksSerial);
+BENCHMARK(hashBlocksParallel)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+BENCHMARK(submitWait)->Arg(1)->Arg(4)->UseRealTime();
+BENCHMARK(postFromWorker)->Arg(1)->Arg(4)->Arg(8)->UseRealTime();
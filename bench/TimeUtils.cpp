@@ -0,0 +1,41 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/TimeUtils.h>
+
+#include <chrono>
+#include <ctime>
+
+static void formatTimeStrftime(benchmark::State& state)
+{
+    char str[32];
+    while (state.KeepRunning()) {
+        std::time_t t = std::time(nullptr);
+        std::strftime(str, sizeof(str), "%F %T", std::localtime(&t));
+        benchmark::DoNotOptimize(str);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void formatTimeCached(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::formatLocalTime(std::time(nullptr)));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <typename C>
+void clockNow(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(C::now());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(formatTimeStrftime);
+BENCHMARK(formatTimeCached);
+
+BENCHMARK_TEMPLATE(clockNow, std::chrono::steady_clock);
+BENCHMARK_TEMPLATE(clockNow, std::chrono::system_clock);
+BENCHMARK_TEMPLATE(clockNow, bmcl::CoarseMonotonicClock);
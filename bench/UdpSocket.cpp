@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/Result.h>
+#include <bmcl/UdpSocket.h>
+
+#include <vector>
+
+// both ends on loopback in one thread, each iteration sends a batch and receives it back
+struct Endpoints {
+    Endpoints()
+        : sender(bmcl::UdpSocket::bind(bmcl::SocketAddressV4(127, 0, 0, 1, 0)).take())
+        , receiver(bmcl::UdpSocket::bind(bmcl::SocketAddressV4(127, 0, 0, 1, 0)).take())
+        , dest(receiver.localAddress().unwrap())
+    {
+        receiver.setReceiveBufferSize(4 << 20);
+    }
+
+    bmcl::UdpSocket sender;
+    bmcl::UdpSocket receiver;
+    bmcl::SocketAddressV4 dest;
+};
+
+template <std::size_t size>
+void perDatagram(benchmark::State& state)
+{
+    const std::size_t count = 64;
+    Endpoints e;
+    std::vector<uint8_t> data(size, 1);
+    std::vector<uint8_t> buf(2048);
+    while (state.KeepRunning()) {
+        for (std::size_t i = 0; i < count; i++) {
+            e.sender.sendTo(bmcl::Bytes(data.data(), data.size()), e.dest);
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            e.receiver.receiveFrom(buf.data(), buf.size(), nullptr);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <std::size_t size>
+void batched(benchmark::State& state)
+{
+    const std::size_t count = 64;
+    Endpoints e;
+    std::vector<uint8_t> data(size, 1);
+    bmcl::UdpBatch out(count);
+    for (std::size_t i = 0; i < count; i++) {
+        out.append(bmcl::Bytes(data.data(), data.size()), e.dest);
+    }
+    bmcl::UdpBatch in(count);
+    while (state.KeepRunning()) {
+        e.sender.send(out);
+        std::size_t received = 0;
+        while (received < count) {
+            received += e.receiver.receive(&in).unwrapOr(0);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <std::size_t size>
+void segmented(benchmark::State& state)
+{
+    const std::size_t count = 64;
+    Endpoints e;
+    e.receiver.setGroEnabled(true);
+    std::vector<uint8_t> data(size * count, 1);
+    bmcl::UdpBatch in(count, 65536);
+    while (state.KeepRunning()) {
+        e.sender.sendSegmented(bmcl::Bytes(data.data(), data.size()), size, e.dest);
+        std::size_t received = 0;
+        while (received < data.size()) {
+            e.receiver.receive(&in);
+            for (std::size_t i = 0; i < in.size(); i++) {
+                received += in.datagram(i).size();
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+
+BENCHMARK_TEMPLATE(perDatagram, 64);
+BENCHMARK_TEMPLATE(batched, 64);
+BENCHMARK_TEMPLATE(perDatagram, 1000);
+BENCHMARK_TEMPLATE(batched, 1000);
+BENCHMARK_TEMPLATE(segmented, 1000);
@@ -0,0 +1,127 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/Uuid.h>
+#include <bmcl/UuidGenerator.h>
+
+#include <bmcl/Result.h>
+#include <bmcl/StringView.h>
+
+#include <string>
+#include <vector>
+
+static void createSystem(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::Uuid::create());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void createV4(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::Uuid::createV4());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void createV7(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::Uuid::createV7());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template <std::size_t count>
+void createV4Batch(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids(count, bmcl::Uuid::createNil());
+    bmcl::UuidGenerator& gen = bmcl::threadUuidGenerator();
+    while (state.KeepRunning()) {
+        gen.createV4(uuids.data(), uuids.size());
+        benchmark::DoNotOptimize(uuids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <std::size_t count>
+void createV7Batch(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids(count, bmcl::Uuid::createNil());
+    bmcl::UuidGenerator& gen = bmcl::threadUuidGenerator();
+    while (state.KeepRunning()) {
+        gen.createV7(uuids.data(), uuids.size());
+        benchmark::DoNotOptimize(uuids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static std::vector<bmcl::Uuid> makeUuids(std::size_t count)
+{
+    std::vector<bmcl::Uuid> uuids(count, bmcl::Uuid::createNil());
+    bmcl::threadUuidGenerator().createV4(uuids.data(), uuids.size());
+    return uuids;
+}
+
+static void format(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(1024);
+    while (state.KeepRunning()) {
+        for (const bmcl::Uuid& u : uuids) {
+            benchmark::DoNotOptimize(u.toStringRepr());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * uuids.size());
+}
+
+static void formatMany(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(1024);
+    std::string text(uuids.size() * bmcl::UuidStringRepr::size(), ' ');
+    while (state.KeepRunning()) {
+        bmcl::Uuid::formatMany(uuids.data(), uuids.size(), &text[0]);
+        benchmark::DoNotOptimize(text.data());
+    }
+    state.SetItemsProcessed(state.iterations() * uuids.size());
+}
+
+static void parse(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(1024);
+    std::vector<std::string> strings;
+    for (const bmcl::Uuid& u : uuids) {
+        strings.push_back(u.toStdString());
+    }
+    while (state.KeepRunning()) {
+        for (const std::string& str : strings) {
+            benchmark::DoNotOptimize(bmcl::Uuid::createFromString(str));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * uuids.size());
+}
+
+static void parseMany(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(1024);
+    std::string text(uuids.size() * bmcl::UuidStringRepr::size(), ' ');
+    bmcl::Uuid::formatMany(uuids.data(), uuids.size(), &text[0]);
+    std::vector<bmcl::StringView> views;
+    for (std::size_t i = 0; i < uuids.size(); i++) {
+        views.emplace_back(text.data() + i * bmcl::UuidStringRepr::size(), bmcl::UuidStringRepr::size());
+    }
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(bmcl::Uuid::parseMany(views.data(), views.size(), uuids.data()));
+    }
+    state.SetItemsProcessed(state.iterations() * uuids.size());
+}
+
+BENCHMARK(createSystem);
+BENCHMARK(createV4);
+BENCHMARK(createV7);
+BENCHMARK_TEMPLATE(createV4Batch, 64);
+BENCHMARK_TEMPLATE(createV7Batch, 64);
+BENCHMARK(format);
+BENCHMARK(formatMany);
+BENCHMARK(parse);
+BENCHMARK(parseMany);
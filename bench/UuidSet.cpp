@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+
+#include <bmcl/UuidSet.h>
+#include <bmcl/UuidHash.h>
+#include <bmcl/UuidGenerator.h>
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+static std::vector<bmcl::Uuid> makeUuids(std::size_t count)
+{
+    std::vector<bmcl::Uuid> uuids(count, bmcl::Uuid::createNil());
+    bmcl::threadUuidGenerator().createV4(uuids.data(), uuids.size());
+    return uuids;
+}
+
+template <std::size_t count>
+void insertStdSet(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(count);
+    while (state.KeepRunning()) {
+        std::unordered_set<bmcl::Uuid> set;
+        for (const bmcl::Uuid& u : uuids) {
+            set.insert(u);
+        }
+        benchmark::DoNotOptimize(set.size());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+template <std::size_t count>
+void insertUuidSet(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(count);
+    std::size_t memory = 0;
+    while (state.KeepRunning()) {
+        bmcl::UuidSet set;
+        set.insert(uuids.data(), uuids.size());
+        memory = set.memoryUsage();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+    state.SetLabel(std::to_string(memory / count) + " bytes per uuid");
+}
+
+template <std::size_t count>
+void containsStdSet(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(count);
+    std::unordered_set<bmcl::Uuid> set(uuids.begin(), uuids.end());
+    std::vector<bmcl::Uuid> queries = makeUuids(count / 2);
+    queries.insert(queries.end(), uuids.begin(), uuids.begin() + count / 2);
+    while (state.KeepRunning()) {
+        std::size_t found = 0;
+        for (const bmcl::Uuid& u : queries) {
+            found += set.count(u);
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+template <std::size_t count>
+void containsUuidSet(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(count);
+    bmcl::UuidSet set;
+    set.insert(uuids.data(), uuids.size());
+    std::vector<bmcl::Uuid> queries = makeUuids(count / 2);
+    queries.insert(queries.end(), uuids.begin(), uuids.begin() + count / 2);
+    while (state.KeepRunning()) {
+        std::size_t found = 0;
+        for (const bmcl::Uuid& u : queries) {
+            found += set.contains(u);
+        }
+        benchmark::DoNotOptimize(found);
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+template <std::size_t count>
+void containsUuidSetBulk(benchmark::State& state)
+{
+    std::vector<bmcl::Uuid> uuids = makeUuids(count);
+    bmcl::UuidSet set;
+    set.insert(uuids.data(), uuids.size());
+    std::vector<bmcl::Uuid> queries = makeUuids(count / 2);
+    queries.insert(queries.end(), uuids.begin(), uuids.begin() + count / 2);
+    std::unique_ptr<bool[]> found(new bool[queries.size()]);
+    while (state.KeepRunning()) {
+        benchmark::DoNotOptimize(set.contains(queries.data(), queries.size(), found.get()));
+    }
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+
+BENCHMARK_TEMPLATE(insertStdSet, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(insertUuidSet, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(containsStdSet, 1000);
+BENCHMARK_TEMPLATE(containsUuidSet, 1000);
+BENCHMARK_TEMPLATE(containsUuidSetBulk, 1000);
+BENCHMARK_TEMPLATE(containsStdSet, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(containsUuidSet, 1000000)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(containsUuidSetBulk, 1000000)->Unit(benchmark::kMillisecond);
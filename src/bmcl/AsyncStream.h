@@ -0,0 +1,536 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Assert.h"
+#include "bmcl/Reader.h"
+#include "bmcl/RingBuffer.h"
+#include "bmcl/Writer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+# if defined(__has_include)
+#  if __has_include(<coroutine>)
+#   define BMCL_HAVE_COROUTINES
+#  endif
+# endif
+#endif
+
+#ifdef BMCL_HAVE_COROUTINES
+# include <coroutine>
+#endif
+
+namespace bmcl {
+
+// readers and writers over a RingBuffer filled (drained) elsewhere, for example by EventLoop::addStream()
+// decoders wait for the bytes they need instead of failing and restarting the whole frame later
+//
+// with C++20 coroutines:
+//     bool isOk = co_await reader->read(4);
+//     if (!isOk) { ... end of stream }
+//     uint32_t size = reader->readUint32Be();
+// (gcc 12 miscompiles awaits of temporaries used directly as if conditions, hence the local)
+// the coroutine is resumed from notify(), which the producer calls after appending data
+//
+// with C++11 the decoder is a step function returning true when done and false when it needs more data,
+// it is called again after new data arrived and continues from the last BMCL_ASYNC_AWAIT_*
+// (locals don't survive suspension, state lives in members):
+//     bool Decoder::step(AsyncReader* reader)
+//     {
+//         BMCL_ASYNC_BEGIN(_state);
+//         BMCL_ASYNC_AWAIT_READ(_state, reader, 4);
+//         _size = reader->readUint32Be();
+//         BMCL_ASYNC_AWAIT_READ(_state, reader, _size);
+//         ...
+//         BMCL_ASYNC_END(_state);
+//     }
+
+// resume point of a C++11 step function
+class AsyncState {
+public:
+    AsyncState();
+
+    bool isDone() const;
+    // restarts from BMCL_ASYNC_BEGIN
+    void reset();
+
+    // used by the BMCL_ASYNC_* macros
+    int position() const;
+    void setPosition(int position);
+
+private:
+    int _position;
+};
+
+inline AsyncState::AsyncState()
+    : _position(0)
+{
+}
+
+inline bool AsyncState::isDone() const
+{
+    return _position == -1;
+}
+
+inline void AsyncState::reset()
+{
+    _position = 0;
+}
+
+inline int AsyncState::position() const
+{
+    return _position;
+}
+
+inline void AsyncState::setPosition(int position)
+{
+    _position = position;
+}
+
+#if defined(__clang__)
+#define BMCL_ASYNC_FALLTHROUGH [[clang::fallthrough]]
+#elif defined(__GNUC__) && __GNUC__ >= 7
+#define BMCL_ASYNC_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define BMCL_ASYNC_FALLTHROUGH
+#endif
+
+// the case labels jump back into the await that suspended, only one await per line is allowed
+#define BMCL_ASYNC_BEGIN(state) \
+    switch ((state).position()) { \
+    case -1: \
+        return true; \
+    case 0:
+
+#define BMCL_ASYNC_AWAIT(state, condition) \
+    do { \
+        (state).setPosition(__LINE__); \
+        BMCL_ASYNC_FALLTHROUGH; \
+        case __LINE__: \
+        if (!(condition)) { \
+            return false; \
+        } \
+    } while (false)
+
+#define BMCL_ASYNC_AWAIT_READ(state, reader, size) BMCL_ASYNC_AWAIT(state, (reader)->isReadable(size))
+
+#define BMCL_ASYNC_AWAIT_WRITE(state, writer, size) BMCL_ASYNC_AWAIT(state, (writer)->isWritable(size))
+
+#define BMCL_ASYNC_END(state) \
+    } \
+    (state).setPosition(-1); \
+    return true
+
+// registration of a suspended awaiter, kept free of coroutine types so the layout is the same in all language modes
+class AsyncWaiter {
+public:
+    AsyncWaiter();
+
+    bool isWaiting() const;
+    void set(void* awaiter, bool (*poll)(void*), void (*resume)(void*));
+    // called by an awaiter destroyed while suspended (with its coroutine frame)
+    void cancel(void* awaiter);
+    // resumes the awaiter if poll says it is complete
+    void notify();
+
+private:
+    void* _awaiter;
+    // makes progress with the data at hand, returns true if the awaiter is complete
+    bool (*_poll)(void*);
+    void (*_resume)(void*);
+};
+
+inline AsyncWaiter::AsyncWaiter()
+    : _awaiter(nullptr)
+    , _poll(nullptr)
+    , _resume(nullptr)
+{
+}
+
+inline bool AsyncWaiter::isWaiting() const
+{
+    return _awaiter != nullptr;
+}
+
+inline void AsyncWaiter::set(void* awaiter, bool (*poll)(void*), void (*resume)(void*))
+{
+    BMCL_ASSERT(_awaiter == nullptr);
+    _awaiter = awaiter;
+    _poll = poll;
+    _resume = resume;
+}
+
+inline void AsyncWaiter::cancel(void* awaiter)
+{
+    if (_awaiter == awaiter) {
+        _awaiter = nullptr;
+    }
+}
+
+inline void AsyncWaiter::notify()
+{
+    if (!_awaiter || !_poll(_awaiter)) {
+        return;
+    }
+    void* awaiter = _awaiter;
+    _awaiter = nullptr;
+    // the coroutine may wait again before this returns
+    _resume(awaiter);
+}
+
+#ifdef BMCL_HAVE_COROUTINES
+
+// awaiter base implementing the AsyncWaiter callbacks, A has bool poll() and bool result()
+template <typename A>
+class AsyncAwaiterBase {
+public:
+    bool await_ready()
+    {
+        return static_cast<A*>(this)->poll();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        _handle = handle;
+        _waiter->set(this, &AsyncAwaiterBase::pollAwaiter, &AsyncAwaiterBase::resumeAwaiter);
+    }
+
+    bool await_resume()
+    {
+        return static_cast<A*>(this)->result();
+    }
+
+protected:
+    explicit AsyncAwaiterBase(AsyncWaiter* waiter)
+        : _waiter(waiter)
+    {
+    }
+
+    ~AsyncAwaiterBase()
+    {
+        _waiter->cancel(this);
+    }
+
+private:
+    static bool pollAwaiter(void* awaiter)
+    {
+        return static_cast<A*>(static_cast<AsyncAwaiterBase*>(awaiter))->poll();
+    }
+
+    static void resumeAwaiter(void* awaiter)
+    {
+        static_cast<AsyncAwaiterBase*>(awaiter)->_handle.resume();
+    }
+
+    AsyncWaiter* _waiter;
+    std::coroutine_handle<> _handle;
+};
+
+#endif
+
+// Reader over the readable part of a ring buffer
+class AsyncReader : public Reader<AsyncReader> {
+public:
+    explicit AsyncReader(RingBuffer* buffer);
+
+    RingBuffer* buffer() const;
+    std::size_t readableSize() const;
+    bool isReadable(std::size_t size) const;
+
+    // end of stream, pending and later awaits complete with false once the data runs out
+    void close();
+    bool isClosed() const;
+
+    // called by the producer after appending data or closing, may resume a suspended coroutine
+    void notify();
+
+    // synchronous part, size must be readable
+    void read(void* dest, std::size_t size);
+    void skip(std::size_t size);
+
+#ifdef BMCL_HAVE_COROUTINES
+    class ReadAwaiter;
+    class ReadIntoAwaiter;
+
+    // suspends until size bytes are readable (size must fit the buffer), returns false on end of stream
+    ReadAwaiter read(std::size_t size);
+    // copies size bytes to dest as they arrive, size is not limited by the buffer capacity
+    ReadIntoAwaiter readInto(void* dest, std::size_t size);
+#endif
+
+private:
+    RingBuffer* _buffer;
+    AsyncWaiter _waiter;
+    bool _isClosed;
+};
+
+inline AsyncReader::AsyncReader(RingBuffer* buffer)
+    : _buffer(buffer)
+    , _isClosed(false)
+{
+}
+
+inline RingBuffer* AsyncReader::buffer() const
+{
+    return _buffer;
+}
+
+inline std::size_t AsyncReader::readableSize() const
+{
+    return _buffer->usedSpace();
+}
+
+inline bool AsyncReader::isReadable(std::size_t size) const
+{
+    BMCL_ASSERT(size <= _buffer->size());
+    return _buffer->usedSpace() >= size;
+}
+
+inline void AsyncReader::close()
+{
+    _isClosed = true;
+}
+
+inline bool AsyncReader::isClosed() const
+{
+    return _isClosed;
+}
+
+inline void AsyncReader::notify()
+{
+    _waiter.notify();
+}
+
+inline void AsyncReader::read(void* dest, std::size_t size)
+{
+    _buffer->read(dest, size);
+}
+
+inline void AsyncReader::skip(std::size_t size)
+{
+    _buffer->erase(size);
+}
+
+// Writer over the free part of a ring buffer
+class AsyncWriter : public Writer<AsyncWriter> {
+public:
+    explicit AsyncWriter(RingBuffer* buffer);
+
+    RingBuffer* buffer() const;
+    std::size_t writableSize() const;
+    bool isWritable(std::size_t size) const;
+
+    // the consumer is gone, pending and later awaits complete with false
+    void close();
+    bool isClosed() const;
+
+    // called by the consumer after taking data out of the buffer or closing
+    void notify();
+
+    // synchronous part, size must be writable
+    void write(const void* data, std::size_t size);
+
+#ifdef BMCL_HAVE_COROUTINES
+    class ReserveAwaiter;
+    class WriteFromAwaiter;
+
+    // suspends until size bytes are writable (size must fit the buffer), returns false if closed
+    ReserveAwaiter reserve(std::size_t size);
+    // copies size bytes from data as space frees up, size is not limited by the buffer capacity
+    WriteFromAwaiter writeFrom(const void* data, std::size_t size);
+#endif
+
+private:
+    RingBuffer* _buffer;
+    AsyncWaiter _waiter;
+    bool _isClosed;
+};
+
+inline AsyncWriter::AsyncWriter(RingBuffer* buffer)
+    : _buffer(buffer)
+    , _isClosed(false)
+{
+}
+
+inline RingBuffer* AsyncWriter::buffer() const
+{
+    return _buffer;
+}
+
+inline std::size_t AsyncWriter::writableSize() const
+{
+    return _buffer->freeSpace();
+}
+
+inline bool AsyncWriter::isWritable(std::size_t size) const
+{
+    BMCL_ASSERT(size <= _buffer->size());
+    return _buffer->freeSpace() >= size;
+}
+
+inline void AsyncWriter::close()
+{
+    _isClosed = true;
+}
+
+inline bool AsyncWriter::isClosed() const
+{
+    return _isClosed;
+}
+
+inline void AsyncWriter::notify()
+{
+    _waiter.notify();
+}
+
+inline void AsyncWriter::write(const void* data, std::size_t size)
+{
+    _buffer->write(data, size);
+}
+
+#ifdef BMCL_HAVE_COROUTINES
+
+class AsyncReader::ReadAwaiter : public AsyncAwaiterBase<ReadAwaiter> {
+public:
+    ReadAwaiter(AsyncReader* reader, std::size_t size)
+        : AsyncAwaiterBase<ReadAwaiter>(&reader->_waiter)
+        , _reader(reader)
+        , _size(size)
+    {
+        BMCL_ASSERT(size <= reader->_buffer->size());
+    }
+
+    bool poll() const
+    {
+        return _reader->isReadable(_size) || _reader->_isClosed;
+    }
+
+    bool result() const
+    {
+        return _reader->isReadable(_size);
+    }
+
+private:
+    AsyncReader* _reader;
+    std::size_t _size;
+};
+
+class AsyncReader::ReadIntoAwaiter : public AsyncAwaiterBase<ReadIntoAwaiter> {
+public:
+    ReadIntoAwaiter(AsyncReader* reader, void* dest, std::size_t size)
+        : AsyncAwaiterBase<ReadIntoAwaiter>(&reader->_waiter)
+        , _reader(reader)
+        , _dest(static_cast<uint8_t*>(dest))
+        , _size(size)
+    {
+    }
+
+    bool poll()
+    {
+        std::size_t size = BMCL_MIN(_size, _reader->readableSize());
+        _reader->read(_dest, size);
+        _dest += size;
+        _size -= size;
+        return _size == 0 || _reader->_isClosed;
+    }
+
+    bool result() const
+    {
+        return _size == 0;
+    }
+
+private:
+    AsyncReader* _reader;
+    uint8_t* _dest;
+    std::size_t _size;
+};
+
+inline AsyncReader::ReadAwaiter AsyncReader::read(std::size_t size)
+{
+    return ReadAwaiter(this, size);
+}
+
+inline AsyncReader::ReadIntoAwaiter AsyncReader::readInto(void* dest, std::size_t size)
+{
+    return ReadIntoAwaiter(this, dest, size);
+}
+
+class AsyncWriter::ReserveAwaiter : public AsyncAwaiterBase<ReserveAwaiter> {
+public:
+    ReserveAwaiter(AsyncWriter* writer, std::size_t size)
+        : AsyncAwaiterBase<ReserveAwaiter>(&writer->_waiter)
+        , _writer(writer)
+        , _size(size)
+    {
+        BMCL_ASSERT(size <= writer->_buffer->size());
+    }
+
+    bool poll() const
+    {
+        return _writer->_isClosed || _writer->isWritable(_size);
+    }
+
+    bool result() const
+    {
+        return !_writer->_isClosed;
+    }
+
+private:
+    AsyncWriter* _writer;
+    std::size_t _size;
+};
+
+class AsyncWriter::WriteFromAwaiter : public AsyncAwaiterBase<WriteFromAwaiter> {
+public:
+    WriteFromAwaiter(AsyncWriter* writer, const void* data, std::size_t size)
+        : AsyncAwaiterBase<WriteFromAwaiter>(&writer->_waiter)
+        , _writer(writer)
+        , _data(static_cast<const uint8_t*>(data))
+        , _size(size)
+    {
+    }
+
+    bool poll()
+    {
+        if (_writer->_isClosed) {
+            return true;
+        }
+        std::size_t size = BMCL_MIN(_size, _writer->writableSize());
+        _writer->write(_data, size);
+        _data += size;
+        _size -= size;
+        return _size == 0;
+    }
+
+    bool result() const
+    {
+        return _size == 0;
+    }
+
+private:
+    AsyncWriter* _writer;
+    const uint8_t* _data;
+    std::size_t _size;
+};
+
+inline AsyncWriter::ReserveAwaiter AsyncWriter::reserve(std::size_t size)
+{
+    return ReserveAwaiter(this, size);
+}
+
+inline AsyncWriter::WriteFromAwaiter AsyncWriter::writeFrom(const void* data, std::size_t size)
+{
+    return WriteFromAwaiter(this, data, size);
+}
+
+#endif
+}
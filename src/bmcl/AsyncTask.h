@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/AsyncStream.h"
+
+#ifdef BMCL_HAVE_COROUTINES
+
+#include "bmcl/Assert.h"
+#include "bmcl/Option.h"
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace bmcl {
+
+template <typename T>
+class AsyncTask;
+
+template <typename T>
+class AsyncPromiseBase {
+public:
+    std::suspend_never initial_suspend() noexcept
+    {
+        return {};
+    }
+
+    auto final_suspend() noexcept
+    {
+        // continues the coroutine awaiting this one, if any
+        struct FinalAwaiter {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<>) noexcept
+            {
+                std::coroutine_handle<> continuation = promise->_continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept
+            {
+            }
+
+            AsyncPromiseBase* promise;
+        };
+        return FinalAwaiter{this};
+    }
+
+    void unhandled_exception()
+    {
+        std::terminate();
+    }
+
+    void setContinuation(std::coroutine_handle<> continuation)
+    {
+        _continuation = continuation;
+    }
+
+private:
+    std::coroutine_handle<> _continuation;
+};
+
+template <typename T>
+class AsyncPromise : public AsyncPromiseBase<T> {
+public:
+    AsyncTask<T> get_return_object();
+
+    template <typename V>
+    void return_value(V&& value)
+    {
+        _value.emplace(std::forward<V>(value));
+    }
+
+    T takeValue()
+    {
+        return _value.take();
+    }
+
+private:
+    Option<T> _value;
+};
+
+template <>
+class AsyncPromise<void> : public AsyncPromiseBase<void> {
+public:
+    AsyncTask<void> get_return_object();
+
+    void return_void()
+    {
+    }
+
+    void takeValue()
+    {
+    }
+};
+
+// coroutine started eagerly, runs until it awaits data from an AsyncReader (AsyncWriter)
+// and continues from notify() of that reader (writer)
+// a task awaited by another task resumes it on completion, so decoders can be composed
+template <typename T>
+class AsyncTask {
+public:
+    using promise_type = AsyncPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    AsyncTask(const AsyncTask& other) = delete;
+    AsyncTask(AsyncTask&& other);
+    // destroys the coroutine frame, suspended or not
+    ~AsyncTask();
+
+    AsyncTask& operator=(const AsyncTask& other) = delete;
+    AsyncTask& operator=(AsyncTask&& other);
+
+    bool isDone() const;
+    // task must be done, can be called once
+    T takeResult();
+
+    bool await_ready() const;
+    void await_suspend(std::coroutine_handle<> continuation);
+    T await_resume();
+
+private:
+    friend class AsyncPromise<T>;
+
+    explicit AsyncTask(Handle handle);
+
+    Handle _handle;
+};
+
+template <typename T>
+inline AsyncTask<T> AsyncPromise<T>::get_return_object()
+{
+    return AsyncTask<T>(AsyncTask<T>::Handle::from_promise(*this));
+}
+
+inline AsyncTask<void> AsyncPromise<void>::get_return_object()
+{
+    return AsyncTask<void>(AsyncTask<void>::Handle::from_promise(*this));
+}
+
+template <typename T>
+inline AsyncTask<T>::AsyncTask(Handle handle)
+    : _handle(handle)
+{
+}
+
+template <typename T>
+inline AsyncTask<T>::AsyncTask(AsyncTask&& other)
+    : _handle(other._handle)
+{
+    other._handle = nullptr;
+}
+
+template <typename T>
+inline AsyncTask<T>::~AsyncTask()
+{
+    if (_handle) {
+        _handle.destroy();
+    }
+}
+
+template <typename T>
+AsyncTask<T>& AsyncTask<T>::operator=(AsyncTask&& other)
+{
+    if (this != &other) {
+        if (_handle) {
+            _handle.destroy();
+        }
+        _handle = other._handle;
+        other._handle = nullptr;
+    }
+    return *this;
+}
+
+template <typename T>
+inline bool AsyncTask<T>::isDone() const
+{
+    return _handle.done();
+}
+
+template <typename T>
+inline T AsyncTask<T>::takeResult()
+{
+    BMCL_ASSERT(isDone());
+    return _handle.promise().takeValue();
+}
+
+template <typename T>
+inline bool AsyncTask<T>::await_ready() const
+{
+    return _handle.done();
+}
+
+template <typename T>
+inline void AsyncTask<T>::await_suspend(std::coroutine_handle<> continuation)
+{
+    _handle.promise().setContinuation(continuation);
+}
+
+template <typename T>
+inline T AsyncTask<T>::await_resume()
+{
+    return _handle.promise().takeValue();
+}
+}
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/Base32.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+namespace bmcl {
+
+static const char base32Chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ234567";
+
+// number of chars for 0..4 trailing bytes
+static const std::size_t tailChars[5] = {0, 2, 4, 5, 7};
+
+static inline int base32CharToValue(char c)
+{
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    } else if (c >= 'a' && c <= 'z') {
+        return c - 'a';
+    } else if (c >= '2' && c <= '7') {
+        return c - '2' + 26;
+    }
+    return -1;
+}
+
+std::size_t base32EncodedSize(std::size_t size, bool pad)
+{
+    if (pad) {
+        return (size + 4) / 5 * 8;
+    }
+    return size / 5 * 8 + tailChars[size % 5];
+}
+
+std::size_t base32MaxDecodedSize(std::size_t size)
+{
+    return (size + 7) / 8 * 5;
+}
+
+std::size_t base32Encode(const uint8_t* data, std::size_t size, char* dest, bool pad)
+{
+    char* start = dest;
+    while (size != 0) {
+        std::size_t blockSize = BMCL_MIN(size, std::size_t(5));
+        uint64_t block = 0;
+        for (std::size_t i = 0; i < 5; i++) {
+            block <<= 8;
+            if (i < blockSize) {
+                block |= data[i];
+            }
+        }
+        std::size_t chars = blockSize == 5 ? 8 : tailChars[blockSize];
+        for (std::size_t i = 0; i < chars; i++) {
+            dest[i] = base32Chars[(block >> (35 - i * 5)) & 0x1f];
+        }
+        dest += chars;
+        if (pad) {
+            for (std::size_t i = chars; i < 8; i++) {
+                *dest = '=';
+                dest++;
+            }
+        }
+        data += blockSize;
+        size -= blockSize;
+    }
+    return dest - start;
+}
+
+std::string base32Encode(Bytes data, bool pad)
+{
+    std::string str(base32EncodedSize(data.size(), pad), '\0');
+    base32Encode(data.data(), data.size(), &str[0], pad);
+    return str;
+}
+
+Result<std::size_t, void> base32Decode(StringView src, uint8_t* dest)
+{
+    std::size_t size = src.size();
+    std::size_t padSize = 0;
+    while (size > 0 && src[size - 1] == '=') {
+        size--;
+        padSize++;
+    }
+    // padding only completes a partial group
+    if (padSize != 0 && (padSize >= 8 || (size + padSize) % 8 != 0)) {
+        return Result<std::size_t, void>();
+    }
+    std::size_t tailSize = size % 8;
+    std::size_t tailBytes = 0;
+    if (tailSize != 0) {
+        while (tailBytes < 5 && tailChars[tailBytes] != tailSize) {
+            tailBytes++;
+        }
+        if (tailBytes == 5) {
+            return Result<std::size_t, void>();
+        }
+    }
+    std::size_t decoded = 0;
+    for (std::size_t i = 0; i < size; i += 8) {
+        std::size_t chars = BMCL_MIN(size - i, std::size_t(8));
+        uint64_t block = 0;
+        for (std::size_t j = 0; j < 8; j++) {
+            block <<= 5;
+            if (j < chars) {
+                int value = base32CharToValue(src[i + j]);
+                if (value < 0) {
+                    return Result<std::size_t, void>();
+                }
+                block |= value;
+            }
+        }
+        std::size_t bytes = (chars == 8) ? 5 : tailBytes;
+        // bits of the last char past the decoded bytes must be zero
+        if ((block & ((uint64_t(1) << (40 - bytes * 8)) - 1)) != 0) {
+            return Result<std::size_t, void>();
+        }
+        for (std::size_t j = 0; j < bytes; j++) {
+            dest[decoded + j] = uint8_t(block >> (32 - j * 8));
+        }
+        decoded += bytes;
+    }
+    return decoded;
+}
+
+Result<Buffer, void> base32Decode(StringView src)
+{
+    Buffer buf = Buffer::createWithUnitializedData(base32MaxDecodedSize(src.size()));
+    auto rv = base32Decode(src, buf.data());
+    if (rv.isErr()) {
+        return Result<Buffer, void>();
+    }
+    buf.resize(rv.unwrap());
+    return buf;
+}
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Bytes.h"
+#include "bmcl/Fwd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bmcl {
+
+// RFC 4648 base32, decoding accepts lower case and missing padding
+
+BMCL_EXPORT std::size_t base32EncodedSize(std::size_t size, bool pad = true);
+BMCL_EXPORT std::size_t base32MaxDecodedSize(std::size_t size);
+
+// dest must have room for base32EncodedSize(size, pad) chars, returns number of chars written
+BMCL_EXPORT std::size_t base32Encode(const uint8_t* data, std::size_t size, char* dest, bool pad = true);
+BMCL_EXPORT std::string base32Encode(Bytes data, bool pad = true);
+
+// dest must have room for base32MaxDecodedSize(src.size()) bytes
+BMCL_EXPORT Result<std::size_t, void> base32Decode(StringView src, uint8_t* dest);
+BMCL_EXPORT Result<Buffer, void> base32Decode(StringView src);
+}
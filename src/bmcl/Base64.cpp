@@ -0,0 +1,491 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/Base64.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/MemWriter.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define BMCL_BASE64_SSSE3
+# include <tmmintrin.h>
+#endif
+
+namespace bmcl {
+
+static const char standardChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char urlChars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static constexpr uint8_t invalidValue = 0xff;
+
+struct Base64DecodeTable {
+    Base64DecodeTable(const char* chars)
+    {
+        std::memset(values, invalidValue, sizeof(values));
+        for (uint8_t i = 0; i < 64; i++) {
+            values[(uint8_t)chars[i]] = i;
+        }
+    }
+
+    uint8_t values[256];
+};
+
+static const Base64DecodeTable standardTable(standardChars);
+static const Base64DecodeTable urlTable(urlChars);
+
+static inline const char* encodeChars(Base64Alphabet alphabet)
+{
+    return alphabet == Base64Alphabet::Standard ? standardChars : urlChars;
+}
+
+static inline const uint8_t* decodeValues(Base64Alphabet alphabet)
+{
+    return alphabet == Base64Alphabet::Standard ? standardTable.values : urlTable.values;
+}
+
+#ifdef BMCL_BASE64_SSSE3
+
+static bool hasSsse3()
+{
+    static const bool value = []() {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3") != 0;
+    }();
+    return value;
+}
+
+// 12 bytes (16 readable) -> 16 chars
+__attribute__((target("ssse3"))) static void encodeBlockSsse3(const uint8_t* src, char* dest, __m128i shiftLut)
+{
+    __m128i in = _mm_loadu_si128((const __m128i*)src);
+    in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    __m128i lutIndices = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    lutIndices = _mm_or_si128(lutIndices, _mm_and_si128(less, _mm_set1_epi8(13)));
+    __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shiftLut, lutIndices), indices);
+    _mm_storeu_si128((__m128i*)dest, chars);
+}
+
+__attribute__((target("ssse3"))) static std::size_t encodeSsse3(const uint8_t* src, std::size_t size, char* dest,
+                                                                 Base64Alphabet alphabet)
+{
+    __m128i shiftLut;
+    if (alphabet == Base64Alphabet::Standard) {
+        shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                 '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    } else {
+        shiftLut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                 '0' - 52, '0' - 52, '0' - 52, '-' - 62, '_' - 63, 'A', 0, 0);
+    }
+    std::size_t consumed = 0;
+    while (size - consumed >= 16) {
+        encodeBlockSsse3(src + consumed, dest, shiftLut);
+        consumed += 12;
+        dest += 16;
+    }
+    return consumed;
+}
+
+// 16 chars -> 12 bytes (16 writable), standard alphabet only
+__attribute__((target("ssse3"))) static bool decodeBlockSsse3(const char* src, uint8_t* dest)
+{
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2f = _mm_set1_epi8(0x2f);
+
+    __m128i in = _mm_loadu_si128((const __m128i*)src);
+    __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2f);
+    __m128i loNibbles = _mm_and_si128(in, mask2f);
+    __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+    __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0xffff) {
+        return false;
+    }
+    __m128i eq2f = _mm_cmpeq_epi8(in, mask2f);
+    __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(eq2f, hiNibbles));
+    __m128i values = _mm_add_epi8(in, roll);
+
+    __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+    merged = _mm_shuffle_epi8(merged, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    _mm_storeu_si128((__m128i*)dest, merged);
+    return true;
+}
+
+__attribute__((target("ssse3"))) static std::size_t decodeSsse3(const char* src, std::size_t size, uint8_t* dest,
+                                                                 bool* isOk)
+{
+    std::size_t consumed = 0;
+    // 4 extra bytes are stored each step, they are overwritten by the following quads
+    while (size - consumed >= 24) {
+        if (!decodeBlockSsse3(src + consumed, dest)) {
+            *isOk = false;
+            return consumed;
+        }
+        consumed += 16;
+        dest += 12;
+    }
+    *isOk = true;
+    return consumed;
+}
+
+#endif
+
+static std::size_t encodeTriples(const uint8_t* src, std::size_t size, char* dest, Base64Alphabet alphabet)
+{
+    std::size_t consumed = 0;
+#ifdef BMCL_BASE64_SSSE3
+    if (size >= 16 && hasSsse3()) {
+        consumed = encodeSsse3(src, size, dest, alphabet);
+        dest += consumed / 3 * 4;
+    }
+#endif
+    const char* chars = encodeChars(alphabet);
+    for (; size - consumed >= 3; consumed += 3) {
+        uint32_t triple = (uint32_t(src[consumed]) << 16) | (uint32_t(src[consumed + 1]) << 8) | src[consumed + 2];
+        dest[0] = chars[(triple >> 18) & 0x3f];
+        dest[1] = chars[(triple >> 12) & 0x3f];
+        dest[2] = chars[(triple >> 6) & 0x3f];
+        dest[3] = chars[triple & 0x3f];
+        dest += 4;
+    }
+    return consumed;
+}
+
+static std::size_t encodeFinal(const uint8_t* src, std::size_t size, char* dest, Base64Alphabet alphabet, bool pad)
+{
+    BMCL_ASSERT(size < 3);
+    const char* chars = encodeChars(alphabet);
+    if (size == 0) {
+        return 0;
+    }
+    uint32_t triple = uint32_t(src[0]) << 16;
+    if (size == 2) {
+        triple |= uint32_t(src[1]) << 8;
+    }
+    dest[0] = chars[(triple >> 18) & 0x3f];
+    dest[1] = chars[(triple >> 12) & 0x3f];
+    if (size == 2) {
+        dest[2] = chars[(triple >> 6) & 0x3f];
+    }
+    if (!pad) {
+        return size + 1;
+    }
+    if (size == 1) {
+        dest[2] = '=';
+    }
+    dest[3] = '=';
+    return 4;
+}
+
+// src has no padding, size is a multiple of 4
+static bool decodeQuads(const char* src, std::size_t size, uint8_t* dest, Base64Alphabet alphabet)
+{
+#ifdef BMCL_BASE64_SSSE3
+    if (alphabet == Base64Alphabet::Standard && size >= 24 && hasSsse3()) {
+        bool isOk;
+        std::size_t consumed = decodeSsse3(src, size, dest, &isOk);
+        if (!isOk) {
+            return false;
+        }
+        src += consumed;
+        size -= consumed;
+        dest += consumed / 4 * 3;
+    }
+#endif
+    const uint8_t* values = decodeValues(alphabet);
+    for (std::size_t i = 0; i < size; i += 4) {
+        uint8_t a = values[(uint8_t)src[i]];
+        uint8_t b = values[(uint8_t)src[i + 1]];
+        uint8_t c = values[(uint8_t)src[i + 2]];
+        uint8_t d = values[(uint8_t)src[i + 3]];
+        if ((a | b | c | d) & 0x80) {
+            return false;
+        }
+        uint32_t triple = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6) | d;
+        dest[0] = uint8_t(triple >> 16);
+        dest[1] = uint8_t(triple >> 8);
+        dest[2] = uint8_t(triple);
+        dest += 3;
+    }
+    return true;
+}
+
+// 2 or 3 chars -> 1 or 2 bytes
+static bool decodeFinal(const char* src, std::size_t size, uint8_t* dest, Base64Alphabet alphabet)
+{
+    BMCL_ASSERT(size == 2 || size == 3);
+    const uint8_t* values = decodeValues(alphabet);
+    uint8_t a = values[(uint8_t)src[0]];
+    uint8_t b = values[(uint8_t)src[1]];
+    uint8_t c = size == 3 ? values[(uint8_t)src[2]] : 0;
+    if ((a | b | c) & 0x80) {
+        return false;
+    }
+    uint32_t triple = (uint32_t(a) << 18) | (uint32_t(b) << 12) | (uint32_t(c) << 6);
+    // bits of the last char past the decoded bytes must be zero
+    if (triple & (size == 2 ? 0xffff : 0xff)) {
+        return false;
+    }
+    dest[0] = uint8_t(triple >> 16);
+    if (size == 3) {
+        dest[1] = uint8_t(triple >> 8);
+    }
+    return true;
+}
+
+std::size_t base64EncodedSize(std::size_t size, bool pad)
+{
+    if (pad) {
+        return (size + 2) / 3 * 4;
+    }
+    return size / 3 * 4 + ((size % 3) ? (size % 3) + 1 : 0);
+}
+
+std::size_t base64MaxDecodedSize(std::size_t size)
+{
+    return size / 4 * 3 + ((size % 4) ? (size % 4) - 1 : 0);
+}
+
+std::size_t base64Encode(const uint8_t* data, std::size_t size, char* dest, Base64Alphabet alphabet, bool pad)
+{
+    std::size_t consumed = encodeTriples(data, size, dest, alphabet);
+    std::size_t written = consumed / 3 * 4;
+    return written + encodeFinal(data + consumed, size - consumed, dest + written, alphabet, pad);
+}
+
+std::string base64Encode(Bytes data, Base64Alphabet alphabet, bool pad)
+{
+    std::string str(base64EncodedSize(data.size(), pad), '\0');
+    base64Encode(data.data(), data.size(), &str[0], alphabet, pad);
+    return str;
+}
+
+void appendBase64(Bytes data, std::string* dest, Base64Alphabet alphabet, bool pad)
+{
+    std::size_t oldSize = dest->size();
+    dest->resize(oldSize + base64EncodedSize(data.size(), pad));
+    base64Encode(data.data(), data.size(), &(*dest)[oldSize], alphabet, pad);
+}
+
+void appendBase64(Bytes data, Buffer* dest, Base64Alphabet alphabet, bool pad)
+{
+    std::size_t oldSize = dest->size();
+    std::size_t newSize = oldSize + base64EncodedSize(data.size(), pad);
+    if (newSize > dest->capacity()) {
+        dest->reserve(BMCL_MAX(newSize, dest->capacity() * 2));
+    }
+    dest->resize(newSize);
+    base64Encode(data.data(), data.size(), (char*)dest->data() + oldSize, alphabet, pad);
+}
+
+void appendBase64(Bytes data, MemWriter* dest, Base64Alphabet alphabet, bool pad)
+{
+    BMCL_ASSERT(dest->writableSize() >= base64EncodedSize(data.size(), pad));
+    std::size_t written = base64Encode(data.data(), data.size(), (char*)dest->current(), alphabet, pad);
+    dest->advance(written);
+}
+
+Result<std::size_t, void> base64Decode(StringView src, uint8_t* dest, Base64Alphabet alphabet)
+{
+    std::size_t size = src.size();
+    std::size_t padSize = 0;
+    while (size > 0 && padSize < 2 && src[size - 1] == '=') {
+        size--;
+        padSize++;
+    }
+    std::size_t tailSize = size % 4;
+    if (tailSize == 1) {
+        return Result<std::size_t, void>();
+    }
+    if (padSize != 0 && (tailSize + padSize) != 4) {
+        return Result<std::size_t, void>();
+    }
+    std::size_t quadsSize = size - tailSize;
+    if (!decodeQuads(src.data(), quadsSize, dest, alphabet)) {
+        return Result<std::size_t, void>();
+    }
+    std::size_t decoded = quadsSize / 4 * 3;
+    if (tailSize != 0) {
+        if (!decodeFinal(src.data() + quadsSize, tailSize, dest + decoded, alphabet)) {
+            return Result<std::size_t, void>();
+        }
+        decoded += tailSize - 1;
+    }
+    return decoded;
+}
+
+Result<Buffer, void> base64Decode(StringView src, Base64Alphabet alphabet)
+{
+    Buffer buf;
+    if (!appendBase64Decoded(src, &buf, alphabet)) {
+        return Result<Buffer, void>();
+    }
+    return buf;
+}
+
+bool appendBase64Decoded(StringView src, Buffer* dest, Base64Alphabet alphabet)
+{
+    std::size_t oldSize = dest->size();
+    std::size_t maxSize = oldSize + base64MaxDecodedSize(src.size());
+    if (maxSize > dest->capacity()) {
+        dest->reserve(BMCL_MAX(maxSize, dest->capacity() * 2));
+    }
+    dest->resize(maxSize);
+    auto rv = base64Decode(src, dest->data() + oldSize, alphabet);
+    if (rv.isErr()) {
+        dest->resize(oldSize);
+        return false;
+    }
+    dest->resize(oldSize + rv.unwrap());
+    return true;
+}
+
+Base64Encoder::Base64Encoder(Base64Alphabet alphabet, bool pad)
+    : _alphabet(alphabet)
+    , _pad(pad)
+    , _tailSize(0)
+{
+}
+
+void Base64Encoder::reset()
+{
+    _tailSize = 0;
+}
+
+std::size_t Base64Encoder::encodeChunk(const uint8_t* data, std::size_t size, char* dest)
+{
+    std::size_t written = 0;
+    if (_tailSize != 0) {
+        uint8_t triple[3];
+        std::memcpy(triple, _tail, _tailSize);
+        std::size_t needed = 3 - _tailSize;
+        if (size < needed) {
+            std::memcpy(_tail + _tailSize, data, size);
+            _tailSize += size;
+            return 0;
+        }
+        std::memcpy(triple + _tailSize, data, needed);
+        encodeTriples(triple, 3, dest, _alphabet);
+        data += needed;
+        size -= needed;
+        dest += 4;
+        written += 4;
+        _tailSize = 0;
+    }
+    std::size_t consumed = encodeTriples(data, size, dest, _alphabet);
+    written += consumed / 3 * 4;
+    _tailSize = size - consumed;
+    std::memcpy(_tail, data + consumed, _tailSize);
+    return written;
+}
+
+std::size_t Base64Encoder::encodeTail(char* dest)
+{
+    std::size_t written = encodeFinal(_tail, _tailSize, dest, _alphabet, _pad);
+    reset();
+    return written;
+}
+
+Base64Decoder::Base64Decoder(Base64Alphabet alphabet)
+    : _alphabet(alphabet)
+    , _tailSize(0)
+    , _padSize(0)
+    , _isFailed(false)
+{
+}
+
+void Base64Decoder::reset()
+{
+    _tailSize = 0;
+    _padSize = 0;
+    _isFailed = false;
+}
+
+bool Base64Decoder::decodeChunk(const char* src, std::size_t size, uint8_t* dest, std::size_t* decoded)
+{
+    *decoded = 0;
+    std::size_t i = 0;
+    while (i < size && !_isFailed) {
+        char c = src[i];
+        if (_padSize != 0) {
+            // only padding is allowed after padding
+            _padSize++;
+            _isFailed = c != '=' || (_tailSize + _padSize) > 4;
+            i++;
+            continue;
+        }
+        if (c == '=') {
+            _padSize = 1;
+            _isFailed = _tailSize < 2;
+            i++;
+            continue;
+        }
+        if (_tailSize == 0 && (size - i) >= 4) {
+            std::size_t end = size;
+            while (end > i && src[end - 1] == '=') {
+                end--;
+            }
+            std::size_t quadsSize = (end - i) / 4 * 4;
+            if (quadsSize != 0) {
+                if (!decodeQuads(src + i, quadsSize, dest, _alphabet)) {
+                    _isFailed = true;
+                    break;
+                }
+                dest += quadsSize / 4 * 3;
+                *decoded += quadsSize / 4 * 3;
+                i += quadsSize;
+                continue;
+            }
+        }
+        _tail[_tailSize] = c;
+        _tailSize++;
+        i++;
+        if (_tailSize == 4) {
+            if (!decodeQuads(_tail, 4, dest, _alphabet)) {
+                _isFailed = true;
+                break;
+            }
+            dest += 3;
+            *decoded += 3;
+            _tailSize = 0;
+        }
+    }
+    return !_isFailed;
+}
+
+bool Base64Decoder::decodeTail(uint8_t* dest, std::size_t* decoded)
+{
+    *decoded = 0;
+    bool isOk = !_isFailed;
+    if (isOk && _padSize != 0) {
+        isOk = (_tailSize + _padSize) == 4;
+    }
+    if (isOk && _tailSize != 0) {
+        isOk = _tailSize != 1 && decodeFinal(_tail, _tailSize, dest, _alphabet);
+        if (isOk) {
+            *decoded = _tailSize - 1;
+        }
+    }
+    reset();
+    return isOk;
+}
+}
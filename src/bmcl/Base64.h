@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Bytes.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/Reader.h"
+#include "bmcl/StringView.h"
+#include "bmcl/Writer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bmcl {
+
+// RFC 4648 base64 (+/) and base64url (-_)
+enum class Base64Alphabet {
+    Standard,
+    Url
+};
+
+BMCL_EXPORT std::size_t base64EncodedSize(std::size_t size, bool pad = true);
+BMCL_EXPORT std::size_t base64MaxDecodedSize(std::size_t size);
+
+// dest must have room for base64EncodedSize(size, pad) chars, returns number of chars written
+BMCL_EXPORT std::size_t base64Encode(const uint8_t* data, std::size_t size, char* dest,
+                                     Base64Alphabet alphabet = Base64Alphabet::Standard, bool pad = true);
+BMCL_EXPORT std::string base64Encode(Bytes data, Base64Alphabet alphabet = Base64Alphabet::Standard, bool pad = true);
+
+BMCL_EXPORT void appendBase64(Bytes data, std::string* dest, Base64Alphabet alphabet = Base64Alphabet::Standard,
+                              bool pad = true);
+BMCL_EXPORT void appendBase64(Bytes data, Buffer* dest, Base64Alphabet alphabet = Base64Alphabet::Standard,
+                              bool pad = true);
+BMCL_EXPORT void appendBase64(Bytes data, MemWriter* dest, Base64Alphabet alphabet = Base64Alphabet::Standard,
+                              bool pad = true);
+
+// padding is optional when decoding, whitespace is not accepted
+// dest must have room for base64MaxDecodedSize(src.size()) bytes
+BMCL_EXPORT Result<std::size_t, void> base64Decode(StringView src, uint8_t* dest,
+                                                   Base64Alphabet alphabet = Base64Alphabet::Standard);
+BMCL_EXPORT Result<Buffer, void> base64Decode(StringView src, Base64Alphabet alphabet = Base64Alphabet::Standard);
+BMCL_EXPORT bool appendBase64Decoded(StringView src, Buffer* dest, Base64Alphabet alphabet = Base64Alphabet::Standard);
+
+class BMCL_EXPORT Base64Encoder {
+public:
+    Base64Encoder(Base64Alphabet alphabet = Base64Alphabet::Standard, bool pad = true);
+
+    template <typename B>
+    void update(Bytes data, Writer<B>* dest);
+    template <typename R, typename B>
+    void update(Reader<R>* src, Writer<B>* dest);
+    template <typename B>
+    void finish(Writer<B>* dest);
+
+    void reset();
+
+private:
+    static constexpr std::size_t chunkSize = 768;
+
+    std::size_t encodeChunk(const uint8_t* data, std::size_t size, char* dest);
+    std::size_t encodeTail(char* dest);
+
+    Base64Alphabet _alphabet;
+    bool _pad;
+    uint8_t _tail[2];
+    std::size_t _tailSize;
+};
+
+class BMCL_EXPORT Base64Decoder {
+public:
+    Base64Decoder(Base64Alphabet alphabet = Base64Alphabet::Standard);
+
+    template <typename B>
+    bool update(StringView src, Writer<B>* dest);
+    template <typename R, typename B>
+    bool update(Reader<R>* src, Writer<B>* dest);
+    template <typename B>
+    bool finish(Writer<B>* dest);
+
+    void reset();
+
+private:
+    static constexpr std::size_t chunkSize = 1024;
+
+    bool decodeChunk(const char* src, std::size_t size, uint8_t* dest, std::size_t* decoded);
+    bool decodeTail(uint8_t* dest, std::size_t* decoded);
+
+    Base64Alphabet _alphabet;
+    char _tail[4];
+    std::size_t _tailSize;
+    std::size_t _padSize;
+    bool _isFailed;
+};
+
+template <typename B>
+void Base64Encoder::update(Bytes data, Writer<B>* dest)
+{
+    char tmp[chunkSize / 3 * 4];
+    const uint8_t* it = data.begin();
+    while (it != data.end()) {
+        std::size_t size = BMCL_MIN(chunkSize - _tailSize, std::size_t(data.end() - it));
+        std::size_t encoded = encodeChunk(it, size, tmp);
+        if (encoded) {
+            static_cast<B*>(dest)->write(tmp, encoded);
+        }
+        it += size;
+    }
+}
+
+template <typename R, typename B>
+void Base64Encoder::update(Reader<R>* src, Writer<B>* dest)
+{
+    uint8_t tmp[chunkSize];
+    R* reader = static_cast<R*>(src);
+    while (std::size_t size = BMCL_MIN(reader->readableSize(), sizeof(tmp))) {
+        reader->read(tmp, size);
+        update(Bytes(tmp, size), dest);
+    }
+}
+
+template <typename B>
+void Base64Encoder::finish(Writer<B>* dest)
+{
+    char tmp[4];
+    std::size_t encoded = encodeTail(tmp);
+    if (encoded) {
+        static_cast<B*>(dest)->write(tmp, encoded);
+    }
+}
+
+template <typename B>
+bool Base64Decoder::update(StringView src, Writer<B>* dest)
+{
+    uint8_t tmp[chunkSize / 4 * 3 + 3];
+    const char* it = src.begin();
+    while (it != src.end()) {
+        std::size_t size = BMCL_MIN(chunkSize, std::size_t(src.end() - it));
+        std::size_t decoded;
+        if (!decodeChunk(it, size, tmp, &decoded)) {
+            return false;
+        }
+        if (decoded) {
+            static_cast<B*>(dest)->write(tmp, decoded);
+        }
+        it += size;
+    }
+    return true;
+}
+
+template <typename R, typename B>
+bool Base64Decoder::update(Reader<R>* src, Writer<B>* dest)
+{
+    char tmp[chunkSize];
+    R* reader = static_cast<R*>(src);
+    while (std::size_t size = BMCL_MIN(reader->readableSize(), sizeof(tmp))) {
+        reader->read(tmp, size);
+        if (!update(StringView(tmp, size), dest)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename B>
+bool Base64Decoder::finish(Writer<B>* dest)
+{
+    uint8_t tmp[3];
+    std::size_t decoded;
+    if (!decodeTail(tmp, &decoded)) {
+        return false;
+    }
+    if (decoded) {
+        static_cast<B*>(dest)->write(tmp, decoded);
+    }
+    return true;
+}
+}
@@ -0,0 +1,444 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/BinaryLog.h"
+#include "bmcl/MemReader.h"
+#include "bmcl/NumberFormat.h"
+#include "bmcl/Panic.h"
+#include "bmcl/TimeUtils.h"
+#include "bmcl/bits/LogQueue.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bmcl {
+
+// file starts with magic and version, followed by records starting with BinaryLogRecordType
+// Format: varuint id, uint8 level, varuint line, varuint size + file, varuint size + format string
+// Message: varuint id, uint64 le nanoseconds since epoch, varuint argument count, arguments
+static const char binaryLogMagic[8] = {'B', 'M', 'C', 'L', 'B', 'L', 'O', 'G'};
+static const uint8_t binaryLogVersion = 1;
+
+enum class BinaryLogRecordType : uint8_t {
+    Format = 0,
+    Message = 1
+};
+
+struct BinaryLogFormat {
+    LogLevel level;
+    unsigned line;
+    std::string file;
+    std::string fmt;
+};
+
+static std::mutex binaryLogFormatsMutex;
+static std::vector<BinaryLogFormat> binaryLogFormats;
+
+uint32_t registerBinaryLogFormat(LogLevel level, const char* file, unsigned line, const char* fmt)
+{
+    BinaryLogFormat format;
+    format.level = level;
+    format.line = line;
+    format.file = file;
+    format.fmt = fmt;
+    std::lock_guard<std::mutex> lock(binaryLogFormatsMutex);
+    binaryLogFormats.push_back(std::move(format));
+    return uint32_t(binaryLogFormats.size() - 1);
+}
+
+static void writeBinaryLogString(Buffer* dest, const std::string& str)
+{
+    dest->writeVarUint(str.size());
+    dest->write(str.data(), str.size());
+}
+
+class BinaryLogWriter : public LogQueueWriter {
+public:
+    BinaryLogWriter();
+
+    bool open(const char* path);
+    void close();
+    uint64_t unwritten() const;
+
+protected:
+    bool handleBatch(const std::vector<std::shared_ptr<LogQueue>>& queues) override;
+
+private:
+    bool writeFormat(uint64_t id);
+    bool writeToFile(const void* data, std::size_t size);
+
+    std::FILE* _file;
+    // after a failed write the rest of the file can't be decoded, records are counted instead
+    bool _isWriteFailed;
+    std::atomic<uint64_t> _unwritten;
+    std::vector<bool> _isFormatWritten;
+    std::string _record;
+    Buffer _formatRecord;
+};
+
+BinaryLogWriter::BinaryLogWriter()
+    : LogQueueWriter(LogQueueWriter::BinarySlot)
+    , _file(nullptr)
+    , _isWriteFailed(false)
+    , _unwritten(0)
+{
+}
+
+bool BinaryLogWriter::open(const char* path)
+{
+    _file = std::fopen(path, "wb");
+    if (!_file) {
+        return false;
+    }
+    _isFormatWritten.clear();
+    _isWriteFailed = false;
+    if (!writeToFile(binaryLogMagic, sizeof(binaryLogMagic)) || !writeToFile(&binaryLogVersion, 1)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BinaryLogWriter::close()
+{
+    std::fclose(_file);
+    _file = nullptr;
+}
+
+uint64_t BinaryLogWriter::unwritten() const
+{
+    return _unwritten.load(std::memory_order_relaxed);
+}
+
+bool BinaryLogWriter::writeToFile(const void* data, std::size_t size)
+{
+    if (!_isWriteFailed && std::fwrite(data, 1, size, _file) != size) {
+        _isWriteFailed = true;
+    }
+    return !_isWriteFailed;
+}
+
+bool BinaryLogWriter::writeFormat(uint64_t id)
+{
+    if (id < _isFormatWritten.size() && _isFormatWritten[id]) {
+        return true;
+    }
+    _formatRecord.resize(0);
+    {
+        std::lock_guard<std::mutex> lock(binaryLogFormatsMutex);
+        if (id >= binaryLogFormats.size()) {
+            return true;
+        }
+        const BinaryLogFormat& format = binaryLogFormats[id];
+        _formatRecord.writeUint8((uint8_t)BinaryLogRecordType::Format);
+        _formatRecord.writeVarUint(id);
+        _formatRecord.writeUint8((uint8_t)format.level);
+        _formatRecord.writeVarUint(format.line);
+        writeBinaryLogString(&_formatRecord, format.file);
+        writeBinaryLogString(&_formatRecord, format.fmt);
+    }
+    if (!writeToFile(_formatRecord.data(), _formatRecord.size())) {
+        return false;
+    }
+    if (id >= _isFormatWritten.size()) {
+        _isFormatWritten.resize(id + 1, false);
+    }
+    _isFormatWritten[id] = true;
+    return true;
+}
+
+bool BinaryLogWriter::handleBatch(const std::vector<std::shared_ptr<LogQueue>>& queues)
+{
+    bool isHandled = false;
+    for (const std::shared_ptr<LogQueue>& queue : queues) {
+        queue->beginRead();
+        while (queue->read(&_record)) {
+            uint64_t id;
+            MemReader reader(_record.data(), _record.size());
+            uint8_t type = (uint8_t)BinaryLogRecordType::Message;
+            bool isWritten = !reader.readVarUint(&id) || writeFormat(id);
+            isWritten = isWritten && writeToFile(&type, 1) && writeToFile(_record.data(), _record.size());
+            if (!isWritten) {
+                _unwritten.fetch_add(1, std::memory_order_relaxed);
+            }
+            isHandled = true;
+        }
+    }
+    if (isHandled && !_isWriteFailed && std::fflush(_file) != 0) {
+        _isWriteFailed = true;
+    }
+    return isHandled;
+}
+
+// created on first use and never destroyed, see asyncWriter in Logging.cpp
+static std::mutex binaryLogWriterMutex;
+static std::atomic<BinaryLogWriter*> binaryLogWriter(nullptr);
+static thread_local Buffer localBinaryLogRecord;
+
+static void stopBinaryLogAtExit()
+{
+    stopBinaryLog();
+}
+
+static void flushBinaryLogOnPanic()
+{
+    BinaryLogWriter* writer = binaryLogWriter.load(std::memory_order_acquire);
+    if (writer && writer->isEnabled()) {
+        writer->flushFor(logPanicFlushTimeout);
+    }
+}
+
+bool startBinaryLog(const char* path, std::size_t queueSize, LogOverflowPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(binaryLogWriterMutex);
+    BinaryLogWriter* writer = binaryLogWriter.load();
+    if (!writer) {
+        writer = new BinaryLogWriter;
+        binaryLogWriter.store(writer);
+        std::atexit(stopBinaryLogAtExit);
+        addPanicFlushHook(flushBinaryLogOnPanic, PanicFlushStage::Drain);
+    }
+    if (writer->isEnabled()) {
+        writer->stop();
+        writer->close();
+    }
+    if (!writer->open(path)) {
+        return false;
+    }
+    writer->start(queueSize, policy);
+    return true;
+}
+
+void stopBinaryLog()
+{
+    std::lock_guard<std::mutex> lock(binaryLogWriterMutex);
+    BinaryLogWriter* writer = binaryLogWriter.load();
+    if (writer && writer->isEnabled()) {
+        writer->stop();
+        writer->close();
+    }
+}
+
+bool isBinaryLogEnabled()
+{
+    BinaryLogWriter* writer = binaryLogWriter.load(std::memory_order_acquire);
+    return writer && writer->isEnabled();
+}
+
+void flushBinaryLog()
+{
+    BinaryLogWriter* writer = binaryLogWriter.load(std::memory_order_acquire);
+    if (writer && writer->isEnabled()) {
+        writer->flush();
+    }
+}
+
+uint64_t droppedBinaryLogRecords()
+{
+    BinaryLogWriter* writer = binaryLogWriter.load(std::memory_order_acquire);
+    if (writer) {
+        return writer->dropped() + writer->unwritten();
+    }
+    return 0;
+}
+
+Buffer* beginBinaryLogRecord(uint32_t id, std::size_t argNum)
+{
+    auto time = std::chrono::system_clock::now().time_since_epoch();
+    Buffer* record = &localBinaryLogRecord;
+    record->resize(0);
+    record->writeVarUint(id);
+    record->writeUint64Le(std::chrono::duration_cast<std::chrono::nanoseconds>(time).count());
+    record->writeVarUint(argNum);
+    return record;
+}
+
+void commitBinaryLogRecord(Buffer* record)
+{
+    BinaryLogWriter* writer = binaryLogWriter.load(std::memory_order_acquire);
+    if (!writer || !writer->isEnabled()) {
+        return;
+    }
+    // records are never truncated, a partial record can't be decoded
+    if (record->size() > writer->maxRecordSize()) {
+        writer->countDropped();
+        return;
+    }
+    // not queued only when logging from the writer thread or after stop, there is nowhere to write it synchronously
+    if (!writer->push(nullptr, 0, record->data(), record->size())) {
+        writer->countDropped();
+    }
+}
+
+static bool readBinaryLogString(MemReader* reader, std::string* dest)
+{
+    uint64_t size;
+    if (!reader->readVarUint(&size) || size > reader->sizeLeft()) {
+        return false;
+    }
+    dest->assign((const char*)reader->current(), std::size_t(size));
+    reader->skip(std::size_t(size));
+    return true;
+}
+
+static bool readBinaryLogArg(MemReader* reader, std::string* dest)
+{
+    if (reader->sizeLeft() < 1) {
+        return false;
+    }
+    switch ((BinaryLogArgType)reader->readUint8()) {
+    case BinaryLogArgType::Bool:
+        if (reader->sizeLeft() < 1) {
+            return false;
+        }
+        dest->append(reader->readUint8() ? "true" : "false");
+        return true;
+    case BinaryLogArgType::Char:
+        if (reader->sizeLeft() < 1) {
+            return false;
+        }
+        dest->push_back(char(reader->readUint8()));
+        return true;
+    case BinaryLogArgType::Int: {
+        int64_t value;
+        if (!reader->readVarInt(&value)) {
+            return false;
+        }
+        formatInt(value, dest);
+        return true;
+    }
+    case BinaryLogArgType::Uint: {
+        uint64_t value;
+        if (!reader->readVarUint(&value)) {
+            return false;
+        }
+        formatUint(value, dest);
+        return true;
+    }
+    case BinaryLogArgType::Double:
+        if (reader->sizeLeft() < 8) {
+            return false;
+        }
+        formatDouble(reader->readFloat64Le(), dest);
+        return true;
+    case BinaryLogArgType::String: {
+        uint64_t size;
+        if (!reader->readVarUint(&size) || size > reader->sizeLeft()) {
+            return false;
+        }
+        dest->append((const char*)reader->current(), std::size_t(size));
+        reader->skip(std::size_t(size));
+        return true;
+    }
+    }
+    return false;
+}
+
+static void appendBinaryLogTime(int64_t nsecs, std::string* dest)
+{
+    dest->append(formatLocalTime(std::time_t(nsecs / 1000000000)), CachedTimeFormatter::formattedSize);
+    char usecStr[8];
+    unsigned usecs = unsigned((nsecs % 1000000000) / 1000);
+    usecStr[0] = '.';
+    for (int i = 6; i > 0; i--) {
+        usecStr[i] = char('0' + usecs % 10);
+        usecs /= 10;
+    }
+    dest->append(usecStr, 7);
+}
+
+bool decodeBinaryLog(Bytes data, std::string* dest)
+{
+    MemReader reader(data);
+    if (reader.sizeLeft() < sizeof(binaryLogMagic) + 1) {
+        return false;
+    }
+    if (std::memcmp(reader.current(), binaryLogMagic, sizeof(binaryLogMagic)) != 0) {
+        return false;
+    }
+    reader.skip(sizeof(binaryLogMagic));
+    if (reader.readUint8() != binaryLogVersion) {
+        return false;
+    }
+
+    // ids are registration indices in the writing process, formats are written in order of first use
+    std::unordered_map<uint32_t, BinaryLogFormat> formats;
+    std::vector<std::string> args;
+    while (!reader.isEmpty()) {
+        uint8_t type = reader.readUint8();
+        uint64_t id;
+        if (!reader.readVarUint(&id) || id > UINT32_MAX) {
+            return false;
+        }
+        if (type == (uint8_t)BinaryLogRecordType::Format) {
+            uint64_t line;
+            if (reader.sizeLeft() < 1) {
+                return false;
+            }
+            BinaryLogFormat format;
+            format.level = (LogLevel)reader.readUint8();
+            if (!reader.readVarUint(&line)) {
+                return false;
+            }
+            format.line = unsigned(line);
+            if (!readBinaryLogString(&reader, &format.file) || !readBinaryLogString(&reader, &format.fmt)) {
+                return false;
+            }
+            formats[uint32_t(id)] = std::move(format);
+            continue;
+        }
+        auto formatIt = formats.find(uint32_t(id));
+        if (type != (uint8_t)BinaryLogRecordType::Message || formatIt == formats.end() || reader.sizeLeft() < 8) {
+            return false;
+        }
+        int64_t time = reader.readInt64Le();
+        uint64_t argNum;
+        if (!reader.readVarUint(&argNum) || argNum > reader.sizeLeft()) {
+            return false;
+        }
+        args.resize(std::size_t(argNum));
+        for (std::string& arg : args) {
+            arg.clear();
+            if (!readBinaryLogArg(&reader, &arg)) {
+                return false;
+            }
+        }
+
+        const BinaryLogFormat& format = formatIt->second;
+        appendBinaryLogTime(time, dest);
+        dest->push_back(' ');
+        dest->append(logLevelPrefix(format.level));
+        dest->push_back(' ');
+        std::size_t argIndex = 0;
+        const std::string& fmt = format.fmt;
+        for (std::size_t i = 0; i < fmt.size(); i++) {
+            if (fmt[i] == '{' && i + 1 < fmt.size() && fmt[i + 1] == '}' && argIndex < args.size()) {
+                dest->append(args[argIndex]);
+                argIndex++;
+                i++;
+            } else {
+                dest->push_back(fmt[i]);
+            }
+        }
+        // arguments without placeholders
+        for (; argIndex < args.size(); argIndex++) {
+            dest->push_back(' ');
+            dest->append(args[argIndex]);
+        }
+        dest->push_back('\n');
+    }
+    return true;
+}
+}
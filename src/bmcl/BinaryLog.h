@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/Bytes.h"
+#include "bmcl/Logging.h"
+#include "bmcl/StringView.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// BMCL_BINLOG(bmcl::LogLevel::Info, "packet {} from {} size {}", id, name, size);
+// format string and call site are registered once, each message stores only the format id,
+// a timestamp and the binary encoded arguments, formatting is done later by decodeBinaryLog()
+#define BMCL_BINLOG(level, ...)                                                                                        \
+    do {                                                                                                               \
+        if (bmcl::isLogLevelEnabled(level) && bmcl::isBinaryLogEnabled()) {                                            \
+            static const uint32_t _bmclBinaryLogId =                                                                   \
+                bmcl::registerBinaryLogFormat(level, __FILE__, __LINE__, BMCL_BINLOG_FORMAT(__VA_ARGS__, 0));          \
+            bmcl::binaryLog(_bmclBinaryLogId, __VA_ARGS__);                                                            \
+        }                                                                                                              \
+    } while (false)
+#define BMCL_BINLOG_FORMAT(fmt, ...) fmt
+
+namespace bmcl {
+
+enum class BinaryLogArgType : uint8_t {
+    Bool = 0,
+    Char = 1,
+    Int = 2, // zigzag varint
+    Uint = 3, // varuint
+    Double = 4, // 8 bytes little endian
+    String = 5 // varuint size followed by data
+};
+
+// file is truncated, records are queued per thread and written by a background thread
+BMCL_EXPORT bool startBinaryLog(const char* path, std::size_t queueSize = 1024 * 1024,
+                                LogOverflowPolicy policy = LogOverflowPolicy::Drop);
+// writes all queued records and closes the file
+BMCL_EXPORT void stopBinaryLog();
+BMCL_EXPORT bool isBinaryLogEnabled();
+// blocks until all records queued before the call are written to the file
+BMCL_EXPORT void flushBinaryLog();
+// includes records not written because of a file write error, records after it are not written too
+BMCL_EXPORT uint64_t droppedBinaryLogRecords();
+
+// appends text lines in the same format as the default log handler, "{}" is replaced by arguments
+// returns false if data is truncated or malformed, lines decoded before the error are kept
+BMCL_EXPORT bool decodeBinaryLog(Bytes data, std::string* dest);
+
+BMCL_EXPORT uint32_t registerBinaryLogFormat(LogLevel level, const char* file, unsigned line, const char* fmt);
+BMCL_EXPORT Buffer* beginBinaryLogRecord(uint32_t id, std::size_t argNum);
+BMCL_EXPORT void commitBinaryLogRecord(Buffer* record);
+
+inline void writeBinaryLogArg(Buffer* dest, bool value)
+{
+    dest->writeUint8((uint8_t)BinaryLogArgType::Bool);
+    dest->writeUint8(value);
+}
+
+inline void writeBinaryLogArg(Buffer* dest, char value)
+{
+    dest->writeUint8((uint8_t)BinaryLogArgType::Char);
+    dest->writeUint8(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type
+writeBinaryLogArg(Buffer* dest, T value)
+{
+    dest->writeUint8((uint8_t)BinaryLogArgType::Int);
+    dest->writeVarInt(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value>::type
+writeBinaryLogArg(Buffer* dest, T value)
+{
+    dest->writeUint8((uint8_t)BinaryLogArgType::Uint);
+    dest->writeVarUint(value);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_enum<T>::value>::type writeBinaryLogArg(Buffer* dest, T value)
+{
+    writeBinaryLogArg(dest, typename std::underlying_type<T>::type(value));
+}
+
+inline void writeBinaryLogArg(Buffer* dest, double value)
+{
+    dest->writeUint8((uint8_t)BinaryLogArgType::Double);
+    dest->writeFloat64Le(value);
+}
+
+inline void writeBinaryLogArg(Buffer* dest, StringView value)
+{
+    dest->writeUint8((uint8_t)BinaryLogArgType::String);
+    dest->writeVarUint(value.size());
+    dest->write(value.data(), value.size());
+}
+
+inline void writeBinaryLogArg(Buffer* dest, const char* value)
+{
+    writeBinaryLogArg(dest, StringView(value));
+}
+
+inline void writeBinaryLogArg(Buffer* dest, const std::string& value)
+{
+    writeBinaryLogArg(dest, StringView(value));
+}
+
+// other pointers would silently convert to bool
+template <typename T>
+void writeBinaryLogArg(Buffer*, const T*) = delete;
+
+inline void writeBinaryLogArgs(Buffer*)
+{
+}
+
+template <typename T, typename... A>
+inline void writeBinaryLogArgs(Buffer* dest, const T& value, const A&... args)
+{
+    writeBinaryLogArg(dest, value);
+    writeBinaryLogArgs(dest, args...);
+}
+
+template <typename... A>
+void binaryLog(uint32_t id, const char*, const A&... args)
+{
+    Buffer* record = beginBinaryLogRecord(id, sizeof...(args));
+    writeBinaryLogArgs(record, args...);
+    commitBinaryLogRecord(record);
+}
+}
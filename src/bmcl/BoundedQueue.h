@@ -0,0 +1,628 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Futex.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace bmcl {
+
+// eventcount over a Futex used by blocking queue operations
+// waiters register before their last check, so notify() is a fence and a load while nobody sleeps
+class QueueSignal {
+public:
+    QueueSignal();
+
+    // isReady is retried (and may have side effects) until it returns true
+    template <typename F>
+    void waitUntil(F&& isReady);
+    void notify(unsigned count);
+    void notifyAll();
+
+private:
+    static constexpr unsigned yieldCount = 16;
+
+    Futex _futex;
+    std::atomic<uint32_t> _waiterCount;
+};
+
+inline QueueSignal::QueueSignal()
+    : _waiterCount(0)
+{
+}
+
+template <typename F>
+void QueueSignal::waitUntil(F&& isReady)
+{
+    for (unsigned i = 0; i < yieldCount; i++) {
+        if (isReady()) {
+            return;
+        }
+        std::this_thread::yield();
+    }
+    while (true) {
+        uint32_t epoch = _futex.load();
+        _waiterCount.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool ready = isReady();
+        if (!ready) {
+            // returns at once if notify() changed the epoch after it was read
+            _futex.wait(epoch);
+        }
+        _waiterCount.fetch_sub(1, std::memory_order_relaxed);
+        if (ready) {
+            return;
+        }
+    }
+}
+
+inline void QueueSignal::notify(unsigned count)
+{
+    // pairs with the fence in waitUntil(), either the waiter sees the new state or we see the waiter
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waiterCount.load(std::memory_order_relaxed) != 0) {
+        _futex.fetchAdd(1);
+        _futex.wake(count);
+    }
+}
+
+inline void QueueSignal::notifyAll()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waiterCount.load(std::memory_order_relaxed) != 0) {
+        _futex.fetchAdd(1);
+        _futex.wakeAll();
+    }
+}
+
+// blocking operations and closing, shared by MpmcQueue and SpscQueue
+// B implements tryPush(), tryPushMany(), tryPop() and tryPopMany()
+template <typename T, typename B>
+class BoundedQueueBase {
+public:
+    BoundedQueueBase(const BoundedQueueBase& other) = delete;
+    BoundedQueueBase& operator=(const BoundedQueueBase& other) = delete;
+
+    // wakes blocked threads, pushes fail afterwards and pops fail once the queue is empty
+    void close();
+    bool isClosed() const;
+
+    // wait for free space, return false only after close()
+    bool push(const T& value);
+    bool push(T&& value);
+    // moves items until all of them are pushed, returns less than count only after close()
+    std::size_t pushMany(T* items, std::size_t count);
+
+    // wait for values, return false (0) only after close() and once the queue is empty
+    bool pop(T* dest);
+    // returns as soon as at least one value was popped
+    std::size_t popMany(T* dest, std::size_t maxCount);
+
+protected:
+    BoundedQueueBase();
+
+    static std::size_t roundCapacity(std::size_t capacity);
+
+    QueueSignal _notEmpty;
+    QueueSignal _notFull;
+
+private:
+    template <typename V>
+    bool pushValue(V&& value);
+
+    B* derived();
+
+    std::atomic<bool> _isClosed;
+};
+
+template <typename T, typename B>
+inline BoundedQueueBase<T, B>::BoundedQueueBase()
+    : _isClosed(false)
+{
+}
+
+template <typename T, typename B>
+inline B* BoundedQueueBase<T, B>::derived()
+{
+    return static_cast<B*>(this);
+}
+
+template <typename T, typename B>
+inline std::size_t BoundedQueueBase<T, B>::roundCapacity(std::size_t capacity)
+{
+    std::size_t rounded = 2;
+    while (rounded < capacity) {
+        rounded *= 2;
+    }
+    return rounded;
+}
+
+template <typename T, typename B>
+void BoundedQueueBase<T, B>::close()
+{
+    _isClosed.store(true, std::memory_order_release);
+    _notEmpty.notifyAll();
+    _notFull.notifyAll();
+}
+
+template <typename T, typename B>
+inline bool BoundedQueueBase<T, B>::isClosed() const
+{
+    return _isClosed.load(std::memory_order_acquire);
+}
+
+template <typename T, typename B>
+template <typename V>
+bool BoundedQueueBase<T, B>::pushValue(V&& value)
+{
+    bool isPushed = false;
+    _notFull.waitUntil([&]() {
+        if (isClosed()) {
+            return true;
+        }
+        isPushed = derived()->tryPush(std::forward<V>(value));
+        return isPushed;
+    });
+    return isPushed;
+}
+
+template <typename T, typename B>
+inline bool BoundedQueueBase<T, B>::push(const T& value)
+{
+    return pushValue(value);
+}
+
+template <typename T, typename B>
+inline bool BoundedQueueBase<T, B>::push(T&& value)
+{
+    return pushValue(std::move(value));
+}
+
+template <typename T, typename B>
+std::size_t BoundedQueueBase<T, B>::pushMany(T* items, std::size_t count)
+{
+    std::size_t pushed = 0;
+    _notFull.waitUntil([&]() {
+        if (isClosed()) {
+            return true;
+        }
+        pushed += derived()->tryPushMany(items + pushed, count - pushed);
+        return pushed == count;
+    });
+    return pushed;
+}
+
+template <typename T, typename B>
+bool BoundedQueueBase<T, B>::pop(T* dest)
+{
+    bool isPopped = false;
+    _notEmpty.waitUntil([&]() {
+        isPopped = derived()->tryPop(dest);
+        return isPopped || isClosed();
+    });
+    // values pushed right before close() are still returned
+    return isPopped || derived()->tryPop(dest);
+}
+
+template <typename T, typename B>
+std::size_t BoundedQueueBase<T, B>::popMany(T* dest, std::size_t maxCount)
+{
+    std::size_t popped = 0;
+    _notEmpty.waitUntil([&]() {
+        popped = derived()->tryPopMany(dest, maxCount);
+        return popped != 0 || maxCount == 0 || isClosed();
+    });
+    if (popped == 0) {
+        popped = derived()->tryPopMany(dest, maxCount);
+    }
+    return popped;
+}
+
+// bounded multi producer multi consumer queue, Vyukov's ring of sequence numbered cells
+// single element operations don't wait for other threads, batch operations claim a range of cells
+// with one CAS and then wait for each cell to be released by the thread that claimed it on the previous lap
+template <typename T>
+class MpmcQueue : public BoundedQueueBase<T, MpmcQueue<T>> {
+public:
+    // capacity is rounded up to a power of two
+    explicit MpmcQueue(std::size_t capacity);
+    ~MpmcQueue();
+
+    std::size_t capacity() const;
+    // may be outdated by the time it returns
+    std::size_t sizeApprox() const;
+
+    bool tryPush(const T& value);
+    bool tryPush(T&& value);
+    // moves values from the front of items, returns number of pushed values
+    std::size_t tryPushMany(T* items, std::size_t count);
+    bool tryPop(T* dest);
+    // move assigns up to maxCount values to dest, returns number of popped values
+    std::size_t tryPopMany(T* dest, std::size_t maxCount);
+
+private:
+    struct Cell {
+        T* value()
+        {
+            return reinterpret_cast<T*>(&storage);
+        }
+
+        std::atomic<std::size_t> sequence;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    template <typename V>
+    bool emplace(V&& value);
+    Cell* cell(std::size_t pos) const;
+    static void waitSequence(Cell* cell, std::size_t sequence);
+
+    std::unique_ptr<Cell[]> _cells;
+    std::size_t _mask;
+    char _pad1[64];
+    std::atomic<std::size_t> _enqueuePos;
+    char _pad2[64];
+    std::atomic<std::size_t> _dequeuePos;
+    char _pad3[64];
+};
+
+template <typename T>
+MpmcQueue<T>::MpmcQueue(std::size_t capacity)
+    : _enqueuePos(0)
+    , _dequeuePos(0)
+{
+    capacity = this->roundCapacity(capacity);
+    _cells.reset(new Cell[capacity]);
+    _mask = capacity - 1;
+    for (std::size_t i = 0; i < capacity; i++) {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+MpmcQueue<T>::~MpmcQueue()
+{
+    std::size_t end = _enqueuePos.load(std::memory_order_relaxed);
+    for (std::size_t pos = _dequeuePos.load(std::memory_order_relaxed); pos != end; pos++) {
+        cell(pos)->value()->~T();
+    }
+}
+
+template <typename T>
+inline std::size_t MpmcQueue<T>::capacity() const
+{
+    return _mask + 1;
+}
+
+template <typename T>
+inline std::size_t MpmcQueue<T>::sizeApprox() const
+{
+    std::size_t dequeuePos = _dequeuePos.load(std::memory_order_acquire);
+    std::size_t enqueuePos = _enqueuePos.load(std::memory_order_acquire);
+    return std::min(enqueuePos - dequeuePos, capacity());
+}
+
+template <typename T>
+inline typename MpmcQueue<T>::Cell* MpmcQueue<T>::cell(std::size_t pos) const
+{
+    return &_cells[pos & _mask];
+}
+
+template <typename T>
+void MpmcQueue<T>::waitSequence(Cell* cell, std::size_t sequence)
+{
+    // the cell was claimed by another thread which is still copying its value
+    while (cell->sequence.load(std::memory_order_acquire) != sequence) {
+        std::this_thread::yield();
+    }
+}
+
+template <typename T>
+template <typename V>
+bool MpmcQueue<T>::emplace(V&& value)
+{
+    std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Cell* c;
+    while (true) {
+        c = cell(pos);
+        std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = std::ptrdiff_t(sequence - pos);
+        if (diff == 0) {
+            if (_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+    new (c->value()) T(std::forward<V>(value));
+    c->sequence.store(pos + 1, std::memory_order_release);
+    this->_notEmpty.notify(1);
+    return true;
+}
+
+template <typename T>
+inline bool MpmcQueue<T>::tryPush(const T& value)
+{
+    return emplace(value);
+}
+
+template <typename T>
+inline bool MpmcQueue<T>::tryPush(T&& value)
+{
+    return emplace(std::move(value));
+}
+
+template <typename T>
+std::size_t MpmcQueue<T>::tryPushMany(T* items, std::size_t count)
+{
+    if (count == 0) {
+        return 0;
+    }
+    std::size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    std::size_t n;
+    while (true) {
+        // cells below the consumer position were claimed on the previous lap and are free or being freed
+        std::size_t dequeuePos = _dequeuePos.load(std::memory_order_acquire);
+        n = std::min(count, capacity() - (pos - dequeuePos));
+        if (n == 0) {
+            return 0;
+        }
+        if (_enqueuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    for (std::size_t i = 0; i < n; i++) {
+        Cell* c = cell(pos + i);
+        waitSequence(c, pos + i);
+        new (c->value()) T(std::move(items[i]));
+        c->sequence.store(pos + i + 1, std::memory_order_release);
+    }
+    this->_notEmpty.notify(unsigned(n));
+    return n;
+}
+
+template <typename T>
+bool MpmcQueue<T>::tryPop(T* dest)
+{
+    std::size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+    Cell* c;
+    while (true) {
+        c = cell(pos);
+        std::size_t sequence = c->sequence.load(std::memory_order_acquire);
+        std::ptrdiff_t diff = std::ptrdiff_t(sequence - (pos + 1));
+        if (diff == 0) {
+            if (_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = _dequeuePos.load(std::memory_order_relaxed);
+        }
+    }
+    *dest = std::move(*c->value());
+    c->value()->~T();
+    c->sequence.store(pos + _mask + 1, std::memory_order_release);
+    this->_notFull.notify(1);
+    return true;
+}
+
+template <typename T>
+std::size_t MpmcQueue<T>::tryPopMany(T* dest, std::size_t maxCount)
+{
+    if (maxCount == 0) {
+        return 0;
+    }
+    std::size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+    std::size_t n;
+    while (true) {
+        // cells below the producer position are claimed and are written or being written
+        std::size_t enqueuePos = _enqueuePos.load(std::memory_order_acquire);
+        n = std::min(maxCount, enqueuePos - pos);
+        if (n == 0) {
+            return 0;
+        }
+        if (_dequeuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    for (std::size_t i = 0; i < n; i++) {
+        Cell* c = cell(pos + i);
+        waitSequence(c, pos + i + 1);
+        dest[i] = std::move(*c->value());
+        c->value()->~T();
+        c->sequence.store(pos + i + _mask + 1, std::memory_order_release);
+    }
+    this->_notFull.notify(unsigned(n));
+    return n;
+}
+
+// bounded single producer single consumer ring, each side caches the other side's position
+// and reads the shared one only when the cached value says the queue is full (empty)
+template <typename T>
+class SpscQueue : public BoundedQueueBase<T, SpscQueue<T>> {
+public:
+    // capacity is rounded up to a power of two
+    explicit SpscQueue(std::size_t capacity);
+    ~SpscQueue();
+
+    std::size_t capacity() const;
+    std::size_t sizeApprox() const;
+
+    // producer side
+    bool tryPush(const T& value);
+    bool tryPush(T&& value);
+    std::size_t tryPushMany(T* items, std::size_t count);
+
+    // consumer side
+    bool tryPop(T* dest);
+    std::size_t tryPopMany(T* dest, std::size_t maxCount);
+
+private:
+    using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+    template <typename V>
+    bool emplace(V&& value);
+    T* slot(std::size_t pos) const;
+
+    std::unique_ptr<Storage[]> _storage;
+    std::size_t _mask;
+    char _pad1[64];
+    // consumer position and the producer position last seen by the consumer
+    std::atomic<std::size_t> _head;
+    std::size_t _cachedTail;
+    char _pad2[64];
+    // producer position and the consumer position last seen by the producer
+    std::atomic<std::size_t> _tail;
+    std::size_t _cachedHead;
+    char _pad3[64];
+};
+
+template <typename T>
+SpscQueue<T>::SpscQueue(std::size_t capacity)
+    : _head(0)
+    , _cachedTail(0)
+    , _tail(0)
+    , _cachedHead(0)
+{
+    capacity = this->roundCapacity(capacity);
+    _storage.reset(new Storage[capacity]);
+    _mask = capacity - 1;
+}
+
+template <typename T>
+SpscQueue<T>::~SpscQueue()
+{
+    std::size_t end = _tail.load(std::memory_order_relaxed);
+    for (std::size_t pos = _head.load(std::memory_order_relaxed); pos != end; pos++) {
+        slot(pos)->~T();
+    }
+}
+
+template <typename T>
+inline std::size_t SpscQueue<T>::capacity() const
+{
+    return _mask + 1;
+}
+
+template <typename T>
+inline std::size_t SpscQueue<T>::sizeApprox() const
+{
+    std::size_t head = _head.load(std::memory_order_acquire);
+    std::size_t tail = _tail.load(std::memory_order_acquire);
+    return std::min(tail - head, capacity());
+}
+
+template <typename T>
+inline T* SpscQueue<T>::slot(std::size_t pos) const
+{
+    return reinterpret_cast<T*>(&_storage[pos & _mask]);
+}
+
+template <typename T>
+template <typename V>
+bool SpscQueue<T>::emplace(V&& value)
+{
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _cachedHead == capacity()) {
+        _cachedHead = _head.load(std::memory_order_acquire);
+        if (tail - _cachedHead == capacity()) {
+            return false;
+        }
+    }
+    new (slot(tail)) T(std::forward<V>(value));
+    _tail.store(tail + 1, std::memory_order_release);
+    this->_notEmpty.notify(1);
+    return true;
+}
+
+template <typename T>
+inline bool SpscQueue<T>::tryPush(const T& value)
+{
+    return emplace(value);
+}
+
+template <typename T>
+inline bool SpscQueue<T>::tryPush(T&& value)
+{
+    return emplace(std::move(value));
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::tryPushMany(T* items, std::size_t count)
+{
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+    std::size_t n = std::min(count, capacity() - (tail - _cachedHead));
+    if (n < count) {
+        _cachedHead = _head.load(std::memory_order_acquire);
+        n = std::min(count, capacity() - (tail - _cachedHead));
+    }
+    if (n == 0) {
+        return 0;
+    }
+    for (std::size_t i = 0; i < n; i++) {
+        new (slot(tail + i)) T(std::move(items[i]));
+    }
+    _tail.store(tail + n, std::memory_order_release);
+    this->_notEmpty.notify(1);
+    return n;
+}
+
+template <typename T>
+bool SpscQueue<T>::tryPop(T* dest)
+{
+    std::size_t head = _head.load(std::memory_order_relaxed);
+    if (head == _cachedTail) {
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        if (head == _cachedTail) {
+            return false;
+        }
+    }
+    T* value = slot(head);
+    *dest = std::move(*value);
+    value->~T();
+    _head.store(head + 1, std::memory_order_release);
+    this->_notFull.notify(1);
+    return true;
+}
+
+template <typename T>
+std::size_t SpscQueue<T>::tryPopMany(T* dest, std::size_t maxCount)
+{
+    std::size_t head = _head.load(std::memory_order_relaxed);
+    std::size_t n = std::min(maxCount, _cachedTail - head);
+    if (n < maxCount) {
+        _cachedTail = _tail.load(std::memory_order_acquire);
+        n = std::min(maxCount, _cachedTail - head);
+    }
+    if (n == 0) {
+        return 0;
+    }
+    for (std::size_t i = 0; i < n; i++) {
+        T* value = slot(head + i);
+        dest[i] = std::move(*value);
+        value->~T();
+    }
+    _head.store(head + n, std::memory_order_release);
+    this->_notFull.notify(1);
+    return n;
+}
+}
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/EventLoop.h"
+
+#if defined(BMCL_PLATFORM_LINUX)
+
+#include "bmcl/Assert.h"
+#include "bmcl/RingBuffer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <functional>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace bmcl {
+
+// events fetched by one epoll_wait call
+static const int maxEvents = 64;
+
+struct EventLoop::Entry {
+    int fd;
+    bool isStream;
+    bool isRemoved;
+    bool isReadPaused;
+    // hangup or error was reported, the next reads continue until end of stream
+    bool isHangUp;
+    IoCallback callback;
+    RingBuffer* input;
+    RingBuffer* output;
+    InputCallback onInput;
+    CloseCallback onClose;
+};
+
+EventLoop::EventLoop()
+    : _epollFd(::epoll_create1(EPOLL_CLOEXEC))
+    , _wakeFd(::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+    , _isStopped(false)
+    , _nextTimerId(1)
+{
+    if (_epollFd != -1 && _wakeFd != -1) {
+        epoll_event event;
+        event.events = EPOLLIN;
+        event.data.fd = _wakeFd;
+        ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &event);
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    if (_epollFd != -1) {
+        ::close(_epollFd);
+    }
+    if (_wakeFd != -1) {
+        ::close(_wakeFd);
+    }
+}
+
+static uint32_t toEpollEvents(unsigned events)
+{
+    uint32_t epollEvents = EPOLLET;
+    if (events & EventLoop::Readable) {
+        epollEvents |= EPOLLIN | EPOLLRDHUP;
+    }
+    if (events & EventLoop::Writable) {
+        epollEvents |= EPOLLOUT;
+    }
+    return epollEvents;
+}
+
+static unsigned fromEpollEvents(uint32_t epollEvents)
+{
+    unsigned events = 0;
+    if (epollEvents & EPOLLIN) {
+        events |= EventLoop::Readable;
+    }
+    if (epollEvents & EPOLLOUT) {
+        events |= EventLoop::Writable;
+    }
+    if (epollEvents & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+        events |= EventLoop::Error;
+    }
+    return events;
+}
+
+bool EventLoop::add(int fd, unsigned events, IoCallback callback)
+{
+    if (contains(fd)) {
+        return false;
+    }
+    epoll_event event;
+    event.events = toEpollEvents(events);
+    event.data.fd = fd;
+    if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return false;
+    }
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->fd = fd;
+    entry->isStream = false;
+    entry->isRemoved = false;
+    entry->isReadPaused = false;
+    entry->isHangUp = false;
+    entry->callback = std::move(callback);
+    entry->input = nullptr;
+    entry->output = nullptr;
+    _entries.emplace(fd, std::move(entry));
+    return true;
+}
+
+bool EventLoop::addStream(int fd, RingBuffer* input, RingBuffer* output, InputCallback onInput, CloseCallback onClose)
+{
+    if (contains(fd)) {
+        return false;
+    }
+    epoll_event event;
+    event.events = toEpollEvents((input ? unsigned(Readable) : 0u) | (output ? unsigned(Writable) : 0u));
+    event.data.fd = fd;
+    if (::epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event) != 0) {
+        return false;
+    }
+    std::unique_ptr<Entry> entry(new Entry);
+    entry->fd = fd;
+    entry->isStream = true;
+    entry->isRemoved = false;
+    entry->isReadPaused = false;
+    entry->isHangUp = false;
+    entry->input = input;
+    entry->output = output;
+    entry->onInput = std::move(onInput);
+    entry->onClose = std::move(onClose);
+    _entries.emplace(fd, std::move(entry));
+    return true;
+}
+
+bool EventLoop::contains(int fd) const
+{
+    return _entries.find(fd) != _entries.end();
+}
+
+bool EventLoop::remove(int fd)
+{
+    auto it = _entries.find(fd);
+    if (it == _entries.end()) {
+        return false;
+    }
+    ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    it->second->isRemoved = true;
+    // the entry may be running one of its callbacks
+    _removed.push_back(std::move(it->second));
+    _entries.erase(it);
+    return true;
+}
+
+void EventLoop::close(Entry* entry, int error)
+{
+    remove(entry->fd);
+    if (entry->onClose) {
+        entry->onClose(error);
+    }
+}
+
+// returns false if the entry was removed
+bool EventLoop::readStream(Entry* entry)
+{
+    RingBuffer* input = entry->input;
+    bool hasData = false;
+    while (true) {
+        if (input->isFull()) {
+            if (entry->onInput) {
+                entry->onInput(input);
+                if (entry->isRemoved) {
+                    return false;
+                }
+            }
+            hasData = false;
+            if (input->isFull()) {
+                // with edge triggering the rest is read only after resumeRead()
+                entry->isReadPaused = true;
+                return true;
+            }
+        }
+        RingBuffer::WritableChunks chunks = input->writableChunks();
+        iovec vecs[2];
+        vecs[0].iov_base = chunks.first;
+        vecs[0].iov_len = chunks.firstSize;
+        vecs[1].iov_base = chunks.second;
+        vecs[1].iov_len = chunks.secondSize;
+        ssize_t rv = ::readv(entry->fd, vecs, chunks.secondSize ? 2 : 1);
+        if (rv > 0) {
+            input->advance(std::size_t(rv));
+            hasData = true;
+            // a short read from a stream means its buffer is empty, after a hangup the end of stream is read too
+            if (!entry->isHangUp && std::size_t(rv) < chunks.firstSize + chunks.secondSize) {
+                break;
+            }
+        } else if (rv == 0) {
+            if (hasData && entry->onInput) {
+                entry->onInput(input);
+                if (entry->isRemoved) {
+                    return false;
+                }
+            }
+            close(entry, 0);
+            return false;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            break;
+        } else {
+            close(entry, errno);
+            return false;
+        }
+    }
+    if (hasData && entry->onInput) {
+        entry->onInput(input);
+        if (entry->isRemoved) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// returns false if the entry was removed
+bool EventLoop::writeStream(Entry* entry)
+{
+    RingBuffer* output = entry->output;
+    while (!output->isEmpty()) {
+        RingBuffer::Chunks chunks = output->readableChunks();
+        iovec vecs[2];
+        vecs[0].iov_base = (void*)chunks.first.data();
+        vecs[0].iov_len = chunks.first.size();
+        vecs[1].iov_base = (void*)chunks.second.data();
+        vecs[1].iov_len = chunks.second.size();
+        ssize_t rv = ::writev(entry->fd, vecs, chunks.second.isEmpty() ? 1 : 2);
+        if (rv >= 0) {
+            output->erase(std::size_t(rv));
+        } else if (errno == EINTR) {
+            continue;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            // continued on the next writable edge
+            return true;
+        } else {
+            close(entry, errno);
+            return false;
+        }
+    }
+    return true;
+}
+
+void EventLoop::handleStream(Entry* entry, unsigned events)
+{
+    if (events & Error) {
+        entry->isHangUp = true;
+    }
+    if ((events & (Readable | Error)) && entry->input && !entry->isReadPaused) {
+        if (!readStream(entry)) {
+            return;
+        }
+    }
+    if ((events & (Writable | Error)) && entry->output) {
+        if (!writeStream(entry)) {
+            return;
+        }
+    }
+    if ((events & Error) && !entry->input) {
+        // nothing to read the error or end of stream from
+        close(entry, 0);
+    }
+}
+
+void EventLoop::flush(int fd)
+{
+    auto it = _entries.find(fd);
+    if (it != _entries.end() && it->second->output) {
+        writeStream(it->second.get());
+    }
+}
+
+void EventLoop::resumeRead(int fd)
+{
+    auto it = _entries.find(fd);
+    if (it != _entries.end() && it->second->isReadPaused) {
+        it->second->isReadPaused = false;
+        readStream(it->second.get());
+    }
+}
+
+EventLoop::TimerId EventLoop::addTimer(Clock::duration delay, TimerCallback callback, Clock::duration interval)
+{
+    TimerId id = _nextTimerId++;
+    Timer timer;
+    timer.callback = std::move(callback);
+    timer.interval = interval;
+    _timers.emplace(id, std::move(timer));
+    TimerDeadline deadline;
+    deadline.deadline = Clock::now() + delay;
+    deadline.id = id;
+    _deadlines.push_back(deadline);
+    std::push_heap(_deadlines.begin(), _deadlines.end(), std::greater<TimerDeadline>());
+    return id;
+}
+
+bool EventLoop::cancelTimer(TimerId id)
+{
+    return _timers.erase(id) != 0;
+}
+
+std::size_t EventLoop::runTimers()
+{
+    std::size_t count = 0;
+    Clock::time_point now = Clock::now();
+    while (!_deadlines.empty() && _deadlines.front().deadline <= now) {
+        TimerDeadline top = _deadlines.front();
+        std::pop_heap(_deadlines.begin(), _deadlines.end(), std::greater<TimerDeadline>());
+        _deadlines.pop_back();
+        auto it = _timers.find(top.id);
+        if (it == _timers.end()) {
+            continue;
+        }
+        // the callback may cancel its own timer or add new ones
+        TimerCallback callback = std::move(it->second.callback);
+        if (it->second.interval == Clock::duration::zero()) {
+            _timers.erase(it);
+            callback();
+        } else {
+            // missed periods are skipped instead of firing in a burst
+            top.deadline = std::max(top.deadline + it->second.interval, now);
+            _deadlines.push_back(top);
+            std::push_heap(_deadlines.begin(), _deadlines.end(), std::greater<TimerDeadline>());
+            callback();
+            it = _timers.find(top.id);
+            if (it != _timers.end()) {
+                it->second.callback = std::move(callback);
+            }
+        }
+        count++;
+    }
+    return count;
+}
+
+int EventLoop::waitTimeout(Clock::duration timeout) const
+{
+    if (!_deadlines.empty()) {
+        Clock::duration untilDeadline = _deadlines.front().deadline - Clock::now();
+        timeout = std::min(timeout, std::max(untilDeadline, Clock::duration::zero()));
+    } else if (timeout == Clock::duration::max()) {
+        return -1;
+    }
+    // rounded up so that timers are never early
+    std::chrono::milliseconds ms = std::chrono::duration_cast<std::chrono::milliseconds>(timeout);
+    if (ms < timeout) {
+        ms += std::chrono::milliseconds(1);
+    }
+    return int(std::min<std::chrono::milliseconds::rep>(ms.count(), INT_MAX));
+}
+
+std::size_t EventLoop::runOnce(Clock::duration timeout)
+{
+    std::size_t count = 0;
+    epoll_event events[maxEvents];
+    int n = ::epoll_wait(_epollFd, events, maxEvents, waitTimeout(timeout));
+    for (int i = 0; i < n; i++) {
+        int fd = events[i].data.fd;
+        if (fd == _wakeFd) {
+            uint64_t value;
+            while (::read(_wakeFd, &value, sizeof(value)) > 0) {
+            }
+            continue;
+        }
+        auto it = _entries.find(fd);
+        if (it == _entries.end()) {
+            continue;
+        }
+        Entry* entry = it->second.get();
+        unsigned ready = fromEpollEvents(events[i].events);
+        if (entry->isStream) {
+            handleStream(entry, ready);
+        } else {
+            entry->callback(ready);
+        }
+        count++;
+    }
+    count += runTimers();
+    _removed.clear();
+    return count;
+}
+
+void EventLoop::run()
+{
+    while (!_isStopped.load(std::memory_order_acquire)) {
+        runOnce(Clock::duration::max());
+    }
+    _isStopped.store(false, std::memory_order_release);
+}
+
+void EventLoop::stop()
+{
+    _isStopped.store(true, std::memory_order_release);
+    wakeUp();
+}
+
+void EventLoop::wakeUp()
+{
+    uint64_t value = 1;
+    ssize_t rv = ::write(_wakeFd, &value, sizeof(value));
+    (void)rv;
+}
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+
+#if defined(BMCL_PLATFORM_LINUX)
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace bmcl {
+
+class RingBuffer;
+
+// single threaded edge triggered epoll reactor (linux only)
+// stream endpoints read straight into RingBuffer free space and write from RingBuffer contents with readv/writev
+// file descriptors stay owned by the caller and must be removed before they are closed
+// only stop() and wakeUp() may be called from other threads
+class BMCL_EXPORT EventLoop {
+public:
+    // not the coarse clock, its readings lag by up to a tick and timers would fire early
+    using Clock = std::chrono::steady_clock;
+    using TimerId = uint64_t;
+
+    enum Events : unsigned {
+        Readable = 1,
+        Writable = 2,
+        // error or hangup, reported with the other events
+        Error = 4,
+    };
+
+    using IoCallback = std::function<void(unsigned events)>;
+    using TimerCallback = std::function<void()>;
+    // called after new data was appended to the input buffer
+    using InputCallback = std::function<void(RingBuffer* input)>;
+    // end of stream (error 0) or read/write errno, the fd is removed from the loop before the call
+    using CloseCallback = std::function<void(int error)>;
+
+    EventLoop();
+    EventLoop(const EventLoop& other) = delete;
+    ~EventLoop();
+
+    EventLoop& operator=(const EventLoop& other) = delete;
+
+    // false if epoll or eventfd couldn't be created
+    bool isValid() const;
+
+    // fd must be non blocking, callbacks get readiness edges
+    bool add(int fd, unsigned events, IoCallback callback);
+
+    // non blocking stream fd (socket, pipe, tty), either buffer may be null
+    // readable data is read until EAGAIN or until input is full, in the latter case onInput is called
+    // and reading continues if it made room, otherwise the endpoint waits for resumeRead()
+    bool addStream(int fd, RingBuffer* input, RingBuffer* output, InputCallback onInput, CloseCallback onClose);
+    // writes output contents, the rest is written when the fd becomes writable
+    void flush(int fd);
+    // continues reading after the input buffer of a paused endpoint was drained
+    void resumeRead(int fd);
+
+    // safe to call from callbacks, including the fd's own
+    bool remove(int fd);
+    bool contains(int fd) const;
+
+    // callback is called after delay and then every interval if it is not zero
+    TimerId addTimer(Clock::duration delay, TimerCallback callback, Clock::duration interval = Clock::duration::zero());
+    bool cancelTimer(TimerId id);
+
+    // handles events until stop()
+    void run();
+    // waits at most timeout for events or timers and handles them, returns number of callbacks called
+    std::size_t runOnce(Clock::duration timeout);
+    void stop();
+    // interrupts a waiting runOnce()
+    void wakeUp();
+
+private:
+    struct Entry;
+
+    struct Timer {
+        TimerCallback callback;
+        Clock::duration interval;
+    };
+
+    struct TimerDeadline {
+        bool operator>(const TimerDeadline& other) const
+        {
+            return deadline > other.deadline;
+        }
+
+        Clock::time_point deadline;
+        TimerId id;
+    };
+
+    void handleStream(Entry* entry, unsigned events);
+    bool readStream(Entry* entry);
+    bool writeStream(Entry* entry);
+    void close(Entry* entry, int error);
+    std::size_t runTimers();
+    int waitTimeout(Clock::duration timeout) const;
+
+    int _epollFd;
+    int _wakeFd;
+    std::atomic<bool> _isStopped;
+    std::unordered_map<int, std::unique_ptr<Entry>> _entries;
+    // removed during callbacks, destroyed after event handling
+    std::vector<std::unique_ptr<Entry>> _removed;
+    std::unordered_map<TimerId, Timer> _timers;
+    // min heap on deadline, canceled timers are skipped when they reach the top
+    std::vector<TimerDeadline> _deadlines;
+    TimerId _nextTimerId;
+};
+
+inline bool EventLoop::isValid() const
+{
+    return _epollFd != -1 && _wakeFd != -1;
+}
+}
+
+#endif
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/FileLogSink.h"
+#include "bmcl/Panic.h"
+#include "bmcl/Result.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#if defined(BMCL_PLATFORM_WINDOWS)
+# include <io.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+#else
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+namespace bmcl {
+
+FileLogSinkConfig::FileLogSinkConfig(const std::string& path)
+    : path(path)
+    , bufferSize(256 * 1024)
+    , maxFileSize(0)
+    , maxFileAge(0)
+    , maxRotatedFiles(5)
+    , syncInterval(0)
+    , flushLevel(LogLevel::Critical)
+{
+}
+
+static std::mutex openSinksMutex;
+static std::vector<FileLogSink*> openSinks;
+
+// locks the sink and records the owning thread for trySync()
+class FileLogSink::Lock {
+public:
+    explicit Lock(FileLogSink* sink)
+        : _sink(sink)
+    {
+        _sink->_mutex.lock();
+        _sink->_lockOwner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    }
+
+    ~Lock()
+    {
+        _sink->_lockOwner.store(std::thread::id(), std::memory_order_relaxed);
+        _sink->_mutex.unlock();
+    }
+
+private:
+    Lock(const Lock&) = delete;
+    Lock& operator=(const Lock&) = delete;
+
+    FileLogSink* _sink;
+};
+
+FileLogSink::FileLogSink(const FileLogSinkConfig& config)
+    : _config(config)
+    , _lockOwner(std::thread::id())
+    , _buffer(BMCL_MAX(config.bufferSize, std::size_t(4096)))
+    , _bufferUsed(0)
+    , _fd(-1)
+    , _fileSize(0)
+    , _syncedSize(0)
+    , _isTimerStopping(false)
+{
+}
+
+FileLogSink::~FileLogSink()
+{
+    stopTimer();
+    {
+        std::lock_guard<std::mutex> lock(openSinksMutex);
+        openSinks.erase(std::remove(openSinks.begin(), openSinks.end(), this), openSinks.end());
+    }
+    if (_fd != -1) {
+        writeBuffer();
+        closeFile();
+    }
+}
+
+Result<std::shared_ptr<FileLogSink>, int> FileLogSink::open(const FileLogSinkConfig& config)
+{
+    std::shared_ptr<FileLogSink> sink(new FileLogSink(config));
+    int rv = sink->openFile();
+    if (rv != 0) {
+        return rv;
+    }
+    addPanicFlushHook(flushFileLogSinks, PanicFlushStage::Sync);
+    {
+        std::lock_guard<std::mutex> lock(openSinksMutex);
+        openSinks.push_back(sink.get());
+    }
+    sink->startTimer();
+    return sink;
+}
+
+const FileLogSinkConfig& FileLogSink::config() const
+{
+    return _config;
+}
+
+uint64_t FileLogSink::fileSize()
+{
+    Lock lock(this);
+    return _fileSize + _bufferUsed;
+}
+
+int FileLogSink::openFile()
+{
+#if defined(BMCL_PLATFORM_WINDOWS)
+    _fd = _open(_config.path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    _fd = ::open(_config.path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+#endif
+    if (_fd == -1) {
+        return errno;
+    }
+#if defined(BMCL_PLATFORM_WINDOWS)
+    __int64 size = _lseeki64(_fd, 0, SEEK_END);
+#else
+    off_t size = ::lseek(_fd, 0, SEEK_END);
+#endif
+    _fileSize = size > 0 ? uint64_t(size) : 0;
+    _openTime = CoarseMonotonicClock::now();
+    _syncTime = _openTime;
+    _syncedSize = _fileSize;
+    return 0;
+}
+
+void FileLogSink::closeFile()
+{
+#if defined(BMCL_PLATFORM_WINDOWS)
+    _close(_fd);
+#else
+    ::close(_fd);
+#endif
+    _fd = -1;
+}
+
+void FileLogSink::syncFile()
+{
+#if defined(BMCL_PLATFORM_WINDOWS)
+    _commit(_fd);
+#elif defined(BMCL_PLATFORM_LINUX)
+    ::fdatasync(_fd);
+#else
+    ::fsync(_fd);
+#endif
+    _syncTime = CoarseMonotonicClock::now();
+    _syncedSize = _fileSize;
+}
+
+void FileLogSink::startTimer()
+{
+    if (_config.syncInterval.count() == 0 && _config.maxFileAge.count() == 0) {
+        return;
+    }
+    _timerThread = std::thread(&FileLogSink::runTimer, this);
+}
+
+void FileLogSink::stopTimer()
+{
+    if (!_timerThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_timerMutex);
+        _isTimerStopping = true;
+    }
+    _timerCv.notify_one();
+    _timerThread.join();
+}
+
+void FileLogSink::runTimer()
+{
+    std::unique_lock<std::mutex> lock(_timerMutex);
+    while (!_isTimerStopping) {
+        lock.unlock();
+        CoarseMonotonicClock::duration timeout = handleTimer();
+        lock.lock();
+        _timerCv.wait_for(lock, timeout, [this]() { return _isTimerStopping; });
+    }
+}
+
+CoarseMonotonicClock::duration FileLogSink::handleTimer()
+{
+    Lock lock(this);
+    CoarseTime now = CoarseMonotonicClock::now();
+    CoarseTime next = CoarseTime::max();
+    if (_config.maxFileAge.count() != 0) {
+        if (_fd != -1 && now - _openTime >= _config.maxFileAge && _fileSize + _bufferUsed != 0) {
+            rotate();
+        }
+        // an empty aged file is rotated after the first write
+        next = _openTime + _config.maxFileAge;
+        if (_fd == -1 || next <= now) {
+            next = now + _config.maxFileAge;
+        }
+    }
+    if (_config.syncInterval.count() != 0) {
+        bool isDirty = _bufferUsed != 0 || _fileSize != _syncedSize;
+        if (_fd != -1 && isDirty && now - _syncTime >= _config.syncInterval) {
+            writeBuffer();
+            syncFile();
+        }
+        CoarseTime nextSync = _syncTime + _config.syncInterval;
+        if (nextSync <= now) {
+            nextSync = now + _config.syncInterval;
+        }
+        next = BMCL_MIN(next, nextSync);
+    }
+    return next - now;
+}
+
+void FileLogSink::writeToFile(const char* data, std::size_t size)
+{
+    while (size != 0) {
+#if defined(BMCL_PLATFORM_WINDOWS)
+        int rv = _write(_fd, data, unsigned(BMCL_MIN(size, std::size_t(1 << 30))));
+#else
+        ssize_t rv = ::write(_fd, data, size);
+#endif
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // nowhere to report the error, data is discarded
+            return;
+        }
+        data += rv;
+        size -= std::size_t(rv);
+        _fileSize += uint64_t(rv);
+    }
+}
+
+void FileLogSink::writeBuffer()
+{
+    writeToFile(_buffer.data(), _bufferUsed);
+    _bufferUsed = 0;
+}
+
+static std::string rotatedPath(const std::string& path, unsigned index)
+{
+    return path + '.' + std::to_string(index);
+}
+
+void FileLogSink::rotate()
+{
+    writeBuffer();
+    closeFile();
+    if (_config.maxRotatedFiles == 0) {
+        std::remove(_config.path.c_str());
+    } else {
+        std::remove(rotatedPath(_config.path, _config.maxRotatedFiles).c_str());
+        for (unsigned i = _config.maxRotatedFiles - 1; i > 0; i--) {
+            std::rename(rotatedPath(_config.path, i).c_str(), rotatedPath(_config.path, i + 1).c_str());
+        }
+        std::rename(_config.path.c_str(), rotatedPath(_config.path, 1).c_str());
+    }
+    // if reopening fails messages are dropped until the next rotation attempt
+    openFile();
+}
+
+void FileLogSink::write(LogLevel level, const char* msg)
+{
+    write(level, std::time(nullptr), msg, std::strlen(msg));
+}
+
+void FileLogSink::write(LogLevel level, std::time_t t, const char* msg, std::size_t size)
+{
+    if ((int)level > (int)logLevel() || level == LogLevel::None) {
+        return;
+    }
+    Lock lock(this);
+    if (_fd == -1) {
+        openFile();
+        if (_fd == -1) {
+            return;
+        }
+    }
+    CoarseTime now = CoarseMonotonicClock::now();
+    bool isTooBig = _config.maxFileSize != 0 && _fileSize + _bufferUsed >= _config.maxFileSize;
+    bool isTooOld = _config.maxFileAge.count() != 0 && now - _openTime >= _config.maxFileAge;
+    if ((isTooBig || isTooOld) && _fileSize + _bufferUsed != 0) {
+        rotate();
+        if (_fd == -1) {
+            return;
+        }
+    }
+
+    // time (19) + ' ' + prefix (9) + ' ' + msg + '\n'
+    std::size_t lineSize = CachedTimeFormatter::formattedSize + 11 + size + 1;
+    if (_buffer.size() - _bufferUsed < lineSize) {
+        writeBuffer();
+    }
+    if (lineSize > _buffer.size()) {
+        writeToFile(formatLocalTime(t), CachedTimeFormatter::formattedSize);
+        writeToFile(" ", 1);
+        writeToFile(logLevelPrefix(level), std::strlen(logLevelPrefix(level)));
+        writeToFile(" ", 1);
+        writeToFile(msg, size);
+        writeToFile("\n", 1);
+    } else {
+        char* dest = _buffer.data() + _bufferUsed;
+        std::memcpy(dest, formatLocalTime(t), CachedTimeFormatter::formattedSize);
+        dest += CachedTimeFormatter::formattedSize;
+        *dest++ = ' ';
+        std::size_t prefixSize = std::strlen(logLevelPrefix(level));
+        std::memcpy(dest, logLevelPrefix(level), prefixSize);
+        dest += prefixSize;
+        *dest++ = ' ';
+        std::memcpy(dest, msg, size);
+        dest += size;
+        *dest++ = '\n';
+        _bufferUsed = dest - _buffer.data();
+    }
+
+    if ((int)level <= (int)_config.flushLevel) {
+        writeBuffer();
+        syncFile();
+    } else if (_config.syncInterval.count() != 0 && now - _syncTime >= _config.syncInterval) {
+        writeBuffer();
+        syncFile();
+    }
+}
+
+void FileLogSink::flush()
+{
+    Lock lock(this);
+    if (_fd != -1) {
+        writeBuffer();
+    }
+}
+
+void FileLogSink::sync()
+{
+    Lock lock(this);
+    if (_fd != -1) {
+        writeBuffer();
+        syncFile();
+    }
+}
+
+LogHandler FileLogSink::handler()
+{
+    std::shared_ptr<FileLogSink> self = shared_from_this();
+    return [self](LogLevel level, const char* msg) {
+        self->write(level, msg);
+    };
+}
+
+void FileLogSink::trySync()
+{
+    // try_lock on a mutex already held by the calling thread is undefined
+    if (_lockOwner.load(std::memory_order_relaxed) == std::this_thread::get_id() || !_mutex.try_lock()) {
+        return;
+    }
+    _lockOwner.store(std::this_thread::get_id(), std::memory_order_relaxed);
+    if (_fd != -1) {
+        writeBuffer();
+        syncFile();
+    }
+    _lockOwner.store(std::thread::id(), std::memory_order_relaxed);
+    _mutex.unlock();
+}
+
+Result<std::shared_ptr<FileLogSink>, int> setFileLogHandler(const FileLogSinkConfig& config)
+{
+    Result<std::shared_ptr<FileLogSink>, int> sink = FileLogSink::open(config);
+    if (sink.isOk()) {
+        setLogHandler(sink.unwrap()->handler());
+    }
+    return sink;
+}
+
+void flushFileLogSinks()
+{
+    if (!openSinksMutex.try_lock()) {
+        return;
+    }
+    for (FileLogSink* sink : openSinks) {
+        sink->trySync();
+    }
+    openSinksMutex.unlock();
+}
+}
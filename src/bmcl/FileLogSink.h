@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Logging.h"
+#include "bmcl/TimeUtils.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bmcl {
+
+template <typename T, typename E>
+class Result;
+
+struct BMCL_EXPORT FileLogSinkConfig {
+    FileLogSinkConfig(const std::string& path);
+
+    std::string path;
+    // lines are collected in userspace and written with one write call when full
+    std::size_t bufferSize;
+    // current file is renamed to path.1, path.1 to path.2 and so on, 0 disables rotation by size or age
+    // size is checked on write, age is also checked by a background thread so an idle file is rotated too
+    uint64_t maxFileSize;
+    std::chrono::seconds maxFileAge;
+    unsigned maxRotatedFiles;
+    // buffer is written and the file is fdatasync'ed if this much time passed since the last sync, 0 disables
+    // checked on write and by a background thread, data is synced at most this long after it was logged
+    std::chrono::milliseconds syncInterval;
+    // messages of this level or more severe are written and synced immediately
+    LogLevel flushLevel;
+};
+
+// buffered log file with rotation, lines have the same format as the default handler without colors
+// all open sinks are synced by a panic flush hook before panic() aborts
+class BMCL_EXPORT FileLogSink : public std::enable_shared_from_this<FileLogSink> {
+public:
+    ~FileLogSink();
+
+    static Result<std::shared_ptr<FileLogSink>, int> open(const FileLogSinkConfig& config);
+
+    const FileLogSinkConfig& config() const;
+    // size of the current file including buffered data
+    uint64_t fileSize();
+
+    void write(LogLevel level, const char* msg);
+    void write(LogLevel level, std::time_t t, const char* msg, std::size_t size);
+    // writes buffered data to the file
+    void flush();
+    // flush() followed by fdatasync
+    void sync();
+    // same as sync() but does nothing if the sink is in use by another call, including one on the calling thread
+    void trySync();
+
+    // handler holding a reference to this sink
+    LogHandler handler();
+
+private:
+    class Lock;
+
+    FileLogSink(const FileLogSinkConfig& config);
+    FileLogSink(const FileLogSink&) = delete;
+    FileLogSink& operator=(const FileLogSink&) = delete;
+
+    int openFile();
+    void closeFile();
+    void rotate();
+    void writeBuffer();
+    void writeToFile(const char* data, std::size_t size);
+    void syncFile();
+    void startTimer();
+    void stopTimer();
+    void runTimer();
+    // syncs and rotates by age if due, returns time until the next check
+    CoarseMonotonicClock::duration handleTimer();
+
+    FileLogSinkConfig _config;
+    std::mutex _mutex;
+    // thread holding _mutex, trySync() may run on a panicking thread inside a call that holds it
+    std::atomic<std::thread::id> _lockOwner;
+    std::vector<char> _buffer;
+    std::size_t _bufferUsed;
+    int _fd;
+    uint64_t _fileSize;
+    CoarseTime _openTime;
+    CoarseTime _syncTime;
+    uint64_t _syncedSize;
+    // started by open() if syncInterval or maxFileAge is set
+    std::thread _timerThread;
+    std::mutex _timerMutex;
+    std::condition_variable _timerCv;
+    bool _isTimerStopping;
+};
+
+// opens a sink and sets its handler as the current log handler
+BMCL_EXPORT Result<std::shared_ptr<FileLogSink>, int> setFileLogHandler(const FileLogSinkConfig& config);
+// writes and syncs buffered data of all open sinks, registered as a panic flush hook by open()
+// best effort, sinks locked at the moment are skipped
+BMCL_EXPORT void flushFileLogSinks();
+}
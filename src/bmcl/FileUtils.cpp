@@ -12,23 +12,35 @@
 #include "bmcl/Option.h"
 #include "bmcl/Buffer.h"
 #include "bmcl/SharedBytes.h"
+#include "bmcl/ArrayView.h"
 
 #include <cstdio>
 #include <cstdlib>
 #include <cerrno>
 #include <string>
+#include <memory>
 #include <mutex>
 #include <cinttypes>
+#include <cstdint>
+#include <atomic>
+#include <thread>
 
 #if defined(BMCL_PLATFORM_WINDOWS)
 # include <windows.h>
 # include <shlwapi.h>
+# include <io.h>
+# include <fcntl.h>
+# include <sys/stat.h>
 #elif defined(BMCL_PLATFORM_UNIX)
 # include <sys/types.h>
+# include <sys/stat.h>
+# include <fcntl.h>
 # include <unistd.h>
 # include <limits.h>
 # include <libgen.h>
 #elif defined(BMCL_PLATFORM_APPLE)
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <libgen.h>
 #include <mach-o/dyld.h>
@@ -36,75 +48,480 @@
     #error "unsupported platform"
 #endif
 
+#if defined(BMCL_PLATFORM_LINUX) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  define BMCL_HAS_IO_URING
+#  include "bmcl/bits/IoUring.h"
+# endif
+#endif
+
 namespace bmcl {
 
 class FileGuard {
 public:
-    explicit FileGuard(std::FILE* file)
-        : _file(file)
+    explicit FileGuard(int fd)
+        : _fd(fd)
     {
     }
 
     ~FileGuard()
     {
-        std::fclose(_file);
+#if defined(BMCL_PLATFORM_WINDOWS)
+        _close(_fd);
+#else
+        ::close(_fd);
+#endif
     }
 
 private:
-    std::FILE* _file;
+    int _fd;
 };
 
-template <typename T, typename C>
-Result<T, int> readFile(const char* path, C&& create)
+#if !defined(BMCL_PLATFORM_WINDOWS)
+static_assert(sizeof(off_t) == 8, "large file support is required, build with _FILE_OFFSET_BITS=64");
+#endif
+
+// opens the file, gets its size with fstat and reads it straight into memory returned by prepare(size),
+// files that don't fit into size_t fail with EFBIG
+// returns errno
+template <typename C>
+static int readFile(const char* path, C&& prepare)
 {
-    std::FILE* file = std::fopen(path, "rb");
-    if (!file) {
+#if defined(BMCL_PLATFORM_WINDOWS)
+    int fd = _open(path, _O_RDONLY | _O_BINARY);
+#else
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+#endif
+    if (fd == -1) {
         return errno;
     }
+    FileGuard guard(fd);
 
-    FileGuard guard(file);
-    if (std::fseek(file, 0, SEEK_END)) {
+#if defined(BMCL_PLATFORM_WINDOWS)
+    struct _stat64 st;
+    if (_fstat64(fd, &st) != 0) {
         return errno;
     }
-
-    long size = std::ftell(file);
-
-    if (size == -1) {
-        return errno;
+    if (st.st_mode & _S_IFDIR) {
+        return EISDIR;
     }
-
-    if (std::fseek(file, 0, SEEK_SET)) {
+#else
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
         return errno;
     }
-
-    T buf = create(size);
-
-    if (std::fread((void*)buf.data(), 1, size, file) != std::size_t(size)) {
-        return errno;
+    if (S_ISDIR(st.st_mode)) {
+        return EISDIR;
+    }
+#endif
+    std::uint64_t fileSize = std::uint64_t(st.st_size);
+    if (fileSize > std::uint64_t(SIZE_MAX)) {
+        return EFBIG;
     }
 
-    return buf;
+    std::size_t size = std::size_t(fileSize);
+    std::uint8_t* dest = prepare(size);
+    std::size_t done = 0;
+    while (done != size) {
+#if defined(BMCL_PLATFORM_WINDOWS)
+        int rv = _read(fd, dest + done, unsigned(BMCL_MIN(size - done, std::size_t(1) << 30)));
+#else
+        ssize_t rv = ::read(fd, dest + done, size - done);
+#endif
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (rv == 0) {
+            // file was truncated after fstat
+            return EIO;
+        }
+        done += std::size_t(rv);
+    }
+    return 0;
 }
 
 Result<std::string, int> readFileIntoString(const char* path)
 {
-    return readFile<std::string>(path, [](std::size_t size) {
-        return std::string(size, '\0');
+    std::string str;
+    int rv = readFile(path, [&str](std::size_t size) {
+        str.resize(size);
+        return (std::uint8_t*)&str[0];
     });
+    if (rv != 0) {
+        return rv;
+    }
+    return str;
 }
 
 Result<Buffer, int> readFileIntoBuffer(const char* path)
 {
-    return readFile<Buffer>(path, [](std::size_t size) {
-        return Buffer::createWithUnitializedData(size);
+    Buffer buf;
+    int rv = readFile(path, [&buf](std::size_t size) {
+        buf = Buffer::createWithUnitializedData(size);
+        return buf.data();
+    });
+    if (rv != 0) {
+        return rv;
+    }
+    return buf;
+}
+
+Result<std::size_t, int> readFileIntoBuffer(const char* path, Buffer* dest)
+{
+    int rv = readFile(path, [dest](std::size_t size) {
+        if (size > dest->capacity()) {
+            // old contents are not needed, avoid copying them in realloc
+            *dest = Buffer::createWithUnitializedData(size);
+        } else {
+            dest->resize(size);
+        }
+        return dest->data();
     });
+    if (rv != 0) {
+        dest->resize(0);
+        return rv;
+    }
+    return dest->size();
 }
 
 Result<SharedBytes, int> readFileIntoBytes(const char* path)
 {
-    return readFile<SharedBytes>(path, [](std::size_t size) {
-        return SharedBytes::create(size);
+    SharedBytes bytes;
+    int rv = readFile(path, [&bytes](std::size_t size) {
+        bytes = SharedBytes::create(size);
+        return bytes.data();
     });
+    if (rv != 0) {
+        return rv;
+    }
+    return bytes;
+}
+
+static std::vector<Result<SharedBytes, int>> makeReadResults(std::vector<SharedBytes>* data, const std::vector<int>& errors)
+{
+    std::vector<Result<SharedBytes, int>> results;
+    results.reserve(errors.size());
+    for (std::size_t i = 0; i < errors.size(); i++) {
+        if (errors[i] != 0) {
+            results.emplace_back(errors[i]);
+        } else {
+            results.emplace_back(std::move((*data)[i]));
+        }
+    }
+    return results;
+}
+
+std::vector<Result<SharedBytes, int>> readFilesIntoBytesThreaded(ArrayView<std::string> paths, std::size_t maxThreads)
+{
+    std::vector<SharedBytes> data(paths.size());
+    std::vector<int> errors(paths.size(), 0);
+    std::atomic<std::size_t> next(0);
+    auto worker = [&]() {
+        while (true) {
+            std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= paths.size()) {
+                return;
+            }
+            Result<SharedBytes, int> rv = readFileIntoBytes(paths[i].c_str());
+            if (rv.isOk()) {
+                data[i] = rv.unwrap();
+            } else {
+                errors[i] = rv.unwrapErr();
+            }
+        }
+    };
+
+    if (maxThreads == 0) {
+        maxThreads = BMCL_MAX(std::thread::hardware_concurrency(), 1u);
+    }
+    std::size_t threadNum = BMCL_MIN(maxThreads, paths.size());
+    std::vector<std::thread> threads;
+    // the calling thread is one of the workers
+    for (std::size_t i = 1; i < threadNum; i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return makeReadResults(&data, errors);
+}
+
+#ifdef BMCL_HAS_IO_URING
+
+static int waitForCompletions(IoUring* ring, std::size_t count, std::vector<int>* results)
+{
+    while (count != 0) {
+        const io_uring_cqe* cqe = ring->peek();
+        if (!cqe) {
+            int rv = ring->wait();
+            if (rv != 0) {
+                return rv;
+            }
+            continue;
+        }
+        (*results)[cqe->user_data] = cqe->res;
+        ring->seen();
+        count--;
+    }
+    return 0;
+}
+
+static void closeFds(const std::vector<int>& fds)
+{
+    for (int fd : fds) {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+}
+
+// memory referenced by the submitted requests of a batch
+struct IoUringBatch {
+    // the kernel may read a path only when the request runs
+    std::vector<std::string> paths;
+    std::vector<struct statx> stats;
+    std::vector<int> cqeResults;
+    std::vector<SharedBytes> data;
+};
+
+// after a failed submit or wait, waits for the requests still running so that the batch can be freed,
+// returns false if the ring failed again, in that case the requests may still write into the batch and it is leaked
+static bool finishFailedBatch(IoUring* ring, std::unique_ptr<IoUringBatch>* batch)
+{
+    if (waitForCompletions(ring, ring->inFlight(), &(*batch)->cqeResults) == 0) {
+        return true;
+    }
+    batch->release();
+    return false;
+}
+
+// files per batch, readFilesIntoBytes() in FileUtils.h documents it
+static const unsigned ioUringBatchSize = 256;
+
+// opens of a batch are submitted together, then stats of the opened descriptors, then all reads, then all closes
+// returns errno if io_uring itself fails, results of batches finished before the failure are already stored
+// in data and errors, files of the failed batch are closed unless their requests can't be waited for
+static int readFilesIoUring(ArrayView<std::string> paths, std::vector<SharedBytes>* data, std::vector<int>* errors)
+{
+    IoUring ring;
+    int rv = ring.init(ioUringBatchSize);
+    if (rv != 0) {
+        return rv;
+    }
+    const std::uint8_t ops[] = {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE};
+    for (std::uint8_t op : ops) {
+        if (!ring.supports(op)) {
+            return ENOSYS;
+        }
+    }
+
+    std::vector<int> batchErrors;
+    std::size_t batchSize = BMCL_MIN(ring.sqEntries(), ring.cqEntries());
+    // every phase starts with an empty submission queue and queues at most one sqe per file
+    BMCL_ASSERT(batchSize <= ring.sqEntries());
+    for (std::size_t start = 0; start < paths.size(); start += batchSize) {
+        std::size_t count = BMCL_MIN(batchSize, paths.size() - start);
+        std::unique_ptr<IoUringBatch> batch(new IoUringBatch);
+        batch->paths.assign(paths.begin() + start, paths.begin() + start + count);
+        batch->stats.resize(count);
+        // opens that didn't complete are left as errors
+        batch->cqeResults.assign(count, -ECANCELED);
+        std::vector<int>& cqeResults = batch->cqeResults;
+        for (std::size_t i = 0; i < count; i++) {
+            io_uring_sqe* sqe = ring.getSqe();
+            sqe->opcode = IORING_OP_OPENAT;
+            sqe->fd = AT_FDCWD;
+            sqe->addr = (std::uintptr_t)batch->paths[i].c_str();
+            sqe->open_flags = O_RDONLY | O_CLOEXEC;
+            sqe->user_data = i;
+        }
+        rv = ring.submit(0);
+        if (rv == 0) {
+            rv = waitForCompletions(&ring, count, &cqeResults);
+        }
+        if (rv != 0) {
+            // files opened by requests that can't be waited for are left open
+            std::vector<int> opened(count, -1);
+            bool isFinished = finishFailedBatch(&ring, &batch);
+            for (std::size_t i = 0; i < count && isFinished; i++) {
+                if (cqeResults[i] >= 0) {
+                    opened[i] = cqeResults[i];
+                }
+            }
+            closeFds(opened);
+            return rv;
+        }
+
+        std::vector<int> fds(count, -1);
+        batchErrors.assign(count, 0);
+        for (std::size_t i = 0; i < count; i++) {
+            if (cqeResults[i] < 0) {
+                batchErrors[i] = -cqeResults[i];
+            } else {
+                fds[i] = cqeResults[i];
+            }
+        }
+
+        // stat the opened descriptors like readFile() does, a path could refer to another file by now
+        std::size_t stats = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            cqeResults[i] = -ECANCELED;
+            if (fds[i] == -1) {
+                continue;
+            }
+            io_uring_sqe* sqe = ring.getSqe();
+            sqe->opcode = IORING_OP_STATX;
+            sqe->fd = fds[i];
+            sqe->addr = (std::uintptr_t)"";
+            sqe->statx_flags = AT_EMPTY_PATH;
+            sqe->len = STATX_TYPE | STATX_SIZE;
+            sqe->off = (std::uintptr_t)&batch->stats[i];
+            sqe->user_data = i;
+            stats++;
+        }
+        rv = ring.submit(0);
+        if (rv == 0) {
+            rv = waitForCompletions(&ring, stats, &cqeResults);
+        }
+        if (rv != 0) {
+            // running stats hold their own file references, descriptors can be closed in any case
+            finishFailedBatch(&ring, &batch);
+            closeFds(fds);
+            return rv;
+        }
+
+        std::vector<std::uint64_t> done(count, 0);
+        std::vector<SharedBytes>& batchData = batch->data;
+        batchData.assign(count, SharedBytes());
+        for (std::size_t i = 0; i < count; i++) {
+            if (fds[i] == -1) {
+                continue;
+            }
+            if (cqeResults[i] < 0) {
+                batchErrors[i] = -cqeResults[i];
+                continue;
+            }
+            const struct statx& st = batch->stats[i];
+            if (S_ISDIR(st.stx_mode)) {
+                batchErrors[i] = EISDIR;
+                continue;
+            }
+            if (st.stx_size > std::uint64_t(SIZE_MAX)) {
+                batchErrors[i] = EFBIG;
+                continue;
+            }
+            batchData[i] = SharedBytes::create(std::size_t(st.stx_size));
+        }
+
+        // short reads are resubmitted
+        while (true) {
+            std::size_t submitted = 0;
+            for (std::size_t i = 0; i < count; i++) {
+                if (batchErrors[i] != 0 || done[i] == batchData[i].size()) {
+                    continue;
+                }
+                io_uring_sqe* sqe = ring.getSqe();
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = fds[i];
+                sqe->addr = (std::uintptr_t)(batchData[i].data() + done[i]);
+                sqe->len = unsigned(BMCL_MIN(batchData[i].size() - done[i], std::uint64_t(1) << 30));
+                sqe->off = done[i];
+                sqe->user_data = i;
+                submitted++;
+            }
+            if (submitted == 0) {
+                break;
+            }
+            rv = ring.submit(0);
+            if (rv == 0) {
+                rv = waitForCompletions(&ring, submitted, &cqeResults);
+            }
+            if (rv != 0) {
+                // running reads hold their own file references, descriptors can be closed in any case
+                finishFailedBatch(&ring, &batch);
+                closeFds(fds);
+                return rv;
+            }
+            for (std::size_t i = 0; i < count; i++) {
+                if (batchErrors[i] != 0 || done[i] == batchData[i].size()) {
+                    continue;
+                }
+                int res = cqeResults[i];
+                if (res == -EINTR || res == -EAGAIN) {
+                    continue;
+                }
+                if (res < 0) {
+                    batchErrors[i] = -res;
+                } else if (res == 0) {
+                    // file was truncated after statx
+                    batchErrors[i] = EIO;
+                } else {
+                    done[i] += unsigned(res);
+                }
+            }
+        }
+
+        std::size_t closes = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            if (fds[i] != -1) {
+                io_uring_sqe* sqe = ring.getSqe();
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = fds[i];
+                sqe->user_data = i;
+                closes++;
+            }
+            // close returns zero or a negative errno, marks closes without a completion
+            cqeResults[i] = 1;
+        }
+        rv = ring.submit(0);
+        if (rv == 0) {
+            rv = waitForCompletions(&ring, closes, &cqeResults);
+        }
+        if (rv != 0) {
+            // once all submitted closes completed, the ones still without a completion were never submitted,
+            // otherwise the descriptors are left open, closing them again could close a reused descriptor
+            if (finishFailedBatch(&ring, &batch)) {
+                for (std::size_t i = 0; i < count; i++) {
+                    if (cqeResults[i] != 1) {
+                        fds[i] = -1;
+                    }
+                }
+                closeFds(fds);
+            }
+            return rv;
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            (*data)[start + i] = std::move(batchData[i]);
+            (*errors)[start + i] = batchErrors[i];
+        }
+    }
+    return 0;
+}
+
+#endif
+
+std::vector<Result<SharedBytes, int>> readFilesIntoBytes(ArrayView<std::string> paths)
+{
+#ifdef BMCL_HAS_IO_URING
+    std::vector<SharedBytes> data(paths.size());
+    std::vector<int> errors(paths.size(), 0);
+    if (readFilesIoUring(paths, &data, &errors) == 0) {
+        return makeReadResults(&data, errors);
+    }
+#endif
+    return readFilesIntoBytesThreaded(paths);
+}
+
+std::future<std::vector<Result<SharedBytes, int>>> readFilesIntoBytesAsync(std::vector<std::string> paths)
+{
+    return std::async(std::launch::async, [](const std::vector<std::string>& paths) {
+        return readFilesIntoBytes(paths);
+    }, std::move(paths));
 }
 
 std::uint64_t applicationPid()
@@ -13,6 +13,8 @@
 
 #include <string>
 #include <cstdint>
+#include <future>
+#include <vector>
 
 namespace bmcl {
 
@@ -24,8 +26,20 @@ class SharedBytes;
 
 BMCL_EXPORT Result<std::string, int> readFileIntoString(const char* path);
 BMCL_EXPORT Result<Buffer, int> readFileIntoBuffer(const char* path);
+// replaces contents of dest reusing its capacity, returns file size
+BMCL_EXPORT Result<std::size_t, int> readFileIntoBuffer(const char* path, Buffer* dest);
 BMCL_EXPORT Result<SharedBytes, int> readFileIntoBytes(const char* path);
 
+// reads many files at once, results are in the order of paths
+// on linux opens and reads of up to 256 files are submitted together through io_uring,
+// elsewhere or if io_uring is unavailable files are read by a pool of threads
+BMCL_EXPORT std::vector<Result<SharedBytes, int>> readFilesIntoBytes(ArrayView<std::string> paths);
+// same as above, runs on a separate thread
+BMCL_EXPORT std::future<std::vector<Result<SharedBytes, int>>> readFilesIntoBytesAsync(std::vector<std::string> paths);
+// thread pool implementation, maxThreads = 0 selects hardware concurrency
+BMCL_EXPORT std::vector<Result<SharedBytes, int>> readFilesIntoBytesThreaded(ArrayView<std::string> paths,
+                                                                            std::size_t maxThreads = 0);
+
 BMCL_EXPORT const bmcl::Option<std::string>& applicationFilePath();
 BMCL_EXPORT const bmcl::Option<std::string>& applicationDirPath();
 BMCL_EXPORT std::uint64_t applicationPid();
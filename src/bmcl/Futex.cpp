@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/Futex.h"
+
+#include <climits>
+
+#if defined(BMCL_PLATFORM_LINUX)
+# include <linux/futex.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+namespace bmcl {
+
+Futex::Futex(uint32_t value)
+    : _value(value)
+{
+}
+
+#if defined(BMCL_PLATFORM_LINUX)
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32 bit integer");
+
+void Futex::wait(uint32_t expected)
+{
+    // the kernel compares the word with expected atomically with going to sleep
+    ::syscall(SYS_futex, &_value, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+void Futex::wake(unsigned count)
+{
+    ::syscall(SYS_futex, &_value, FUTEX_WAKE_PRIVATE, int(count > INT_MAX ? INT_MAX : count), nullptr, nullptr, 0);
+}
+
+void Futex::wakeAll()
+{
+    wake(INT_MAX);
+}
+
+#else
+
+void Futex::wait(uint32_t expected)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (_value.load(std::memory_order_acquire) == expected) {
+        _cv.wait(lock);
+    }
+}
+
+void Futex::wake(unsigned count)
+{
+    // taking the lock orders the wakeup after a waiter's check of the word
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (count == 1) {
+        _cv.notify_one();
+    } else {
+        _cv.notify_all();
+    }
+}
+
+void Futex::wakeAll()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _cv.notify_all();
+}
+
+#endif
+}
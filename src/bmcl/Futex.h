@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if !defined(BMCL_PLATFORM_LINUX)
+# include <condition_variable>
+# include <mutex>
+#endif
+
+namespace bmcl {
+
+// 32 bit word threads can sleep on until it changes
+// uses futex(2) on linux and a mutex with a condition variable elsewhere
+class BMCL_EXPORT Futex {
+public:
+    explicit Futex(uint32_t value = 0);
+    Futex(const Futex& other) = delete;
+
+    Futex& operator=(const Futex& other) = delete;
+
+    uint32_t load() const;
+    void store(uint32_t value);
+    uint32_t fetchAdd(uint32_t value);
+
+    // sleeps while the word equals expected, may return spuriously
+    void wait(uint32_t expected);
+    // wakes up to count threads waiting on the word, called after changing it
+    void wake(unsigned count);
+    void wakeAll();
+
+private:
+    std::atomic<uint32_t> _value;
+#if !defined(BMCL_PLATFORM_LINUX)
+    std::mutex _mutex;
+    std::condition_variable _cv;
+#endif
+};
+
+inline uint32_t Futex::load() const
+{
+    return _value.load(std::memory_order_acquire);
+}
+
+inline void Futex::store(uint32_t value)
+{
+    _value.store(value, std::memory_order_release);
+}
+
+inline uint32_t Futex::fetchAdd(uint32_t value)
+{
+    return _value.fetch_add(value, std::memory_order_acq_rel);
+}
+}
@@ -51,4 +51,16 @@ constexpr R fnv1aHashCString(const char* data, R value = FnvHashParams<R>::offse
 {
     return (*data == '\0') ? value : fnv1aHashCString<R>(data + 1, (value ^ R(*data)) * FnvHashParams<R>::prime);
 }
+
+// murmur3 finalizer, spreads entropy of all input bits to all output bits
+// suitable for power of two sized tables
+inline std::uint64_t mixHash64(std::uint64_t value)
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
 }
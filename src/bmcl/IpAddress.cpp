@@ -1,5 +1,10 @@
 #include "bmcl/IpAddress.h"
+#include "bmcl/Assert.h"
 #include "bmcl/Endian.h"
+#include "bmcl/Hash.h"
+#include "bmcl/NumberFormat.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
 
 #include <cstring>
 
@@ -19,6 +24,237 @@
 
 namespace bmcl {
 
+constexpr std::size_t Ipv4Address::formattedMaxSize;
+constexpr std::size_t Ipv6Address::formattedMaxSize;
+constexpr std::size_t SocketAddressV4::formattedMaxSize;
+constexpr std::size_t SocketAddressV6::formattedMaxSize;
+constexpr std::size_t SocketAddress::formattedMaxSize;
+
+static inline bool isDigit(char c)
+{
+    return unsigned(c - '0') < 10;
+}
+
+static inline unsigned hexDigit(char c)
+{
+    if (isDigit(c)) {
+        return unsigned(c - '0');
+    }
+    unsigned lower = unsigned(c | 0x20) - 'a';
+    return lower < 6 ? lower + 10 : 16;
+}
+
+// decimal without leading zeros, consumes all digits
+static bool parseDecimal(const char** it, const char* end, uint32_t max, uint32_t* dest)
+{
+    const char* begin = *it;
+    const char* c = begin;
+    uint64_t value = 0;
+    while (c < end && isDigit(*c)) {
+        value = value * 10 + unsigned(*c - '0');
+        if (value > max) {
+            return false;
+        }
+        c++;
+    }
+    std::size_t size = c - begin;
+    if (size == 0 || (size > 1 && *begin == '0')) {
+        return false;
+    }
+    *dest = uint32_t(value);
+    *it = c;
+    return true;
+}
+
+static bool parseV4(const char* it, const char* end, uint8_t* dest)
+{
+    for (int i = 0; i < 4; i++) {
+        if (i != 0) {
+            if (it == end || *it != '.') {
+                return false;
+            }
+            it++;
+        }
+        uint32_t octet;
+        if (!parseDecimal(&it, end, 255, &octet)) {
+            return false;
+        }
+        dest[i] = uint8_t(octet);
+    }
+    return it == end;
+}
+
+// groups before :: are written in place, groups after it are shifted to the end once the count is known
+static bool parseV6(const char* it, const char* end, uint8_t* dest)
+{
+    std::memset(dest, 0, 16);
+    std::size_t size = 0;
+    std::size_t gap = std::size_t(-1);
+    if (it != end && *it == ':') {
+        if (end - it < 2 || it[1] != ':') {
+            return false;
+        }
+        it += 2;
+        gap = 0;
+        if (it == end) {
+            return true;
+        }
+    }
+    while (true) {
+        const char* groupBegin = it;
+        uint32_t value = 0;
+        while (it < end && (it - groupBegin) < 5) {
+            unsigned digit = hexDigit(*it);
+            if (digit == 16) {
+                break;
+            }
+            value = (value << 4) | digit;
+            it++;
+        }
+        std::size_t digits = it - groupBegin;
+        if (it < end && *it == '.') {
+            // embedded ipv4 takes the last 4 bytes
+            if (size > 12 || !parseV4(groupBegin, end, dest + size)) {
+                return false;
+            }
+            size += 4;
+            break;
+        }
+        if (digits == 0 || digits > 4 || size == 16) {
+            return false;
+        }
+        dest[size++] = uint8_t(value >> 8);
+        dest[size++] = uint8_t(value);
+        if (it == end) {
+            break;
+        }
+        if (*it != ':') {
+            return false;
+        }
+        it++;
+        if (it != end && *it == ':') {
+            if (gap != std::size_t(-1)) {
+                return false;
+            }
+            gap = size;
+            it++;
+            if (it == end) {
+                break;
+            }
+        } else if (it == end) {
+            return false;
+        }
+    }
+    if (gap == std::size_t(-1)) {
+        return size == 16;
+    }
+    // :: must stand for at least one group
+    if (size == 16) {
+        return false;
+    }
+    std::size_t tail = size - gap;
+    std::memmove(dest + 16 - tail, dest + gap, tail);
+    std::memset(dest + gap, 0, 16 - tail - gap);
+    return true;
+}
+
+static bool parsePort(const char* it, const char* end, uint16_t* dest)
+{
+    uint32_t port;
+    if (!parseDecimal(&it, end, 65535, &port) || it != end) {
+        return false;
+    }
+    *dest = uint16_t(port);
+    return true;
+}
+
+static inline char* formatOctet(uint8_t value, char* dest)
+{
+    if (value >= 100) {
+        *dest++ = char('0' + value / 100);
+        *dest++ = char('0' + value / 10 % 10);
+    } else if (value >= 10) {
+        *dest++ = char('0' + value / 10);
+    }
+    *dest++ = char('0' + value % 10);
+    return dest;
+}
+
+static char* formatV4(const uint8_t* data, char* dest)
+{
+    dest = formatOctet(data[0], dest);
+    for (int i = 1; i < 4; i++) {
+        *dest++ = '.';
+        dest = formatOctet(data[i], dest);
+    }
+    return dest;
+}
+
+static char* formatV6(const uint8_t* data, char* dest)
+{
+    static const char digits[] = "0123456789abcdef";
+    uint16_t groups[8];
+    for (int i = 0; i < 8; i++) {
+        groups[i] = uint16_t((data[i * 2] << 8) | data[i * 2 + 1]);
+    }
+
+    // longest run of zero groups, the first one if there are several, single groups are not compressed
+    int bestStart = -1;
+    int bestSize = 1;
+    for (int i = 0; i < 8;) {
+        if (groups[i] != 0) {
+            i++;
+            continue;
+        }
+        int start = i;
+        while (i < 8 && groups[i] == 0) {
+            i++;
+        }
+        if (i - start > bestSize) {
+            bestStart = start;
+            bestSize = i - start;
+        }
+    }
+
+    // ::ffff:a.b.c.d
+    bool isMapped = bestStart == 0 && bestSize == 5 && groups[5] == 0xffff;
+    int groupCount = isMapped ? 6 : 8;
+    for (int i = 0; i < groupCount; i++) {
+        if (i == bestStart) {
+            *dest++ = ':';
+            *dest++ = ':';
+            i += bestSize - 1;
+            continue;
+        }
+        if (i != 0 && i != bestStart + bestSize) {
+            *dest++ = ':';
+        }
+        uint16_t group = groups[i];
+        if (group >= 0x1000) {
+            *dest++ = digits[group >> 12];
+        }
+        if (group >= 0x100) {
+            *dest++ = digits[(group >> 8) & 0xf];
+        }
+        if (group >= 0x10) {
+            *dest++ = digits[(group >> 4) & 0xf];
+        }
+        *dest++ = digits[group & 0xf];
+    }
+    if (isMapped) {
+        *dest++ = ':';
+        dest = formatV4(data + 12, dest);
+    }
+    return dest;
+}
+
+static inline uint64_t load64(const uint8_t* data)
+{
+    uint64_t value;
+    std::memcpy(&value, data, 8);
+    return value;
+}
+
 Ipv4Address::Ipv4Address(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
 #ifdef BMCL_LITTLE_ENDIAN
     : _data(uint32_t(a) | (uint32_t(b) << 8) | (uint32_t(c) << 16) | (uint32_t(d) << 24))
@@ -50,6 +286,108 @@ std::array<uint8_t, 4> Ipv4Address::toArray() const
     return address;
 }
 
+Result<Ipv4Address, void> Ipv4Address::fromString(StringView str)
+{
+    std::array<uint8_t, 4> address;
+    if (!parseV4(str.data(), str.data() + str.size(), address.data())) {
+        return Result<Ipv4Address, void>();
+    }
+    return Ipv4Address(address);
+}
+
+std::size_t Ipv4Address::format(char* dest) const
+{
+    return formatV4(toArray().data(), dest) - dest;
+}
+
+std::string Ipv4Address::toStdString() const
+{
+    char tmp[formattedMaxSize];
+    return std::string(tmp, format(tmp));
+}
+
+std::size_t Ipv4Address::hash() const
+{
+    return std::size_t(mixHash64(_data));
+}
+
+Ipv6Address::Ipv6Address()
+{
+    _data.fill(0);
+}
+
+Ipv6Address::Ipv6Address(uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint16_t e, uint16_t f, uint16_t g, uint16_t h)
+{
+    const uint16_t groups[8] = {a, b, c, d, e, f, g, h};
+    for (int i = 0; i < 8; i++) {
+        _data[i * 2] = uint8_t(groups[i] >> 8);
+        _data[i * 2 + 1] = uint8_t(groups[i]);
+    }
+}
+
+Ipv6Address Ipv6Address::fromV4Mapped(Ipv4Address address)
+{
+    Data data;
+    data.fill(0);
+    data[10] = 0xff;
+    data[11] = 0xff;
+    std::array<uint8_t, 4> v4 = address.toArray();
+    std::memcpy(data.data() + 12, v4.data(), 4);
+    return Ipv6Address(data);
+}
+
+Result<Ipv6Address, void> Ipv6Address::fromString(StringView str)
+{
+    Data data;
+    if (!parseV6(str.data(), str.data() + str.size(), data.data())) {
+        return Result<Ipv6Address, void>();
+    }
+    return Ipv6Address(data);
+}
+
+uint16_t Ipv6Address::group(std::size_t index) const
+{
+    return uint16_t((_data[index * 2] << 8) | _data[index * 2 + 1]);
+}
+
+bool Ipv6Address::isV4Mapped() const
+{
+    static const uint8_t prefix[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    return std::memcmp(_data.data(), prefix, 12) == 0;
+}
+
+bool Ipv6Address::isLoopback() const
+{
+    static const uint8_t loopback[16] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+    return std::memcmp(_data.data(), loopback, 16) == 0;
+}
+
+bool Ipv6Address::isUnspecified() const
+{
+    return load64(_data.data()) == 0 && load64(_data.data() + 8) == 0;
+}
+
+Ipv4Address Ipv6Address::toV4() const
+{
+    return Ipv4Address(_data[12], _data[13], _data[14], _data[15]);
+}
+
+std::size_t Ipv6Address::format(char* dest) const
+{
+    return formatV6(_data.data(), dest) - dest;
+}
+
+std::string Ipv6Address::toStdString() const
+{
+    char tmp[formattedMaxSize];
+    return std::string(tmp, format(tmp));
+}
+
+std::size_t Ipv6Address::hash() const
+{
+    return std::size_t(mixHash64(load64(_data.data()) * 0x9e3779b97f4a7c15ull ^ load64(_data.data() + 8)));
+}
+
 SocketAddressV4::SocketAddressV4(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint16_t port)
     : _address(a, b, c, d)
     , _port(hton16(port))
@@ -104,8 +442,192 @@ SocketAddressV4& SocketAddressV4::operator=(SocketAddressV4&& other)
     return *this;
 }
 
-bool SocketAddressV4::operator==(const SocketAddressV4& other)
+bool SocketAddressV4::operator==(const SocketAddressV4& other) const
 {
     return (_address == other._address) && (_port == other._port);
 }
+
+bool SocketAddressV4::operator!=(const SocketAddressV4& other) const
+{
+    return !(*this == other);
+}
+
+Result<SocketAddressV4, void> SocketAddressV4::fromString(StringView str)
+{
+    const char* begin = str.data();
+    const char* end = begin + str.size();
+    const char* colon = end;
+    while (colon != begin && colon[-1] != ':') {
+        colon--;
+    }
+    if (colon == begin) {
+        return Result<SocketAddressV4, void>();
+    }
+    std::array<uint8_t, 4> address;
+    uint16_t port;
+    if (!parseV4(begin, colon - 1, address.data()) || !parsePort(colon, end, &port)) {
+        return Result<SocketAddressV4, void>();
+    }
+    return SocketAddressV4(Ipv4Address(address), port);
+}
+
+std::size_t SocketAddressV4::format(char* dest) const
+{
+    std::size_t size = _address.format(dest);
+    dest[size++] = ':';
+    return size + formatUint(port(), dest + size);
+}
+
+std::string SocketAddressV4::toStdString() const
+{
+    char tmp[formattedMaxSize];
+    return std::string(tmp, format(tmp));
+}
+
+std::size_t SocketAddressV4::hash() const
+{
+    return std::size_t(mixHash64((uint64_t(_address.toUint32()) << 16) | port()));
+}
+
+Result<SocketAddressV6, void> SocketAddressV6::fromString(StringView str)
+{
+    const char* begin = str.data();
+    const char* end = begin + str.size();
+    if (begin == end || *begin != '[') {
+        return Result<SocketAddressV6, void>();
+    }
+    const char* addressEnd = (const char*)std::memchr(begin, ']', str.size());
+    if (!addressEnd || end - addressEnd < 2 || addressEnd[1] != ':') {
+        return Result<SocketAddressV6, void>();
+    }
+    const char* portBegin = addressEnd + 2;
+    const char* percent = (const char*)std::memchr(begin + 1, '%', addressEnd - begin - 1);
+    uint32_t scopeId = 0;
+    if (percent) {
+        const char* it = percent + 1;
+        if (!parseDecimal(&it, addressEnd, 0xffffffff, &scopeId) || it != addressEnd) {
+            return Result<SocketAddressV6, void>();
+        }
+        addressEnd = percent;
+    }
+    Ipv6Address::Data address;
+    uint16_t port;
+    if (!parseV6(begin + 1, addressEnd, address.data()) || !parsePort(portBegin, end, &port)) {
+        return Result<SocketAddressV6, void>();
+    }
+    return SocketAddressV6(Ipv6Address(address), port, scopeId);
+}
+
+std::size_t SocketAddressV6::format(char* dest) const
+{
+    char* it = dest;
+    *it++ = '[';
+    it += _address.format(it);
+    if (_scopeId != 0) {
+        *it++ = '%';
+        it += formatUint(_scopeId, it);
+    }
+    *it++ = ']';
+    *it++ = ':';
+    it += formatUint(_port, it);
+    return it - dest;
+}
+
+std::string SocketAddressV6::toStdString() const
+{
+    char tmp[formattedMaxSize];
+    return std::string(tmp, format(tmp));
+}
+
+std::size_t SocketAddressV6::hash() const
+{
+    uint64_t extra = (uint64_t(_scopeId) << 16) | _port;
+    return std::size_t(mixHash64(_address.hash() ^ extra));
+}
+
+SocketAddress::SocketAddress()
+    : _scopeId(0)
+    , _port(0)
+    , _version(IpVersion::V4)
+{
+    _address.fill(0);
+}
+
+SocketAddress::SocketAddress(const SocketAddressV4& address)
+    : _scopeId(0)
+    , _port(address.port())
+    , _version(IpVersion::V4)
+{
+    _address.fill(0);
+    std::array<uint8_t, 4> v4 = address.address().toArray();
+    std::memcpy(_address.data(), v4.data(), 4);
+}
+
+SocketAddress::SocketAddress(const SocketAddressV6& address)
+    : _address(address.address().data())
+    , _scopeId(address.scopeId())
+    , _port(address.port())
+    , _version(IpVersion::V6)
+{
+}
+
+Result<SocketAddress, void> SocketAddress::fromString(StringView str)
+{
+    if (!str.isEmpty() && str.data()[0] == '[') {
+        auto rv = SocketAddressV6::fromString(str);
+        if (rv.isErr()) {
+            return Result<SocketAddress, void>();
+        }
+        return SocketAddress(rv.unwrap());
+    }
+    auto rv = SocketAddressV4::fromString(str);
+    if (rv.isErr()) {
+        return Result<SocketAddress, void>();
+    }
+    return SocketAddress(rv.unwrap());
+}
+
+SocketAddressV4 SocketAddress::toV4() const
+{
+    BMCL_ASSERT(isV4());
+    return SocketAddressV4(_address[0], _address[1], _address[2], _address[3], _port);
+}
+
+SocketAddressV6 SocketAddress::toV6() const
+{
+    BMCL_ASSERT(isV6());
+    return SocketAddressV6(Ipv6Address(_address), _port, _scopeId);
+}
+
+std::size_t SocketAddress::format(char* dest) const
+{
+    if (isV4()) {
+        return toV4().format(dest);
+    }
+    return toV6().format(dest);
+}
+
+std::string SocketAddress::toStdString() const
+{
+    char tmp[formattedMaxSize];
+    return std::string(tmp, format(tmp));
+}
+
+std::size_t SocketAddress::hash() const
+{
+    if (isV4()) {
+        return toV4().hash();
+    }
+    return toV6().hash();
+}
+
+bool SocketAddress::operator==(const SocketAddress& other) const
+{
+    return _version == other._version && _port == other._port && _scopeId == other._scopeId && _address == other._address;
+}
+
+bool SocketAddress::operator!=(const SocketAddress& other) const
+{
+    return !(*this == other);
+}
 }
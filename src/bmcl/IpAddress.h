@@ -1,14 +1,24 @@
 #pragma once
 
 #include "bmcl/Config.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/Writer.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <array>
+#include <string>
 
 namespace bmcl {
 
+// text conversions don't allocate, parse accepts the whole view only
+// formatting writes at most formattedMaxSize chars and returns number of chars written
+
 class BMCL_EXPORT Ipv4Address {
 public:
+    // 255.255.255.255
+    static constexpr std::size_t formattedMaxSize = 15;
+
     Ipv4Address();
     Ipv4Address(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
     Ipv4Address(uint32_t data);
@@ -16,13 +26,25 @@ public:
     Ipv4Address(const Ipv4Address& other);
     Ipv4Address(Ipv4Address&& other);
 
+    // dotted decimal, leading zeros are rejected
+    static Result<Ipv4Address, void> fromString(StringView str);
+
     uint32_t toUint32() const;
     std::array<uint8_t, 4> toArray() const;
 
+    std::size_t format(char* dest) const;
+    template <typename B>
+    void format(Writer<B>* dest) const;
+    std::string toStdString() const;
+
+    std::size_t hash() const;
+
     Ipv4Address& operator=(const Ipv4Address& other);
     Ipv4Address& operator=(Ipv4Address&& other);
 
     bool operator==(const Ipv4Address& other) const;
+    bool operator!=(const Ipv4Address& other) const;
+    bool operator<(const Ipv4Address& other) const;
 
 private:
     uint32_t _data;
@@ -60,8 +82,87 @@ inline bool Ipv4Address::operator==(const Ipv4Address& other) const
     return _data == other._data;
 }
 
+inline bool Ipv4Address::operator!=(const Ipv4Address& other) const
+{
+    return _data != other._data;
+}
+
+inline bool Ipv4Address::operator<(const Ipv4Address& other) const
+{
+    return toUint32() < other.toUint32();
+}
+
+class BMCL_EXPORT Ipv6Address {
+public:
+    using Data = std::array<uint8_t, 16>;
+
+    // ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255
+    static constexpr std::size_t formattedMaxSize = 45;
+
+    // ::
+    Ipv6Address();
+    // network byte order
+    Ipv6Address(const Data& data);
+    Ipv6Address(uint16_t a, uint16_t b, uint16_t c, uint16_t d, uint16_t e, uint16_t f, uint16_t g, uint16_t h);
+    // ::ffff:a.b.c.d
+    static Ipv6Address fromV4Mapped(Ipv4Address address);
+
+    // RFC 4291 text form, including :: compression and a trailing dotted ipv4 part
+    static Result<Ipv6Address, void> fromString(StringView str);
+
+    const Data& data() const;
+    uint16_t group(std::size_t index) const;
+    bool isV4Mapped() const;
+    bool isLoopback() const;
+    bool isUnspecified() const;
+    Ipv4Address toV4() const;
+
+    // RFC 5952 canonical form
+    std::size_t format(char* dest) const;
+    template <typename B>
+    void format(Writer<B>* dest) const;
+    std::string toStdString() const;
+
+    std::size_t hash() const;
+
+    bool operator==(const Ipv6Address& other) const;
+    bool operator!=(const Ipv6Address& other) const;
+    bool operator<(const Ipv6Address& other) const;
+
+private:
+    Data _data;
+};
+
+inline Ipv6Address::Ipv6Address(const Data& data)
+    : _data(data)
+{
+}
+
+inline const Ipv6Address::Data& Ipv6Address::data() const
+{
+    return _data;
+}
+
+inline bool Ipv6Address::operator==(const Ipv6Address& other) const
+{
+    return _data == other._data;
+}
+
+inline bool Ipv6Address::operator!=(const Ipv6Address& other) const
+{
+    return _data != other._data;
+}
+
+inline bool Ipv6Address::operator<(const Ipv6Address& other) const
+{
+    return _data < other._data;
+}
+
 class BMCL_EXPORT SocketAddressV4 {
 public:
+    // 255.255.255.255:65535
+    static constexpr std::size_t formattedMaxSize = 21;
+
     SocketAddressV4();
     SocketAddressV4(uint8_t a, uint8_t b, uint8_t c, uint8_t d, uint16_t port);
     SocketAddressV4(uint32_t address, uint16_t port);
@@ -69,16 +170,27 @@ public:
     SocketAddressV4(const SocketAddressV4& other);
     SocketAddressV4(SocketAddressV4&& other);
 
+    // a.b.c.d:port
+    static Result<SocketAddressV4, void> fromString(StringView str);
+
     Ipv4Address address() const;
     uint16_t port() const;
 
     void setIpAddress(Ipv4Address address);
     void setPort(uint16_t port);
 
+    std::size_t format(char* dest) const;
+    template <typename B>
+    void format(Writer<B>* dest) const;
+    std::string toStdString() const;
+
+    std::size_t hash() const;
+
     SocketAddressV4& operator=(const SocketAddressV4& other);
     SocketAddressV4& operator=(SocketAddressV4&& other);
 
-    bool operator==(const SocketAddressV4& other);
+    bool operator==(const SocketAddressV4& other) const;
+    bool operator!=(const SocketAddressV4& other) const;
 
 private:
     Ipv4Address _address;
@@ -99,4 +211,190 @@ inline void SocketAddressV4::setIpAddress(Ipv4Address address)
 {
     _address = address;
 }
+
+class BMCL_EXPORT SocketAddressV6 {
+public:
+    // [ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255%4294967295]:65535
+    static constexpr std::size_t formattedMaxSize = 64;
+
+    SocketAddressV6();
+    SocketAddressV6(const Ipv6Address& address, uint16_t port, uint32_t scopeId = 0);
+
+    // [address]:port or [address%scope]:port with a numeric scope id
+    static Result<SocketAddressV6, void> fromString(StringView str);
+
+    const Ipv6Address& address() const;
+    uint16_t port() const;
+    uint32_t scopeId() const;
+
+    void setIpAddress(const Ipv6Address& address);
+    void setPort(uint16_t port);
+    void setScopeId(uint32_t scopeId);
+
+    std::size_t format(char* dest) const;
+    template <typename B>
+    void format(Writer<B>* dest) const;
+    std::string toStdString() const;
+
+    std::size_t hash() const;
+
+    bool operator==(const SocketAddressV6& other) const;
+    bool operator!=(const SocketAddressV6& other) const;
+
+private:
+    Ipv6Address _address;
+    uint16_t _port;
+    uint32_t _scopeId;
+};
+
+inline SocketAddressV6::SocketAddressV6()
+    : _port(0)
+    , _scopeId(0)
+{
+}
+
+inline SocketAddressV6::SocketAddressV6(const Ipv6Address& address, uint16_t port, uint32_t scopeId)
+    : _address(address)
+    , _port(port)
+    , _scopeId(scopeId)
+{
+}
+
+inline const Ipv6Address& SocketAddressV6::address() const
+{
+    return _address;
+}
+
+inline uint16_t SocketAddressV6::port() const
+{
+    return _port;
+}
+
+inline uint32_t SocketAddressV6::scopeId() const
+{
+    return _scopeId;
+}
+
+inline void SocketAddressV6::setIpAddress(const Ipv6Address& address)
+{
+    _address = address;
+}
+
+inline void SocketAddressV6::setPort(uint16_t port)
+{
+    _port = port;
+}
+
+inline void SocketAddressV6::setScopeId(uint32_t scopeId)
+{
+    _scopeId = scopeId;
+}
+
+inline bool SocketAddressV6::operator==(const SocketAddressV6& other) const
+{
+    return _address == other._address && _port == other._port && _scopeId == other._scopeId;
+}
+
+inline bool SocketAddressV6::operator!=(const SocketAddressV6& other) const
+{
+    return !(*this == other);
+}
+
+enum class IpVersion {
+    V4,
+    V6,
+};
+
+// either SocketAddressV4 or SocketAddressV6
+class BMCL_EXPORT SocketAddress {
+public:
+    static constexpr std::size_t formattedMaxSize = SocketAddressV6::formattedMaxSize;
+
+    // 0.0.0.0:0
+    SocketAddress();
+    SocketAddress(const SocketAddressV4& address);
+    SocketAddress(const SocketAddressV6& address);
+
+    // SocketAddressV6 format if str starts with '[', SocketAddressV4 otherwise
+    static Result<SocketAddress, void> fromString(StringView str);
+
+    IpVersion version() const;
+    bool isV4() const;
+    bool isV6() const;
+    SocketAddressV4 toV4() const;
+    SocketAddressV6 toV6() const;
+    uint16_t port() const;
+
+    std::size_t format(char* dest) const;
+    template <typename B>
+    void format(Writer<B>* dest) const;
+    std::string toStdString() const;
+
+    std::size_t hash() const;
+
+    bool operator==(const SocketAddress& other) const;
+    bool operator!=(const SocketAddress& other) const;
+
+private:
+    // ipv4 address occupies first 4 bytes, both in network byte order
+    Ipv6Address::Data _address;
+    uint32_t _scopeId;
+    uint16_t _port;
+    IpVersion _version;
+};
+
+inline IpVersion SocketAddress::version() const
+{
+    return _version;
+}
+
+inline bool SocketAddress::isV4() const
+{
+    return _version == IpVersion::V4;
+}
+
+inline bool SocketAddress::isV6() const
+{
+    return _version == IpVersion::V6;
+}
+
+inline uint16_t SocketAddress::port() const
+{
+    return _port;
+}
+
+template <typename B>
+inline void Ipv4Address::format(Writer<B>* dest) const
+{
+    char tmp[formattedMaxSize];
+    static_cast<B*>(dest)->write(tmp, format(tmp));
+}
+
+template <typename B>
+inline void Ipv6Address::format(Writer<B>* dest) const
+{
+    char tmp[formattedMaxSize];
+    static_cast<B*>(dest)->write(tmp, format(tmp));
+}
+
+template <typename B>
+inline void SocketAddressV4::format(Writer<B>* dest) const
+{
+    char tmp[formattedMaxSize];
+    static_cast<B*>(dest)->write(tmp, format(tmp));
+}
+
+template <typename B>
+inline void SocketAddressV6::format(Writer<B>* dest) const
+{
+    char tmp[formattedMaxSize];
+    static_cast<B*>(dest)->write(tmp, format(tmp));
+}
+
+template <typename B>
+inline void SocketAddress::format(Writer<B>* dest) const
+{
+    char tmp[formattedMaxSize];
+    static_cast<B*>(dest)->write(tmp, format(tmp));
+}
 }
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/IpAddress.h"
+
+#include <functional>
+
+namespace std {
+
+template<>
+struct hash<bmcl::Ipv4Address>
+{
+    std::size_t operator()(const bmcl::Ipv4Address& p) const
+    {
+        return p.hash();
+    }
+};
+
+template<>
+struct hash<bmcl::Ipv6Address>
+{
+    std::size_t operator()(const bmcl::Ipv6Address& p) const
+    {
+        return p.hash();
+    }
+};
+
+template<>
+struct hash<bmcl::SocketAddressV4>
+{
+    std::size_t operator()(const bmcl::SocketAddressV4& p) const
+    {
+        return p.hash();
+    }
+};
+
+template<>
+struct hash<bmcl::SocketAddressV6>
+{
+    std::size_t operator()(const bmcl::SocketAddressV6& p) const
+    {
+        return p.hash();
+    }
+};
+
+template<>
+struct hash<bmcl::SocketAddress>
+{
+    std::size_t operator()(const bmcl::SocketAddress& p) const
+    {
+        return p.hash();
+    }
+};
+}
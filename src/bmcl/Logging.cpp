@@ -9,110 +9,612 @@
 #include "bmcl/Config.h"
 #include "bmcl/Logging.h"
 #include "bmcl/ColorStream.h"
+#include "bmcl/Panic.h"
+#include "bmcl/TimeUtils.h"
+#include "bmcl/bits/LogQueue.h"
 
-#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace bmcl {
 
-static LogLevel _currentLogLevel = LogLevel::Debug;
+static std::atomic<int> _currentLogLevel((int)LogLevel::Debug);
 
 void setLogLevel(LogLevel level)
 {
-    _currentLogLevel = level;
+    _currentLogLevel.store((int)level, std::memory_order_relaxed);
 }
 
 LogLevel logLevel()
 {
-    return _currentLogLevel;
+    return (LogLevel)_currentLogLevel.load(std::memory_order_relaxed);
 }
 
-static void coutHandler(LogLevel level, const char* msg)
+const char* logLevelPrefix(LogLevel level)
 {
-    if ((int)level > (int)_currentLogLevel) {
-        return;
+    switch (level) {
+    case LogLevel::Debug:
+        return "DEBUG:   ";
+    case LogLevel::Info:
+        return "INFO:    ";
+    case LogLevel::Warning:
+        return "WARNING: ";
+    case LogLevel::Critical:
+        return "CRITICAL:";
+    case LogLevel::Panic:
+        return "PANIC:   ";
+    default:
+        return "???: ";
+    }
+}
+
+static bool writeLogLine(ColorStream* out, LogLevel level, std::time_t t, const char* msg)
+{
+    if ((int)level > (int)logLevel()) {
+        return false;
     }
     if (level == LogLevel::None) {
-        return;
+        return false;
     }
-    const char* prefix;
     ColorAttr attr;
     switch (level) {
     case LogLevel::Debug:
-        prefix = "DEBUG:   ";
         attr = ColorAttr::FgMagenta;
         break;
     case LogLevel::Info:
-        prefix = "INFO:    ";
         attr = ColorAttr::FgCyan;
         break;
     case LogLevel::Warning:
-        prefix = "WARNING: ";
         attr = ColorAttr::FgYellow;
         break;
     case LogLevel::Critical:
-        prefix = "CRITICAL:";
-        attr = ColorAttr::FgRed;
-        break;
     case LogLevel::Panic:
-        prefix = "PANIC:   ";
         attr = ColorAttr::FgRed;
         break;
     default:
-        prefix = "???: ";
+        attr = ColorAttr::Normal;
     }
-    char timeStr[20];
-    std::time_t t = std::time(nullptr);
-    std::strftime(timeStr, sizeof(timeStr), "%F %T", std::localtime(&t));
-    ColorStdError out;
-    out << ColorAttr::Bright << timeStr << ' ';
-    out << attr << prefix << ColorAttr::Reset << ' ';
+    *out << ColorAttr::Bright << formatLocalTime(t) << ' ';
+    *out << attr << logLevelPrefix(level) << ColorAttr::Reset << ' ';
 #ifdef BMCL_HAVE_QT
-    out << QString::fromUtf8(msg).toLocal8Bit().constData() << std::endl;
+    *out << QString::fromUtf8(msg).toLocal8Bit().constData();
 #else
-    out << msg << std::endl;
+    *out << msg;
 #endif
+    return true;
 }
 
-static LogHandler currentLogHandler = coutHandler;
+// null means default handler, accessed only with atomic_load/atomic_store
+static std::shared_ptr<const LogHandler> currentLogHandler;
+
+static void handleMessage(const LogHandler* handler, LogLevel level, std::time_t t, const char* msg)
+{
+    if (handler) {
+        (*handler)(level, msg);
+        return;
+    }
+    ColorStdError out;
+    if (writeLogLine(&out, level, t, msg)) {
+        out << std::endl;
+    }
+}
 
 void setLogHandler(const LogHandler& handler)
 {
-    currentLogHandler = handler;
+    std::atomic_store(&currentLogHandler, std::make_shared<const LogHandler>(handler));
 }
 
 void setLogHandler(LogHandler&& handler)
 {
-    currentLogHandler = std::move(handler);
+    std::atomic_store(&currentLogHandler, std::make_shared<const LogHandler>(std::move(handler)));
 }
 
 void setDefaulLogHandler()
 {
-    currentLogHandler = coutHandler;
+    std::atomic_store(&currentLogHandler, std::shared_ptr<const LogHandler>());
+}
+
+static thread_local std::shared_ptr<LogQueue> localLogQueues[LogQueueWriter::SlotCount];
+// yields of a producer blocked on a full queue before it waits for the writer
+static const unsigned maxBlockedPushSpins = 16;
+// set on writer threads, handlers running there must not wait for their own thread
+static thread_local const LogQueueWriter* runningLogQueueWriter = nullptr;
+
+LogQueueWriter::LogQueueWriter(Slot slot)
+    : _slot(slot)
+    , _removedDropped(0)
+    , _isEnabled(false)
+    , _isRunning(false)
+    , _isWriterSleeping(false)
+    , _activePushes(0)
+    , _queueSize(0)
+    , _policy((int)LogOverflowPolicy::Drop)
+{
+}
+
+LogQueueWriter::~LogQueueWriter()
+{
+}
+
+void LogQueueWriter::start(std::size_t queueSize, LogOverflowPolicy policy)
+{
+    std::size_t capacity = 4096;
+    while (capacity < queueSize) {
+        capacity *= 2;
+    }
+    _queueSize.store(capacity);
+    _policy.store((int)policy);
+    _isRunning.store(true);
+    _thread = std::thread(&LogQueueWriter::run, this);
+    _isEnabled.store(true, std::memory_order_release);
+}
+
+void LogQueueWriter::stop()
+{
+    _isEnabled.store(false);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _isRunning.store(false);
+    }
+    _writerCv.notify_one();
+    _spaceCv.notify_all();
+    _thread.join();
+    // pushes starting from now on see _isRunning cleared and return false
+    while (_activePushes.load() != 0) {
+        std::this_thread::yield();
+    }
+    drainStopped();
+    _flushCv.notify_all();
+}
+
+// records pushed after the last check of the writer thread are handled on the calling thread
+void LogQueueWriter::drainStopped()
+{
+    std::vector<std::shared_ptr<LogQueue>> queues;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        queues = _queues;
+    }
+    while (handleBatch(queues)) {
+        for (const std::shared_ptr<LogQueue>& queue : queues) {
+            queue->commitRead();
+        }
+    }
+}
+
+LogQueue* LogQueueWriter::localQueue()
+{
+    std::shared_ptr<LogQueue>& local = localLogQueues[_slot];
+    std::size_t queueSize = _queueSize.load(std::memory_order_relaxed);
+    if (!local || local->capacity() != queueSize) {
+        auto queue = std::make_shared<LogQueue>(queueSize);
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queues.push_back(queue);
+        local = std::move(queue);
+    }
+    return local.get();
+}
+
+bool LogQueueWriter::isWriterThread() const
+{
+    return runningLogQueueWriter == this;
+}
+
+bool LogQueueWriter::push(const void* header, std::size_t headerSize, const void* data, std::size_t dataSize)
+{
+    // with a full queue under the Block policy the writer would wait for itself
+    if (isWriterThread()) {
+        return false;
+    }
+    // pairs with the store to _isRunning in stop() before it waits for active pushes
+    _activePushes.fetch_add(1);
+    bool isPushed = _isRunning.load() && pushLocal(header, headerSize, data, dataSize);
+    _activePushes.fetch_sub(1);
+    return isPushed;
+}
+
+bool LogQueueWriter::pushLocal(const void* header, std::size_t headerSize, const void* data, std::size_t dataSize)
+{
+    LogQueue* queue = localQueue();
+    unsigned spins = 0;
+    while (!queue->tryPush(header, headerSize, data, dataSize)) {
+        if (_policy.load(std::memory_order_relaxed) == (int)LogOverflowPolicy::Drop) {
+            queue->countDropped();
+            return true;
+        }
+        if (!_isRunning.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        // a batch is usually handled within a few yields, then the producer sleeps until the writer frees space
+        if (spins < maxBlockedPushSpins) {
+            spins++;
+            std::this_thread::yield();
+            continue;
+        }
+        std::size_t recordSize = queue->recordSize(headerSize, dataSize);
+        std::unique_lock<std::mutex> lock(_mutex);
+        _writerCv.notify_one();
+        _spaceCv.wait(lock, [this, queue, recordSize]() {
+            return queue->hasSpace(recordSize) || !_isRunning.load();
+        });
+    }
+    // pairs with the store to _isWriterSleeping before the writer checks queues for the last time
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_isWriterSleeping.load(std::memory_order_relaxed)) {
+        wakeWriter();
+    }
+    return true;
+}
+
+void LogQueueWriter::countDropped()
+{
+    localQueue()->countDropped();
+}
+
+void LogQueueWriter::wakeWriter()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _writerCv.notify_one();
+}
+
+// waits until records queued before the call are handled, without a timeout if it is null
+bool LogQueueWriter::waitHandled(const std::chrono::milliseconds* timeout)
+{
+    if (isWriterThread()) {
+        return false;
+    }
+    std::vector<std::pair<std::shared_ptr<LogQueue>, uint64_t>> positions;
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (const std::shared_ptr<LogQueue>& queue : _queues) {
+        positions.emplace_back(queue, queue->writePos());
+    }
+    _writerCv.notify_one();
+    auto isHandled = [this, &positions]() {
+        if (!_isRunning.load()) {
+            return true;
+        }
+        for (const auto& pos : positions) {
+            if (!pos.first->isHandled(pos.second)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    if (timeout) {
+        return _flushCv.wait_for(lock, *timeout, isHandled);
+    }
+    _flushCv.wait(lock, isHandled);
+    return true;
+}
+
+void LogQueueWriter::flush()
+{
+    waitHandled(nullptr);
+}
+
+bool LogQueueWriter::flushFor(std::chrono::milliseconds timeout)
+{
+    return waitHandled(&timeout);
+}
+
+uint64_t LogQueueWriter::dropped()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t total = _removedDropped;
+    for (const std::shared_ptr<LogQueue>& queue : _queues) {
+        total += queue->dropped();
+    }
+    return total;
+}
+
+bool LogQueueWriter::hasPendingLocked() const
+{
+    for (const std::shared_ptr<LogQueue>& queue : _queues) {
+        if (!queue->isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void LogQueueWriter::run()
+{
+    runningLogQueueWriter = this;
+    std::vector<std::shared_ptr<LogQueue>> queues;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            // queues of exited threads are removed once empty
+            auto it = _queues.begin();
+            while (it != _queues.end()) {
+                if (it->use_count() == 1 && (*it)->isEmpty()) {
+                    _removedDropped += (*it)->dropped();
+                    it = _queues.erase(it);
+                } else {
+                    it++;
+                }
+            }
+            queues = _queues;
+        }
+
+        bool isHandled = handleBatch(queues);
+        if (isHandled) {
+            for (const std::shared_ptr<LogQueue>& queue : queues) {
+                queue->commitRead();
+            }
+        }
+        queues.clear();
+        if (isHandled) {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _flushCv.notify_all();
+            _spaceCv.notify_all();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_isRunning.load()) {
+            if (!hasPendingLocked()) {
+                break;
+            }
+            continue;
+        }
+        _isWriterSleeping.store(true);
+        if (!hasPendingLocked()) {
+            _writerCv.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        _isWriterSleeping.store(false);
+    }
+}
+
+struct LogRecordHeader {
+    uint32_t level;
+    int64_t time;
+};
+
+class AsyncLogWriter : public LogQueueWriter {
+public:
+    AsyncLogWriter();
+
+    bool push(LogLevel level, const char* msg);
+
+protected:
+    bool handleBatch(const std::vector<std::shared_ptr<LogQueue>>& queues) override;
+
+private:
+    std::string _record;
+};
+
+AsyncLogWriter::AsyncLogWriter()
+    : LogQueueWriter(LogQueueWriter::TextSlot)
+{
+}
+
+bool AsyncLogWriter::push(LogLevel level, const char* msg)
+{
+    LogRecordHeader header;
+    header.level = uint32_t(level);
+    header.time = int64_t(std::time(nullptr));
+    return LogQueueWriter::push(&header, sizeof(header), msg, std::strlen(msg));
+}
+
+bool AsyncLogWriter::handleBatch(const std::vector<std::shared_ptr<LogQueue>>& queues)
+{
+    std::shared_ptr<const LogHandler> handler = std::atomic_load(&currentLogHandler);
+    ColorStdError out;
+    bool isHandled = false;
+    for (const std::shared_ptr<LogQueue>& queue : queues) {
+        queue->beginRead();
+        while (queue->read(&_record)) {
+            LogRecordHeader header;
+            std::memcpy(&header, _record.data(), sizeof(header));
+            const char* msg = _record.c_str() + sizeof(header);
+            if (handler) {
+                (*handler)((LogLevel)header.level, msg);
+            } else if (writeLogLine(&out, (LogLevel)header.level, std::time_t(header.time), msg)) {
+                out << '\n';
+            }
+            isHandled = true;
+        }
+    }
+    if (isHandled && !handler) {
+        out << std::flush;
+    }
+    return isHandled;
+}
+
+// created on first use and never destroyed, so logging stays valid during static destruction
+static std::mutex asyncWriterMutex;
+static std::atomic<AsyncLogWriter*> asyncWriter(nullptr);
+
+static void stopAsyncLoggingAtExit()
+{
+    disableAsyncLogging();
+}
+
+static void flushLogOnPanic()
+{
+    AsyncLogWriter* writer = asyncWriter.load(std::memory_order_acquire);
+    if (writer && writer->isEnabled()) {
+        writer->flushFor(logPanicFlushTimeout);
+    }
+}
+
+void enableAsyncLogging(std::size_t queueSize, LogOverflowPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(asyncWriterMutex);
+    AsyncLogWriter* writer = asyncWriter.load();
+    if (!writer) {
+        writer = new AsyncLogWriter;
+        asyncWriter.store(writer);
+        std::atexit(stopAsyncLoggingAtExit);
+        addPanicFlushHook(flushLogOnPanic, PanicFlushStage::Drain);
+    }
+    if (writer->isEnabled()) {
+        writer->stop();
+    }
+    writer->start(queueSize, policy);
+}
+
+void disableAsyncLogging()
+{
+    std::lock_guard<std::mutex> lock(asyncWriterMutex);
+    AsyncLogWriter* writer = asyncWriter.load();
+    if (writer && writer->isEnabled()) {
+        writer->stop();
+    }
+}
+
+bool isAsyncLoggingEnabled()
+{
+    AsyncLogWriter* writer = asyncWriter.load(std::memory_order_acquire);
+    return writer && writer->isEnabled();
+}
+
+void flushLog()
+{
+    AsyncLogWriter* writer = asyncWriter.load(std::memory_order_acquire);
+    if (writer && writer->isEnabled()) {
+        writer->flush();
+    }
+}
+
+uint64_t droppedLogMessages()
+{
+    AsyncLogWriter* writer = asyncWriter.load(std::memory_order_acquire);
+    if (writer) {
+        return writer->dropped();
+    }
+    return 0;
 }
 
 void log(LogLevel level, const char* msg)
 {
-    currentLogHandler(level, msg);
+    AsyncLogWriter* writer = asyncWriter.load(std::memory_order_acquire);
+    if (writer && writer->isEnabled()) {
+        if (level != LogLevel::Panic && writer->push(level, msg)) {
+            return;
+        }
+        writer->flush();
+    }
+    std::shared_ptr<const LogHandler> handler = std::atomic_load(&currentLogHandler);
+    handleMessage(handler.get(), level, std::time(nullptr), msg);
+}
+
+#ifndef BMCL_HAVE_QT
+
+class LogStreamBuf : public std::streambuf {
+public:
+    std::string& str()
+    {
+        return _str;
+    }
+
+protected:
+    int_type overflow(int_type c) override
+    {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            _str.push_back(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override
+    {
+        _str.append(s, std::size_t(n));
+        return n;
+    }
+
+private:
+    std::string _str;
+};
+
+struct LogMessageBuffer {
+    LogMessageBuffer()
+        : stream(&buf)
+        , isInUse(false)
+    {
+    }
+
+    void reset()
+    {
+        buf.str().clear();
+        stream.clear();
+        stream.flags(std::ios_base::dec | std::ios_base::skipws);
+        stream.precision(6);
+        stream.width(0);
+        stream.fill(' ');
+    }
+
+    LogStreamBuf buf;
+    std::ostream stream;
+    bool isInUse;
+};
+
+static thread_local LogMessageBuffer localLogMessageBuffer;
+
+#endif
+
+Logger::Logger(LogLevel level)
+    : _level(level)
+    , _isEnabled(isLogLevelEnabled(level))
+#ifdef BMCL_HAVE_QT
+    , _stream(&_buffer, QIODevice::WriteOnly)
+{
 }
+#else
+    , _buffer(nullptr)
+    , _stream(nullptr)
+{
+    if (!_isEnabled) {
+        return;
+    }
+    if (localLogMessageBuffer.isInUse) {
+        _buffer = new LogMessageBuffer;
+    } else {
+        _buffer = &localLogMessageBuffer;
+        _buffer->reset();
+    }
+    _buffer->isInUse = true;
+    _stream = &_buffer->stream;
+}
+#endif
 
 Logger::~Logger()
 {
+    if (!_isEnabled) {
+        return;
+    }
 #ifdef BMCL_HAVE_QT
     log(_level, _buffer.toUtf8().constData());
 #else
-    log(_level, _stream.str().c_str());
+    log(_level, _buffer->buf.str().c_str());
+    if (_buffer == &localLogMessageBuffer) {
+        _buffer->isInUse = false;
+    } else {
+        delete _buffer;
+    }
 #endif
 }
 
 Logger& Logger::operator<<(const char* msg)
 {
-    if ((int)_level <= (int)_currentLogLevel) {
+    if (_isEnabled) {
 #ifdef BMCL_HAVE_QT
         _stream << QString::fromUtf8(msg);
 #else
-        _stream << msg;
+        *_stream << msg;
 #endif
     }
     return *this;
@@ -121,11 +623,11 @@ Logger& Logger::operator<<(const char* msg)
 template<>
 Logger& Logger::operator<<(const std::string& value)
 {
-    if ((int)_level <= (int)_currentLogLevel) {
+    if (_isEnabled) {
 #ifdef BMCL_HAVE_QT
         _stream << QString::fromStdString(value);
 #else
-        _stream << value.c_str();
+        _stream->write(value.data(), value.size());
 #endif
     }
     return *this;
@@ -10,16 +10,25 @@
 
 #include "bmcl/Config.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
 #ifdef BMCL_HAVE_QT
 #include <QTextStream>
 #include <QBuffer>
 #else
-#include <sstream>
+#include <ostream>
 #endif
 
-#define BMCL_LOG(level) bmcl::Logger(level)
+// levels above BMCL_LOG_MAX_LEVEL are compiled out, e.g. -DBMCL_LOG_MAX_LEVEL=4 removes debug messages
+#ifndef BMCL_LOG_MAX_LEVEL
+# define BMCL_LOG_MAX_LEVEL 5
+#endif
+
+// nothing is constructed or evaluated if the level is disabled
+#define BMCL_LOG(level) \
+    !bmcl::isLogLevelEnabled(level) ? (void)0 : bmcl::LogVoidify() & bmcl::Logger(level)
 #define BMCL_DEBUG() BMCL_LOG(bmcl::LogLevel::Debug)
 #define BMCL_INFO() BMCL_LOG(bmcl::LogLevel::Info)
 #define BMCL_WARNING() BMCL_LOG(bmcl::LogLevel::Warning)
@@ -36,18 +45,44 @@ enum class LogLevel {
     Debug = 5
 };
 
+enum class LogOverflowPolicy {
+    Drop, // message is discarded and counted, see droppedLogMessages()
+    Block // caller waits until the writer thread frees queue space
+};
+
 using LogHandler = std::function<void(LogLevel level, const char* msg)>;
 
 BMCL_EXPORT void setLogLevel(LogLevel level);
 BMCL_EXPORT LogLevel logLevel();
+inline bool isLogLevelEnabled(LogLevel level);
+// fixed width prefix used by the default handler, e.g. "INFO:    "
+BMCL_EXPORT const char* logLevelPrefix(LogLevel level);
 BMCL_EXPORT void setLogHandler(const LogHandler& handler);
 BMCL_EXPORT void setLogHandler(LogHandler&& handler);
 BMCL_EXPORT void setDefaulLogHandler();
 BMCL_EXPORT void log(LogLevel level, const char* msg);
 
+// in async mode log() copies messages into a lock-free per-thread queue of queueSize bytes
+// and returns, the handler is called only from a background writer thread which handles
+// messages in batches and flushes the default handler output once per batch
+// Panic messages flush the queues and are handled on the calling thread
+// queueSize is rounded up to a power of two of at least 4096, messages longer than
+// half of it are truncated to fit
+BMCL_EXPORT void enableAsyncLogging(std::size_t queueSize = 256 * 1024,
+                                    LogOverflowPolicy policy = LogOverflowPolicy::Drop);
+// handles all queued messages and stops the writer thread
+BMCL_EXPORT void disableAsyncLogging();
+BMCL_EXPORT bool isAsyncLoggingEnabled();
+// blocks until all messages queued before the call are handled
+BMCL_EXPORT void flushLog();
+BMCL_EXPORT uint64_t droppedLogMessages();
+
+struct LogMessageBuffer;
+
+// formats into a reusable thread local buffer, a fresh one is allocated only for nested messages
 class BMCL_EXPORT Logger {
 public:
-    inline Logger(LogLevel level);
+    Logger(LogLevel level);
     ~Logger();
 
     template <typename T>
@@ -55,28 +90,39 @@ public:
     Logger& operator<<(const char* value);
 
 private:
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
     LogLevel _level;
+    bool _isEnabled;
 #ifdef BMCL_HAVE_QT
     QTextStream _stream;
     QString _buffer;
 #else
-    std::ostringstream _stream;
+    LogMessageBuffer* _buffer;
+    std::ostream* _stream;
 #endif
 };
 
-inline Logger::Logger(LogLevel level)
-    : _level(level)
-#ifdef BMCL_HAVE_QT
-    , _stream(&_buffer, QIODevice::WriteOnly)
-#endif
+// turns the logger expression into void for the BMCL_LOG ternary
+struct LogVoidify {
+    void operator&(const Logger&) {}
+};
+
+inline bool isLogLevelEnabled(LogLevel level)
 {
+    return (int)level <= BMCL_LOG_MAX_LEVEL && (int)level <= (int)logLevel();
 }
 
 template <typename T>
 Logger& Logger::operator<<(const T& value)
 {
-    if ((int)_level <= (int)bmcl::logLevel()) {
+    if (_isEnabled) {
+#ifdef BMCL_HAVE_QT
         _stream << value;
+#else
+        *_stream << value;
+#endif
     }
     return *this;
 }
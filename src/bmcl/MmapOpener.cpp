@@ -20,6 +20,14 @@ static const HANDLE invalidFd = INVALID_HANDLE_VALUE;
 static constexpr int invalidFd = -1;
 #endif
 
+MmapOpenOptions::MmapOpenOptions()
+    : access(MmapAccess::Normal)
+    , willNeed(false)
+    , populate(false)
+    , hugePages(false)
+{
+}
+
 MmapOpener::MmapOpener()
     : _fd(invalidFd)
 #ifdef _WIN32
@@ -47,6 +55,11 @@ MmapOpener::~MmapOpener()
 }
 
 bool MmapOpener::open(const char* path)
+{
+    return open(path, MmapOpenOptions());
+}
+
+bool MmapOpener::open(const char* path, const MmapOpenOptions& options)
 {
     unmapAndClose();
 
@@ -104,16 +117,124 @@ bool MmapOpener::open(const char* path)
 
     _size = st.st_size;
 
-    _data = (const std::uint8_t*)::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    if (options.populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    _data = (const std::uint8_t*)::mmap(nullptr, _size, PROT_READ, flags, _fd, 0);
     if (_data == MAP_FAILED) {
         ::close(fd);
         _fd = -1;
+        _data = nullptr;
         return false;
     }
+
+    void* data = (void*)_data;
+    if (options.access == MmapAccess::Sequential) {
+        ::madvise(data, _size, MADV_SEQUENTIAL);
+    } else if (options.access == MmapAccess::Random) {
+        ::madvise(data, _size, MADV_RANDOM);
+    }
+    if (options.willNeed) {
+        ::madvise(data, _size, MADV_WILLNEED);
+    }
+#ifdef MADV_HUGEPAGE
+    if (options.hugePages) {
+        ::madvise(data, _size, MADV_HUGEPAGE);
+    }
+#endif
 #endif
     return true;
 }
 
+#ifndef _WIN32
+static std::size_t pageSize()
+{
+    static const std::size_t size = std::size_t(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+// returns false if the range is empty after clamping to the file size
+static bool alignRange(std::size_t fileSize, std::size_t* offset, std::size_t* size)
+{
+    if (*offset >= fileSize) {
+        return false;
+    }
+    std::size_t end = *offset + BMCL_MIN(*size, fileSize - *offset);
+    std::size_t begin = *offset & ~(pageSize() - 1);
+    *offset = begin;
+    *size = end - begin;
+    return *size != 0;
+}
+#endif
+
+bool MmapOpener::prefetch(std::size_t offset, std::size_t size) const
+{
+#ifdef _WIN32
+    (void)offset;
+    (void)size;
+    return false;
+#else
+    if (!isOpen() || !alignRange(_size, &offset, &size)) {
+        return false;
+    }
+    return ::madvise((void*)(_data + offset), size, MADV_WILLNEED) == 0;
+#endif
+}
+
+bool MmapOpener::evict(std::size_t offset, std::size_t size) const
+{
+#ifdef _WIN32
+    (void)offset;
+    (void)size;
+    return false;
+#else
+    if (!isOpen() || !alignRange(_size, &offset, &size)) {
+        return false;
+    }
+    // pages of a read only private mapping are never dirty, dropping them is safe
+    if (::madvise((void*)(_data + offset), size, MADV_DONTNEED) != 0) {
+        return false;
+    }
+#if defined(POSIX_FADV_DONTNEED) && !defined(BMCL_PLATFORM_APPLE)
+    ::posix_fadvise(_fd, off_t(offset), off_t(size), POSIX_FADV_DONTNEED);
+#endif
+    return true;
+#endif
+}
+
+MmapReadAhead::MmapReadAhead(const MmapOpener* file, std::size_t windowSize, bool evictBehind)
+    : _file(file)
+    , _windowSize(BMCL_MAX(windowSize, std::size_t(2)))
+    , _prefetchedEnd(0)
+    , _evictedEnd(0)
+    , _evictBehind(evictBehind)
+{
+}
+
+void MmapReadAhead::update(std::size_t position)
+{
+    if (position + _windowSize / 2 >= _prefetchedEnd && _prefetchedEnd < _file->size()) {
+        std::size_t begin = BMCL_MAX(position, _prefetchedEnd);
+        _file->prefetch(begin, _windowSize);
+        _prefetchedEnd = begin + _windowSize;
+    }
+    // keep one window behind the reader
+    if (_evictBehind && position >= _evictedEnd + 2 * _windowSize) {
+        std::size_t end = position - _windowSize;
+        _file->evict(_evictedEnd, end - _evictedEnd);
+        _evictedEnd = end;
+    }
+}
+
+void MmapReadAhead::reset()
+{
+    _prefetchedEnd = 0;
+    _evictedEnd = 0;
+}
+
 bool MmapOpener::close()
 {
     if (isOpen()) {
@@ -31,6 +31,25 @@
 
 namespace bmcl {
 
+enum class MmapAccess {
+    Normal,
+    Sequential, // aggressive kernel read-ahead, pages behind may be freed early
+    Random // read-ahead disabled
+};
+
+// applied when mapping, hints not supported by the platform are ignored
+struct BMCL_EXPORT MmapOpenOptions {
+    MmapOpenOptions();
+
+    MmapAccess access;
+    // start reading the whole file in the background (MADV_WILLNEED)
+    bool willNeed;
+    // prefault all pages before open() returns (MAP_POPULATE)
+    bool populate;
+    // transparent huge pages, needs kernel support for file backed THP (MADV_HUGEPAGE)
+    bool hugePages;
+};
+
 class BMCL_EXPORT MmapOpener {
 public:
 #ifdef _WIN32
@@ -48,8 +67,16 @@ public:
     MmapOpener& operator=(MmapOpener&& other);
 
     bool open(const char* path);
+    bool open(const char* path, const MmapOpenOptions& options);
     bool close();
 
+    // ranges are extended to page boundaries, return false if not supported or failed
+    // starts reading the range in the background
+    bool prefetch(std::size_t offset, std::size_t size) const;
+    // drops the range from this mapping and asks the kernel to drop it from the page cache,
+    // data is read again from the file on next access
+    bool evict(std::size_t offset, std::size_t size) const;
+
     bool isOpen() const;
 
     const std::uint8_t* data() const;
@@ -71,6 +98,23 @@ private:
     std::size_t _size;
 };
 
+// keeps prefetched data ahead of a sequential reader,
+// update() issues a prefetch of the next window each time the position crosses half a window
+class BMCL_EXPORT MmapReadAhead {
+public:
+    MmapReadAhead(const MmapOpener* file, std::size_t windowSize = 8 * 1024 * 1024, bool evictBehind = false);
+
+    void update(std::size_t position);
+    void reset();
+
+private:
+    const MmapOpener* _file;
+    std::size_t _windowSize;
+    std::size_t _prefetchedEnd;
+    std::size_t _evictedEnd;
+    bool _evictBehind;
+};
+
 inline bool MmapOpener::isOpen() const
 {
     return _data != nullptr;
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/MmapWindowReader.h"
+#include "bmcl/Assert.h"
+#include "bmcl/Bytes.h"
+
+#include <cstring>
+#include <string>
+
+namespace bmcl {
+
+#ifdef _WIN32
+static const HANDLE invalidFd = INVALID_HANDLE_VALUE;
+
+static std::size_t mapGranularity()
+{
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+#else
+static_assert(sizeof(off_t) == 8, "large file support is required, build with _FILE_OFFSET_BITS=64");
+
+static constexpr int invalidFd = -1;
+
+static std::size_t mapGranularity()
+{
+    return std::size_t(::sysconf(_SC_PAGESIZE));
+}
+#endif
+
+MmapWindowReader::MmapWindowReader()
+{
+    clearInternalData();
+}
+
+MmapWindowReader::~MmapWindowReader()
+{
+    close();
+}
+
+void MmapWindowReader::clearInternalData()
+{
+    _fd = invalidFd;
+#ifdef _WIN32
+    _mapHandle = nullptr;
+#endif
+    _size = 0;
+    _position = 0;
+    _windowSize = 0;
+    _maxWindows = 0;
+    _useCounter = 0;
+    _windows.clear();
+    _currentData = nullptr;
+    _currentOffset = 0;
+    _currentSize = 0;
+    _hasError = false;
+}
+
+bool MmapWindowReader::open(const char* path, std::size_t windowSize, std::size_t maxWindows)
+{
+    close();
+#ifdef _WIN32
+    std::size_t pathLen = std::strlen(path);
+    std::wstring wPath(path, path + pathLen);
+    _fd = ::CreateFileW(wPath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                        nullptr);
+    if (_fd == invalidFd) {
+        return false;
+    }
+    LARGE_INTEGER sizeStruct;
+    if (!::GetFileSizeEx(_fd, &sizeStruct)) {
+        ::CloseHandle(_fd);
+        _fd = invalidFd;
+        return false;
+    }
+    _size = sizeStruct.QuadPart;
+    if (_size != 0) {
+        _mapHandle = ::CreateFileMappingW(_fd, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!_mapHandle) {
+            ::CloseHandle(_fd);
+            _fd = invalidFd;
+            return false;
+        }
+    }
+#else
+    _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (_fd < 0) {
+        _fd = invalidFd;
+        return false;
+    }
+    struct stat st;
+    if (::fstat(_fd, &st) < 0) {
+        ::close(_fd);
+        _fd = invalidFd;
+        return false;
+    }
+    _size = std::uint64_t(st.st_size);
+#endif
+    std::size_t granularity = mapGranularity();
+    windowSize = BMCL_MAX(windowSize, granularity);
+    _windowSize = (windowSize + granularity - 1) & ~(granularity - 1);
+    _maxWindows = BMCL_MAX(maxWindows, std::size_t(1));
+    _windows.reserve(_maxWindows);
+    return true;
+}
+
+bool MmapWindowReader::close()
+{
+    if (!isOpen()) {
+        return false;
+    }
+    for (const Window& window : _windows) {
+        unmapWindow(window);
+    }
+#ifdef _WIN32
+    if (_mapHandle) {
+        ::CloseHandle(_mapHandle);
+    }
+    ::CloseHandle(_fd);
+#else
+    ::close(_fd);
+#endif
+    clearInternalData();
+    return true;
+}
+
+void MmapWindowReader::unmapWindow(const Window& window)
+{
+#ifdef _WIN32
+    ::UnmapViewOfFile(window.data);
+#else
+    ::munmap((void*)window.data, window.size);
+#endif
+}
+
+const MmapWindowReader::Window* MmapWindowReader::mapWindow(std::uint64_t index)
+{
+    _useCounter++;
+    for (Window& window : _windows) {
+        if (window.index == index) {
+            window.lastUse = _useCounter;
+            return &window;
+        }
+    }
+
+    Window* window;
+    if (_windows.size() < _maxWindows) {
+        _windows.emplace_back();
+        window = &_windows.back();
+    } else {
+        window = &_windows[0];
+        for (Window& w : _windows) {
+            if (w.lastUse < window->lastUse) {
+                window = &w;
+            }
+        }
+        unmapWindow(*window);
+        if (window->data == _currentData) {
+            _currentData = nullptr;
+        }
+    }
+
+    std::uint64_t offset = index * _windowSize;
+    std::size_t size = std::size_t(BMCL_MIN(std::uint64_t(_windowSize), _size - offset));
+#ifdef _WIN32
+    const void* data = ::MapViewOfFile(_mapHandle, FILE_MAP_READ, DWORD(offset >> 32), DWORD(offset & 0xffffffff), size);
+#else
+    const void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, _fd, off_t(offset));
+    if (data == MAP_FAILED) {
+        data = nullptr;
+    }
+#endif
+    // fails if the address space is exhausted, the slot is dropped
+    if (!data) {
+        _windows.erase(_windows.begin() + (window - _windows.data()));
+        _hasError = true;
+        return nullptr;
+    }
+    window->index = index;
+    window->lastUse = _useCounter;
+    window->data = (const std::uint8_t*)data;
+    window->size = size;
+    return window;
+}
+
+bool MmapWindowReader::readSlow(void* dest, std::size_t size, std::uint64_t position)
+{
+    std::uint8_t* out = (std::uint8_t*)dest;
+    while (size != 0) {
+        const Window* window = mapWindow(position / _windowSize);
+        if (!window) {
+            std::memset(out, 0, size);
+            return false;
+        }
+        std::size_t offset = std::size_t(position % _windowSize);
+        std::size_t chunk = BMCL_MIN(size, window->size - offset);
+        std::memcpy(out, window->data + offset, chunk);
+        out += chunk;
+        size -= chunk;
+        position += chunk;
+        _currentData = window->data;
+        _currentOffset = window->index * _windowSize;
+        _currentSize = window->size;
+    }
+    return true;
+}
+
+void MmapWindowReader::seek(std::uint64_t position)
+{
+    BMCL_ASSERT(position <= _size);
+    _position = position;
+}
+
+void MmapWindowReader::skip(std::uint64_t size)
+{
+    BMCL_ASSERT(size <= sizeLeft());
+    _position += size;
+}
+
+void MmapWindowReader::peek(void* dest, std::size_t size, std::uint64_t offset)
+{
+    BMCL_ASSERT(offset <= sizeLeft() && size <= sizeLeft() - offset);
+    readSlow(dest, size, _position + offset);
+}
+
+Bytes MmapWindowReader::readableChunk()
+{
+    if (_position == _size) {
+        return Bytes();
+    }
+    const Window* window = mapWindow(_position / _windowSize);
+    if (!window) {
+        return Bytes();
+    }
+    _currentData = window->data;
+    _currentOffset = window->index * _windowSize;
+    _currentSize = window->size;
+    std::size_t offset = std::size_t(_position - _currentOffset);
+    return Bytes(window->data + offset, window->size - offset);
+}
+}
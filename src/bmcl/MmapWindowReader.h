@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/MmapOpener.h"
+#include "bmcl/Reader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace bmcl {
+
+// reads a file through fixed size aligned windows mapped on demand,
+// at most maxWindows are mapped at once and the least recently used one is unmapped first
+// allows reading files larger than the address space, reads crossing window boundaries are handled transparently
+// if a window can't be mapped, read() and peek() fill dest with zeros, readableChunk() returns empty bytes
+// and hasError() returns true
+class BMCL_EXPORT MmapWindowReader : public Reader<MmapWindowReader> {
+public:
+    using FdType = MmapOpener::FdType;
+
+    MmapWindowReader();
+    MmapWindowReader(const MmapWindowReader& other) = delete;
+    ~MmapWindowReader();
+
+    MmapWindowReader& operator=(const MmapWindowReader& other) = delete;
+
+    // windowSize is rounded up to the mapping granularity
+    bool open(const char* path, std::size_t windowSize = 16 * 1024 * 1024, std::size_t maxWindows = 4);
+    bool close();
+
+    bool isOpen() const;
+    bool hasError() const;
+    bool isEmpty() const;
+    std::uint64_t size() const;
+    std::uint64_t position() const;
+    std::uint64_t sizeLeft() const;
+    std::size_t windowSize() const;
+    std::size_t mappedWindows() const;
+
+    void seek(std::uint64_t position);
+    void skip(std::uint64_t size);
+    void read(void* dest, std::size_t size);
+    void peek(void* dest, std::size_t size, std::uint64_t offset);
+
+    // maps the window containing the current position and returns data from the position to the window end,
+    // valid until the next call mapping a window, empty at the end of file
+    Bytes readableChunk();
+
+private:
+    struct Window {
+        std::uint64_t index;
+        std::uint64_t lastUse;
+        const std::uint8_t* data;
+        std::size_t size;
+    };
+
+    const Window* mapWindow(std::uint64_t index);
+    void unmapWindow(const Window& window);
+    bool readSlow(void* dest, std::size_t size, std::uint64_t position);
+    void clearInternalData();
+
+    FdType _fd;
+#ifdef _WIN32
+    FdType _mapHandle;
+#endif
+    std::uint64_t _size;
+    std::uint64_t _position;
+    std::size_t _windowSize;
+    std::size_t _maxWindows;
+    std::uint64_t _useCounter;
+    std::vector<Window> _windows;
+    // last used window, used without lookup while reads stay inside it
+    const std::uint8_t* _currentData;
+    std::uint64_t _currentOffset;
+    std::size_t _currentSize;
+    bool _hasError;
+};
+
+inline bool MmapWindowReader::isOpen() const
+{
+    return _windowSize != 0;
+}
+
+inline bool MmapWindowReader::hasError() const
+{
+    return _hasError;
+}
+
+inline bool MmapWindowReader::isEmpty() const
+{
+    return _position == _size;
+}
+
+inline std::uint64_t MmapWindowReader::size() const
+{
+    return _size;
+}
+
+inline std::uint64_t MmapWindowReader::position() const
+{
+    return _position;
+}
+
+inline std::uint64_t MmapWindowReader::sizeLeft() const
+{
+    return _size - _position;
+}
+
+inline std::size_t MmapWindowReader::windowSize() const
+{
+    return _windowSize;
+}
+
+inline std::size_t MmapWindowReader::mappedWindows() const
+{
+    return _windows.size();
+}
+
+inline void MmapWindowReader::read(void* dest, std::size_t size)
+{
+    std::uint64_t offset = _position - _currentOffset;
+    if (_currentData && offset < _currentSize && _currentSize - offset >= size) {
+        std::memcpy(dest, _currentData + offset, size);
+        _position += size;
+        return;
+    }
+    BMCL_ASSERT(size <= sizeLeft());
+    if (readSlow(dest, size, _position)) {
+        _position += size;
+    }
+}
+}
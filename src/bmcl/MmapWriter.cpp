@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/MmapWriter.h"
+#include "bmcl/Assert.h"
+#include "bmcl/Bytes.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+namespace bmcl {
+
+#ifdef _WIN32
+static const HANDLE invalidFd = INVALID_HANDLE_VALUE;
+
+static std::size_t pageSize()
+{
+    // MapViewOfFile offsets must be aligned to allocation granularity
+    SYSTEM_INFO info;
+    ::GetSystemInfo(&info);
+    return info.dwAllocationGranularity;
+}
+#else
+static constexpr int invalidFd = -1;
+
+static std::size_t pageSize()
+{
+    static const std::size_t size = std::size_t(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+#endif
+
+static std::size_t alignUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+MmapWriter::MmapWriter()
+    : _fd(invalidFd)
+#ifdef _WIN32
+    , _mapHandle(nullptr)
+#endif
+    , _data(nullptr)
+    , _size(0)
+    , _capacity(0)
+    , _growSize(0)
+    , _isOpen(false)
+    , _hasError(false)
+{
+}
+
+MmapWriter::MmapWriter(MmapWriter&& other)
+    : _fd(other._fd)
+#ifdef _WIN32
+    , _mapHandle(other._mapHandle)
+#endif
+    , _data(other._data)
+    , _size(other._size)
+    , _capacity(other._capacity)
+    , _growSize(other._growSize)
+    , _isOpen(other._isOpen)
+    , _hasError(other._hasError)
+{
+    other.clearInternalData();
+}
+
+MmapWriter::~MmapWriter()
+{
+    unmapAndClose();
+}
+
+MmapWriter& MmapWriter::operator=(MmapWriter&& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    unmapAndClose();
+    _fd = other._fd;
+#ifdef _WIN32
+    _mapHandle = other._mapHandle;
+#endif
+    _data = other._data;
+    _size = other._size;
+    _capacity = other._capacity;
+    _growSize = other._growSize;
+    _isOpen = other._isOpen;
+    _hasError = other._hasError;
+    other.clearInternalData();
+    return *this;
+}
+
+void MmapWriter::clearInternalData()
+{
+    _fd = invalidFd;
+#ifdef _WIN32
+    _mapHandle = nullptr;
+#endif
+    _data = nullptr;
+    _size = 0;
+    _capacity = 0;
+    _growSize = 0;
+    _isOpen = false;
+    _hasError = false;
+}
+
+bool MmapWriter::open(const char* path, std::size_t growSize)
+{
+    unmapAndClose();
+#ifdef _WIN32
+    std::size_t pathLen = std::strlen(path);
+    std::wstring wPath(path, path + pathLen);
+    _fd = ::CreateFileW(wPath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS,
+                        FILE_ATTRIBUTE_NORMAL, nullptr);
+#else
+    _fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+    if (_fd == invalidFd) {
+        return false;
+    }
+    _growSize = alignUp(BMCL_MAX(growSize, std::size_t(1)), pageSize());
+    _isOpen = true;
+    return true;
+}
+
+bool MmapWriter::close()
+{
+    if (!_isOpen) {
+        return false;
+    }
+    bool isOk = !_hasError;
+#ifdef _WIN32
+    if (_data) {
+        isOk = ::FlushViewOfFile(_data, _size) && isOk;
+        ::UnmapViewOfFile(_data);
+        ::CloseHandle(_mapHandle);
+    }
+    LARGE_INTEGER end;
+    end.QuadPart = _size;
+    isOk = ::SetFilePointerEx(_fd, end, nullptr, FILE_BEGIN) && ::SetEndOfFile(_fd) && isOk;
+    ::CloseHandle(_fd);
+#else
+    if (_data) {
+        ::munmap(_data, _capacity);
+    }
+    isOk = ::ftruncate(_fd, off_t(_size)) == 0 && isOk;
+    ::close(_fd);
+#endif
+    clearInternalData();
+    return isOk;
+}
+
+void MmapWriter::unmapAndClose()
+{
+    if (_isOpen) {
+        close();
+    }
+}
+
+bool MmapWriter::map(std::size_t capacity)
+{
+#ifdef _WIN32
+    if (_data) {
+        ::UnmapViewOfFile(_data);
+        ::CloseHandle(_mapHandle);
+        _data = nullptr;
+    }
+    std::uint64_t size64 = capacity;
+    _mapHandle = ::CreateFileMappingW(_fd, nullptr, PAGE_READWRITE, DWORD(size64 >> 32),
+                                      DWORD(size64 & 0x00000000ffffffffull), nullptr);
+    if (!_mapHandle) {
+        return false;
+    }
+    _data = (std::uint8_t*)::MapViewOfFile(_mapHandle, FILE_MAP_WRITE, 0, 0, 0);
+    if (!_data) {
+        ::CloseHandle(_mapHandle);
+        _mapHandle = nullptr;
+        return false;
+    }
+#else
+    // disk space is allocated up front so that writing to the mapping can't fail with SIGBUS on a full disk
+# if defined(BMCL_PLATFORM_LINUX)
+    int rv = ::fallocate(_fd, 0, off_t(_capacity), off_t(capacity - _capacity));
+    if (rv != 0 && (errno == EOPNOTSUPP || errno == ENOSYS)) {
+        rv = ::ftruncate(_fd, off_t(capacity));
+    }
+# else
+    int rv = ::ftruncate(_fd, off_t(capacity));
+# endif
+    if (rv != 0) {
+        return false;
+    }
+    void* data;
+# if defined(MREMAP_MAYMOVE)
+    if (_data) {
+        data = ::mremap(_data, _capacity, capacity, MREMAP_MAYMOVE);
+    } else {
+        data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+    }
+# else
+    if (_data) {
+        ::munmap(_data, _capacity);
+        _data = nullptr;
+    }
+    data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+# endif
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    _data = (std::uint8_t*)data;
+#endif
+    return true;
+}
+
+bool MmapWriter::grow(std::size_t minCapacity)
+{
+    if (_hasError || !_isOpen) {
+        return false;
+    }
+    std::size_t capacity = BMCL_MAX(_capacity + _growSize, alignUp(minCapacity, pageSize()));
+    if (!map(capacity)) {
+        _hasError = true;
+        return false;
+    }
+    _capacity = capacity;
+    return true;
+}
+
+std::uint8_t* MmapWriter::reserve(std::size_t size)
+{
+    if (_capacity - _size < size && !grow(_size + size)) {
+        return nullptr;
+    }
+    return _data + _size;
+}
+
+void MmapWriter::advance(std::size_t size)
+{
+    BMCL_ASSERT(_capacity - _size >= size);
+    _size += size;
+}
+
+void MmapWriter::write(const void* data, std::size_t size)
+{
+    std::uint8_t* dest = reserve(size);
+    if (dest) {
+        std::memcpy(dest, data, size);
+        _size += size;
+    }
+}
+
+Bytes MmapWriter::writtenData() const
+{
+    return Bytes(_data, _size);
+}
+
+bool MmapWriter::flushAsync(std::size_t offset, std::size_t size)
+{
+    if (!_isOpen) {
+        return false;
+    }
+    // nothing is mapped until the first write
+    if (offset >= _size || size == 0) {
+        return true;
+    }
+    size = BMCL_MIN(size, _size - offset);
+#if defined(_WIN32)
+    return ::FlushViewOfFile(_data + offset, size);
+#elif defined(BMCL_PLATFORM_LINUX)
+    // MS_ASYNC doesn't start writeback on linux
+    return ::sync_file_range(_fd, off_t(offset), off_t(size), SYNC_FILE_RANGE_WRITE) == 0;
+#else
+    std::size_t begin = offset & ~(pageSize() - 1);
+    return ::msync(_data + begin, offset + size - begin, MS_ASYNC) == 0;
+#endif
+}
+
+bool MmapWriter::flush(std::size_t offset, std::size_t size)
+{
+    if (!_isOpen) {
+        return false;
+    }
+    // nothing is mapped until the first write
+    if (offset >= _size || size == 0) {
+        return true;
+    }
+    size = BMCL_MIN(size, _size - offset);
+#if defined(_WIN32)
+    return ::FlushViewOfFile(_data + offset, size) && ::FlushFileBuffers(_fd);
+#else
+    std::size_t begin = offset & ~(pageSize() - 1);
+    return ::msync(_data + begin, offset + size - begin, MS_SYNC) == 0;
+#endif
+}
+
+bool MmapWriter::flush()
+{
+    return flush(0, _size);
+}
+}
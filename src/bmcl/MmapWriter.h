@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/MmapOpener.h"
+#include "bmcl/Writer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bmcl {
+
+// appends to a shared writable mapping of a file, data goes straight to the page cache
+// the file is extended by growSize chunks with preallocated disk space and truncated to size() on close
+// if the file can't be extended, write() discards data and hasError() returns true
+class BMCL_EXPORT MmapWriter : public Writer<MmapWriter> {
+public:
+    using FdType = MmapOpener::FdType;
+
+    MmapWriter();
+    MmapWriter(const MmapWriter& other) = delete;
+    MmapWriter(MmapWriter&& other);
+    ~MmapWriter();
+
+    MmapWriter& operator=(const MmapWriter& other) = delete;
+    MmapWriter& operator=(MmapWriter&& other);
+
+    // creates or truncates the file
+    bool open(const char* path, std::size_t growSize = 64 * 1024 * 1024);
+    bool close();
+
+    bool isOpen() const;
+    bool hasError() const;
+
+    // bytes written
+    std::size_t size() const;
+    // mapped size, file size until close()
+    std::size_t capacity() const;
+    const std::uint8_t* data() const;
+    std::uint8_t* data();
+    Bytes writtenData() const;
+
+    void write(const void* data, std::size_t size);
+    // returns space for at least size bytes at the current position for serializing in place,
+    // followed by advance(), nullptr if the file can't be extended
+    std::uint8_t* reserve(std::size_t size);
+    void advance(std::size_t size);
+
+    // flush functions fail only if the writer is closed or the system call fails, empty ranges succeed
+    // starts writeback of the range and returns without waiting
+    bool flushAsync(std::size_t offset, std::size_t size);
+    // writes the range to disk and waits
+    bool flush(std::size_t offset, std::size_t size);
+    bool flush();
+
+private:
+    bool grow(std::size_t minCapacity);
+    bool map(std::size_t capacity);
+    void unmapAndClose();
+    void clearInternalData();
+
+    FdType _fd;
+#ifdef _WIN32
+    FdType _mapHandle;
+#endif
+    std::uint8_t* _data;
+    std::size_t _size;
+    std::size_t _capacity;
+    std::size_t _growSize;
+    bool _isOpen;
+    bool _hasError;
+};
+
+inline bool MmapWriter::isOpen() const
+{
+    return _isOpen;
+}
+
+inline bool MmapWriter::hasError() const
+{
+    return _hasError;
+}
+
+inline std::size_t MmapWriter::size() const
+{
+    return _size;
+}
+
+inline std::size_t MmapWriter::capacity() const
+{
+    return _capacity;
+}
+
+inline const std::uint8_t* MmapWriter::data() const
+{
+    return _data;
+}
+
+inline std::uint8_t* MmapWriter::data()
+{
+    return _data;
+}
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/Writer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bmcl {
+
+// locale independent number <-> text conversion, no allocations
+
+constexpr std::size_t formatIntMaxSize = 20;
+constexpr std::size_t formatDoubleMaxSize = 24;
+
+enum class NumberParseError {
+    Empty,
+    InvalidFormat,
+    OutOfRange
+};
+
+// dest must have room for formatIntMaxSize chars, returns number of chars written
+BMCL_EXPORT std::size_t formatInt(int64_t value, char* dest);
+BMCL_EXPORT std::size_t formatUint(uint64_t value, char* dest);
+
+// shortest representation that parses back to the same value
+// fixed notation for decimal exponents in [-5, 17), scientific otherwise (1.5e+300, 2e-7)
+// dest must have room for formatDoubleMaxSize chars, returns number of chars written
+BMCL_EXPORT std::size_t formatDouble(double value, char* dest);
+
+BMCL_EXPORT void formatInt(int64_t value, std::string* dest);
+BMCL_EXPORT void formatUint(uint64_t value, std::string* dest);
+BMCL_EXPORT void formatDouble(double value, std::string* dest);
+
+template <typename B>
+void formatInt(int64_t value, Writer<B>* dest);
+template <typename B>
+void formatUint(uint64_t value, Writer<B>* dest);
+template <typename B>
+void formatDouble(double value, Writer<B>* dest);
+
+// decimal only, optional sign, the whole view must be a number
+BMCL_EXPORT Result<int64_t, NumberParseError> parseInt(StringView str);
+BMCL_EXPORT Result<uint64_t, NumberParseError> parseUint(StringView str);
+
+// accepts [+-]digits[.digits][e[+-]digits], inf, infinity and nan (case insensitive)
+// always uses '.' as a decimal point, overflow to infinity is reported as OutOfRange
+BMCL_EXPORT Result<double, NumberParseError> parseDouble(StringView str);
+
+template <typename B>
+inline void formatInt(int64_t value, Writer<B>* dest)
+{
+    char tmp[formatIntMaxSize];
+    static_cast<B*>(dest)->write(tmp, formatInt(value, tmp));
+}
+
+template <typename B>
+inline void formatUint(uint64_t value, Writer<B>* dest)
+{
+    char tmp[formatIntMaxSize];
+    static_cast<B*>(dest)->write(tmp, formatUint(value, tmp));
+}
+
+template <typename B>
+inline void formatDouble(double value, Writer<B>* dest)
+{
+    char tmp[formatDoubleMaxSize];
+    static_cast<B*>(dest)->write(tmp, formatDouble(value, tmp));
+}
+}
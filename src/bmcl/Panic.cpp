@@ -10,8 +10,12 @@
 #include "bmcl/Panic.h"
 #include "bmcl/Alloca.h"
 
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
 #include <cstdio>
+#include <mutex>
+#include <thread>
 
 namespace bmcl {
 
@@ -37,9 +41,56 @@ PanicHandler defaultPanicHandler()
     return defaultHandler;
 }
 
+// read without locking by panic(), slots are only filled and never cleared
+static std::mutex flushHooksMutex;
+static std::atomic<PanicFlushHook> flushHooks[2][maxPanicFlushHooks];
+static std::atomic<bool> isPanicking(false);
+static thread_local bool isPanickingThread = false;
+
+bool addPanicFlushHook(PanicFlushHook hook, PanicFlushStage stage)
+{
+    std::lock_guard<std::mutex> lock(flushHooksMutex);
+    std::atomic<PanicFlushHook>* hooks = flushHooks[(int)stage];
+    for (std::size_t i = 0; i < maxPanicFlushHooks; i++) {
+        PanicFlushHook current = hooks[i].load(std::memory_order_relaxed);
+        if (current == hook) {
+            return true;
+        }
+        if (!current) {
+            hooks[i].store(hook, std::memory_order_release);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void runFlushHooks(PanicFlushStage stage)
+{
+    std::atomic<PanicFlushHook>* hooks = flushHooks[(int)stage];
+    for (std::size_t i = 0; i < maxPanicFlushHooks; i++) {
+        PanicFlushHook hook = hooks[i].load(std::memory_order_acquire);
+        if (!hook) {
+            return;
+        }
+        hook();
+    }
+}
+
 BMCL_NORETURN void panic(const char* msg)
 {
     currentHandler(msg);
+    // a hook that panics aborts without running hooks again
+    if (!isPanickingThread) {
+        isPanickingThread = true;
+        if (isPanicking.exchange(true)) {
+            // another thread runs the hooks and aborts the process
+            while (true) {
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+            }
+        }
+        runFlushHooks(PanicFlushStage::Drain);
+        runFlushHooks(PanicFlushStage::Sync);
+    }
     std::abort();
 }
 }
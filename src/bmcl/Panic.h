@@ -10,13 +10,25 @@
 
 #include "bmcl/Config.h"
 
+#include <cstddef>
+
 namespace bmcl {
 
 typedef void (*PanicHandler)(const char* msg);
+typedef void (*PanicFlushHook)();
+
+enum class PanicFlushStage {
+    Drain, // moves pending data to its destination, e.g. async log queues to the log handler
+    Sync   // writes destinations to disk, runs after all Drain hooks
+};
 
 BMCL_EXPORT void setPanicHandler(PanicHandler handler);
 BMCL_EXPORT PanicHandler panicHandler();
 BMCL_EXPORT PanicHandler defaultPanicHandler();
+// hooks are called once by panic() after the handler and before aborting, in registration order within a stage
+// adding a hook again has no effect, returns false if the stage already has maxPanicFlushHooks hooks
+BMCL_EXPORT bool addPanicFlushHook(PanicFlushHook hook, PanicFlushStage stage);
+const std::size_t maxPanicFlushHooks = 16;
 
 BMCL_EXPORT BMCL_NORETURN void panic(const char* msg);
 };
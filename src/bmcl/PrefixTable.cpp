@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/PrefixTable.h"
+#include "bmcl/Assert.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bmcl {
+
+constexpr uint32_t PrefixTrie::maxValue;
+constexpr uint32_t PrefixTrie::notFound;
+constexpr uint32_t PrefixTrie::childFlag;
+constexpr std::size_t PrefixTrie::rootSize;
+constexpr std::size_t PrefixTrie::nodeSize;
+
+// number of lookups started and prefetched ahead in bulk operations
+static const std::size_t bulkChunk = 16;
+
+static inline void prefetchEntry(const uint32_t* entry)
+{
+#if defined(__GNUC__)
+    __builtin_prefetch(entry);
+#else
+    (void)entry;
+#endif
+}
+
+PrefixTrie::PrefixTrie(std::size_t keySize)
+    : _entries(rootSize, 0)
+    , _sizes(rootSize, 0)
+    , _keySize(keySize)
+{
+}
+
+PrefixTrie::~PrefixTrie()
+{
+}
+
+std::size_t PrefixTrie::memoryUsage() const
+{
+    return _entries.capacity() * sizeof(uint32_t) + _sizes.capacity();
+}
+
+void PrefixTrie::clear()
+{
+    _entries.assign(rootSize, 0);
+    _sizes.assign(rootSize, 0);
+    _freeNodes.clear();
+    _prefixes.clear();
+}
+
+PrefixTrie::Key PrefixTrie::normalize(const uint8_t* key, unsigned prefixSize) const
+{
+    Key normalized;
+    normalized.fill(0);
+    std::memcpy(normalized.data(), key, prefixSize / 8);
+    if (prefixSize % 8) {
+        normalized[prefixSize / 8] = key[prefixSize / 8] & uint8_t(0xff00 >> (prefixSize % 8));
+    }
+    return normalized;
+}
+
+inline unsigned PrefixTrie::levelEnd(unsigned level) const
+{
+    return 16 + level * 8;
+}
+
+inline std::size_t PrefixTrie::entryIndex(const uint8_t* key, unsigned level) const
+{
+    if (level == 0) {
+        return (std::size_t(key[0]) << 8) | key[1];
+    }
+    return key[level + 1];
+}
+
+uint32_t PrefixTrie::allocateNode(uint32_t entry, uint8_t size)
+{
+    uint32_t node;
+    if (_freeNodes.empty()) {
+        node = uint32_t(childFlag | ((_entries.size() - rootSize) / nodeSize + 1));
+        _entries.resize(_entries.size() + nodeSize);
+        _sizes.resize(_sizes.size() + nodeSize);
+    } else {
+        node = _freeNodes.back();
+        _freeNodes.pop_back();
+    }
+    std::size_t offset = nodeOffset(node);
+    std::fill(_entries.begin() + offset, _entries.begin() + offset + nodeSize, entry);
+    std::fill(_sizes.begin() + offset, _sizes.begin() + offset + nodeSize, size);
+    return node;
+}
+
+void PrefixTrie::freeNode(uint32_t entry)
+{
+    _freeNodes.push_back(entry);
+}
+
+// sets entries not covered by a longer prefix, descends into child nodes
+void PrefixTrie::fill(std::size_t offset, std::size_t count, uint32_t entry, uint8_t size)
+{
+    for (std::size_t i = offset; i < offset + count; i++) {
+        if (_entries[i] & childFlag) {
+            fill(nodeOffset(_entries[i]), nodeSize, entry, size);
+        } else if (_sizes[i] <= size) {
+            _entries[i] = entry;
+            _sizes[i] = size;
+        }
+    }
+}
+
+// replaces entries that came from a prefix of the given size
+void PrefixTrie::replace(std::size_t offset, std::size_t count, uint8_t size, uint32_t entry, uint8_t newSize)
+{
+    for (std::size_t i = offset; i < offset + count; i++) {
+        if (_entries[i] & childFlag) {
+            replace(nodeOffset(_entries[i]), nodeSize, size, entry, newSize);
+        } else if (_sizes[i] == size) {
+            _entries[i] = entry;
+            _sizes[i] = newSize;
+        }
+    }
+}
+
+// expands a prefix over the entries it covers, on replace only entries of this prefix are changed and child nodes
+// left filled with a single route covering the whole parent entry are merged back into it
+void PrefixTrie::assign(const uint8_t* key, unsigned prefixSize, uint32_t entry, uint8_t entrySize, bool isReplace)
+{
+    std::size_t path[16];
+    std::size_t offset = 0;
+    unsigned level = 0;
+    while (true) {
+        unsigned end = levelEnd(level);
+        std::size_t index = offset + entryIndex(key, level);
+        if (prefixSize <= end) {
+            std::size_t count = std::size_t(1) << (end - prefixSize);
+            index &= ~(count - 1);
+            if (isReplace) {
+                replace(index, count, uint8_t(prefixSize), entry, entrySize);
+            } else {
+                fill(index, count, entry, entrySize);
+            }
+            break;
+        }
+        if (!(_entries[index] & childFlag)) {
+            if (isReplace) {
+                // merged entries only hold routes not longer than their level, none of them is replaced
+                BMCL_ASSERT(_sizes[index] <= end);
+                return;
+            }
+            // the node is filled with the route covering this entry
+            uint32_t node = allocateNode(_entries[index], _sizes[index]);
+            _entries[index] = node;
+            _sizes[index] = 0;
+        }
+        path[level] = index;
+        offset = nodeOffset(_entries[index]);
+        level++;
+    }
+
+    if (!isReplace) {
+        return;
+    }
+    while (level != 0) {
+        level--;
+        std::size_t index = path[level];
+        std::size_t child = nodeOffset(_entries[index]);
+        uint32_t first = _entries[child];
+        uint8_t firstSize = _sizes[child];
+        // a route longer than the parent level can't be stored in the parent entry
+        if ((first & childFlag) || firstSize > levelEnd(level)) {
+            return;
+        }
+        for (std::size_t i = child + 1; i < child + nodeSize; i++) {
+            if (_entries[i] != first || _sizes[i] != firstSize) {
+                return;
+            }
+        }
+        freeNode(_entries[index]);
+        _entries[index] = first;
+        _sizes[index] = firstSize;
+    }
+}
+
+bool PrefixTrie::insert(const uint8_t* key, unsigned prefixSize, uint32_t value)
+{
+    BMCL_ASSERT(prefixSize <= _keySize * 8);
+    BMCL_ASSERT(value <= maxValue);
+    Key normalized = normalize(key, prefixSize);
+    auto it = _prefixes.find(std::make_pair(normalized, prefixSize));
+    if (it != _prefixes.end()) {
+        it->second = value;
+        assign(normalized.data(), prefixSize, value + 1, uint8_t(prefixSize), true);
+        return false;
+    }
+    _prefixes.emplace(std::make_pair(normalized, prefixSize), value);
+    assign(normalized.data(), prefixSize, value + 1, uint8_t(prefixSize), false);
+    return true;
+}
+
+bool PrefixTrie::remove(const uint8_t* key, unsigned prefixSize)
+{
+    BMCL_ASSERT(prefixSize <= _keySize * 8);
+    Key normalized = normalize(key, prefixSize);
+    auto it = _prefixes.find(std::make_pair(normalized, prefixSize));
+    if (it == _prefixes.end()) {
+        return false;
+    }
+    _prefixes.erase(it);
+
+    // entries of the removed prefix go to the next shorter prefix containing it
+    uint32_t entry = 0;
+    uint8_t entrySize = 0;
+    for (unsigned size = prefixSize; size != 0; size--) {
+        auto covering = _prefixes.find(std::make_pair(normalize(key, size - 1), size - 1));
+        if (covering != _prefixes.end()) {
+            entry = covering->second + 1;
+            entrySize = uint8_t(size - 1);
+            break;
+        }
+    }
+    assign(normalized.data(), prefixSize, entry, entrySize, true);
+    return true;
+}
+
+Option<uint32_t> PrefixTrie::find(const uint8_t* key, unsigned prefixSize) const
+{
+    if (prefixSize > _keySize * 8) {
+        return None;
+    }
+    auto it = _prefixes.find(std::make_pair(normalize(key, prefixSize), prefixSize));
+    if (it == _prefixes.end()) {
+        return None;
+    }
+    return it->second;
+}
+
+uint32_t PrefixTrie::lookup(const uint8_t* key) const
+{
+    uint32_t entry = _entries[(std::size_t(key[0]) << 8) | key[1]];
+    for (std::size_t i = 2; entry & childFlag; i++) {
+        entry = _entries[nodeOffset(entry) + key[i]];
+    }
+    return entry;
+}
+
+Ipv4PrefixTable::Ipv4PrefixTable()
+    : PrefixTrie(4)
+{
+}
+
+bool Ipv4PrefixTable::insert(Ipv4Address address, unsigned prefixSize, uint32_t value)
+{
+    return PrefixTrie::insert(address.toArray().data(), prefixSize, value);
+}
+
+bool Ipv4PrefixTable::remove(Ipv4Address address, unsigned prefixSize)
+{
+    return PrefixTrie::remove(address.toArray().data(), prefixSize);
+}
+
+Option<uint32_t> Ipv4PrefixTable::find(Ipv4Address address, unsigned prefixSize) const
+{
+    return PrefixTrie::find(address.toArray().data(), prefixSize);
+}
+
+inline uint32_t Ipv4PrefixTable::lookupEntry(uint32_t address) const
+{
+    uint32_t entry = _entries[address >> 16];
+    if (entry & childFlag) {
+        entry = _entries[nodeOffset(entry) + ((address >> 8) & 0xff)];
+        if (entry & childFlag) {
+            entry = _entries[nodeOffset(entry) + (address & 0xff)];
+        }
+    }
+    return entry;
+}
+
+Option<uint32_t> Ipv4PrefixTable::lookup(Ipv4Address address) const
+{
+    uint32_t entry = lookupEntry(address.toUint32());
+    if (entry == 0) {
+        return None;
+    }
+    return entry - 1;
+}
+
+std::size_t Ipv4PrefixTable::lookup(const Ipv4Address* addresses, std::size_t count, uint32_t* dest) const
+{
+    std::size_t found = 0;
+    uint32_t entries[bulkChunk];
+    for (std::size_t start = 0; start < count; start += bulkChunk) {
+        std::size_t n = BMCL_MIN(bulkChunk, count - start);
+        // root entries of the whole chunk are read first so that second level loads overlap
+        for (std::size_t i = 0; i < n; i++) {
+            uint32_t address = addresses[start + i].toUint32();
+            entries[i] = _entries[address >> 16];
+            if (entries[i] & childFlag) {
+                prefetchEntry(&_entries[nodeOffset(entries[i]) + ((address >> 8) & 0xff)]);
+            }
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            uint32_t entry = entries[i];
+            if (entry & childFlag) {
+                uint32_t address = addresses[start + i].toUint32();
+                entry = _entries[nodeOffset(entry) + ((address >> 8) & 0xff)];
+                if (entry & childFlag) {
+                    entry = _entries[nodeOffset(entry) + (address & 0xff)];
+                }
+            }
+            dest[start + i] = entry - 1;
+            found += entry != 0;
+        }
+    }
+    return found;
+}
+
+Ipv6PrefixTable::Ipv6PrefixTable()
+    : PrefixTrie(16)
+{
+}
+
+bool Ipv6PrefixTable::insert(const Ipv6Address& address, unsigned prefixSize, uint32_t value)
+{
+    return PrefixTrie::insert(address.data().data(), prefixSize, value);
+}
+
+bool Ipv6PrefixTable::remove(const Ipv6Address& address, unsigned prefixSize)
+{
+    return PrefixTrie::remove(address.data().data(), prefixSize);
+}
+
+Option<uint32_t> Ipv6PrefixTable::find(const Ipv6Address& address, unsigned prefixSize) const
+{
+    return PrefixTrie::find(address.data().data(), prefixSize);
+}
+
+Option<uint32_t> Ipv6PrefixTable::lookup(const Ipv6Address& address) const
+{
+    uint32_t entry = PrefixTrie::lookup(address.data().data());
+    if (entry == 0) {
+        return None;
+    }
+    return entry - 1;
+}
+
+std::size_t Ipv6PrefixTable::lookup(const Ipv6Address* addresses, std::size_t count, uint32_t* dest) const
+{
+    std::size_t found = 0;
+    uint32_t entries[bulkChunk];
+    for (std::size_t start = 0; start < count; start += bulkChunk) {
+        std::size_t n = BMCL_MIN(bulkChunk, count - start);
+        for (std::size_t i = 0; i < n; i++) {
+            const uint8_t* key = addresses[start + i].data().data();
+            entries[i] = _entries[(std::size_t(key[0]) << 8) | key[1]];
+            if (entries[i] & childFlag) {
+                prefetchEntry(&_entries[nodeOffset(entries[i]) + key[2]]);
+            }
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            const uint8_t* key = addresses[start + i].data().data();
+            uint32_t entry = entries[i];
+            for (std::size_t j = 2; entry & childFlag; j++) {
+                entry = _entries[nodeOffset(entry) + key[j]];
+            }
+            dest[start + i] = entry - 1;
+            found += entry != 0;
+        }
+    }
+    return found;
+}
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/IpAddress.h"
+#include "bmcl/Option.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace bmcl {
+
+// longest prefix match over big endian keys of 4 or 16 bytes, maps prefixes to 31 bit values
+// multibit trie with a 16 bit root level and 8 bit levels below it, routes are expanded over all entries
+// they cover so a lookup reads one entry per level (at most 3 for ipv4)
+// each node below the root takes 1280 bytes, sparse long prefixes (deep ipv6 routes) need a node per level
+class BMCL_EXPORT PrefixTrie {
+public:
+    static constexpr uint32_t maxValue = 0x7ffffffe;
+    // written by bulk lookups for addresses without a matching prefix
+    static constexpr uint32_t notFound = 0xffffffff;
+
+    // number of prefixes
+    std::size_t size() const;
+    bool isEmpty() const;
+    // bytes allocated for trie nodes
+    std::size_t memoryUsage() const;
+    void clear();
+
+protected:
+    using Key = std::array<uint8_t, 16>;
+
+    explicit PrefixTrie(std::size_t keySize);
+    ~PrefixTrie();
+
+    bool insert(const uint8_t* key, unsigned prefixSize, uint32_t value);
+    bool remove(const uint8_t* key, unsigned prefixSize);
+    Option<uint32_t> find(const uint8_t* key, unsigned prefixSize) const;
+    uint32_t lookup(const uint8_t* key) const;
+
+    static constexpr uint32_t childFlag = 0x80000000;
+    static constexpr std::size_t rootSize = 65536;
+    static constexpr std::size_t nodeSize = 256;
+
+    // entries hold value + 1, 0 if no prefix covers the entry, or childFlag | node index
+    static std::size_t nodeOffset(uint32_t entry);
+
+    std::vector<uint32_t> _entries;
+
+private:
+    Key normalize(const uint8_t* key, unsigned prefixSize) const;
+    unsigned levelEnd(unsigned level) const;
+    std::size_t entryIndex(const uint8_t* key, unsigned level) const;
+    uint32_t allocateNode(uint32_t entry, uint8_t size);
+    void freeNode(uint32_t entry);
+    void fill(std::size_t offset, std::size_t count, uint32_t entry, uint8_t size);
+    void replace(std::size_t offset, std::size_t count, uint8_t size, uint32_t entry, uint8_t newSize);
+    void assign(const uint8_t* key, unsigned prefixSize, uint32_t entry, uint8_t entrySize, bool isReplace);
+
+    // prefix size of the route stored in each leaf entry
+    std::vector<uint8_t> _sizes;
+    std::vector<uint32_t> _freeNodes;
+    std::map<std::pair<Key, unsigned>, uint32_t> _prefixes;
+    std::size_t _keySize;
+};
+
+inline std::size_t PrefixTrie::size() const
+{
+    return _prefixes.size();
+}
+
+inline bool PrefixTrie::isEmpty() const
+{
+    return _prefixes.empty();
+}
+
+inline std::size_t PrefixTrie::nodeOffset(uint32_t entry)
+{
+    return rootSize + std::size_t((entry & ~childFlag) - 1) * nodeSize;
+}
+
+class BMCL_EXPORT Ipv4PrefixTable : public PrefixTrie {
+public:
+    Ipv4PrefixTable();
+
+    // bits of address past prefixSize are ignored, replaces the value of an existing prefix
+    // returns false if the prefix was already present
+    bool insert(Ipv4Address address, unsigned prefixSize, uint32_t value);
+    bool remove(Ipv4Address address, unsigned prefixSize);
+    // exact prefix
+    Option<uint32_t> find(Ipv4Address address, unsigned prefixSize) const;
+
+    // value of the longest prefix containing address
+    Option<uint32_t> lookup(Ipv4Address address) const;
+    // sets dest[i] to the value for addresses[i] or notFound, returns number of found addresses
+    std::size_t lookup(const Ipv4Address* addresses, std::size_t count, uint32_t* dest) const;
+
+private:
+    uint32_t lookupEntry(uint32_t address) const;
+};
+
+class BMCL_EXPORT Ipv6PrefixTable : public PrefixTrie {
+public:
+    Ipv6PrefixTable();
+
+    bool insert(const Ipv6Address& address, unsigned prefixSize, uint32_t value);
+    bool remove(const Ipv6Address& address, unsigned prefixSize);
+    Option<uint32_t> find(const Ipv6Address& address, unsigned prefixSize) const;
+
+    Option<uint32_t> lookup(const Ipv6Address& address) const;
+    std::size_t lookup(const Ipv6Address* addresses, std::size_t count, uint32_t* dest) const;
+};
+}
@@ -107,17 +107,47 @@ void RingBuffer::peek(void* dest, std::size_t size, std::size_t offset) const
 
 RingBuffer::Chunks RingBuffer::readableChunks()
 {
-    if (_freeSpace == 0) {
+    if (_freeSpace == _size) {
         /* ------------------------wr------------ */
-        return Chunks(_data + _readOffset, 0, _data + _readOffset, 0);
-    } else if (_writeOffset < _readOffset) { //TODO: V517 https://www.viva64.com/en/w/V517 The use of 'if (A) {...} else if (A) {...}' pattern was detected. There is a probability of logical error presence. Check lines: 114, 117.
+        return Chunks(_data + _readOffset, 0, _data, 0);
+    } else if (_readOffset < _writeOffset) {
         /* ---------r***************w------------ */
-        return Chunks(_data + _readOffset, _writeOffset - _readOffset, _data + _writeOffset, 0);
-    } else if (_readOffset > _writeOffset) {
-        /* *********w---------------r************ */
-        return Chunks(_data + _readOffset, _size - _readOffset, _data, _writeOffset);
+        return Chunks(_data + _readOffset, _writeOffset - _readOffset, _data, 0);
     }
+    /* *********w---------------r************ */
     /* ************************wr************ */
     return Chunks(_data + _readOffset, _size - _readOffset, _data, _writeOffset);
 }
+
+RingBuffer::WritableChunks RingBuffer::writableChunks()
+{
+    WritableChunks chunks;
+    if (_freeSpace == 0) {
+        /* ************************wr************ */
+        chunks.first = _data + _writeOffset;
+        chunks.firstSize = 0;
+        chunks.second = _data;
+        chunks.secondSize = 0;
+    } else if (_writeOffset < _readOffset) {
+        /* *********w---------------r************ */
+        chunks.first = _data + _writeOffset;
+        chunks.firstSize = _readOffset - _writeOffset;
+        chunks.second = _data;
+        chunks.secondSize = 0;
+    } else {
+        /* ---------r***************w------------ */
+        /* ------------------------wr------------ */
+        chunks.first = _data + _writeOffset;
+        chunks.firstSize = _size - _writeOffset;
+        chunks.second = _data;
+        chunks.secondSize = _readOffset;
+    }
+    return chunks;
+}
+
+void RingBuffer::advance(std::size_t size)
+{
+    BMCL_ASSERT(size <= _freeSpace);
+    extend(size);
+}
 }
@@ -32,6 +32,14 @@ public:
         Bytes second;
     };
 
+    // free space, filled in place (with readv for example) and followed by advance()
+    struct WritableChunks {
+        uint8_t* first;
+        std::size_t firstSize;
+        uint8_t* second;
+        std::size_t secondSize;
+    };
+
     RingBuffer(void* data, std::size_t size);
 
     inline void write(Bytes data);
@@ -58,6 +66,9 @@ public:
     inline void skip(std::size_t size);
 
     Chunks readableChunks();
+    WritableChunks writableChunks();
+    // makes size bytes written to writableChunks() readable
+    void advance(std::size_t size);
 
 private:
     void init(void* data, std::size_t size);
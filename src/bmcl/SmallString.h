@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Assert.h"
+#include "bmcl/StringView.h"
+#include "bmcl/Writer.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+namespace bmcl {
+
+// null terminated string, stored inline while size() <= N and moved to heap after that
+template <std::size_t N>
+class SmallString : public Writer<SmallString<N>> {
+public:
+    typedef std::size_t size_type;
+    typedef char* iterator;
+    typedef const char* const_iterator;
+
+    SmallString();
+    SmallString(const char* str);
+    SmallString(const char* str, std::size_t size);
+    SmallString(StringView view);
+    SmallString(const SmallString& other);
+    SmallString(SmallString&& other);
+    ~SmallString();
+
+    SmallString& operator=(const SmallString& other);
+    SmallString& operator=(SmallString&& other);
+    SmallString& operator=(StringView view);
+    SmallString& operator=(const char* str);
+
+    static constexpr std::size_t inlineCapacity();
+
+    const char* data() const;
+    char* data();
+    const char* cStr() const;
+
+    std::size_t size() const;
+    std::size_t capacity() const;
+    bool isEmpty() const;
+    bool isInline() const;
+
+    iterator begin();
+    const_iterator begin() const;
+    iterator end();
+    const_iterator end() const;
+
+    char& operator[](std::size_t index);
+    char operator[](std::size_t index) const;
+
+    void clear();
+    void reserve(std::size_t capacity);
+    void resize(std::size_t size, char filler = '\0');
+
+    void append(StringView view);
+    void append(char c);
+    void write(const void* data, std::size_t size);
+
+    SmallString& operator+=(StringView view);
+    SmallString& operator+=(char c);
+
+    StringView view() const;
+    operator StringView() const;
+    std::string toStdString() const;
+
+    bool operator==(StringView other) const;
+    bool operator!=(StringView other) const;
+    bool operator<(StringView other) const;
+
+private:
+    void assign(const char* data, std::size_t size);
+    void grow(std::size_t minCapacity);
+    void setInline();
+
+    char* _data;
+    std::size_t _size;
+    std::size_t _capacity;
+    char _inline[N + 1];
+};
+
+template <std::size_t N>
+inline SmallString<N>::SmallString()
+{
+    setInline();
+}
+
+template <std::size_t N>
+inline SmallString<N>::SmallString(const char* str)
+    : SmallString(str, std::strlen(str))
+{
+}
+
+template <std::size_t N>
+inline SmallString<N>::SmallString(const char* str, std::size_t size)
+{
+    setInline();
+    assign(str, size);
+}
+
+template <std::size_t N>
+inline SmallString<N>::SmallString(StringView view)
+    : SmallString(view.data(), view.size())
+{
+}
+
+template <std::size_t N>
+inline SmallString<N>::SmallString(const SmallString& other)
+    : SmallString(other._data, other._size)
+{
+}
+
+template <std::size_t N>
+inline SmallString<N>::SmallString(SmallString&& other)
+{
+    if (other.isInline()) {
+        setInline();
+        assign(other._data, other._size);
+    } else {
+        _data = other._data;
+        _size = other._size;
+        _capacity = other._capacity;
+        other.setInline();
+    }
+}
+
+template <std::size_t N>
+inline SmallString<N>::~SmallString()
+{
+    if (!isInline()) {
+        std::free(_data);
+    }
+}
+
+template <std::size_t N>
+inline SmallString<N>& SmallString<N>::operator=(const SmallString& other)
+{
+    if (this != &other) {
+        assign(other._data, other._size);
+    }
+    return *this;
+}
+
+template <std::size_t N>
+inline SmallString<N>& SmallString<N>::operator=(SmallString&& other)
+{
+    if (this == &other) {
+        return *this;
+    }
+    if (other.isInline()) {
+        assign(other._data, other._size);
+        return *this;
+    }
+    if (!isInline()) {
+        std::free(_data);
+    }
+    _data = other._data;
+    _size = other._size;
+    _capacity = other._capacity;
+    other.setInline();
+    return *this;
+}
+
+template <std::size_t N>
+inline SmallString<N>& SmallString<N>::operator=(StringView view)
+{
+    assign(view.data(), view.size());
+    return *this;
+}
+
+template <std::size_t N>
+inline SmallString<N>& SmallString<N>::operator=(const char* str)
+{
+    assign(str, std::strlen(str));
+    return *this;
+}
+
+template <std::size_t N>
+constexpr std::size_t SmallString<N>::inlineCapacity()
+{
+    return N;
+}
+
+template <std::size_t N>
+inline const char* SmallString<N>::data() const
+{
+    return _data;
+}
+
+template <std::size_t N>
+inline char* SmallString<N>::data()
+{
+    return _data;
+}
+
+template <std::size_t N>
+inline const char* SmallString<N>::cStr() const
+{
+    return _data;
+}
+
+template <std::size_t N>
+inline std::size_t SmallString<N>::size() const
+{
+    return _size;
+}
+
+template <std::size_t N>
+inline std::size_t SmallString<N>::capacity() const
+{
+    return _capacity;
+}
+
+template <std::size_t N>
+inline bool SmallString<N>::isEmpty() const
+{
+    return _size == 0;
+}
+
+template <std::size_t N>
+inline bool SmallString<N>::isInline() const
+{
+    return _data == _inline;
+}
+
+template <std::size_t N>
+inline typename SmallString<N>::iterator SmallString<N>::begin()
+{
+    return _data;
+}
+
+template <std::size_t N>
+inline typename SmallString<N>::const_iterator SmallString<N>::begin() const
+{
+    return _data;
+}
+
+template <std::size_t N>
+inline typename SmallString<N>::iterator SmallString<N>::end()
+{
+    return _data + _size;
+}
+
+template <std::size_t N>
+inline typename SmallString<N>::const_iterator SmallString<N>::end() const
+{
+    return _data + _size;
+}
+
+template <std::size_t N>
+inline char& SmallString<N>::operator[](std::size_t index)
+{
+    BMCL_ASSERT(index < _size);
+    return _data[index];
+}
+
+template <std::size_t N>
+inline char SmallString<N>::operator[](std::size_t index) const
+{
+    BMCL_ASSERT(index < _size);
+    return _data[index];
+}
+
+template <std::size_t N>
+inline void SmallString<N>::clear()
+{
+    _size = 0;
+    _data[0] = '\0';
+}
+
+template <std::size_t N>
+inline void SmallString<N>::reserve(std::size_t capacity)
+{
+    if (capacity > _capacity) {
+        grow(capacity);
+    }
+}
+
+template <std::size_t N>
+inline void SmallString<N>::resize(std::size_t size, char filler)
+{
+    reserve(size);
+    if (size > _size) {
+        std::memset(_data + _size, filler, size - _size);
+    }
+    _size = size;
+    _data[_size] = '\0';
+}
+
+template <std::size_t N>
+inline void SmallString<N>::append(StringView view)
+{
+    write(view.data(), view.size());
+}
+
+template <std::size_t N>
+inline void SmallString<N>::append(char c)
+{
+    if (_size == _capacity) {
+        grow(_size + 1);
+    }
+    _data[_size] = c;
+    _size++;
+    _data[_size] = '\0';
+}
+
+template <std::size_t N>
+inline void SmallString<N>::write(const void* data, std::size_t size)
+{
+    if ((_capacity - _size) < size) {
+        // data may point into this string
+        std::size_t offset = (const char*)data - _data;
+        bool isSelf = (const char*)data >= _data && offset <= _size;
+        grow(_size + size);
+        if (isSelf) {
+            data = _data + offset;
+        }
+    }
+    std::memmove(_data + _size, data, size);
+    _size += size;
+    _data[_size] = '\0';
+}
+
+template <std::size_t N>
+inline SmallString<N>& SmallString<N>::operator+=(StringView view)
+{
+    append(view);
+    return *this;
+}
+
+template <std::size_t N>
+inline SmallString<N>& SmallString<N>::operator+=(char c)
+{
+    append(c);
+    return *this;
+}
+
+template <std::size_t N>
+inline StringView SmallString<N>::view() const
+{
+    return StringView(_data, _size);
+}
+
+template <std::size_t N>
+inline SmallString<N>::operator StringView() const
+{
+    return view();
+}
+
+template <std::size_t N>
+inline std::string SmallString<N>::toStdString() const
+{
+    return std::string(_data, _size);
+}
+
+template <std::size_t N>
+inline bool SmallString<N>::operator==(StringView other) const
+{
+    return view() == other;
+}
+
+template <std::size_t N>
+inline bool SmallString<N>::operator!=(StringView other) const
+{
+    return view() != other;
+}
+
+template <std::size_t N>
+inline bool SmallString<N>::operator<(StringView other) const
+{
+    std::size_t size = BMCL_MIN(_size, other.size());
+    int rv = std::memcmp(_data, other.data(), size);
+    return rv < 0 || (rv == 0 && _size < other.size());
+}
+
+template <std::size_t N>
+inline void SmallString<N>::assign(const char* data, std::size_t size)
+{
+    if (size > _capacity) {
+        grow(size);
+    }
+    std::memmove(_data, data, size);
+    _size = size;
+    _data[_size] = '\0';
+}
+
+template <std::size_t N>
+void SmallString<N>::grow(std::size_t minCapacity)
+{
+    std::size_t capacity = BMCL_MAX(minCapacity, _capacity * 2);
+    char* data;
+    if (isInline()) {
+        data = (char*)std::malloc(capacity + 1);
+        BMCL_ASSERT(data);
+        std::memcpy(data, _inline, _size + 1);
+    } else {
+        data = (char*)std::realloc(_data, capacity + 1);
+        BMCL_ASSERT(data);
+    }
+    _data = data;
+    _capacity = capacity;
+}
+
+template <std::size_t N>
+inline void SmallString<N>::setInline()
+{
+    _data = _inline;
+    _size = 0;
+    _capacity = N;
+    _inline[0] = '\0';
+}
+}
@@ -6,21 +6,31 @@
  * file, You can obtain one at http://mozilla.org/MPL/2.0/.
  */
 
-#include <sstream>
-
 #include "bmcl/String.h"
+#include "bmcl/StringView.h"
+
+#include "bmcl/Buffer.h"
+#include "bmcl/MemWriter.h"
+#include "bmcl/Result.h"
 
 #include <cassert>
 
+#if defined(BMCL_HAVE_SSE2)
+# include <emmintrin.h>
+#endif
+
 namespace bmcl
 {
 
 std::vector<std::string>& split(const std::string& s, char delim, std::vector<std::string>& elems)
 {
-    std::istringstream ss(s);
-    std::string item;
-    while (std::getline(ss, item, delim)) {
-        elems.push_back(item);
+    // same as std::getline: the trailing empty field is dropped
+    StringView view(s);
+    for (StringView item : view.split(delim)) {
+        if (item.end() == view.end() && item.isEmpty()) {
+            break;
+        }
+        elems.push_back(item.toStdString());
     }
     return elems;
 }
@@ -32,6 +42,61 @@ std::vector<std::string> split(const std::string &s, char delim)
     return elems;
 }
 
+#if defined(BMCL_HAVE_SSE2)
+
+// 16 bytes -> 32 chars, letters start at 'a' + offset where offset is 'a' - '0' - 10 or 'A' - '0' - 10
+static inline void encodeHexBlock(const uint8_t* src, char* dest, __m128i letterOffset)
+{
+    const __m128i lowMask = _mm_set1_epi8(0x0f);
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0');
+    __m128i block = _mm_loadu_si128((const __m128i*)src);
+    __m128i hi = _mm_and_si128(_mm_srli_epi16(block, 4), lowMask);
+    __m128i lo = _mm_and_si128(block, lowMask);
+    __m128i first = _mm_unpacklo_epi8(hi, lo);
+    __m128i second = _mm_unpackhi_epi8(hi, lo);
+    first = _mm_add_epi8(_mm_add_epi8(first, zero), _mm_and_si128(_mm_cmpgt_epi8(first, nine), letterOffset));
+    second = _mm_add_epi8(_mm_add_epi8(second, zero), _mm_and_si128(_mm_cmpgt_epi8(second, nine), letterOffset));
+    _mm_storeu_si128((__m128i*)dest, first);
+    _mm_storeu_si128((__m128i*)(dest + 16), second);
+}
+
+// unsigned value <= limit
+static inline __m128i lessOrEqualU8(__m128i value, __m128i limit)
+{
+    return _mm_cmpeq_epi8(_mm_max_epu8(value, limit), limit);
+}
+
+static inline __m128i decodeHexChars(__m128i chars, __m128i* valid)
+{
+    __m128i digits = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i isDigit = lessOrEqualU8(digits, _mm_set1_epi8(9));
+    __m128i letters = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i isLetter = lessOrEqualU8(letters, _mm_set1_epi8(5));
+    letters = _mm_add_epi8(letters, _mm_set1_epi8(10));
+    *valid = _mm_and_si128(*valid, _mm_or_si128(isDigit, isLetter));
+    return _mm_or_si128(_mm_and_si128(digits, isDigit), _mm_and_si128(letters, isLetter));
+}
+
+// 32 chars -> 16 bytes
+static inline bool decodeHexBlock(const char* src, uint8_t* dest)
+{
+    __m128i valid = _mm_set1_epi8(-1);
+    __m128i first = decodeHexChars(_mm_loadu_si128((const __m128i*)src), &valid);
+    __m128i second = decodeHexChars(_mm_loadu_si128((const __m128i*)(src + 16)), &valid);
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+        return false;
+    }
+    // each 16 bit lane holds (lo << 8) | hi
+    const __m128i lowByte = _mm_set1_epi16(0x00ff);
+    first = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, lowByte), 4), _mm_srli_epi16(first, 8));
+    second = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(second, lowByte), 4), _mm_srli_epi16(second, 8));
+    _mm_storeu_si128((__m128i*)dest, _mm_packus_epi16(first, second));
+    return true;
+}
+
+#endif
+
 static inline char nibbleToHexCharLower(uint8_t nibble)
 {
     assert(nibble < 16);
@@ -47,25 +112,161 @@ static inline char nibbleToHexCharUpper(uint8_t nibble)
 }
 
 template <char (*conv)(uint8_t)>
-inline std::string bytesToHexStringBase(const uint8_t* data, std::size_t size)
+inline void bytesToHexBase(const uint8_t* data, std::size_t size, char* dest)
 {
-    std::string str(size * 2, ' ');
     for (std::size_t i = 0; i < size; i++) {
         uint8_t byte = data[i];
-        str[i*2] = conv((byte & 0xf0) >> 4);
-        str[i*2 + 1] = conv(byte & 0x0f);
+        dest[i*2] = conv((byte & 0xf0) >> 4);
+        dest[i*2 + 1] = conv(byte & 0x0f);
     }
-    return str;
+}
+
+void bytesToHexLower(const uint8_t* data, std::size_t size, char* dest)
+{
+#if defined(BMCL_HAVE_SSE2)
+    const __m128i offset = _mm_set1_epi8('a' - '0' - 10);
+    while (size >= 16) {
+        encodeHexBlock(data, dest, offset);
+        data += 16;
+        dest += 32;
+        size -= 16;
+    }
+#endif
+    bytesToHexBase<nibbleToHexCharLower>(data, size, dest);
+}
+
+void bytesToHexUpper(const uint8_t* data, std::size_t size, char* dest)
+{
+#if defined(BMCL_HAVE_SSE2)
+    const __m128i offset = _mm_set1_epi8('A' - '0' - 10);
+    while (size >= 16) {
+        encodeHexBlock(data, dest, offset);
+        data += 16;
+        dest += 32;
+        size -= 16;
+    }
+#endif
+    bytesToHexBase<nibbleToHexCharUpper>(data, size, dest);
 }
 
 std::string bytesToHexStringLower(const uint8_t* data, std::size_t size)
 {
-    return bytesToHexStringBase<nibbleToHexCharLower>(data, size);
+    std::string str(size * 2, ' ');
+    bytesToHexLower(data, size, &str[0]);
+    return str;
 }
 
 std::string bytesToHexStringUpper(const uint8_t* data, std::size_t size)
 {
-    return bytesToHexStringBase<nibbleToHexCharUpper>(data, size);
+    std::string str(size * 2, ' ');
+    bytesToHexUpper(data, size, &str[0]);
+    return str;
+}
+
+template <void (*encode)(const uint8_t*, std::size_t, char*)>
+inline void appendHex(Bytes data, std::string* dest)
+{
+    std::size_t oldSize = dest->size();
+    dest->resize(oldSize + data.size() * 2);
+    encode(data.data(), data.size(), &(*dest)[oldSize]);
+}
+
+template <void (*encode)(const uint8_t*, std::size_t, char*)>
+inline void appendHex(Bytes data, Buffer* dest)
+{
+    std::size_t oldSize = dest->size();
+    std::size_t newSize = oldSize + data.size() * 2;
+    if (newSize > dest->capacity()) {
+        dest->reserve(BMCL_MAX(newSize, dest->capacity() * 2));
+    }
+    dest->resize(newSize);
+    encode(data.data(), data.size(), (char*)dest->data() + oldSize);
+}
+
+template <void (*encode)(const uint8_t*, std::size_t, char*)>
+inline void appendHex(Bytes data, MemWriter* dest)
+{
+    BMCL_ASSERT(dest->writableSize() >= data.size() * 2);
+    encode(data.data(), data.size(), (char*)dest->current());
+    dest->advance(data.size() * 2);
 }
+
+void appendHexLower(Bytes data, std::string* dest)
+{
+    appendHex<bytesToHexLower>(data, dest);
+}
+
+void appendHexUpper(Bytes data, std::string* dest)
+{
+    appendHex<bytesToHexUpper>(data, dest);
+}
+
+void appendHexLower(Bytes data, Buffer* dest)
+{
+    appendHex<bytesToHexLower>(data, dest);
+}
+
+void appendHexUpper(Bytes data, Buffer* dest)
+{
+    appendHex<bytesToHexUpper>(data, dest);
+}
+
+void appendHexLower(Bytes data, MemWriter* dest)
+{
+    appendHex<bytesToHexLower>(data, dest);
 }
 
+void appendHexUpper(Bytes data, MemWriter* dest)
+{
+    appendHex<bytesToHexUpper>(data, dest);
+}
+
+static inline int hexCharToNibble(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool hexToBytes(StringView hex, uint8_t* dest)
+{
+    if (hex.size() % 2) {
+        return false;
+    }
+    const char* src = hex.data();
+    std::size_t size = hex.size() / 2;
+#if defined(BMCL_HAVE_SSE2)
+    while (size >= 16) {
+        if (!decodeHexBlock(src, dest)) {
+            return false;
+        }
+        src += 32;
+        dest += 16;
+        size -= 16;
+    }
+#endif
+    for (std::size_t i = 0; i < size; i++) {
+        int hi = hexCharToNibble(src[i * 2]);
+        int lo = hexCharToNibble(src[i * 2 + 1]);
+        if ((hi | lo) < 0) {
+            return false;
+        }
+        dest[i] = (hi << 4) | lo;
+    }
+    return true;
+}
+
+Result<Buffer, void> hexToBytes(StringView hex)
+{
+    Buffer buf = Buffer::createWithUnitializedData(hex.size() / 2);
+    if (!hexToBytes(hex, buf.data())) {
+        return Result<Buffer, void>();
+    }
+    return buf;
+}
+}
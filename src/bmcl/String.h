@@ -10,6 +10,8 @@
 
 #include "bmcl/Config.h"
 #include "bmcl/Bytes.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/Writer.h"
 
 #include <string>
 #include <vector>
@@ -31,4 +33,51 @@ inline std::string bytesToHexStringUpper(bmcl::Bytes bytes)
 {
     return bytesToHexStringUpper(bytes.data(), bytes.size());
 }
+
+// dest must have room for size * 2 chars, no null terminator is written
+BMCL_EXPORT void bytesToHexLower(const uint8_t* data, std::size_t size, char* dest);
+BMCL_EXPORT void bytesToHexUpper(const uint8_t* data, std::size_t size, char* dest);
+
+BMCL_EXPORT void appendHexLower(Bytes data, std::string* dest);
+BMCL_EXPORT void appendHexUpper(Bytes data, std::string* dest);
+BMCL_EXPORT void appendHexLower(Bytes data, Buffer* dest);
+BMCL_EXPORT void appendHexUpper(Bytes data, Buffer* dest);
+BMCL_EXPORT void appendHexLower(Bytes data, MemWriter* dest);
+BMCL_EXPORT void appendHexUpper(Bytes data, MemWriter* dest);
+
+template <typename B>
+void appendHexLower(Bytes data, Writer<B>* dest);
+template <typename B>
+void appendHexUpper(Bytes data, Writer<B>* dest);
+
+// accepts both cases, fails on odd size or non hex chars
+// dest must have room for hex.size() / 2 bytes
+BMCL_EXPORT bool hexToBytes(StringView hex, uint8_t* dest);
+BMCL_EXPORT Result<Buffer, void> hexToBytes(StringView hex);
+
+template <void (*encode)(const uint8_t*, std::size_t, char*), typename B>
+void appendHexChunked(Bytes data, Writer<B>* dest)
+{
+    constexpr std::size_t chunkSize = 256;
+    char tmp[chunkSize * 2];
+    const uint8_t* it = data.begin();
+    while (it != data.end()) {
+        std::size_t size = BMCL_MIN(chunkSize, std::size_t(data.end() - it));
+        encode(it, size, tmp);
+        static_cast<B*>(dest)->write(tmp, size * 2);
+        it += size;
+    }
+}
+
+template <typename B>
+inline void appendHexLower(Bytes data, Writer<B>* dest)
+{
+    appendHexChunked<bytesToHexLower>(data, dest);
+}
+
+template <typename B>
+inline void appendHexUpper(Bytes data, Writer<B>* dest)
+{
+    appendHexChunked<bytesToHexUpper>(data, dest);
+}
 }
@@ -14,6 +14,13 @@
 #include <bitset>
 #include <climits>
 
+#if defined(BMCL_HAVE_SSE2)
+# include <emmintrin.h>
+#endif
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
 namespace bmcl {
 
 static char asciiToUpper(char c)
@@ -187,4 +194,85 @@ StringView StringView::trim(StringView chars) const
     return ltrim(chars).rtrim(chars);
 }
 
+#if defined(BMCL_HAVE_SSE2)
+static inline unsigned countTrailingZeros(unsigned value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+#endif
+
+SplitByCharSet::SplitByCharSet(StringView chars)
+    : _charsNum(0)
+{
+    std::fill(_table, _table + 256, false);
+    for (char c : chars) {
+        uint8_t index = c;
+        if (_table[index]) {
+            continue;
+        }
+        _table[index] = true;
+        if (_charsNum < maxVectorChars) {
+            _chars[_charsNum] = c;
+        }
+        _charsNum++;
+    }
+}
+
+const char* SplitByCharSet::find(const char* begin, const char* end) const
+{
+    if (_charsNum == 1) {
+        const void* pos = std::memchr(begin, _chars[0], end - begin);
+        return pos ? (const char*)pos : end;
+    }
+#if defined(BMCL_HAVE_SSE2)
+    if (_charsNum > 1 && _charsNum <= maxVectorChars) {
+        __m128i needles[maxVectorChars];
+        for (std::size_t i = 0; i < _charsNum; i++) {
+            needles[i] = _mm_set1_epi8(_chars[i]);
+        }
+        while ((end - begin) >= 16) {
+            __m128i block = _mm_loadu_si128((const __m128i*)begin);
+            __m128i matches = _mm_cmpeq_epi8(block, needles[0]);
+            for (std::size_t i = 1; i < _charsNum; i++) {
+                matches = _mm_or_si128(matches, _mm_cmpeq_epi8(block, needles[i]));
+            }
+            unsigned mask = _mm_movemask_epi8(matches);
+            if (mask) {
+                return begin + countTrailingZeros(mask);
+            }
+            begin += 16;
+        }
+    }
+#endif
+    while (begin != end) {
+        if (_table[(uint8_t)*begin]) {
+            return begin;
+        }
+        begin++;
+    }
+    return end;
+}
+
+const char* SplitByString::find(const char* begin, const char* end) const
+{
+    std::size_t delimSize = _delim.size();
+    char first = _delim[0];
+    while (std::size_t(end - begin) >= delimSize) {
+        const char* pos = (const char*)std::memchr(begin, first, end - begin - delimSize + 1);
+        if (!pos) {
+            break;
+        }
+        if (std::memcmp(pos + 1, _delim.data() + 1, delimSize - 1) == 0) {
+            return pos;
+        }
+        begin = pos + 1;
+    }
+    return end;
+}
 }
@@ -15,10 +15,18 @@
 #include <cassert>
 #include <cstddef>
 #include <cstring>
+#include <iterator>
 #include <string>
 
 namespace bmcl {
 
+class SplitByChar;
+class SplitByCharSet;
+class SplitByString;
+
+template <typename D>
+class StringSplitRange;
+
 class BMCL_EXPORT StringView : public ArrayViewBase<char, StringView> {
 public:
     constexpr inline StringView();
@@ -59,6 +67,13 @@ public:
     StringView rtrim(StringView chars = " \t\n\v\f\r") const;
     StringView trim(StringView chars = " \t\n\v\f\r") const;
 
+    // lazy splitting, pieces point into this view and nothing is allocated
+    // n delimiters always produce n + 1 pieces (empty pieces included)
+    // the returned range must outlive its iterators
+    inline StringSplitRange<SplitByChar> split(char delim) const;
+    inline StringSplitRange<SplitByString> split(StringView delim) const;
+    inline StringSplitRange<SplitByCharSet> splitAnyOf(StringView chars) const;
+
 private:
     template <typename C>
     std::string map(C&& convert) const;
@@ -138,4 +153,231 @@ inline bool operator!=(const T& lhs, StringView rhs)
 {
     return StringView(lhs).operator!=(rhs);
 }
+
+class BMCL_EXPORT SplitByChar {
+public:
+    inline SplitByChar(char c);
+
+    inline const char* find(const char* begin, const char* end) const;
+    inline std::size_t size() const;
+
+private:
+    char _c;
+};
+
+class BMCL_EXPORT SplitByCharSet {
+public:
+    SplitByCharSet(StringView chars);
+
+    const char* find(const char* begin, const char* end) const;
+    inline std::size_t size() const;
+
+private:
+    static constexpr std::size_t maxVectorChars = 8;
+
+    bool _table[256];
+    char _chars[maxVectorChars];
+    std::size_t _charsNum;
+};
+
+class BMCL_EXPORT SplitByString {
+public:
+    inline SplitByString(StringView delim);
+
+    const char* find(const char* begin, const char* end) const;
+    inline std::size_t size() const;
+
+private:
+    StringView _delim;
+};
+
+template <typename D>
+class StringSplitIterator {
+public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef StringView value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const StringView* pointer;
+    typedef const StringView& reference;
+
+    inline StringSplitIterator();
+    inline StringSplitIterator(StringView str, const D* delim);
+
+    inline reference operator*() const;
+    inline pointer operator->() const;
+
+    inline StringSplitIterator& operator++();
+    inline StringSplitIterator operator++(int);
+
+    inline bool operator==(const StringSplitIterator& other) const;
+    inline bool operator!=(const StringSplitIterator& other) const;
+
+private:
+    inline void findNext(const char* from);
+
+    StringView _current;
+    const char* _next;
+    const char* _end;
+    const D* _delim;
+};
+
+template <typename D>
+class StringSplitRange {
+public:
+    typedef StringSplitIterator<D> iterator;
+    typedef StringSplitIterator<D> const_iterator;
+
+    inline StringSplitRange(StringView str, const D& delim);
+
+    inline iterator begin() const;
+    inline iterator end() const;
+
+private:
+    StringView _str;
+    D _delim;
+};
+
+inline SplitByChar::SplitByChar(char c)
+    : _c(c)
+{
+}
+
+inline const char* SplitByChar::find(const char* begin, const char* end) const
+{
+    const void* pos = std::memchr(begin, _c, end - begin);
+    if (pos) {
+        return (const char*)pos;
+    }
+    return end;
+}
+
+inline std::size_t SplitByChar::size() const
+{
+    return 1;
+}
+
+inline std::size_t SplitByCharSet::size() const
+{
+    return 1;
+}
+
+inline SplitByString::SplitByString(StringView delim)
+    : _delim(delim)
+{
+    BMCL_ASSERT(!delim.isEmpty());
+}
+
+inline std::size_t SplitByString::size() const
+{
+    return _delim.size();
+}
+
+template <typename D>
+inline StringSplitIterator<D>::StringSplitIterator()
+    : _next(nullptr)
+    , _end(nullptr)
+    , _delim(nullptr)
+{
+}
+
+template <typename D>
+inline StringSplitIterator<D>::StringSplitIterator(StringView str, const D* delim)
+    : _end(str.end())
+    , _delim(delim)
+{
+    findNext(str.begin());
+}
+
+template <typename D>
+inline void StringSplitIterator<D>::findNext(const char* from)
+{
+    const char* pos = _delim->find(from, _end);
+    _current = StringView(from, pos);
+    if (pos == _end) {
+        _next = nullptr;
+    } else {
+        _next = pos + _delim->size();
+    }
+}
+
+template <typename D>
+inline typename StringSplitIterator<D>::reference StringSplitIterator<D>::operator*() const
+{
+    return _current;
+}
+
+template <typename D>
+inline typename StringSplitIterator<D>::pointer StringSplitIterator<D>::operator->() const
+{
+    return &_current;
+}
+
+template <typename D>
+inline StringSplitIterator<D>& StringSplitIterator<D>::operator++()
+{
+    BMCL_ASSERT(_delim);
+    if (_next) {
+        findNext(_next);
+    } else {
+        _delim = nullptr;
+    }
+    return *this;
+}
+
+template <typename D>
+inline StringSplitIterator<D> StringSplitIterator<D>::operator++(int)
+{
+    StringSplitIterator<D> it = *this;
+    operator++();
+    return it;
+}
+
+template <typename D>
+inline bool StringSplitIterator<D>::operator==(const StringSplitIterator<D>& other) const
+{
+    if (_delim == nullptr || other._delim == nullptr) {
+        return _delim == other._delim;
+    }
+    return _current.data() == other._current.data() && _next == other._next;
+}
+
+template <typename D>
+inline bool StringSplitIterator<D>::operator!=(const StringSplitIterator<D>& other) const
+{
+    return !operator==(other);
+}
+
+template <typename D>
+inline StringSplitRange<D>::StringSplitRange(StringView str, const D& delim)
+    : _str(str)
+    , _delim(delim)
+{
+}
+
+template <typename D>
+inline typename StringSplitRange<D>::iterator StringSplitRange<D>::begin() const
+{
+    return iterator(_str, &_delim);
+}
+
+template <typename D>
+inline typename StringSplitRange<D>::iterator StringSplitRange<D>::end() const
+{
+    return iterator();
+}
+
+inline StringSplitRange<SplitByChar> StringView::split(char delim) const
+{
+    return StringSplitRange<SplitByChar>(*this, SplitByChar(delim));
+}
+
+inline StringSplitRange<SplitByString> StringView::split(StringView delim) const
+{
+    return StringSplitRange<SplitByString>(*this, SplitByString(delim));
+}
+
+inline StringSplitRange<SplitByCharSet> StringView::splitAnyOf(StringView chars) const
+{
+    return StringSplitRange<SplitByCharSet>(*this, SplitByCharSet(chars));
+}
 }
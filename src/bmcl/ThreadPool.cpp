@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/ThreadPool.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace bmcl {
+
+// Chase-Lev deque as described in "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al.)
+// push() and pop() are called only by the owner, steal() by any thread
+class WorkStealingDeque {
+public:
+    using Task = ThreadPool::Task;
+
+    WorkStealingDeque();
+    ~WorkStealingDeque();
+
+    void push(Task* task);
+    Task* pop();
+    Task* steal();
+
+private:
+    class Array {
+    public:
+        explicit Array(std::size_t capacity)
+            : _mask(capacity - 1)
+            , _items(new std::atomic<Task*>[capacity])
+        {
+        }
+
+        std::size_t capacity() const
+        {
+            return _mask + 1;
+        }
+
+        Task* get(int64_t index) const
+        {
+            return _items[std::size_t(index) & _mask].load(std::memory_order_relaxed);
+        }
+
+        void put(int64_t index, Task* task)
+        {
+            _items[std::size_t(index) & _mask].store(task, std::memory_order_relaxed);
+        }
+
+    private:
+        std::size_t _mask;
+        std::unique_ptr<std::atomic<Task*>[]> _items;
+    };
+
+    static constexpr std::size_t initialCapacity = 256;
+
+    std::atomic<int64_t> _top;
+    // keeps thieves updating _top off the owner's cache line
+    char _padding[64];
+    std::atomic<int64_t> _bottom;
+    std::atomic<Array*> _array;
+    // replaced arrays may still be read by thieves, freed with the deque
+    std::vector<std::unique_ptr<Array>> _arrays;
+};
+
+constexpr std::size_t WorkStealingDeque::initialCapacity;
+
+WorkStealingDeque::WorkStealingDeque()
+    : _top(0)
+    , _bottom(0)
+{
+    _arrays.emplace_back(new Array(initialCapacity));
+    _array.store(_arrays.back().get(), std::memory_order_relaxed);
+}
+
+WorkStealingDeque::~WorkStealingDeque()
+{
+    while (Task* task = pop()) {
+        delete task;
+    }
+}
+
+void WorkStealingDeque::push(Task* task)
+{
+    int64_t bottom = _bottom.load(std::memory_order_relaxed);
+    int64_t top = _top.load(std::memory_order_acquire);
+    Array* array = _array.load(std::memory_order_relaxed);
+    if (bottom - top > int64_t(array->capacity()) - 1) {
+        Array* bigger = new Array(array->capacity() * 2);
+        for (int64_t i = top; i < bottom; i++) {
+            bigger->put(i, array->get(i));
+        }
+        _arrays.emplace_back(bigger);
+        _array.store(bigger, std::memory_order_release);
+        array = bigger;
+    }
+    array->put(bottom, task);
+    // publishes the item to steal(), same as a release fence followed by a relaxed store
+    _bottom.store(bottom + 1, std::memory_order_release);
+}
+
+WorkStealingDeque::Task* WorkStealingDeque::pop()
+{
+    int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+    Array* array = _array.load(std::memory_order_relaxed);
+    _bottom.store(bottom, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t top = _top.load(std::memory_order_relaxed);
+    if (top > bottom) {
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    Task* task = array->get(bottom);
+    if (top == bottom) {
+        // last item, races with thieves
+        if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            task = nullptr;
+        }
+        _bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+WorkStealingDeque::Task* WorkStealingDeque::steal()
+{
+    int64_t top = _top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t bottom = _bottom.load(std::memory_order_acquire);
+    if (top >= bottom) {
+        return nullptr;
+    }
+    Array* array = _array.load(std::memory_order_acquire);
+    Task* task = array->get(top);
+    if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return task;
+}
+
+class ThreadPoolWorker {
+public:
+    ThreadPoolWorker(ThreadPool* pool, std::size_t index)
+        : pool(pool)
+        , index(index)
+    {
+    }
+
+    ThreadPool* pool;
+    std::size_t index;
+    WorkStealingDeque deque;
+    std::thread thread;
+};
+
+static thread_local ThreadPoolWorker* currentWorker = nullptr;
+
+ThreadPool::ThreadPool(std::size_t threadCount)
+    : _queueSize(0)
+    , _pendingCount(0)
+    , _sleepingCount(0)
+    , _postCount(0)
+    , _helperCount(0)
+    , _isStopping(false)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (std::size_t i = 0; i < threadCount; i++) {
+        _workers.emplace_back(new ThreadPoolWorker(this, i));
+    }
+    for (const std::unique_ptr<ThreadPoolWorker>& worker : _workers) {
+        worker->thread = std::thread(&ThreadPool::workerMain, this, worker.get());
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _isStopping = true;
+    }
+    _sleepCv.notify_all();
+    for (const std::unique_ptr<ThreadPoolWorker>& worker : _workers) {
+        worker->thread.join();
+    }
+}
+
+std::size_t ThreadPool::threadCount() const
+{
+    return _workers.size();
+}
+
+void ThreadPool::post(Task task)
+{
+    Task* node = new Task(std::move(task));
+    ThreadPoolWorker* worker = currentWorker;
+    if (worker && worker->pool == this) {
+        worker->deque.push(node);
+    } else {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        _queue.push_back(node);
+        _queueSize.fetch_add(1, std::memory_order_relaxed);
+    }
+    _pendingCount.fetch_add(1);
+    notify();
+    notifyHelpers();
+}
+
+void ThreadPool::notifyHelpers()
+{
+    // pairs with the _helperCount increment and _postCount check in helpUntil()
+    _postCount.fetch_add(1);
+    if (_helperCount.load() == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_helpersMutex);
+    for (const Helper& helper : _helpers) {
+        {
+            std::lock_guard<std::mutex> helperLock(*helper.mutex);
+        }
+        helper.doneCv->notify_all();
+    }
+}
+
+void ThreadPool::notify()
+{
+    // pairs with the _sleepingCount increment and _pendingCount check in workerMain()
+    if (_sleepingCount.load() == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _sleepCv.notify_one();
+}
+
+ThreadPool::Task* ThreadPool::takeTask(ThreadPoolWorker* worker)
+{
+    if (worker) {
+        if (Task* task = worker->deque.pop()) {
+            return task;
+        }
+    }
+    if (_queueSize.load(std::memory_order_relaxed) != 0) {
+        std::lock_guard<std::mutex> lock(_queueMutex);
+        if (!_queue.empty()) {
+            Task* task = _queue.front();
+            _queue.pop_front();
+            _queueSize.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+    }
+    std::size_t start = worker ? worker->index + 1 : 0;
+    for (std::size_t i = 0; i < _workers.size(); i++) {
+        ThreadPoolWorker* victim = _workers[(start + i) % _workers.size()].get();
+        if (victim == worker) {
+            continue;
+        }
+        if (Task* task = victim->deque.steal()) {
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+bool ThreadPool::runOne()
+{
+    ThreadPoolWorker* worker = currentWorker;
+    if (worker && worker->pool != this) {
+        worker = nullptr;
+    }
+    Task* task = takeTask(worker);
+    if (!task) {
+        return false;
+    }
+    _pendingCount.fetch_sub(1, std::memory_order_relaxed);
+    (*task)();
+    delete task;
+    return true;
+}
+
+void ThreadPool::workerMain(ThreadPoolWorker* worker)
+{
+    currentWorker = worker;
+    while (true) {
+        if (runOne()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        _sleepingCount.fetch_add(1);
+        while (_pendingCount.load() <= 0 && !_isStopping) {
+            _sleepCv.wait(lock);
+        }
+        _sleepingCount.fetch_sub(1);
+        if (_isStopping && _pendingCount.load() <= 0) {
+            break;
+        }
+    }
+    currentWorker = nullptr;
+}
+
+void ThreadPool::helpUntil(const std::atomic<bool>& isDone, std::mutex& mutex, std::condition_variable& doneCv)
+{
+    while (!isDone.load(std::memory_order_acquire)) {
+        uint64_t postCount = _postCount.load();
+        if (runOne()) {
+            continue;
+        }
+        // the awaited work is running on another thread and may post tasks it depends on,
+        // post() wakes registered helpers so that they look for tasks again
+        Helper helper;
+        helper.mutex = &mutex;
+        helper.doneCv = &doneCv;
+        {
+            std::lock_guard<std::mutex> lock(_helpersMutex);
+            _helpers.push_back(helper);
+        }
+        _helperCount.fetch_add(1);
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!isDone.load(std::memory_order_acquire) && _postCount.load() == postCount) {
+                doneCv.wait(lock);
+            }
+        }
+        _helperCount.fetch_sub(1);
+        std::lock_guard<std::mutex> lock(_helpersMutex);
+        _helpers.erase(std::find_if(_helpers.begin(), _helpers.end(), [&doneCv](const Helper& other) {
+            return other.doneCv == &doneCv;
+        }));
+    }
+}
+
+struct ParallelForState {
+    std::atomic<std::size_t> nextChunk;
+    std::atomic<std::size_t> doneChunks;
+    std::atomic<bool> isDone;
+    std::mutex mutex;
+    std::condition_variable doneCv;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t grain;
+    std::size_t chunkCount;
+    const std::function<void(std::size_t, std::size_t)>* func;
+};
+
+static void runChunks(ParallelForState* state)
+{
+    while (true) {
+        std::size_t chunk = state->nextChunk.fetch_add(1, std::memory_order_relaxed);
+        if (chunk >= state->chunkCount) {
+            return;
+        }
+        std::size_t begin = state->begin + chunk * state->grain;
+        (*state->func)(begin, std::min(begin + state->grain, state->end));
+        if (state->doneChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == state->chunkCount) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->isDone.store(true, std::memory_order_release);
+            state->doneCv.notify_all();
+        }
+    }
+}
+
+void ThreadPool::parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                             const std::function<void(std::size_t, std::size_t)>& func)
+{
+    if (begin >= end) {
+        return;
+    }
+    grain = std::max<std::size_t>(grain, 1);
+    std::size_t chunkCount = (end - begin - 1) / grain + 1;
+    if (chunkCount == 1) {
+        func(begin, end);
+        return;
+    }
+
+    // chunks are claimed from a shared counter, helpers that start late find nothing left and exit
+    // helpers may outlive the call so the state is shared
+    std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+    state->nextChunk.store(0, std::memory_order_relaxed);
+    state->doneChunks.store(0, std::memory_order_relaxed);
+    state->isDone.store(false, std::memory_order_relaxed);
+    state->begin = begin;
+    state->end = end;
+    state->grain = grain;
+    state->chunkCount = chunkCount;
+    state->func = &func;
+
+    std::size_t helperCount = std::min(chunkCount - 1, _workers.size());
+    for (std::size_t i = 0; i < helperCount; i++) {
+        post([state]() {
+            runChunks(state.get());
+        });
+    }
+    runChunks(state.get());
+    helpUntil(state->isDone, state->mutex, state->doneCv);
+}
+}
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/ArrayView.h"
+#include "bmcl/Assert.h"
+#include "bmcl/Option.h"
+#include "bmcl/Rc.h"
+#include "bmcl/Result.h"
+#include "bmcl/ThreadSafeRefCountable.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace bmcl {
+
+class ThreadPool;
+class ThreadPoolWorker;
+
+template <typename T, typename E>
+class TaskState : public ThreadSafeRefCountable<TaskState<T, E>> {
+public:
+    TaskState();
+
+    void setResult(Result<T, E>&& result);
+
+    std::atomic<bool> isDone;
+    std::mutex mutex;
+    std::condition_variable doneCv;
+    Option<Result<T, E>> result;
+};
+
+// result of a task submitted with ThreadPool::submit()
+template <typename T, typename E>
+class TaskHandle {
+public:
+    using State = TaskState<T, E>;
+
+    TaskHandle();
+
+    bool isValid() const;
+    bool isDone() const;
+
+    // waits for the task while running other pool tasks on the calling thread, invalidates the handle
+    Result<T, E> wait();
+
+private:
+    friend class ThreadPool;
+
+    TaskHandle(ThreadPool* pool, const Rc<State>& state);
+
+    ThreadPool* _pool;
+    Rc<State> _state;
+};
+
+template <typename R>
+struct TaskResultTraits;
+
+template <typename T, typename E>
+struct TaskResultTraits<Result<T, E>> {
+    using Handle = TaskHandle<T, E>;
+};
+
+// handle type for a task function returning Result<T, E>
+template <typename F>
+using TaskHandleFor = typename TaskResultTraits<typename std::decay<decltype(std::declval<F&>()())>::type>::Handle;
+
+// work stealing pool, each worker has a Chase-Lev deque of tasks
+// tasks posted by a worker go to its own deque and are run LIFO by it and stolen FIFO by idle workers,
+// tasks posted by other threads go to a shared queue
+// waiting functions (TaskHandle::wait(), parallelFor()) run queued tasks instead of blocking
+// so they can be used from inside tasks
+class BMCL_EXPORT ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(std::size_t threadCount = 0);
+    ThreadPool(const ThreadPool& other) = delete;
+    // runs remaining tasks before joining workers
+    ~ThreadPool();
+
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+
+    std::size_t threadCount() const;
+
+    void post(Task task);
+
+    // func returns Result<T, E> and must be copyable
+    template <typename F>
+    TaskHandleFor<F> submit(F&& func);
+
+    // calls func(chunkBegin, chunkEnd) for consecutive ranges of at most grain indexes covering [begin, end)
+    // chunks are run by the calling thread and by pool workers, returns after all of them finished
+    void parallelFor(std::size_t begin, std::size_t end, std::size_t grain,
+                     const std::function<void(std::size_t, std::size_t)>& func);
+    // calls func(ArrayView<T> chunk) for slices of range of at most grain elements
+    template <typename T, typename F>
+    void parallelFor(ArrayView<T> range, std::size_t grain, F&& func);
+
+    // runs one queued task on the calling thread, returns false if none was found
+    bool runOne();
+
+private:
+    template <typename T, typename E>
+    friend class TaskHandle;
+    friend class ThreadPoolWorker;
+
+    Task* takeTask(ThreadPoolWorker* worker);
+    void notify();
+    void notifyHelpers();
+    void workerMain(ThreadPoolWorker* worker);
+    void helpUntil(const std::atomic<bool>& isDone, std::mutex& mutex, std::condition_variable& doneCv);
+
+    std::vector<std::unique_ptr<ThreadPoolWorker>> _workers;
+    std::mutex _queueMutex;
+    std::deque<Task*> _queue;
+    std::atomic<std::size_t> _queueSize;
+    // tasks posted but not yet taken
+    std::atomic<std::ptrdiff_t> _pendingCount;
+    std::atomic<std::size_t> _sleepingCount;
+    std::mutex _sleepMutex;
+    std::condition_variable _sleepCv;
+    bool _isStopping;
+
+    // threads blocked in helpUntil(), woken by post()
+    struct Helper {
+        std::mutex* mutex;
+        std::condition_variable* doneCv;
+    };
+    std::atomic<uint64_t> _postCount;
+    std::atomic<std::size_t> _helperCount;
+    std::mutex _helpersMutex;
+    std::vector<Helper> _helpers;
+};
+
+template <typename T, typename E>
+inline TaskState<T, E>::TaskState()
+    : isDone(false)
+{
+}
+
+template <typename T, typename E>
+void TaskState<T, E>::setResult(Result<T, E>&& value)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    result.emplace(std::move(value));
+    isDone.store(true, std::memory_order_release);
+    doneCv.notify_all();
+}
+
+template <typename T, typename E>
+inline TaskHandle<T, E>::TaskHandle()
+    : _pool(nullptr)
+{
+}
+
+template <typename T, typename E>
+inline TaskHandle<T, E>::TaskHandle(ThreadPool* pool, const Rc<State>& state)
+    : _pool(pool)
+    , _state(state)
+{
+}
+
+template <typename T, typename E>
+inline bool TaskHandle<T, E>::isValid() const
+{
+    return !_state.isNull();
+}
+
+template <typename T, typename E>
+inline bool TaskHandle<T, E>::isDone() const
+{
+    return _state->isDone.load(std::memory_order_acquire);
+}
+
+template <typename T, typename E>
+Result<T, E> TaskHandle<T, E>::wait()
+{
+    BMCL_ASSERT(isValid());
+    _pool->helpUntil(_state->isDone, _state->mutex, _state->doneCv);
+    Rc<State> state = std::move(_state);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->result.take();
+}
+
+template <typename T, typename E, typename F>
+class TaskRunner {
+public:
+    TaskRunner(const Rc<TaskState<T, E>>& state, F&& func)
+        : _state(state)
+        , _func(std::move(func))
+    {
+    }
+
+    TaskRunner(const Rc<TaskState<T, E>>& state, const F& func)
+        : _state(state)
+        , _func(func)
+    {
+    }
+
+    void operator()()
+    {
+        _state->setResult(_func());
+    }
+
+private:
+    Rc<TaskState<T, E>> _state;
+    F _func;
+};
+
+template <typename T, typename E, typename F>
+inline TaskRunner<T, E, typename std::decay<F>::type> makeTaskRunner(const TaskHandle<T, E>*, const Rc<TaskState<T, E>>& state, F&& func)
+{
+    return TaskRunner<T, E, typename std::decay<F>::type>(state, std::forward<F>(func));
+}
+
+template <typename F>
+TaskHandleFor<F> ThreadPool::submit(F&& func)
+{
+    using Handle = TaskHandleFor<F>;
+    Rc<typename Handle::State> state = new typename Handle::State;
+    post(makeTaskRunner((const Handle*)nullptr, state, std::forward<F>(func)));
+    return Handle(this, state);
+}
+
+template <typename T, typename F>
+void ThreadPool::parallelFor(ArrayView<T> range, std::size_t grain, F&& func)
+{
+    parallelFor(0, range.size(), grain, [&range, &func](std::size_t begin, std::size_t end) {
+        func(range.slice(begin, end));
+    });
+}
+}
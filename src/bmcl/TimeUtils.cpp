@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/TimeUtils.h"
+
+#include <chrono>
+#include <ctime>
+
+#if defined(BMCL_PLATFORM_UNIX) || defined(BMCL_PLATFORM_APPLE)
+# include <time.h>
+#endif
+
+namespace bmcl {
+
+constexpr bool CoarseMonotonicClock::is_steady;
+constexpr std::size_t CachedTimeFormatter::formattedSize;
+
+#if defined(BMCL_PLATFORM_LINUX) && defined(CLOCK_MONOTONIC_COARSE)
+
+CoarseMonotonicClock::time_point CoarseMonotonicClock::now() noexcept
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return time_point(duration(int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec));
+}
+
+CoarseMonotonicClock::duration CoarseMonotonicClock::resolution()
+{
+    timespec ts;
+    if (clock_getres(CLOCK_MONOTONIC_COARSE, &ts) != 0) {
+        return duration(1);
+    }
+    return duration(int64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec);
+}
+
+#else
+
+CoarseMonotonicClock::time_point CoarseMonotonicClock::now() noexcept
+{
+    auto time = std::chrono::steady_clock::now().time_since_epoch();
+    return time_point(std::chrono::duration_cast<duration>(time));
+}
+
+CoarseMonotonicClock::duration CoarseMonotonicClock::resolution()
+{
+    return std::chrono::duration_cast<duration>(std::chrono::steady_clock::duration(1));
+}
+
+#endif
+
+static inline void formatTwoDigits(unsigned value, char* dest)
+{
+    dest[0] = char('0' + value / 10);
+    dest[1] = char('0' + value % 10);
+}
+
+CachedTimeFormatter::CachedTimeFormatter()
+    : _minuteStart(0)
+    , _last(-1)
+{
+    _str[0] = '\0';
+}
+
+const char* CachedTimeFormatter::format(std::time_t t)
+{
+    if (t == _last) {
+        return _str;
+    }
+    // timezone offsets change on minute boundaries, so only seconds need updating inside the cached minute
+    if (_last != -1 && t >= _minuteStart && t < _minuteStart + 60) {
+        formatTwoDigits(unsigned(t - _minuteStart), _str + 17);
+        _last = t;
+        return _str;
+    }
+    std::tm tm;
+#if defined(BMCL_PLATFORM_WINDOWS)
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    std::strftime(_str, sizeof(_str), "%Y-%m-%d %H:%M:%S", &tm);
+    _minuteStart = t - tm.tm_sec;
+    _last = t;
+    // leap second, don't cache the minute
+    if (tm.tm_sec >= 60) {
+        _last = -1;
+    }
+    return _str;
+}
+
+const char* formatLocalTime(std::time_t t)
+{
+    static thread_local CachedTimeFormatter formatter;
+    return formatter.format(t);
+}
+}
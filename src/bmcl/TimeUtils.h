@@ -3,12 +3,49 @@
 #include "bmcl/Config.h"
 
 #include <chrono>
+#include <cstddef>
+#include <ctime>
 
 namespace bmcl {
 
 using SystemClock = std::chrono::system_clock;
 using SystemTime = SystemClock::time_point;
 
+// steady clock updated once per scheduler tick (usually 1-4 ms) on linux, costs a few ns per call
+// other platforms fall back to std::chrono::steady_clock
+class BMCL_EXPORT CoarseMonotonicClock {
+public:
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<CoarseMonotonicClock> time_point;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept;
+    static duration resolution();
+};
+
+using CoarseTime = CoarseMonotonicClock::time_point;
+
+// formats local time as "YYYY-MM-DD HH:MM:SS", localtime is called only when the minute changes
+class BMCL_EXPORT CachedTimeFormatter {
+public:
+    static constexpr std::size_t formattedSize = 19;
+
+    CachedTimeFormatter();
+
+    // returned string is null terminated and valid until the next call
+    const char* format(std::time_t t);
+
+private:
+    std::time_t _minuteStart;
+    std::time_t _last;
+    char _str[formattedSize + 1];
+};
+
+// uses a thread local CachedTimeFormatter
+BMCL_EXPORT const char* formatLocalTime(std::time_t t);
+
 template <typename T>
 std::chrono::seconds toSecs(const T& timePoint)
 {
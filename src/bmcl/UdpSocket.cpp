@@ -0,0 +1,545 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/UdpSocket.h"
+#include "bmcl/Assert.h"
+#include "bmcl/Result.h"
+#include "bmcl/SharedBytes.h"
+
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+# include <winsock2.h>
+# include <ws2tcpip.h>
+#else
+# include <arpa/inet.h>
+# include <errno.h>
+# include <fcntl.h>
+# include <netinet/in.h>
+# include <sys/socket.h>
+# include <unistd.h>
+#endif
+
+#if defined(BMCL_PLATFORM_LINUX)
+# include <netinet/udp.h>
+# define BMCL_HAS_MMSG
+# ifndef SOL_UDP
+#  define SOL_UDP 17
+# endif
+# ifndef UDP_SEGMENT
+#  define UDP_SEGMENT 103
+# endif
+# ifndef UDP_GRO
+#  define UDP_GRO 104
+# endif
+#endif
+
+namespace bmcl {
+
+// messages passed to one recvmmsg/sendmmsg call
+static const std::size_t mmsgChunk = 64;
+// largest udp payload over ipv4
+static const std::size_t maxPayload = 65507;
+
+#ifdef _WIN32
+using SockLen = int;
+
+static int lastError()
+{
+    return WSAGetLastError();
+}
+
+static void closeSocket(UdpSocket::SocketType handle)
+{
+    ::closesocket(SOCKET(handle));
+}
+
+static void startup()
+{
+    static std::once_flag flag;
+    std::call_once(flag, []() {
+        WSADATA data;
+        WSAStartup(MAKEWORD(2, 2), &data);
+    });
+}
+
+static const UdpSocket::SocketType invalidSocket = UdpSocket::SocketType(INVALID_SOCKET);
+#else
+using SockLen = socklen_t;
+
+static int lastError()
+{
+    return errno;
+}
+
+static void closeSocket(UdpSocket::SocketType handle)
+{
+    ::close(handle);
+}
+
+static void startup()
+{
+}
+
+static const UdpSocket::SocketType invalidSocket = -1;
+#endif
+
+static sockaddr_in toSockaddr(const SocketAddressV4& address)
+{
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(address.address().toUint32());
+    addr.sin_port = htons(address.port());
+    return addr;
+}
+
+static SocketAddressV4 fromSockaddr(const sockaddr_in& addr)
+{
+    return SocketAddressV4(ntohl(addr.sin_addr.s_addr), ntohs(addr.sin_port));
+}
+
+UdpBatch::UdpBatch(std::size_t capacity, std::size_t slotSize)
+    : _storage(capacity * slotSize)
+    , _entries(capacity)
+    , _slotSize(slotSize)
+    , _size(0)
+{
+}
+
+bool UdpBatch::append(Bytes data, const SocketAddressV4& address)
+{
+    if (isFull() || data.size() > _slotSize) {
+        return false;
+    }
+    std::memcpy(slot(_size), data.data(), data.size());
+    commit(data.size(), address);
+    return true;
+}
+
+uint8_t* UdpBatch::reserve()
+{
+    if (isFull()) {
+        return nullptr;
+    }
+    return slot(_size);
+}
+
+void UdpBatch::commit(std::size_t size, const SocketAddressV4& address)
+{
+    BMCL_ASSERT(!isFull());
+    BMCL_ASSERT(size <= _slotSize);
+    Entry& entry = _entries[_size];
+    entry.address = address;
+    entry.size = size;
+    entry.segmentSize = 0;
+    entry.isTruncated = false;
+    _size++;
+}
+
+UdpSocket::UdpSocket()
+    : _handle(invalidSocket)
+    , _hasGso(true)
+{
+}
+
+UdpSocket::UdpSocket(SocketType handle)
+    : _handle(handle)
+    , _hasGso(true)
+{
+}
+
+UdpSocket::UdpSocket(UdpSocket&& other)
+    : _handle(other._handle)
+    , _hasGso(other._hasGso)
+{
+    other._handle = invalidSocket;
+}
+
+UdpSocket::~UdpSocket()
+{
+    close();
+}
+
+UdpSocket& UdpSocket::operator=(UdpSocket&& other)
+{
+    if (this != &other) {
+        close();
+        _handle = other._handle;
+        _hasGso = other._hasGso;
+        other._handle = invalidSocket;
+    }
+    return *this;
+}
+
+void UdpSocket::close()
+{
+    if (isValid()) {
+        closeSocket(_handle);
+        _handle = invalidSocket;
+    }
+}
+
+Result<UdpSocket, int> UdpSocket::bind(const SocketAddressV4& address)
+{
+    startup();
+#if defined(BMCL_PLATFORM_LINUX)
+    SocketType handle = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+#else
+    SocketType handle = SocketType(::socket(AF_INET, SOCK_DGRAM, 0));
+#endif
+    if (handle == invalidSocket) {
+        return lastError();
+    }
+#if !defined(_WIN32) && !defined(BMCL_PLATFORM_LINUX)
+    ::fcntl(handle, F_SETFD, FD_CLOEXEC);
+#endif
+    UdpSocket udp(handle);
+    sockaddr_in addr = toSockaddr(address);
+    if (::bind(handle, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        return lastError();
+    }
+    return udp;
+}
+
+Result<SocketAddressV4, int> UdpSocket::localAddress() const
+{
+    sockaddr_in addr;
+    SockLen size = sizeof(addr);
+    if (::getsockname(_handle, (sockaddr*)&addr, &size) != 0) {
+        return lastError();
+    }
+    return fromSockaddr(addr);
+}
+
+bool UdpSocket::setNonBlocking(bool isNonBlocking)
+{
+#ifdef _WIN32
+    u_long mode = isNonBlocking;
+    return ::ioctlsocket(SOCKET(_handle), FIONBIO, &mode) == 0;
+#else
+    int flags = ::fcntl(_handle, F_GETFL);
+    if (flags == -1) {
+        return false;
+    }
+    flags = isNonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return ::fcntl(_handle, F_SETFL, flags) == 0;
+#endif
+}
+
+bool UdpSocket::setReceiveBufferSize(std::size_t size)
+{
+    int value = int(size);
+    return ::setsockopt(_handle, SOL_SOCKET, SO_RCVBUF, (const char*)&value, sizeof(value)) == 0;
+}
+
+bool UdpSocket::setSendBufferSize(std::size_t size)
+{
+    int value = int(size);
+    return ::setsockopt(_handle, SOL_SOCKET, SO_SNDBUF, (const char*)&value, sizeof(value)) == 0;
+}
+
+bool UdpSocket::setGroEnabled(bool isEnabled)
+{
+#if defined(BMCL_PLATFORM_LINUX)
+    int value = isEnabled;
+    return ::setsockopt(_handle, SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0;
+#else
+    (void)isEnabled;
+    return false;
+#endif
+}
+
+Result<std::size_t, int> UdpSocket::sendTo(Bytes data, const SocketAddressV4& address)
+{
+    sockaddr_in addr = toSockaddr(address);
+    auto rv = ::sendto(_handle, (const char*)data.data(), data.size(), 0, (const sockaddr*)&addr, sizeof(addr));
+    if (rv < 0) {
+        return lastError();
+    }
+    return std::size_t(rv);
+}
+
+Result<std::size_t, int> UdpSocket::receiveFrom(void* dest, std::size_t size, SocketAddressV4* src)
+{
+    sockaddr_in addr;
+    SockLen addrSize = sizeof(addr);
+    auto rv = ::recvfrom(_handle, (char*)dest, size, 0, (sockaddr*)&addr, &addrSize);
+    if (rv < 0) {
+        return lastError();
+    }
+    if (src) {
+        *src = fromSockaddr(addr);
+    }
+    return std::size_t(rv);
+}
+
+#if defined(BMCL_HAS_MMSG)
+
+Result<std::size_t, int> UdpSocket::receive(UdpBatch* batch)
+{
+    batch->clear();
+    mmsghdr headers[mmsgChunk];
+    iovec vecs[mmsgChunk];
+    sockaddr_in addrs[mmsgChunk];
+    alignas(cmsghdr) char controls[mmsgChunk][CMSG_SPACE(sizeof(int))];
+
+    // without MSG_WAITFORONE a blocking call waits until all count datagrams arrive
+    int flags = MSG_WAITFORONE;
+    while (!batch->isFull()) {
+        std::size_t count = BMCL_MIN(mmsgChunk, batch->capacity() - batch->size());
+        for (std::size_t i = 0; i < count; i++) {
+            vecs[i].iov_base = batch->slot(batch->size() + i);
+            vecs[i].iov_len = batch->slotSize();
+            msghdr& msg = headers[i].msg_hdr;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &addrs[i];
+            msg.msg_namelen = sizeof(addrs[i]);
+            msg.msg_iov = &vecs[i];
+            msg.msg_iovlen = 1;
+            msg.msg_control = controls[i];
+            msg.msg_controllen = sizeof(controls[i]);
+        }
+        int rv = ::recvmmsg(_handle, headers, unsigned(count), flags, nullptr);
+        if (rv < 0) {
+            int error = errno;
+            if (batch->isEmpty()) {
+                if (error == EINTR) {
+                    continue;
+                }
+                return error;
+            }
+            break;
+        }
+        for (int i = 0; i < rv; i++) {
+            const msghdr& msg = headers[i].msg_hdr;
+            UdpBatch::Entry& entry = batch->_entries[batch->_size];
+            entry.address = fromSockaddr(addrs[i]);
+            entry.size = BMCL_MIN(std::size_t(headers[i].msg_len), batch->slotSize());
+            entry.isTruncated = msg.msg_flags & MSG_TRUNC;
+            entry.segmentSize = 0;
+            for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR((msghdr*)&msg, cmsg)) {
+                if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                    int segmentSize;
+                    std::memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+                    if (std::size_t(segmentSize) < entry.size) {
+                        entry.segmentSize = std::size_t(segmentSize);
+                    }
+                }
+            }
+            batch->_size++;
+        }
+        if (std::size_t(rv) < count) {
+            break;
+        }
+        // only the first call waits
+        flags = MSG_DONTWAIT;
+    }
+    return batch->size();
+}
+
+template <typename F>
+static Result<std::size_t, int> sendChunks(int handle, std::size_t count, F&& getMessage)
+{
+    mmsghdr headers[mmsgChunk];
+    iovec vecs[mmsgChunk];
+    sockaddr_in addrs[mmsgChunk];
+
+    std::size_t sent = 0;
+    while (sent < count) {
+        std::size_t n = BMCL_MIN(mmsgChunk, count - sent);
+        for (std::size_t i = 0; i < n; i++) {
+            const SocketAddressV4* address;
+            Bytes data = getMessage(sent + i, &address);
+            addrs[i] = toSockaddr(*address);
+            vecs[i].iov_base = (void*)data.data();
+            vecs[i].iov_len = data.size();
+            msghdr& msg = headers[i].msg_hdr;
+            std::memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &addrs[i];
+            msg.msg_namelen = sizeof(addrs[i]);
+            msg.msg_iov = &vecs[i];
+            msg.msg_iovlen = 1;
+        }
+        int rv = ::sendmmsg(handle, headers, unsigned(n), 0);
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (sent == 0) {
+                return errno;
+            }
+            break;
+        }
+        sent += std::size_t(rv);
+        if (std::size_t(rv) < n) {
+            break;
+        }
+    }
+    return sent;
+}
+
+#else
+
+Result<std::size_t, int> UdpSocket::receive(UdpBatch* batch)
+{
+    batch->clear();
+    while (!batch->isFull()) {
+        sockaddr_in addr;
+        SockLen addrSize = sizeof(addr);
+# if defined(MSG_DONTWAIT)
+        int flags = batch->isEmpty() ? 0 : MSG_DONTWAIT;
+# else
+        int flags = 0;
+# endif
+        auto rv = ::recvfrom(_handle, (char*)batch->slot(batch->size()), batch->slotSize(), flags, (sockaddr*)&addr, &addrSize);
+        if (rv < 0) {
+            if (batch->isEmpty()) {
+                return lastError();
+            }
+            break;
+        }
+        UdpBatch::Entry& entry = batch->_entries[batch->_size];
+        entry.address = fromSockaddr(addr);
+        entry.size = BMCL_MIN(std::size_t(rv), batch->slotSize());
+        entry.isTruncated = std::size_t(rv) > batch->slotSize();
+        entry.segmentSize = 0;
+        batch->_size++;
+# if !defined(MSG_DONTWAIT)
+        // can't check for more data without blocking
+        break;
+# endif
+    }
+    return batch->size();
+}
+
+template <typename F>
+static Result<std::size_t, int> sendChunks(UdpSocket::SocketType handle, std::size_t count, F&& getMessage)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        const SocketAddressV4* address;
+        Bytes data = getMessage(i, &address);
+        sockaddr_in addr = toSockaddr(*address);
+        auto rv = ::sendto(handle, (const char*)data.data(), data.size(), 0, (const sockaddr*)&addr, sizeof(addr));
+        if (rv < 0) {
+            if (i == 0) {
+                return lastError();
+            }
+            return i;
+        }
+    }
+    return count;
+}
+
+#endif
+
+Result<std::size_t, int> UdpSocket::send(const UdpBatch& batch)
+{
+    return sendChunks(_handle, batch.size(), [&batch](std::size_t i, const SocketAddressV4** address) {
+        *address = &batch.address(i);
+        return batch.datagram(i);
+    });
+}
+
+Result<std::size_t, int> UdpSocket::send(const Bytes* datagrams, const SocketAddressV4* addresses, std::size_t count)
+{
+    return sendChunks(_handle, count, [datagrams, addresses](std::size_t i, const SocketAddressV4** address) {
+        *address = &addresses[i];
+        return datagrams[i];
+    });
+}
+
+Result<std::size_t, int> UdpSocket::send(const SharedBytes* datagrams, const SocketAddressV4* addresses, std::size_t count)
+{
+    return sendChunks(_handle, count, [datagrams, addresses](std::size_t i, const SocketAddressV4** address) {
+        *address = &addresses[i];
+        return datagrams[i].view();
+    });
+}
+
+Result<std::size_t, int> UdpSocket::sendSegmented(Bytes data, std::size_t segmentSize, const SocketAddressV4& address)
+{
+    BMCL_ASSERT(segmentSize != 0);
+    std::size_t sent = 0;
+#if defined(BMCL_PLATFORM_LINUX)
+    // the kernel accepts up to 64 segments and a total size of one udp datagram
+    std::size_t maxChunk = BMCL_MIN(std::size_t(64), maxPayload / segmentSize) * segmentSize;
+    sockaddr_in addr = toSockaddr(address);
+    while (_hasGso && sent < data.size() && maxChunk != 0) {
+        std::size_t size = BMCL_MIN(maxChunk, data.size() - sent);
+        iovec vec;
+        vec.iov_base = (void*)(data.data() + sent);
+        vec.iov_len = size;
+        alignas(cmsghdr) char control[CMSG_SPACE(sizeof(uint16_t))];
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &vec;
+        msg.msg_iovlen = 1;
+        if (size > segmentSize) {
+            std::memset(control, 0, sizeof(control));
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_SEGMENT;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            uint16_t value = uint16_t(segmentSize);
+            std::memcpy(CMSG_DATA(cmsg), &value, sizeof(value));
+        }
+        ssize_t rv = ::sendmsg(_handle, &msg, 0);
+        if (rv < 0) {
+            int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            // no kernel or device support, the rest goes without offload
+            if (error == EINVAL || error == ENOPROTOOPT || error == EOPNOTSUPP || error == EIO) {
+                _hasGso = false;
+                break;
+            }
+            if (sent == 0) {
+                return error;
+            }
+            return sent;
+        }
+        sent += size;
+    }
+#endif
+
+    while (sent < data.size()) {
+        Bytes segments[mmsgChunk];
+        SocketAddressV4 addresses[mmsgChunk];
+        std::size_t count = 0;
+        std::size_t offset = sent;
+        while (count < mmsgChunk && offset < data.size()) {
+            std::size_t size = BMCL_MIN(segmentSize, data.size() - offset);
+            segments[count] = Bytes(data.data() + offset, size);
+            addresses[count] = address;
+            offset += size;
+            count++;
+        }
+        Result<std::size_t, int> rv = send(segments, addresses, count);
+        if (rv.isErr()) {
+            if (sent == 0) {
+                return rv.unwrapErr();
+            }
+            break;
+        }
+        for (std::size_t i = 0; i < rv.unwrap(); i++) {
+            sent += segments[i].size();
+        }
+        if (rv.unwrap() < count) {
+            break;
+        }
+    }
+    return sent;
+}
+}
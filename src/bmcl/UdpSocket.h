@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/ArrayView.h"
+#include "bmcl/Fwd.h"
+#include "bmcl/IpAddress.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bmcl {
+
+class SharedBytes;
+
+// fixed number of datagram slots with storage allocated once, reused between receive and send calls
+class BMCL_EXPORT UdpBatch {
+public:
+    // slotSize is the largest datagram that fits, should be 64k if GRO is enabled
+    explicit UdpBatch(std::size_t capacity, std::size_t slotSize = 2048);
+
+    std::size_t capacity() const;
+    std::size_t slotSize() const;
+    std::size_t size() const;
+    bool isEmpty() const;
+    bool isFull() const;
+    void clear();
+
+    Bytes datagram(std::size_t index) const;
+    const SocketAddressV4& address(std::size_t index) const;
+    // datagram was larger than slotSize and was cut
+    bool isTruncated(std::size_t index) const;
+    // size of the datagrams coalesced into this one by GRO (the last may be shorter), 0 if it is a single datagram
+    std::size_t segmentSize(std::size_t index) const;
+
+    // copies data to the next slot, returns false if the batch is full or data is larger than slotSize
+    bool append(Bytes data, const SocketAddressV4& address);
+    // next free slot for serializing in place, followed by commit() with the written size
+    uint8_t* reserve();
+    void commit(std::size_t size, const SocketAddressV4& address);
+
+private:
+    friend class UdpSocket;
+
+    struct Entry {
+        SocketAddressV4 address;
+        std::size_t size;
+        std::size_t segmentSize;
+        bool isTruncated;
+    };
+
+    uint8_t* slot(std::size_t index);
+    const uint8_t* slot(std::size_t index) const;
+
+    std::vector<uint8_t> _storage;
+    std::vector<Entry> _entries;
+    std::size_t _slotSize;
+    std::size_t _size;
+};
+
+inline std::size_t UdpBatch::capacity() const
+{
+    return _entries.size();
+}
+
+inline std::size_t UdpBatch::slotSize() const
+{
+    return _slotSize;
+}
+
+inline std::size_t UdpBatch::size() const
+{
+    return _size;
+}
+
+inline bool UdpBatch::isEmpty() const
+{
+    return _size == 0;
+}
+
+inline bool UdpBatch::isFull() const
+{
+    return _size == _entries.size();
+}
+
+inline void UdpBatch::clear()
+{
+    _size = 0;
+}
+
+inline uint8_t* UdpBatch::slot(std::size_t index)
+{
+    return _storage.data() + index * _slotSize;
+}
+
+inline const uint8_t* UdpBatch::slot(std::size_t index) const
+{
+    return _storage.data() + index * _slotSize;
+}
+
+inline Bytes UdpBatch::datagram(std::size_t index) const
+{
+    return Bytes(slot(index), _entries[index].size);
+}
+
+inline const SocketAddressV4& UdpBatch::address(std::size_t index) const
+{
+    return _entries[index].address;
+}
+
+inline bool UdpBatch::isTruncated(std::size_t index) const
+{
+    return _entries[index].isTruncated;
+}
+
+inline std::size_t UdpBatch::segmentSize(std::size_t index) const
+{
+    return _entries[index].segmentSize;
+}
+
+// ipv4 udp socket, errors are errno values (WSAGetLastError() on windows)
+// batches go through single recvmmsg/sendmmsg calls on linux and through a call per datagram elsewhere
+class BMCL_EXPORT UdpSocket {
+public:
+#ifdef _WIN32
+    using SocketType = std::uintptr_t;
+#else
+    using SocketType = int;
+#endif
+
+    UdpSocket();
+    UdpSocket(const UdpSocket& other) = delete;
+    UdpSocket(UdpSocket&& other);
+    ~UdpSocket();
+
+    UdpSocket& operator=(const UdpSocket& other) = delete;
+    UdpSocket& operator=(UdpSocket&& other);
+
+    // port 0 binds to a free port
+    static Result<UdpSocket, int> bind(const SocketAddressV4& address);
+
+    bool isValid() const;
+    SocketType nativeHandle() const;
+    void close();
+
+    Result<SocketAddressV4, int> localAddress() const;
+
+    // non blocking receives return EAGAIN (EWOULDBLOCK on windows) if there is no data
+    bool setNonBlocking(bool isNonBlocking);
+    bool setReceiveBufferSize(std::size_t size);
+    bool setSendBufferSize(std::size_t size);
+    // lets the kernel coalesce consecutive datagrams from one source (linux 5.0+), see UdpBatch::segmentSize()
+    bool setGroEnabled(bool isEnabled);
+
+    Result<std::size_t, int> sendTo(Bytes data, const SocketAddressV4& address);
+    // returns datagram size, src may be null
+    Result<std::size_t, int> receiveFrom(void* dest, std::size_t size, SocketAddressV4* src);
+
+    // replaces batch contents with up to capacity() datagrams, waits only for the first one
+    // returns number of received datagrams, an error is only returned if nothing was received
+    Result<std::size_t, int> receive(UdpBatch* batch);
+
+    // return number of sent datagrams, an error is only returned if nothing was sent
+    Result<std::size_t, int> send(const UdpBatch& batch);
+    Result<std::size_t, int> send(const Bytes* datagrams, const SocketAddressV4* addresses, std::size_t count);
+    Result<std::size_t, int> send(const SharedBytes* datagrams, const SocketAddressV4* addresses, std::size_t count);
+
+    // sends data as datagrams of segmentSize bytes (the last may be shorter) to one address
+    // the kernel does the splitting if UDP_SEGMENT is supported (linux 4.18+), otherwise segments are sent as a batch
+    // returns number of sent bytes
+    Result<std::size_t, int> sendSegmented(Bytes data, std::size_t segmentSize, const SocketAddressV4& address);
+
+private:
+    explicit UdpSocket(SocketType handle);
+
+    SocketType _handle;
+    bool _hasGso;
+};
+
+inline bool UdpSocket::isValid() const
+{
+#ifdef _WIN32
+    return _handle != SocketType(~0);
+#else
+    return _handle != -1;
+#endif
+}
+
+inline UdpSocket::SocketType UdpSocket::nativeHandle() const
+{
+    return _handle;
+}
+}
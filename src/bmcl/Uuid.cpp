@@ -7,8 +7,10 @@
  */
 
 #include "bmcl/Uuid.h"
+#include "bmcl/UuidGenerator.h"
 #include "bmcl/StringView.h"
 #include "bmcl/Result.h"
+#include "bmcl/String.h"
 
 #ifdef BMCL_HAVE_QT
 # include <QString>
@@ -18,6 +20,7 @@
 #endif
 
 #include <algorithm>
+#include <cstring>
 
 namespace bmcl {
 
@@ -31,39 +34,52 @@ namespace bmcl {
     #error "Unsupported platform"
 #endif
 
-inline void appendHex(uint8_t n, char* dest)
+// 16 bytes -> {xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}, hex conversion is vectorized in bytesToHexLower
+static inline void formatUuid(const uint8_t* data, char* dest)
 {
-    const char* hexChars = "0123456789abcdef";
-    dest[0] = hexChars[(n & 0xf0) >> 4];
-    dest[1] = hexChars[n & 0x0f];
+    char hex[32];
+    bytesToHexLower(data, 16, hex);
+    dest[0] = '{';
+    std::memcpy(dest + 1, hex, 8);
+    dest[9] = '-';
+    std::memcpy(dest + 10, hex + 8, 4);
+    dest[14] = '-';
+    std::memcpy(dest + 15, hex + 12, 4);
+    dest[19] = '-';
+    std::memcpy(dest + 20, hex + 16, 4);
+    dest[24] = '-';
+    std::memcpy(dest + 25, hex + 20, 12);
+    dest[37] = '}';
+}
+
+// accepts the same formats as uuidFromString, dashes are removed and the hex chars are decoded by hexToBytes
+static inline bool parseUuid(const char* str, std::size_t size, uint8_t* dest)
+{
+    if (size == 34 || size == 38) {
+        if (str[0] != '{' || str[size - 1] != '}') {
+            return false;
+        }
+        str++;
+        size -= 2;
+    }
+    if (size == 32) {
+        return hexToBytes(StringView(str, 32), dest);
+    }
+    if (size != 36 || str[8] != '-' || str[13] != '-' || str[18] != '-' || str[23] != '-') {
+        return false;
+    }
+    char hex[32];
+    std::memcpy(hex, str, 8);
+    std::memcpy(hex + 8, str + 9, 4);
+    std::memcpy(hex + 12, str + 14, 4);
+    std::memcpy(hex + 16, str + 19, 4);
+    std::memcpy(hex + 20, str + 24, 12);
+    return hexToBytes(StringView(hex, 32), dest);
 }
 
 UuidStringRepr::UuidStringRepr(const Uuid& uuid)
 {
-    const Uuid::Data data = uuid.data();
-
-    _data[0] = '{';
-    appendHex(data[0], &_data[1]);
-    appendHex(data[1], &_data[3]);
-    appendHex(data[2], &_data[5]);
-    appendHex(data[3], &_data[7]);
-    _data[9] = '-';
-    appendHex(data[4], &_data[10]);
-    appendHex(data[5], &_data[12]);
-    _data[14] = '-';
-    appendHex(data[6], &_data[15]);
-    appendHex(data[7], &_data[17]);
-    _data[19] = '-';
-    appendHex(data[8], &_data[20]);
-    appendHex(data[9], &_data[22]);
-    _data[24] = '-';
-    appendHex(data[10], &_data[25]);
-    appendHex(data[11], &_data[27]);
-    appendHex(data[12], &_data[29]);
-    appendHex(data[13], &_data[31]);
-    appendHex(data[14], &_data[33]);
-    appendHex(data[15], &_data[35]);
-    _data[37] = '}';
+    formatUuid(uuid.data().data(), _data.data());
     _data[38] = '\0';
 }
 
@@ -145,6 +161,15 @@ Uuid Uuid::create()
     return u;
 }
 
+Uuid Uuid::createV4()
+{
+    return threadUuidGenerator().createV4();
+}
+
+Uuid Uuid::createV7()
+{
+    return threadUuidGenerator().createV7();
+}
 
 template <typename C, typename T>
 Result<Uuid, void> Uuid::uuidFromString(T view)
@@ -242,19 +267,41 @@ Result<Uuid, void> Uuid::createFromString(const QStringRef& str)
 
 Result<Uuid, void> Uuid::createFromString(const QByteArray& str)
 {
-    return uuidFromString<int>(StringView(str.data(), str.size()));
+    return createFromString(StringView(str.data(), str.size()));
 }
 
 Result<Uuid, void> Uuid::createFromString(const QLatin1String& str)
 {
-    return uuidFromString<int>(StringView(str.data(), str.size()));
+    return createFromString(StringView(str.data(), str.size()));
 }
 
 #endif
 
 Result<Uuid, void> Uuid::createFromString(bmcl::StringView view)
 {
-    return uuidFromString<int>(view);
+    Uuid u;
+    if (!parseUuid(view.data(), view.size(), u._data.data())) {
+        return Result<Uuid, void>();
+    }
+    return u;
+}
+
+std::size_t Uuid::parseMany(const StringView* src, std::size_t count, Uuid* dest)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        if (!parseUuid(src[i].data(), src[i].size(), dest[i]._data.data())) {
+            return i;
+        }
+    }
+    return count;
+}
+
+void Uuid::formatMany(const Uuid* src, std::size_t count, char* dest)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        formatUuid(src[i]._data.data(), dest);
+        dest += UuidStringRepr::reprSize;
+    }
 }
 
 std::string Uuid::toStdString() const
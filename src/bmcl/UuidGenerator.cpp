@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#if defined(_WIN32) && !defined(_CRT_RAND_S)
+# define _CRT_RAND_S
+#endif
+
+#include "bmcl/UuidGenerator.h"
+#include "bmcl/Panic.h"
+
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(BMCL_PLATFORM_LINUX)
+# include <sys/syscall.h>
+#endif
+#if defined(BMCL_PLATFORM_UNIX) || defined(BMCL_PLATFORM_APPLE)
+# include <fcntl.h>
+# include <pthread.h>
+# include <unistd.h>
+#endif
+
+namespace bmcl {
+
+constexpr std::size_t UuidGenerator::bufferSize;
+
+// incremented in the child after fork, generators compare it with the value at seeding
+static std::atomic<unsigned> forkGeneration(0);
+
+#if defined(BMCL_PLATFORM_UNIX) || defined(BMCL_PLATFORM_APPLE)
+static void onFork()
+{
+    forkGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void registerForkHandler()
+{
+    static bool isRegistered = (pthread_atfork(nullptr, nullptr, onFork), true);
+    (void)isRegistered;
+}
+
+static bool readUrandom(std::uint8_t* dest, std::size_t size)
+{
+    int fd = ::open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+    while (size != 0) {
+        ssize_t rv = ::read(fd, dest, size);
+        if (rv <= 0) {
+            if (rv < 0 && errno == EINTR) {
+                continue;
+            }
+            ::close(fd);
+            return false;
+        }
+        dest += rv;
+        size -= std::size_t(rv);
+    }
+    ::close(fd);
+    return true;
+}
+#else
+static void registerForkHandler()
+{
+}
+#endif
+
+static void systemRandom(void* dest, std::size_t size)
+{
+    std::uint8_t* out = (std::uint8_t*)dest;
+#if defined(BMCL_PLATFORM_WINDOWS)
+    while (size != 0) {
+        unsigned value;
+        if (rand_s(&value) != 0) {
+            panic("rand_s failed");
+        }
+        std::size_t chunk = BMCL_MIN(size, sizeof(value));
+        std::memcpy(out, &value, chunk);
+        out += chunk;
+        size -= chunk;
+    }
+#elif defined(BMCL_PLATFORM_APPLE) || defined(BMCL_PLATFORM_BSD)
+    (void)out;
+    arc4random_buf(dest, size);
+#else
+# if defined(BMCL_PLATFORM_LINUX) && defined(SYS_getrandom)
+    while (size != 0) {
+        long rv = ::syscall(SYS_getrandom, out, size, 0);
+        if (rv < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        out += rv;
+        size -= std::size_t(rv);
+    }
+# endif
+    if (size != 0 && !readUrandom(out, size)) {
+        panic("failed to read system random source");
+    }
+#endif
+}
+
+static inline std::uint32_t rotl(std::uint32_t value, int shift)
+{
+    return (value << shift) | (value >> (32 - shift));
+}
+
+#define BMCL_CHACHA_QR(a, b, c, d)          \
+    a += b; d ^= a; d = rotl(d, 16);        \
+    c += d; b ^= c; b = rotl(b, 12);        \
+    a += b; d ^= a; d = rotl(d, 8);         \
+    c += d; b ^= c; b = rotl(b, 7)
+
+static void chacha20Block(const std::uint32_t* key, std::uint64_t counter, std::uint8_t* dest)
+{
+    std::uint32_t input[16] = {
+        0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+        key[0], key[1], key[2], key[3],
+        key[4], key[5], key[6], key[7],
+        std::uint32_t(counter), std::uint32_t(counter >> 32), 0, 0,
+    };
+    std::uint32_t x[16];
+    std::memcpy(x, input, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        BMCL_CHACHA_QR(x[0], x[4], x[8], x[12]);
+        BMCL_CHACHA_QR(x[1], x[5], x[9], x[13]);
+        BMCL_CHACHA_QR(x[2], x[6], x[10], x[14]);
+        BMCL_CHACHA_QR(x[3], x[7], x[11], x[15]);
+        BMCL_CHACHA_QR(x[0], x[5], x[10], x[15]);
+        BMCL_CHACHA_QR(x[1], x[6], x[11], x[12]);
+        BMCL_CHACHA_QR(x[2], x[7], x[8], x[13]);
+        BMCL_CHACHA_QR(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; i++) {
+        std::uint32_t value = x[i] + input[i];
+        dest[i * 4 + 0] = std::uint8_t(value);
+        dest[i * 4 + 1] = std::uint8_t(value >> 8);
+        dest[i * 4 + 2] = std::uint8_t(value >> 16);
+        dest[i * 4 + 3] = std::uint8_t(value >> 24);
+    }
+}
+
+#undef BMCL_CHACHA_QR
+
+UuidGenerator::UuidGenerator()
+    : _lastTimestamp(0)
+    , _sequence(0)
+{
+    registerForkHandler();
+    reseed();
+}
+
+UuidGenerator::~UuidGenerator()
+{
+    std::memset(_key, 0, sizeof(_key));
+    std::memset(_buffer, 0, sizeof(_buffer));
+}
+
+void UuidGenerator::reseed()
+{
+    _generation = forkGeneration.load(std::memory_order_relaxed);
+    systemRandom(_key, sizeof(_key));
+    _counter = 0;
+    refill();
+}
+
+void UuidGenerator::refill()
+{
+    for (std::size_t i = 0; i < bufferSize; i += 64) {
+        chacha20Block(_key, _counter++, _buffer + i);
+    }
+    // fast key erasure, the first 32 bytes become the next key and are never returned
+    std::memcpy(_key, _buffer, sizeof(_key));
+    std::memset(_buffer, 0, sizeof(_key));
+    _offset = sizeof(_key);
+}
+
+inline void UuidGenerator::checkFork()
+{
+    if (forkGeneration.load(std::memory_order_relaxed) != _generation) {
+        reseed();
+    }
+}
+
+void UuidGenerator::generate(void* dest, std::size_t size)
+{
+    checkFork();
+    std::uint8_t* out = (std::uint8_t*)dest;
+    while (size != 0) {
+        if (_offset == bufferSize) {
+            refill();
+        }
+        std::size_t chunk = BMCL_MIN(size, bufferSize - _offset);
+        std::memcpy(out, _buffer + _offset, chunk);
+        // used output is wiped
+        std::memset(_buffer + _offset, 0, chunk);
+        _offset += chunk;
+        out += chunk;
+        size -= chunk;
+    }
+}
+
+static inline void setVersion(Uuid::Data* data, std::uint8_t version)
+{
+    (*data)[6] = ((*data)[6] & 0x0f) | std::uint8_t(version << 4);
+    (*data)[8] = ((*data)[8] & 0x3f) | 0x80;
+}
+
+Uuid UuidGenerator::createV4()
+{
+    Uuid::Data data;
+    generate(data.data(), data.size());
+    setVersion(&data, 4);
+    return Uuid(data);
+}
+
+void UuidGenerator::createV4(Uuid* dest, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        dest[i] = createV4();
+    }
+}
+
+static std::uint64_t unixTimeMs()
+{
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return std::uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(now).count());
+}
+
+Uuid::Data UuidGenerator::nextV7(std::uint64_t timestamp)
+{
+    Uuid::Data data;
+    generate(data.data() + 6, 10);
+
+    // 12 bit rand_a is a counter, it starts at a random value with the top bit clear to leave room for increments
+    // if it overflows or the clock goes back the previous timestamp is reused or advanced
+    if (timestamp > _lastTimestamp) {
+        _lastTimestamp = timestamp;
+        _sequence = ((unsigned(data[6]) << 8) | data[7]) & 0x7ff;
+    } else {
+        _sequence++;
+        if (_sequence > 0xfff) {
+            _lastTimestamp++;
+            _sequence = ((unsigned(data[6]) << 8) | data[7]) & 0x7ff;
+        }
+    }
+
+    data[0] = std::uint8_t(_lastTimestamp >> 40);
+    data[1] = std::uint8_t(_lastTimestamp >> 32);
+    data[2] = std::uint8_t(_lastTimestamp >> 24);
+    data[3] = std::uint8_t(_lastTimestamp >> 16);
+    data[4] = std::uint8_t(_lastTimestamp >> 8);
+    data[5] = std::uint8_t(_lastTimestamp);
+    data[6] = std::uint8_t(0x70 | (_sequence >> 8));
+    data[7] = std::uint8_t(_sequence);
+    data[8] = (data[8] & 0x3f) | 0x80;
+    return data;
+}
+
+Uuid UuidGenerator::createV7()
+{
+    return Uuid(nextV7(unixTimeMs()));
+}
+
+void UuidGenerator::createV7(Uuid* dest, std::size_t count)
+{
+    std::uint64_t timestamp = unixTimeMs();
+    for (std::size_t i = 0; i < count; i++) {
+        dest[i] = Uuid(nextV7(timestamp));
+    }
+}
+
+UuidGenerator& threadUuidGenerator()
+{
+    static thread_local UuidGenerator generator;
+    return generator;
+}
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Uuid.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bmcl {
+
+// userspace uuid generator, not thread safe
+// random data comes from ChaCha20 keyed from the system random source, the key is replaced
+// with generator output after each refill so earlier output can't be recovered from the state
+// reseeds automatically in a child process after fork
+class BMCL_EXPORT UuidGenerator {
+public:
+    UuidGenerator();
+    UuidGenerator(const UuidGenerator& other) = delete;
+    ~UuidGenerator();
+
+    UuidGenerator& operator=(const UuidGenerator& other) = delete;
+
+    // random uuid (RFC 9562 version 4)
+    Uuid createV4();
+    void createV4(Uuid* dest, std::size_t count);
+
+    // unix millisecond timestamp followed by random bits (RFC 9562 version 7),
+    // uuids created by one generator are strictly increasing
+    Uuid createV7();
+    void createV7(Uuid* dest, std::size_t count);
+
+    void generate(void* dest, std::size_t size);
+    void reseed();
+
+private:
+    static constexpr std::size_t bufferSize = 1024;
+
+    void refill();
+    void checkFork();
+    Uuid::Data nextV7(std::uint64_t timestamp);
+
+    std::uint32_t _key[8];
+    std::uint64_t _counter;
+    std::size_t _offset;
+    unsigned _generation;
+    std::uint64_t _lastTimestamp;
+    unsigned _sequence;
+    std::uint8_t _buffer[bufferSize];
+};
+
+// generator owned by the calling thread
+BMCL_EXPORT UuidGenerator& threadUuidGenerator();
+}
@@ -0,0 +1,369 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include "bmcl/UuidSet.h"
+#include "bmcl/Assert.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if defined(BMCL_HAVE_SSE2)
+# include <emmintrin.h>
+#endif
+
+namespace bmcl {
+
+constexpr std::size_t UuidSet::groupSize;
+constexpr std::uint8_t UuidSet::emptyCtrl;
+constexpr std::uint8_t UuidSet::deletedCtrl;
+
+static const std::size_t invalidIndex = std::size_t(-1);
+// number of lookups hashed and prefetched ahead in bulk operations
+static const std::size_t bulkChunk = 16;
+
+// bit i is set if ctrl[i] == value
+static inline unsigned matchCtrl(const std::uint8_t* ctrl, std::uint8_t value)
+{
+#if defined(BMCL_HAVE_SSE2)
+    __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+    return unsigned(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(char(value)))));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        mask |= unsigned(ctrl[i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+// bit i is set if slot i is empty or deleted
+static inline unsigned matchFree(const std::uint8_t* ctrl)
+{
+#if defined(BMCL_HAVE_SSE2)
+    return unsigned(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)ctrl)));
+#else
+    unsigned mask = 0;
+    for (unsigned i = 0; i < 16; i++) {
+        mask |= unsigned(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+static inline bool keyEquals(const std::uint8_t* key, const Uuid& uuid)
+{
+#if defined(BMCL_HAVE_SSE2)
+    __m128i a = _mm_loadu_si128((const __m128i*)key);
+    __m128i b = _mm_loadu_si128((const __m128i*)uuid.data().data());
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff;
+#else
+    return std::memcmp(key, uuid.data().data(), 16) == 0;
+#endif
+}
+
+static inline unsigned lowestBit(unsigned mask)
+{
+#if defined(__GNUC__)
+    return unsigned(__builtin_ctz(mask));
+#else
+    unsigned i = 0;
+    while (!(mask & 1)) {
+        mask >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static inline std::uint64_t load64(const std::uint8_t* data)
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, 8);
+    return value;
+}
+
+// v7 and v1 uuids have low entropy in the first bytes, both halves are mixed
+std::uint64_t UuidSet::hash(const Uuid& uuid)
+{
+    std::uint64_t x = load64(uuid.data().data()) * 0x9e3779b97f4a7c15ull;
+    x ^= load64(uuid.data().data() + 8);
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ull;
+    x ^= x >> 32;
+    return x;
+}
+
+UuidSet::UuidSet()
+    : _ctrl(nullptr)
+    , _keys(nullptr)
+    , _capacity(0)
+    , _size(0)
+    , _deleted(0)
+{
+}
+
+UuidSet::UuidSet(const UuidSet& other)
+    : _ctrl(nullptr)
+    , _keys(nullptr)
+    , _capacity(0)
+    , _size(other._size)
+    , _deleted(other._deleted)
+{
+    if (other._capacity) {
+        allocate(other._capacity);
+        std::memcpy(_ctrl, other._ctrl, memoryUsage());
+    }
+}
+
+UuidSet::UuidSet(UuidSet&& other)
+    : _ctrl(other._ctrl)
+    , _keys(other._keys)
+    , _capacity(other._capacity)
+    , _size(other._size)
+    , _deleted(other._deleted)
+{
+    other._ctrl = nullptr;
+    other._keys = nullptr;
+    other._capacity = 0;
+    other._size = 0;
+    other._deleted = 0;
+}
+
+UuidSet::~UuidSet()
+{
+    std::free(_ctrl);
+}
+
+UuidSet& UuidSet::operator=(const UuidSet& other)
+{
+    if (this != &other) {
+        UuidSet copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+UuidSet& UuidSet::operator=(UuidSet&& other)
+{
+    if (this != &other) {
+        std::free(_ctrl);
+        _ctrl = other._ctrl;
+        _keys = other._keys;
+        _capacity = other._capacity;
+        _size = other._size;
+        _deleted = other._deleted;
+        other._ctrl = nullptr;
+        other._keys = nullptr;
+        other._capacity = 0;
+        other._size = 0;
+        other._deleted = 0;
+    }
+    return *this;
+}
+
+void UuidSet::allocate(std::size_t capacity)
+{
+    BMCL_ASSERT(capacity % groupSize == 0);
+    // groups are read with unaligned loads, some allocators only guarantee 8 byte alignment
+    _ctrl = (std::uint8_t*)std::malloc(capacity * 17);
+    BMCL_ASSERT(_ctrl);
+    _keys = _ctrl + capacity;
+    _capacity = capacity;
+    std::memset(_ctrl, emptyCtrl, capacity);
+}
+
+inline void UuidSet::setCtrl(std::size_t index, std::uint8_t ctrl)
+{
+    _ctrl[index] = ctrl;
+}
+
+void UuidSet::clear()
+{
+    if (_capacity) {
+        std::memset(_ctrl, emptyCtrl, _capacity);
+    }
+    _size = 0;
+    _deleted = 0;
+}
+
+static std::size_t capacityFor(std::size_t size)
+{
+    std::size_t capacity = 16;
+    while (capacity / 8 * 7 < size) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+void UuidSet::reserve(std::size_t size)
+{
+    if (capacityFor(size) > _capacity) {
+        rehash(capacityFor(size));
+    }
+}
+
+void UuidSet::rehash(std::size_t capacity)
+{
+    std::uint8_t* oldCtrl = _ctrl;
+    std::uint8_t* oldKeys = _keys;
+    std::size_t oldCapacity = _capacity;
+    allocate(capacity);
+    _deleted = 0;
+    for (std::size_t i = 0; i < oldCapacity; i++) {
+        if (oldCtrl[i] < emptyCtrl) {
+            Uuid::Data data;
+            std::memcpy(data.data(), oldKeys + i * 16, 16);
+            Uuid uuid(data);
+            std::uint64_t h = hash(uuid);
+            std::size_t index = findFree(h);
+            setCtrl(index, std::uint8_t(h & 0x7f));
+            std::memcpy(_keys + index * 16, data.data(), 16);
+        }
+    }
+    std::free(oldCtrl);
+}
+
+std::size_t UuidSet::find(const Uuid& uuid, std::uint64_t hash) const
+{
+    if (_capacity == 0) {
+        return invalidIndex;
+    }
+    std::size_t groupMask = _capacity / groupSize - 1;
+    std::size_t group = (hash >> 7) & groupMask;
+    std::uint8_t h2 = std::uint8_t(hash & 0x7f);
+    // triangular probing visits every group when the group count is a power of two
+    for (std::size_t step = 1; step <= groupMask + 1; step++) {
+        const std::uint8_t* ctrl = _ctrl + group * groupSize;
+        unsigned match = matchCtrl(ctrl, h2);
+        while (match) {
+            std::size_t index = group * groupSize + lowestBit(match);
+            if (keyEquals(keyAt(index), uuid)) {
+                return index;
+            }
+            match &= match - 1;
+        }
+        if (matchCtrl(ctrl, emptyCtrl)) {
+            return invalidIndex;
+        }
+        group = (group + step) & groupMask;
+    }
+    return invalidIndex;
+}
+
+std::size_t UuidSet::findFree(std::uint64_t hash) const
+{
+    std::size_t groupMask = _capacity / groupSize - 1;
+    std::size_t group = (hash >> 7) & groupMask;
+    for (std::size_t step = 1;; step++) {
+        unsigned match = matchFree(_ctrl + group * groupSize);
+        if (match) {
+            return group * groupSize + lowestBit(match);
+        }
+        group = (group + step) & groupMask;
+    }
+}
+
+inline void UuidSet::prefetch(std::uint64_t hash) const
+{
+#if defined(__GNUC__)
+    if (_capacity) {
+        std::size_t group = (hash >> 7) & (_capacity / groupSize - 1);
+        __builtin_prefetch(_ctrl + group * groupSize);
+        __builtin_prefetch(_keys + group * groupSize * 16);
+    }
+#else
+    (void)hash;
+#endif
+}
+
+bool UuidSet::insert(const Uuid& uuid, std::uint64_t hash)
+{
+    if (find(uuid, hash) != invalidIndex) {
+        return false;
+    }
+    if ((_size + _deleted + 1) > _capacity / 8 * 7) {
+        // tombstones are dropped without growing if they take a large part of the table
+        std::size_t capacity = _deleted > _size / 2 ? _capacity : _capacity * 2;
+        rehash(BMCL_MAX(capacity, groupSize));
+    }
+    std::size_t index = findFree(hash);
+    if (_ctrl[index] == deletedCtrl) {
+        _deleted--;
+    }
+    setCtrl(index, std::uint8_t(hash & 0x7f));
+    std::memcpy(_keys + index * 16, uuid.data().data(), 16);
+    _size++;
+    return true;
+}
+
+bool UuidSet::insert(const Uuid& uuid)
+{
+    return insert(uuid, hash(uuid));
+}
+
+std::size_t UuidSet::insert(const Uuid* uuids, std::size_t count)
+{
+    reserve(_size + count);
+    std::size_t inserted = 0;
+    std::uint64_t hashes[bulkChunk];
+    for (std::size_t start = 0; start < count; start += bulkChunk) {
+        std::size_t n = BMCL_MIN(bulkChunk, count - start);
+        for (std::size_t i = 0; i < n; i++) {
+            hashes[i] = hash(uuids[start + i]);
+            prefetch(hashes[i]);
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            inserted += insert(uuids[start + i], hashes[i]);
+        }
+    }
+    return inserted;
+}
+
+bool UuidSet::remove(const Uuid& uuid)
+{
+    std::size_t index = find(uuid, hash(uuid));
+    if (index == invalidIndex) {
+        return false;
+    }
+    // probing only continues past full groups, if this group has an empty slot no probe sequence
+    // depends on the removed slot being occupied
+    if (matchCtrl(_ctrl + index / groupSize * groupSize, emptyCtrl)) {
+        setCtrl(index, emptyCtrl);
+    } else {
+        setCtrl(index, deletedCtrl);
+        _deleted++;
+    }
+    _size--;
+    return true;
+}
+
+bool UuidSet::contains(const Uuid& uuid) const
+{
+    return find(uuid, hash(uuid)) != invalidIndex;
+}
+
+std::size_t UuidSet::contains(const Uuid* uuids, std::size_t count, bool* dest) const
+{
+    std::size_t found = 0;
+    std::uint64_t hashes[bulkChunk];
+    for (std::size_t start = 0; start < count; start += bulkChunk) {
+        std::size_t n = BMCL_MIN(bulkChunk, count - start);
+        for (std::size_t i = 0; i < n; i++) {
+            hashes[i] = hash(uuids[start + i]);
+            prefetch(hashes[i]);
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            bool isFound = find(uuids[start + i], hashes[i]) != invalidIndex;
+            dest[start + i] = isFound;
+            found += isFound;
+        }
+    }
+    return found;
+}
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Uuid.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace bmcl {
+
+// open addressing hash set of uuids, 17 bytes per slot
+// slots are split into groups of 16, each group has 16 control bytes holding 7 bits of the hash of occupied slots,
+// a lookup compares the control bytes of a group at once and only checks keys of matching slots
+class BMCL_EXPORT UuidSet {
+public:
+    UuidSet();
+    UuidSet(const UuidSet& other);
+    UuidSet(UuidSet&& other);
+    ~UuidSet();
+
+    UuidSet& operator=(const UuidSet& other);
+    UuidSet& operator=(UuidSet&& other);
+
+    std::size_t size() const;
+    bool isEmpty() const;
+    // number of slots
+    std::size_t capacity() const;
+    // bytes allocated for the table
+    std::size_t memoryUsage() const;
+
+    // makes room for size elements without rehashing
+    void reserve(std::size_t size);
+    void clear();
+
+    // returns false if the uuid is already in the set
+    bool insert(const Uuid& uuid);
+    // returns number of inserted uuids
+    std::size_t insert(const Uuid* uuids, std::size_t count);
+    bool remove(const Uuid& uuid);
+
+    bool contains(const Uuid& uuid) const;
+    // sets dest[i] to contains(uuids[i]), returns number of found uuids
+    std::size_t contains(const Uuid* uuids, std::size_t count, bool* dest) const;
+
+    template <typename F>
+    void forEach(F&& func) const;
+
+private:
+    static constexpr std::size_t groupSize = 16;
+    static constexpr std::uint8_t emptyCtrl = 0x80;
+    static constexpr std::uint8_t deletedCtrl = 0xfe;
+
+    static std::uint64_t hash(const Uuid& uuid);
+    std::size_t find(const Uuid& uuid, std::uint64_t hash) const;
+    std::size_t findFree(std::uint64_t hash) const;
+    bool insert(const Uuid& uuid, std::uint64_t hash);
+    void prefetch(std::uint64_t hash) const;
+    void rehash(std::size_t capacity);
+    void allocate(std::size_t capacity);
+    void setCtrl(std::size_t index, std::uint8_t ctrl);
+    const std::uint8_t* keyAt(std::size_t index) const;
+
+    // control bytes followed by keys in one allocation
+    std::uint8_t* _ctrl;
+    std::uint8_t* _keys;
+    std::size_t _capacity;
+    std::size_t _size;
+    std::size_t _deleted;
+};
+
+inline std::size_t UuidSet::size() const
+{
+    return _size;
+}
+
+inline bool UuidSet::isEmpty() const
+{
+    return _size == 0;
+}
+
+inline std::size_t UuidSet::capacity() const
+{
+    return _capacity;
+}
+
+inline std::size_t UuidSet::memoryUsage() const
+{
+    return _capacity * 17;
+}
+
+inline const std::uint8_t* UuidSet::keyAt(std::size_t index) const
+{
+    return _keys + index * 16;
+}
+
+template <typename F>
+void UuidSet::forEach(F&& func) const
+{
+    for (std::size_t i = 0; i < _capacity; i++) {
+        if (_ctrl[i] < emptyCtrl) {
+            Uuid::Data data;
+            std::memcpy(data.data(), keyAt(i), 16);
+            func(Uuid(data));
+        }
+    }
+}
+}
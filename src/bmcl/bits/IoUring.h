@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace bmcl {
+
+// minimal io_uring wrapper over raw syscalls, internal
+// single threaded, the caller keeps the number of requests in flight below cqEntries()
+class IoUring {
+public:
+    IoUring()
+        : _fd(-1)
+        , _sqRing(nullptr)
+        , _cqRing(nullptr)
+        , _sqes(nullptr)
+        , _sqRingSize(0)
+        , _cqRingSize(0)
+        , _sqeTail(0)
+        , _submittedTail(0)
+        , _inFlight(0)
+    {
+    }
+
+    IoUring(const IoUring& other) = delete;
+    IoUring& operator=(const IoUring& other) = delete;
+
+    ~IoUring()
+    {
+        if (_sqes) {
+            ::munmap(_sqes, _params.sq_entries * sizeof(io_uring_sqe));
+        }
+        if (_cqRing && _cqRing != _sqRing) {
+            ::munmap(_cqRing, _cqRingSize);
+        }
+        if (_sqRing) {
+            ::munmap(_sqRing, _sqRingSize);
+        }
+        if (_fd != -1) {
+            ::close(_fd);
+        }
+    }
+
+    // returns errno, fails on kernels without io_uring or if it is disabled
+    int init(unsigned entries)
+    {
+        std::memset(&_params, 0, sizeof(_params));
+        long fd = ::syscall(__NR_io_uring_setup, entries, &_params);
+        if (fd < 0) {
+            return errno;
+        }
+        _fd = int(fd);
+        _sqRingSize = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+        _cqRingSize = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+        bool isSingleMmap = _params.features & IORING_FEAT_SINGLE_MMAP;
+        if (isSingleMmap) {
+            _sqRingSize = _cqRingSize = BMCL_MAX(_sqRingSize, _cqRingSize);
+        }
+        void* sqRing = ::mmap(nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                              IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            return errno;
+        }
+        _sqRing = (std::uint8_t*)sqRing;
+        if (isSingleMmap) {
+            _cqRing = _sqRing;
+        } else {
+            void* cqRing = ::mmap(nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+                                  IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                return errno;
+            }
+            _cqRing = (std::uint8_t*)cqRing;
+        }
+        void* sqes = ::mmap(nullptr, _params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            return errno;
+        }
+        _sqes = (io_uring_sqe*)sqes;
+
+        // sqes are always filled in ring order, so the index array is the identity
+        unsigned* array = (unsigned*)(_sqRing + _params.sq_off.array);
+        for (unsigned i = 0; i < _params.sq_entries; i++) {
+            array[i] = i;
+        }
+        _sqeTail = *sqTail();
+        _submittedTail = _sqeTail;
+        return 0;
+    }
+
+    bool supports(std::uint8_t opcode) const
+    {
+        std::vector<std::uint8_t> buf(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = (io_uring_probe*)buf.data();
+        if (::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+            return false;
+        }
+        return opcode <= probe->last_op && (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED);
+    }
+
+    unsigned sqEntries() const
+    {
+        return _params.sq_entries;
+    }
+
+    unsigned cqEntries() const
+    {
+        return _params.cq_entries;
+    }
+
+    // returns a zeroed sqe or nullptr if the submission queue is full
+    io_uring_sqe* getSqe()
+    {
+        unsigned head = __atomic_load_n(sqHead(), __ATOMIC_ACQUIRE);
+        if (_sqeTail - head >= _params.sq_entries) {
+            return nullptr;
+        }
+        io_uring_sqe* sqe = &_sqes[_sqeTail & *sqMask()];
+        std::memset(sqe, 0, sizeof(io_uring_sqe));
+        _sqeTail++;
+        return sqe;
+    }
+
+    // submits queued sqes and waits for at least waitNr completions, returns errno
+    int submit(unsigned waitNr)
+    {
+        __atomic_store_n(sqTail(), _sqeTail, __ATOMIC_RELEASE);
+        do {
+            unsigned toSubmit = _sqeTail - _submittedTail;
+            unsigned flags = waitNr ? IORING_ENTER_GETEVENTS : 0;
+            long rv = ::syscall(__NR_io_uring_enter, _fd, toSubmit, waitNr, flags, nullptr, 0);
+            if (rv < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            _submittedTail += unsigned(rv);
+            _inFlight += unsigned(rv);
+            waitNr = 0;
+        } while (_submittedTail != _sqeTail);
+        return 0;
+    }
+
+    // blocks until at least one completion is available, returns errno
+    int wait()
+    {
+        while (true) {
+            long rv = ::syscall(__NR_io_uring_enter, _fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (rv >= 0) {
+                return 0;
+            }
+            if (errno != EINTR) {
+                return errno;
+            }
+        }
+    }
+
+    // returns the next completion or nullptr, each returned cqe must be released with seen()
+    const io_uring_cqe* peek()
+    {
+        unsigned head = *cqHead();
+        if (head == __atomic_load_n(cqTail(), __ATOMIC_ACQUIRE)) {
+            return nullptr;
+        }
+        io_uring_cqe* cqes = (io_uring_cqe*)(_cqRing + _params.cq_off.cqes);
+        return &cqes[head & *cqMask()];
+    }
+
+    void seen()
+    {
+        __atomic_store_n(cqHead(), *cqHead() + 1, __ATOMIC_RELEASE);
+        _inFlight--;
+    }
+
+    // number of submitted requests whose completions were not released with seen() yet
+    unsigned inFlight() const
+    {
+        return _inFlight;
+    }
+
+private:
+    unsigned* sqHead()
+    {
+        return (unsigned*)(_sqRing + _params.sq_off.head);
+    }
+
+    unsigned* sqTail()
+    {
+        return (unsigned*)(_sqRing + _params.sq_off.tail);
+    }
+
+    unsigned* sqMask()
+    {
+        return (unsigned*)(_sqRing + _params.sq_off.ring_mask);
+    }
+
+    unsigned* cqHead()
+    {
+        return (unsigned*)(_cqRing + _params.cq_off.head);
+    }
+
+    unsigned* cqTail()
+    {
+        return (unsigned*)(_cqRing + _params.cq_off.tail);
+    }
+
+    unsigned* cqMask()
+    {
+        return (unsigned*)(_cqRing + _params.cq_off.ring_mask);
+    }
+
+    int _fd;
+    io_uring_params _params;
+    std::uint8_t* _sqRing;
+    std::uint8_t* _cqRing;
+    io_uring_sqe* _sqes;
+    std::size_t _sqRingSize;
+    std::size_t _cqRingSize;
+    unsigned _sqeTail;
+    unsigned _submittedTail;
+    unsigned _inFlight;
+};
+}
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#pragma once
+
+#include "bmcl/Config.h"
+#include "bmcl/Logging.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace bmcl {
+
+// internal to the library, used by async text logging and binary logging
+
+// single producer single consumer queue of variable size records
+// records are committed by the consumer after a whole batch is handled
+class LogQueue {
+public:
+    inline LogQueue(std::size_t capacity);
+
+    inline std::size_t capacity() const;
+    inline std::size_t maxRecordSize() const;
+    inline bool isEmpty() const;
+    inline bool isHandled(uint64_t pos) const;
+    inline uint64_t writePos() const;
+    // size taken by a record with data truncated to maxRecordSize()
+    inline std::size_t recordSize(std::size_t headerSize, std::size_t dataSize) const;
+    // called by the producer
+    inline bool hasSpace(std::size_t recordSize) const;
+
+    // data is truncated to maxRecordSize()
+    inline bool tryPush(const void* header, std::size_t headerSize, const void* data, std::size_t dataSize);
+    inline void countDropped();
+    inline uint64_t dropped() const;
+
+    inline void beginRead();
+    inline bool read(std::string* record);
+    inline void commitRead();
+
+private:
+    inline void copyIn(uint64_t pos, const void* src, std::size_t size);
+    inline void copyOut(uint64_t pos, void* dest, std::size_t size) const;
+
+    std::vector<uint8_t> _data;
+    uint64_t _mask;
+    uint64_t _readPos;
+    uint64_t _readEnd;
+    std::atomic<uint64_t> _dropped;
+    char _pad1[64];
+    std::atomic<uint64_t> _head;
+    char _pad2[64];
+    std::atomic<uint64_t> _tail;
+};
+
+// how long panic flush hooks wait for a writer thread, a stuck handler must not keep a panicking process alive
+constexpr std::chrono::milliseconds logPanicFlushTimeout(1000);
+
+// owns a background thread draining per-thread queues
+// every writer instance uses its own thread local queue slot
+class LogQueueWriter {
+public:
+    enum Slot {
+        TextSlot = 0,
+        BinarySlot = 1,
+        SlotCount = 2
+    };
+
+    LogQueueWriter(Slot slot);
+    virtual ~LogQueueWriter();
+
+    inline bool isEnabled() const;
+    inline std::size_t maxRecordSize() const;
+    void start(std::size_t queueSize, LogOverflowPolicy policy);
+    void stop();
+    // returns false if the record was not queued and should be handled synchronously,
+    // records pushed from the writer thread itself are never queued
+    bool push(const void* header, std::size_t headerSize, const void* data, std::size_t dataSize);
+    void countDropped();
+    // returns immediately if called from the writer thread
+    void flush();
+    // same as flush() but waits at most timeout, returns false if records are still pending
+    bool flushFor(std::chrono::milliseconds timeout);
+    bool isWriterThread() const;
+    uint64_t dropped();
+
+protected:
+    // called from the writer thread, queues are read with beginRead()/read(), returns true if anything was handled
+    virtual bool handleBatch(const std::vector<std::shared_ptr<LogQueue>>& queues) = 0;
+
+private:
+    LogQueue* localQueue();
+    bool pushLocal(const void* header, std::size_t headerSize, const void* data, std::size_t dataSize);
+    void drainStopped();
+    bool waitHandled(const std::chrono::milliseconds* timeout);
+    void run();
+    bool hasPendingLocked() const;
+    void wakeWriter();
+
+    Slot _slot;
+    std::mutex _mutex;
+    std::condition_variable _writerCv;
+    std::condition_variable _flushCv;
+    // notified after every handled batch, producers blocked on a full queue wait on it
+    std::condition_variable _spaceCv;
+    std::vector<std::shared_ptr<LogQueue>> _queues;
+    std::thread _thread;
+    uint64_t _removedDropped;
+    std::atomic<bool> _isEnabled;
+    std::atomic<bool> _isRunning;
+    std::atomic<bool> _isWriterSleeping;
+    // pushes that passed the _isRunning check, stop() waits for them before the final drain
+    std::atomic<unsigned> _activePushes;
+    std::atomic<std::size_t> _queueSize;
+    std::atomic<int> _policy;
+};
+
+inline LogQueue::LogQueue(std::size_t capacity)
+    : _data(capacity)
+    , _mask(capacity - 1)
+    , _readPos(0)
+    , _readEnd(0)
+    , _dropped(0)
+    , _head(0)
+    , _tail(0)
+{
+}
+
+inline std::size_t LogQueue::capacity() const
+{
+    return _data.size();
+}
+
+inline std::size_t LogQueue::maxRecordSize() const
+{
+    return _data.size() / 2;
+}
+
+inline bool LogQueue::isEmpty() const
+{
+    return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+}
+
+inline bool LogQueue::isHandled(uint64_t pos) const
+{
+    return _tail.load(std::memory_order_acquire) >= pos;
+}
+
+inline uint64_t LogQueue::writePos() const
+{
+    return _head.load(std::memory_order_acquire);
+}
+
+inline void LogQueue::copyIn(uint64_t pos, const void* src, std::size_t size)
+{
+    // src may be null for empty headers
+    if (size == 0) {
+        return;
+    }
+    std::size_t offset = pos & _mask;
+    std::size_t first = BMCL_MIN(size, _data.size() - offset);
+    std::memcpy(_data.data() + offset, src, first);
+    std::memcpy(_data.data(), (const uint8_t*)src + first, size - first);
+}
+
+inline void LogQueue::copyOut(uint64_t pos, void* dest, std::size_t size) const
+{
+    std::size_t offset = pos & _mask;
+    std::size_t first = BMCL_MIN(size, _data.size() - offset);
+    std::memcpy(dest, _data.data() + offset, first);
+    std::memcpy((uint8_t*)dest + first, _data.data(), size - first);
+}
+
+inline std::size_t LogQueue::recordSize(std::size_t headerSize, std::size_t dataSize) const
+{
+    return sizeof(uint32_t) + headerSize + BMCL_MIN(dataSize, maxRecordSize() - headerSize);
+}
+
+inline bool LogQueue::hasSpace(std::size_t recordSize) const
+{
+    uint64_t head = _head.load(std::memory_order_relaxed);
+    uint64_t tail = _tail.load(std::memory_order_acquire);
+    return _data.size() - (head - tail) >= recordSize;
+}
+
+inline bool LogQueue::tryPush(const void* header, std::size_t headerSize, const void* data, std::size_t dataSize)
+{
+    dataSize = BMCL_MIN(dataSize, maxRecordSize() - headerSize);
+    uint32_t size = uint32_t(headerSize + dataSize);
+    std::size_t recordSize = sizeof(size) + size;
+
+    if (!hasSpace(recordSize)) {
+        return false;
+    }
+    uint64_t head = _head.load(std::memory_order_relaxed);
+    copyIn(head, &size, sizeof(size));
+    copyIn(head + sizeof(size), header, headerSize);
+    copyIn(head + sizeof(size) + headerSize, data, dataSize);
+    _head.store(head + recordSize, std::memory_order_release);
+    return true;
+}
+
+inline void LogQueue::countDropped()
+{
+    _dropped.store(_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+inline uint64_t LogQueue::dropped() const
+{
+    return _dropped.load(std::memory_order_relaxed);
+}
+
+inline void LogQueue::beginRead()
+{
+    _readEnd = _head.load(std::memory_order_acquire);
+}
+
+inline bool LogQueue::read(std::string* record)
+{
+    if (_readPos == _readEnd) {
+        return false;
+    }
+    uint32_t size;
+    copyOut(_readPos, &size, sizeof(size));
+    record->resize(size);
+    copyOut(_readPos + sizeof(size), &(*record)[0], size);
+    _readPos += sizeof(size) + size;
+    return true;
+}
+
+inline void LogQueue::commitRead()
+{
+    _tail.store(_readPos, std::memory_order_release);
+}
+
+inline bool LogQueueWriter::isEnabled() const
+{
+    return _isEnabled.load(std::memory_order_acquire);
+}
+
+inline std::size_t LogQueueWriter::maxRecordSize() const
+{
+    return _queueSize.load(std::memory_order_relaxed) / 2;
+}
+}
@@ -0,0 +1,246 @@
+#include "bmcl/AsyncStream.h"
+#include "bmcl/AsyncTask.h"
+#include "bmcl/RingBuffer.h"
+
+#include "BmclTest.h"
+
+#include <string>
+#include <vector>
+
+using namespace bmcl;
+
+// frames are a big endian uint16 size followed by the payload
+
+static std::string makeFrame(const std::string& payload)
+{
+    std::string frame;
+    frame.push_back(char(payload.size() >> 8));
+    frame.push_back(char(payload.size()));
+    return frame + payload;
+}
+
+class FrameDecoder {
+public:
+    FrameDecoder()
+        : headerReads(0)
+    {
+    }
+
+    bool step(AsyncReader* reader)
+    {
+        BMCL_ASYNC_BEGIN(_state);
+        BMCL_ASYNC_AWAIT_READ(_state, reader, 2);
+        _size = reader->readUint16Be();
+        headerReads++;
+        BMCL_ASYNC_AWAIT_READ(_state, reader, _size);
+        payload.resize(_size);
+        reader->read(&payload[0], _size);
+        BMCL_ASYNC_END(_state);
+    }
+
+    void reset()
+    {
+        _state.reset();
+    }
+
+    bool isDone() const
+    {
+        return _state.isDone();
+    }
+
+    std::string payload;
+    std::size_t headerReads;
+
+private:
+    AsyncState _state;
+    std::size_t _size;
+};
+
+TEST(AsyncStream, state_machine_resumes)
+{
+    uint8_t storage[16];
+    RingBuffer buffer(storage, sizeof(storage));
+    AsyncReader reader(&buffer);
+    FrameDecoder decoder;
+
+    std::string data = makeFrame("hello") + makeFrame("") + makeFrame("world!");
+    std::vector<std::string> frames;
+    // fed one byte at a time, every step continues where the previous one stopped
+    for (char c : data) {
+        buffer.write(&c, 1);
+        while (decoder.step(&reader)) {
+            EXPECT_TRUE(decoder.isDone());
+            EXPECT_TRUE(decoder.step(&reader));
+            frames.push_back(decoder.payload);
+            decoder.reset();
+        }
+    }
+    EXPECT_EQ(std::vector<std::string>({"hello", "", "world!"}), frames);
+    EXPECT_EQ(3u, decoder.headerReads);
+    EXPECT_TRUE(buffer.isEmpty());
+}
+
+class FrameEncoder {
+public:
+    explicit FrameEncoder(const std::string& payload)
+        : _payload(payload)
+    {
+    }
+
+    bool step(AsyncWriter* writer)
+    {
+        BMCL_ASYNC_BEGIN(_state);
+        BMCL_ASYNC_AWAIT_WRITE(_state, writer, 2 + _payload.size());
+        writer->writeUint16Be(uint16_t(_payload.size()));
+        writer->write(_payload.data(), _payload.size());
+        BMCL_ASYNC_END(_state);
+    }
+
+private:
+    AsyncState _state;
+    std::string _payload;
+};
+
+TEST(AsyncStream, state_machine_writer)
+{
+    uint8_t storage[8];
+    RingBuffer buffer(storage, sizeof(storage));
+    AsyncWriter writer(&buffer);
+    buffer.write("abcd", 4);
+
+    FrameEncoder encoder("12345");
+    EXPECT_FALSE(encoder.step(&writer));
+    EXPECT_FALSE(encoder.step(&writer));
+    buffer.erase(3);
+    EXPECT_TRUE(encoder.step(&writer));
+    EXPECT_EQ(8u, buffer.usedSpace());
+    char result[8];
+    buffer.read(result, 8);
+    EXPECT_EQ(std::string("d") + makeFrame("12345"), std::string(result, 8));
+}
+
+#ifdef BMCL_HAVE_COROUTINES
+
+static AsyncTask<Option<std::string>> readFrame(AsyncReader* reader)
+{
+    bool isOk = co_await reader->read(2);
+    if (!isOk) {
+        co_return None;
+    }
+    std::string payload(reader->readUint16Be(), '\0');
+    isOk = co_await reader->readInto(&payload[0], payload.size());
+    if (!isOk) {
+        co_return None;
+    }
+    co_return payload;
+}
+
+static AsyncTask<std::vector<std::string>> readFrames(AsyncReader* reader)
+{
+    std::vector<std::string> frames;
+    while (true) {
+        Option<std::string> frame = co_await readFrame(reader);
+        if (frame.isNone()) {
+            co_return frames;
+        }
+        frames.push_back(frame.take());
+    }
+}
+
+TEST(AsyncStream, coroutine_reader)
+{
+    // payloads are larger than the buffer
+    uint8_t storage[8];
+    RingBuffer buffer(storage, sizeof(storage));
+    AsyncReader reader(&buffer);
+    AsyncTask<std::vector<std::string>> task = readFrames(&reader);
+
+    std::string data = makeFrame("first frame") + makeFrame("") + makeFrame("x");
+    std::size_t offset = 0;
+    while (offset < data.size()) {
+        std::size_t size = BMCL_MIN(buffer.freeSpace(), BMCL_MIN(data.size() - offset, std::size_t(3)));
+        buffer.write(data.data() + offset, size);
+        offset += size;
+        reader.notify();
+        EXPECT_FALSE(task.isDone());
+    }
+    EXPECT_TRUE(buffer.isEmpty());
+    reader.close();
+    reader.notify();
+    ASSERT_TRUE(task.isDone());
+    EXPECT_EQ(std::vector<std::string>({"first frame", "", "x"}), task.takeResult());
+}
+
+TEST(AsyncStream, coroutine_reader_truncated)
+{
+    uint8_t storage[8];
+    RingBuffer buffer(storage, sizeof(storage));
+    AsyncReader reader(&buffer);
+    AsyncTask<Option<std::string>> task = readFrame(&reader);
+    buffer.write("\x00\x05" "ab", 4);
+    reader.notify();
+    EXPECT_FALSE(task.isDone());
+    reader.close();
+    reader.notify();
+    ASSERT_TRUE(task.isDone());
+    EXPECT_TRUE(task.takeResult().isNone());
+}
+
+static AsyncTask<bool> writeFrame(AsyncWriter* writer, std::string payload)
+{
+    bool isOk = co_await writer->reserve(2);
+    if (!isOk) {
+        co_return false;
+    }
+    writer->writeUint16Be(uint16_t(payload.size()));
+    co_return co_await writer->writeFrom(payload.data(), payload.size());
+}
+
+TEST(AsyncStream, coroutine_writer)
+{
+    uint8_t storage[4];
+    RingBuffer buffer(storage, sizeof(storage));
+    AsyncWriter writer(&buffer);
+    buffer.write("abc", 3);
+
+    AsyncTask<bool> task = writeFrame(&writer, "0123456789");
+    std::string written;
+    while (!task.isDone()) {
+        char chunk[4];
+        std::size_t size = buffer.usedSpace();
+        buffer.read(chunk, size);
+        written.append(chunk, size);
+        writer.notify();
+    }
+    EXPECT_TRUE(task.takeResult());
+    std::size_t size = buffer.usedSpace();
+    char chunk[4];
+    buffer.read(chunk, size);
+    written.append(chunk, size);
+    EXPECT_EQ("abc" + makeFrame("0123456789"), written);
+
+    buffer.write("abcd", 4);
+    AsyncTask<bool> closed = writeFrame(&writer, "x");
+    EXPECT_FALSE(closed.isDone());
+    writer.close();
+    writer.notify();
+    ASSERT_TRUE(closed.isDone());
+    EXPECT_FALSE(closed.takeResult());
+}
+
+TEST(AsyncStream, destroy_suspended_task)
+{
+    uint8_t storage[8];
+    RingBuffer buffer(storage, sizeof(storage));
+    AsyncReader reader(&buffer);
+    {
+        AsyncTask<std::vector<std::string>> task = readFrames(&reader);
+        EXPECT_FALSE(task.isDone());
+    }
+    // the destroyed awaiter was unregistered
+    buffer.write("\x00\x01" "a", 3);
+    reader.notify();
+    EXPECT_EQ(3u, buffer.usedSpace());
+}
+
+#endif
@@ -0,0 +1,82 @@
+#include "bmcl/Base32.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace bmcl;
+
+static std::string decodeToString(StringView src)
+{
+    auto rv = base32Decode(src);
+    if (rv.isErr()) {
+        return "<error>";
+    }
+    return std::string((const char*)rv.unwrap().begin(), rv.unwrap().size());
+}
+
+TEST(Base32, rfcVectors)
+{
+    EXPECT_EQ("", base32Encode(StringView("").asBytes()));
+    EXPECT_EQ("MY======", base32Encode(StringView("f").asBytes()));
+    EXPECT_EQ("MZXQ====", base32Encode(StringView("fo").asBytes()));
+    EXPECT_EQ("MZXW6===", base32Encode(StringView("foo").asBytes()));
+    EXPECT_EQ("MZXW6YQ=", base32Encode(StringView("foob").asBytes()));
+    EXPECT_EQ("MZXW6YTB", base32Encode(StringView("fooba").asBytes()));
+    EXPECT_EQ("MZXW6YTBOI======", base32Encode(StringView("foobar").asBytes()));
+
+    EXPECT_EQ("", decodeToString(""));
+    EXPECT_EQ("f", decodeToString("MY======"));
+    EXPECT_EQ("fo", decodeToString("MZXQ===="));
+    EXPECT_EQ("foo", decodeToString("MZXW6==="));
+    EXPECT_EQ("foob", decodeToString("MZXW6YQ="));
+    EXPECT_EQ("fooba", decodeToString("MZXW6YTB"));
+    EXPECT_EQ("foobar", decodeToString("MZXW6YTBOI======"));
+}
+
+TEST(Base32, unpaddedAndLowerCase)
+{
+    EXPECT_EQ("MZXW6YTBOI", base32Encode(StringView("foobar").asBytes(), false));
+    EXPECT_EQ("foobar", decodeToString("MZXW6YTBOI"));
+    EXPECT_EQ("foobar", decodeToString("mzxw6ytboi======"));
+}
+
+TEST(Base32, roundTrip)
+{
+    for (std::size_t size = 0; size < 100; size++) {
+        std::vector<uint8_t> data(size);
+        for (std::size_t i = 0; i < size; i++) {
+            data[i] = uint8_t(i * 37 + size);
+        }
+        for (bool pad : {true, false}) {
+            std::string encoded = base32Encode(data, pad);
+            ASSERT_EQ(base32EncodedSize(size, pad), encoded.size());
+            auto decoded = base32Decode(encoded);
+            ASSERT_TRUE(decoded.isOk());
+            EXPECT_EQ(data, std::vector<uint8_t>(decoded.unwrap().begin(), decoded.unwrap().end()));
+        }
+    }
+}
+
+TEST(Base32, invalid)
+{
+    EXPECT_EQ("<error>", decodeToString("M"));
+    EXPECT_EQ("<error>", decodeToString("MZX"));
+    EXPECT_EQ("<error>", decodeToString("MY====="));
+    EXPECT_EQ("<error>", decodeToString("MY======="));
+    EXPECT_EQ("<error>", decodeToString("MY1====="));
+    EXPECT_EQ("<error>", decodeToString("MY==A==="));
+    EXPECT_EQ("<error>", decodeToString("MZXW6YTB MZXW6YTB"));
+    // padding only groups and non zero trailing bits
+    EXPECT_EQ("<error>", decodeToString("========"));
+    EXPECT_EQ("<error>", decodeToString("MZXW6YTB========"));
+    EXPECT_EQ("<error>", decodeToString("MZ======"));
+    EXPECT_EQ("<error>", decodeToString("MZXR===="));
+    EXPECT_EQ("<error>", decodeToString("MZXW6YR="));
+    EXPECT_EQ("<error>", decodeToString("MZXW7"));
+}
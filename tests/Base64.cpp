@@ -0,0 +1,252 @@
+#include "bmcl/Base64.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/MemReader.h"
+#include "bmcl/MemWriter.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace bmcl;
+
+static std::vector<uint8_t> makeBytes(std::size_t size)
+{
+    std::vector<uint8_t> data(size);
+    uint32_t state = 0x12345678;
+    for (std::size_t i = 0; i < size; i++) {
+        state = state * 1103515245 + 12345;
+        data[i] = state >> 24;
+    }
+    return data;
+}
+
+static std::string referenceBase64(const std::vector<uint8_t>& data, const char* alphabet, bool pad)
+{
+    std::string result;
+    std::size_t i = 0;
+    for (; i + 3 <= data.size(); i += 3) {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        result.push_back(alphabet[(v >> 18) & 0x3f]);
+        result.push_back(alphabet[(v >> 12) & 0x3f]);
+        result.push_back(alphabet[(v >> 6) & 0x3f]);
+        result.push_back(alphabet[v & 0x3f]);
+    }
+    std::size_t left = data.size() - i;
+    if (left == 1) {
+        uint32_t v = data[i] << 16;
+        result.push_back(alphabet[(v >> 18) & 0x3f]);
+        result.push_back(alphabet[(v >> 12) & 0x3f]);
+        if (pad) {
+            result.append("==");
+        }
+    } else if (left == 2) {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8);
+        result.push_back(alphabet[(v >> 18) & 0x3f]);
+        result.push_back(alphabet[(v >> 12) & 0x3f]);
+        result.push_back(alphabet[(v >> 6) & 0x3f]);
+        if (pad) {
+            result.push_back('=');
+        }
+    }
+    return result;
+}
+
+static const char* standardAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char* urlAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+static std::string decodeToString(StringView src, Base64Alphabet alphabet = Base64Alphabet::Standard)
+{
+    auto rv = base64Decode(src, alphabet);
+    if (rv.isErr()) {
+        return "<error>";
+    }
+    return std::string((const char*)rv.unwrap().begin(), rv.unwrap().size());
+}
+
+TEST(Base64, rfcVectors)
+{
+    EXPECT_EQ("", base64Encode(StringView("").asBytes()));
+    EXPECT_EQ("Zg==", base64Encode(StringView("f").asBytes()));
+    EXPECT_EQ("Zm8=", base64Encode(StringView("fo").asBytes()));
+    EXPECT_EQ("Zm9v", base64Encode(StringView("foo").asBytes()));
+    EXPECT_EQ("Zm9vYg==", base64Encode(StringView("foob").asBytes()));
+    EXPECT_EQ("Zm9vYmE=", base64Encode(StringView("fooba").asBytes()));
+    EXPECT_EQ("Zm9vYmFy", base64Encode(StringView("foobar").asBytes()));
+
+    EXPECT_EQ("", decodeToString(""));
+    EXPECT_EQ("f", decodeToString("Zg=="));
+    EXPECT_EQ("fo", decodeToString("Zm8="));
+    EXPECT_EQ("foo", decodeToString("Zm9v"));
+    EXPECT_EQ("foob", decodeToString("Zm9vYg=="));
+    EXPECT_EQ("fooba", decodeToString("Zm9vYmE="));
+    EXPECT_EQ("foobar", decodeToString("Zm9vYmFy"));
+}
+
+TEST(Base64, unpadded)
+{
+    EXPECT_EQ("Zg", base64Encode(StringView("f").asBytes(), Base64Alphabet::Standard, false));
+    EXPECT_EQ("Zm8", base64Encode(StringView("fo").asBytes(), Base64Alphabet::Standard, false));
+    EXPECT_EQ("f", decodeToString("Zg"));
+    EXPECT_EQ("fo", decodeToString("Zm8"));
+    EXPECT_EQ(2u, base64EncodedSize(1, false));
+    EXPECT_EQ(4u, base64EncodedSize(1, true));
+}
+
+TEST(Base64, urlAlphabet)
+{
+    uint8_t data[] = {0xfb, 0xff, 0xbf};
+    EXPECT_EQ("+/+/", base64Encode(Bytes::fromStaticArray(data)));
+    EXPECT_EQ("-_-_", base64Encode(Bytes::fromStaticArray(data), Base64Alphabet::Url));
+    EXPECT_EQ("<error>", decodeToString("-_-_"));
+    EXPECT_EQ("<error>", decodeToString("+/+/", Base64Alphabet::Url));
+    EXPECT_EQ(std::string((const char*)data, 3), decodeToString("-_-_", Base64Alphabet::Url));
+}
+
+TEST(Base64, roundTrip)
+{
+    for (std::size_t size = 0; size < 300; size++) {
+        std::vector<uint8_t> data = makeBytes(size);
+        for (Base64Alphabet alphabet : {Base64Alphabet::Standard, Base64Alphabet::Url}) {
+            const char* chars = alphabet == Base64Alphabet::Standard ? standardAlphabet : urlAlphabet;
+            for (bool pad : {true, false}) {
+                std::string encoded = base64Encode(data, alphabet, pad);
+                ASSERT_EQ(referenceBase64(data, chars, pad), encoded);
+                ASSERT_EQ(base64EncodedSize(size, pad), encoded.size());
+                auto decoded = base64Decode(encoded, alphabet);
+                ASSERT_TRUE(decoded.isOk());
+                EXPECT_EQ(data, std::vector<uint8_t>(decoded.unwrap().begin(), decoded.unwrap().end()));
+            }
+        }
+    }
+}
+
+TEST(Base64, append)
+{
+    std::string str = "x";
+    appendBase64(StringView("foo").asBytes(), &str);
+    EXPECT_EQ("xZm9v", str);
+
+    Buffer buf;
+    appendBase64(StringView("f").asBytes(), &buf);
+    appendBase64(StringView("foo").asBytes(), &buf);
+    EXPECT_EQ("Zg==Zm9v", std::string((const char*)buf.begin(), buf.size()));
+    EXPECT_TRUE(appendBase64Decoded("Zm9v", &buf));
+    EXPECT_EQ("Zg==Zm9vfoo", std::string((const char*)buf.begin(), buf.size()));
+    EXPECT_FALSE(appendBase64Decoded("Zm9vY", &buf));
+
+    char dest[9] = {0};
+    MemWriter writer(dest, 8);
+    appendBase64(StringView("fo").asBytes(), &writer);
+    appendBase64(StringView("foo").asBytes(), &writer);
+    EXPECT_TRUE(writer.isFull());
+    EXPECT_STREQ("Zm8=Zm9v", dest);
+}
+
+TEST(Base64, invalid)
+{
+    EXPECT_EQ("<error>", decodeToString("Z"));
+    EXPECT_EQ("<error>", decodeToString("Z==="));
+    EXPECT_EQ("<error>", decodeToString("Zg==="));
+    EXPECT_EQ("<error>", decodeToString("Zg=a"));
+    EXPECT_EQ("<error>", decodeToString("=Zg="));
+    EXPECT_EQ("<error>", decodeToString("Zm9vYmFy Zm9v"));
+    EXPECT_EQ("<error>", decodeToString("Zm9vYmFy\n"));
+
+    std::string valid = base64Encode(makeBytes(96));
+    EXPECT_TRUE(base64Decode(valid).isOk());
+    for (std::size_t i = 0; i < valid.size(); i++) {
+        for (char c : {'*', '-', '_', '=', '\0', '\x80', '\xff'}) {
+            std::string bad = valid;
+            bad[i] = c;
+            EXPECT_TRUE(base64Decode(bad).isErr()) << i << ' ' << int(c);
+        }
+    }
+}
+
+TEST(Base64, nonCanonical)
+{
+    EXPECT_EQ("A", decodeToString("QQ=="));
+    EXPECT_EQ("AB", decodeToString("QUI="));
+    EXPECT_EQ("<error>", decodeToString("QR=="));
+    EXPECT_EQ("<error>", decodeToString("QUJ="));
+    EXPECT_EQ("<error>", decodeToString("QR"));
+    EXPECT_EQ("<error>", decodeToString("QUJ"));
+
+    Buffer dest;
+    Base64Decoder decoder;
+    EXPECT_TRUE(decoder.update("Zm9vQR==", &dest));
+    EXPECT_FALSE(decoder.finish(&dest));
+    decoder.reset();
+    dest.resize(0);
+    EXPECT_TRUE(decoder.update("Zm9vQUJ", &dest));
+    EXPECT_FALSE(decoder.finish(&dest));
+}
+
+TEST(Base64, streamingEncoder)
+{
+    std::vector<uint8_t> data = makeBytes(5000);
+    std::string expected = referenceBase64(data, standardAlphabet, true);
+    for (std::size_t step : {1, 2, 3, 5, 17, 100, 767, 768, 769, 4999}) {
+        Buffer dest;
+        Base64Encoder encoder;
+        for (std::size_t i = 0; i < data.size(); i += step) {
+            std::size_t size = std::min(step, data.size() - i);
+            encoder.update(Bytes(data.data() + i, size), &dest);
+        }
+        encoder.finish(&dest);
+        EXPECT_EQ(expected, std::string((const char*)dest.begin(), dest.size())) << step;
+    }
+
+    MemReader reader(data.data(), data.size());
+    Buffer dest;
+    Base64Encoder encoder(Base64Alphabet::Url, false);
+    encoder.update(&reader, &dest);
+    encoder.finish(&dest);
+    EXPECT_EQ(referenceBase64(data, urlAlphabet, false), std::string((const char*)dest.begin(), dest.size()));
+}
+
+TEST(Base64, streamingDecoder)
+{
+    std::vector<uint8_t> data = makeBytes(5001);
+    std::string encoded = referenceBase64(data, standardAlphabet, true);
+    for (std::size_t step : {1, 2, 3, 4, 5, 17, 100, 1023, 1024, 1025, 6667}) {
+        Buffer dest;
+        Base64Decoder decoder;
+        for (std::size_t i = 0; i < encoded.size(); i += step) {
+            std::size_t size = std::min(step, encoded.size() - i);
+            ASSERT_TRUE(decoder.update(StringView(encoded.data() + i, size), &dest));
+        }
+        ASSERT_TRUE(decoder.finish(&dest));
+        EXPECT_EQ(data, std::vector<uint8_t>(dest.begin(), dest.end())) << step;
+    }
+
+    MemReader reader((const uint8_t*)encoded.data(), encoded.size());
+    Buffer dest;
+    Base64Decoder decoder;
+    ASSERT_TRUE(decoder.update(&reader, &dest));
+    ASSERT_TRUE(decoder.finish(&dest));
+    EXPECT_EQ(data, std::vector<uint8_t>(dest.begin(), dest.end()));
+}
+
+TEST(Base64, streamingDecoderInvalid)
+{
+    Buffer dest;
+    Base64Decoder decoder;
+    EXPECT_TRUE(decoder.update("Zg", &dest));
+    EXPECT_TRUE(decoder.update("=", &dest));
+    EXPECT_FALSE(decoder.update("a", &dest));
+
+    decoder.reset();
+    dest.resize(0);
+    EXPECT_TRUE(decoder.update("Zm9vY", &dest));
+    EXPECT_FALSE(decoder.finish(&dest));
+
+    decoder.reset();
+    dest.resize(0);
+    EXPECT_TRUE(decoder.update("Zm9v", &dest));
+    EXPECT_FALSE(decoder.update("Y!ab", &dest));
+}
@@ -0,0 +1,176 @@
+#include "bmcl/BinaryLog.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/FileUtils.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace bmcl;
+
+static const char* testLogPath = "binarylog_test.blog";
+
+class BinaryLogTest : public ::testing::Test {
+protected:
+    void TearDown() override
+    {
+        stopBinaryLog();
+        std::remove(testLogPath);
+    }
+
+    std::vector<std::string> decodeLines()
+    {
+        stopBinaryLog();
+        Result<Buffer, int> data = readFileIntoBuffer(testLogPath);
+        EXPECT_TRUE(data.isOk());
+        std::string text;
+        EXPECT_TRUE(decodeBinaryLog(data.unwrap(), &text));
+        std::vector<std::string> lines;
+        if (text.empty()) {
+            return lines;
+        }
+        auto range = StringView(text).rtrim('\n').split('\n');
+        for (StringView line : range) {
+            // strip "YYYY-MM-DD HH:MM:SS.uuuuuu "
+            EXPECT_LT(27u, line.size());
+            lines.push_back(line.sliceFrom(27).toStdString());
+        }
+        return lines;
+    }
+};
+
+TEST_F(BinaryLogTest, disabled)
+{
+    EXPECT_FALSE(isBinaryLogEnabled());
+    int evaluated = 0;
+    BMCL_BINLOG(LogLevel::Info, "value {}", ++evaluated);
+    EXPECT_EQ(0, evaluated);
+}
+
+TEST_F(BinaryLogTest, arguments)
+{
+    ASSERT_TRUE(startBinaryLog(testLogPath));
+    EXPECT_TRUE(isBinaryLogEnabled());
+    std::string name = "device";
+    BMCL_BINLOG(LogLevel::Info, "packet {} from {} size {}", 12u, name, -1024);
+    BMCL_BINLOG(LogLevel::Warning, "no arguments");
+    BMCL_BINLOG(LogLevel::Debug, "{} {} {} {}", true, 'c', 1.5, StringView("view"));
+    BMCL_BINLOG(LogLevel::Critical, "missing {} {}", "one");
+    BMCL_BINLOG(LogLevel::Info, "extra", uint8_t(255), int64_t(-9000000000));
+
+    std::vector<std::string> lines = decodeLines();
+    ASSERT_EQ(5u, lines.size());
+    EXPECT_EQ("INFO:     packet 12 from device size -1024", lines[0]);
+    EXPECT_EQ("WARNING:  no arguments", lines[1]);
+    EXPECT_EQ("DEBUG:    true c 1.5 view", lines[2]);
+    EXPECT_EQ("CRITICAL: missing one {}", lines[3]);
+    EXPECT_EQ("INFO:     extra 255 -9000000000", lines[4]);
+}
+
+TEST_F(BinaryLogTest, formatWrittenOnce)
+{
+    ASSERT_TRUE(startBinaryLog(testLogPath));
+    for (int i = 0; i < 100; i++) {
+        BMCL_BINLOG(LogLevel::Info, "a long format string that is stored in the file only once {}", i);
+    }
+    stopBinaryLog();
+    Result<Buffer, int> data = readFileIntoBuffer(testLogPath);
+    ASSERT_TRUE(data.isOk());
+    EXPECT_GT(2000u, data.unwrap().size());
+
+    std::vector<std::string> lines = decodeLines();
+    ASSERT_EQ(100u, lines.size());
+    EXPECT_EQ("INFO:     a long format string that is stored in the file only once 99", lines[99]);
+}
+
+TEST_F(BinaryLogTest, levelFilter)
+{
+    ASSERT_TRUE(startBinaryLog(testLogPath));
+    setLogLevel(LogLevel::Info);
+    int evaluated = 0;
+    BMCL_BINLOG(LogLevel::Debug, "skipped {}", ++evaluated);
+    BMCL_BINLOG(LogLevel::Info, "written");
+    setLogLevel(LogLevel::Debug);
+    EXPECT_EQ(0, evaluated);
+
+    std::vector<std::string> lines = decodeLines();
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_EQ("INFO:     written", lines[0]);
+}
+
+TEST_F(BinaryLogTest, threads)
+{
+    ASSERT_TRUE(startBinaryLog(testLogPath, 4096, LogOverflowPolicy::Block));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < 1000; i++) {
+                BMCL_BINLOG(LogLevel::Info, "thread {} message {}", t, i);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    flushBinaryLog();
+    EXPECT_EQ(0u, droppedBinaryLogRecords());
+
+    std::vector<std::string> lines = decodeLines();
+    EXPECT_EQ(4000u, lines.size());
+}
+
+TEST_F(BinaryLogTest, oversizedRecordIsDropped)
+{
+    ASSERT_TRUE(startBinaryLog(testLogPath, 4096));
+    uint64_t dropped = droppedBinaryLogRecords();
+    BMCL_BINLOG(LogLevel::Info, "{}", std::string(3000, 'x'));
+    BMCL_BINLOG(LogLevel::Info, "small");
+    flushBinaryLog();
+    EXPECT_EQ(dropped + 1, droppedBinaryLogRecords());
+
+    std::vector<std::string> lines = decodeLines();
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_EQ("INFO:     small", lines[0]);
+}
+
+TEST_F(BinaryLogTest, malformed)
+{
+    std::string text;
+    EXPECT_FALSE(decodeBinaryLog(Bytes(), &text));
+    EXPECT_FALSE(decodeBinaryLog(StringView("NOTALOG\x01").asBytes(), &text));
+
+    ASSERT_TRUE(startBinaryLog(testLogPath));
+    BMCL_BINLOG(LogLevel::Info, "first {}", 1);
+    BMCL_BINLOG(LogLevel::Info, "second {}", 2);
+    stopBinaryLog();
+    Result<Buffer, int> data = readFileIntoBuffer(testLogPath);
+    ASSERT_TRUE(data.isOk());
+    Bytes truncated(data.unwrap().data(), data.unwrap().size() - 1);
+    EXPECT_FALSE(decodeBinaryLog(truncated, &text));
+    EXPECT_NE(std::string::npos, text.find("first 1"));
+    EXPECT_EQ(std::string::npos, text.find("second"));
+}
+
+TEST_F(BinaryLogTest, hugeFormatId)
+{
+    Buffer data;
+    data.write("BMCLBLOG", 8);
+    data.writeUint8(1);
+    data.writeUint8(0);
+    data.writeVarUint(UINT64_C(0x7fffffffffffffff));
+    data.writeUint8((uint8_t)LogLevel::Info);
+    data.writeVarUint(1);
+    data.writeVarUint(1);
+    data.write("f", 1);
+    data.writeVarUint(1);
+    data.write("x", 1);
+    std::string text;
+    EXPECT_FALSE(decodeBinaryLog(data, &text));
+}
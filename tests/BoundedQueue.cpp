@@ -0,0 +1,278 @@
+#include "bmcl/BoundedQueue.h"
+#include "bmcl/SharedBytes.h"
+
+#include "BmclTest.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace bmcl;
+
+template <typename Q>
+class BoundedQueueTest : public ::testing::Test {
+};
+
+typedef ::testing::Types<MpmcQueue<std::string>, SpscQueue<std::string>> QueueTypes;
+TYPED_TEST_CASE(BoundedQueueTest, QueueTypes);
+
+TYPED_TEST(BoundedQueueTest, capacity)
+{
+    TypeParam q1(1);
+    EXPECT_EQ(2u, q1.capacity());
+    TypeParam q5(5);
+    EXPECT_EQ(8u, q5.capacity());
+    TypeParam q8(8);
+    EXPECT_EQ(8u, q8.capacity());
+}
+
+TYPED_TEST(BoundedQueueTest, push_pop)
+{
+    TypeParam q(4);
+    std::string value;
+    EXPECT_FALSE(q.tryPop(&value));
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 4; i++) {
+            EXPECT_TRUE(q.tryPush(std::to_string(lap * 10 + i)));
+        }
+        std::string extra = "extra";
+        EXPECT_FALSE(q.tryPush(std::move(extra)));
+        EXPECT_EQ("extra", extra);
+        EXPECT_EQ(4u, q.sizeApprox());
+        for (int i = 0; i < 4; i++) {
+            ASSERT_TRUE(q.tryPop(&value));
+            EXPECT_EQ(std::to_string(lap * 10 + i), value);
+        }
+        EXPECT_FALSE(q.tryPop(&value));
+        EXPECT_EQ(0u, q.sizeApprox());
+    }
+}
+
+TYPED_TEST(BoundedQueueTest, push_pop_many)
+{
+    TypeParam q(8);
+    std::vector<std::string> items;
+    for (int i = 0; i < 12; i++) {
+        items.push_back(std::to_string(i));
+    }
+    EXPECT_EQ(0u, q.tryPushMany(items.data(), 0));
+    EXPECT_EQ(3u, q.tryPushMany(items.data(), 3));
+    EXPECT_EQ(5u, q.tryPushMany(items.data() + 3, 9));
+    EXPECT_EQ(0u, q.tryPushMany(items.data() + 8, 4));
+
+    std::string dest[16];
+    EXPECT_EQ(0u, q.tryPopMany(dest, 0));
+    EXPECT_EQ(6u, q.tryPopMany(dest, 6));
+    // wraps around the end of the ring
+    EXPECT_EQ(4u, q.tryPushMany(items.data() + 8, 4));
+    EXPECT_EQ(6u, q.tryPopMany(dest + 6, 10));
+    EXPECT_EQ(0u, q.tryPopMany(dest, 10));
+    for (int i = 0; i < 12; i++) {
+        EXPECT_EQ(std::to_string(i), dest[i]);
+    }
+}
+
+struct Counted {
+    Counted()
+    {
+        alive++;
+    }
+
+    Counted(const Counted&)
+    {
+        alive++;
+    }
+
+    ~Counted()
+    {
+        alive--;
+    }
+
+    Counted& operator=(const Counted&) = default;
+
+    static int alive;
+};
+
+int Counted::alive = 0;
+
+TEST(BoundedQueue, destroys_remaining)
+{
+    {
+        MpmcQueue<Counted> mpmc(4);
+        SpscQueue<Counted> spsc(4);
+        Counted value;
+        for (int i = 0; i < 3; i++) {
+            mpmc.push(value);
+            spsc.push(value);
+        }
+        mpmc.pop(&value);
+        spsc.pop(&value);
+        EXPECT_EQ(5, Counted::alive);
+    }
+    EXPECT_EQ(0, Counted::alive);
+}
+
+TEST(BoundedQueue, shared_bytes)
+{
+    SpscQueue<SharedBytes> q(4);
+    SharedBytes bytes = SharedBytes::create((const uint8_t*)"abc", 3);
+    EXPECT_TRUE(q.push(std::move(bytes)));
+    SharedBytes dest;
+    EXPECT_TRUE(q.pop(&dest));
+    ASSERT_EQ(3u, dest.size());
+    EXPECT_EQ('b', dest.data()[1]);
+}
+
+TYPED_TEST(BoundedQueueTest, close)
+{
+    TypeParam q(4);
+    std::string value;
+    std::thread consumer([&q]() {
+        std::string v;
+        EXPECT_TRUE(q.pop(&v));
+        EXPECT_EQ("a", v);
+        // blocks until close()
+        EXPECT_FALSE(q.pop(&v));
+    });
+    EXPECT_TRUE(q.push(std::string("a")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    q.close();
+    consumer.join();
+    EXPECT_TRUE(q.isClosed());
+    EXPECT_FALSE(q.push(std::string("b")));
+}
+
+TYPED_TEST(BoundedQueueTest, close_keeps_values)
+{
+    TypeParam q(4);
+    q.push(std::string("a"));
+    q.push(std::string("b"));
+    q.close();
+    std::string dest[4];
+    EXPECT_EQ(2u, q.popMany(dest, 4));
+    EXPECT_EQ(0u, q.popMany(dest, 4));
+    EXPECT_FALSE(q.pop(dest));
+}
+
+TYPED_TEST(BoundedQueueTest, blocking_single_producer)
+{
+    const std::size_t count = 100000;
+    TypeParam q(16);
+    std::thread producer([&q]() {
+        for (std::size_t i = 0; i < count; i++) {
+            q.push(std::to_string(i));
+        }
+        q.close();
+    });
+    std::size_t expected = 0;
+    std::string dest[7];
+    while (std::size_t n = q.popMany(dest, 7)) {
+        for (std::size_t i = 0; i < n; i++) {
+            ASSERT_EQ(std::to_string(expected), dest[i]);
+            expected++;
+        }
+    }
+    producer.join();
+    EXPECT_EQ(count, expected);
+}
+
+static void runMpmc(std::size_t producerCount, std::size_t consumerCount, std::size_t batch)
+{
+    const std::size_t perProducer = 50000;
+    MpmcQueue<uint64_t> q(64);
+    std::atomic<uint64_t> sum(0);
+    std::atomic<std::size_t> popped(0);
+    std::atomic<std::size_t> producersLeft(producerCount);
+    std::vector<std::thread> threads;
+    for (std::size_t p = 0; p < producerCount; p++) {
+        threads.emplace_back([&, p]() {
+            std::vector<uint64_t> items(batch);
+            for (std::size_t i = 0; i < perProducer; i += batch) {
+                for (std::size_t j = 0; j < batch; j++) {
+                    items[j] = p * perProducer + i + j;
+                }
+                EXPECT_EQ(batch, q.pushMany(items.data(), batch));
+            }
+            if (producersLeft.fetch_sub(1) == 1) {
+                q.close();
+            }
+        });
+    }
+    for (std::size_t c = 0; c < consumerCount; c++) {
+        threads.emplace_back([&]() {
+            std::vector<uint64_t> dest(batch);
+            // values of each producer arrive in order
+            std::vector<uint64_t> last(producerCount, 0);
+            std::vector<bool> seen(producerCount, false);
+            while (std::size_t n = q.popMany(dest.data(), batch)) {
+                for (std::size_t i = 0; i < n; i++) {
+                    std::size_t p = dest[i] / perProducer;
+                    EXPECT_TRUE(!seen[p] || dest[i] > last[p]);
+                    seen[p] = true;
+                    last[p] = dest[i];
+                    sum.fetch_add(dest[i], std::memory_order_relaxed);
+                }
+                popped.fetch_add(n);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::size_t total = producerCount * perProducer;
+    EXPECT_EQ(total, popped.load());
+    EXPECT_EQ(uint64_t(total) * (total - 1) / 2, sum.load());
+}
+
+TEST(MpmcQueue, many_producers_many_consumers)
+{
+    runMpmc(4, 4, 1);
+}
+
+TEST(MpmcQueue, many_producers_many_consumers_batched)
+{
+    runMpmc(4, 3, 10);
+}
+
+TEST(MpmcQueue, mixed_single_and_batch)
+{
+    const std::size_t count = 100000;
+    MpmcQueue<uint64_t> q(8);
+    std::atomic<uint64_t> sum(0);
+    std::thread batchProducer([&]() {
+        uint64_t items[4];
+        for (std::size_t i = 0; i < count; i += 4) {
+            for (std::size_t j = 0; j < 4; j++) {
+                items[j] = 1;
+            }
+            q.pushMany(items, 4);
+        }
+    });
+    std::thread singleProducer([&]() {
+        for (std::size_t i = 0; i < count; i++) {
+            q.push(2);
+        }
+    });
+    std::thread batchConsumer([&]() {
+        uint64_t dest[5];
+        while (std::size_t n = q.popMany(dest, 5)) {
+            for (std::size_t i = 0; i < n; i++) {
+                sum.fetch_add(dest[i]);
+            }
+        }
+    });
+    std::thread singleConsumer([&]() {
+        uint64_t value;
+        while (q.pop(&value)) {
+            sum.fetch_add(value);
+        }
+    });
+    batchProducer.join();
+    singleProducer.join();
+    // consumers drain the rest before pops fail
+    q.close();
+    batchConsumer.join();
+    singleConsumer.join();
+    EXPECT_EQ(count * 3, sum.load());
+}
@@ -0,0 +1,259 @@
+#include "bmcl/EventLoop.h"
+
+#if defined(BMCL_PLATFORM_LINUX)
+
+#include "bmcl/RingBuffer.h"
+
+#include "BmclTest.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace bmcl;
+
+class EventLoopTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        ASSERT_EQ(0, ::socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, _fds));
+    }
+
+    void TearDown() override
+    {
+        closeFd(0);
+        closeFd(1);
+    }
+
+    void closeFd(int index)
+    {
+        if (_fds[index] != -1) {
+            ::close(_fds[index]);
+            _fds[index] = -1;
+        }
+    }
+
+    void send(const void* data, std::size_t size)
+    {
+        ASSERT_EQ(ssize_t(size), ::write(_fds[1], data, size));
+    }
+
+    std::vector<uint8_t> receive()
+    {
+        std::vector<uint8_t> data(4096);
+        ssize_t rv = ::read(_fds[1], data.data(), data.size());
+        data.resize(rv > 0 ? rv : 0);
+        return data;
+    }
+
+    static EventLoop::Clock::duration ms(int count)
+    {
+        return std::chrono::milliseconds(count);
+    }
+
+    EventLoop _loop;
+    int _fds[2];
+};
+
+TEST_F(EventLoopTest, io_callback)
+{
+    ASSERT_TRUE(_loop.isValid());
+    unsigned events = 0;
+    ASSERT_TRUE(_loop.add(_fds[0], EventLoop::Readable, [&](unsigned e) { events |= e; }));
+    EXPECT_TRUE(_loop.contains(_fds[0]));
+    EXPECT_FALSE(_loop.add(_fds[0], EventLoop::Readable, [](unsigned) {}));
+
+    EXPECT_EQ(0u, _loop.runOnce(ms(0)));
+    send("a", 1);
+    EXPECT_EQ(1u, _loop.runOnce(ms(1000)));
+    EXPECT_TRUE(events & EventLoop::Readable);
+
+    EXPECT_TRUE(_loop.remove(_fds[0]));
+    EXPECT_FALSE(_loop.contains(_fds[0]));
+    EXPECT_FALSE(_loop.remove(_fds[0]));
+    send("b", 1);
+    EXPECT_EQ(0u, _loop.runOnce(ms(0)));
+}
+
+TEST_F(EventLoopTest, stream_input_wraps)
+{
+    uint8_t storage[8];
+    RingBuffer input(storage, sizeof(storage));
+    std::vector<uint8_t> received;
+    auto onInput = [&](RingBuffer* buf) {
+        // leaves one byte in the buffer to make the next read wrap
+        while (buf->usedSpace() > 1) {
+            received.push_back(buf->readUint8());
+        }
+    };
+    ASSERT_TRUE(_loop.addStream(_fds[0], &input, nullptr, onInput, [](int) {}));
+
+    send("abcde", 5);
+    _loop.runOnce(ms(1000));
+    EXPECT_EQ(std::vector<uint8_t>({'a', 'b', 'c', 'd'}), received);
+    send("fghij", 5);
+    _loop.runOnce(ms(1000));
+    EXPECT_EQ(std::vector<uint8_t>({'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i'}), received);
+    EXPECT_EQ(1u, input.usedSpace());
+}
+
+TEST_F(EventLoopTest, stream_pauses_when_full)
+{
+    uint8_t storage[4];
+    RingBuffer input(storage, sizeof(storage));
+    std::size_t calls = 0;
+    ASSERT_TRUE(_loop.addStream(_fds[0], &input, nullptr, [&](RingBuffer*) { calls++; }, [](int) {}));
+
+    send("0123456789", 10);
+    _loop.runOnce(ms(1000));
+    EXPECT_EQ(1u, calls);
+    EXPECT_TRUE(input.isFull());
+    // no new edge, the loop doesn't read until resumeRead()
+    EXPECT_EQ(0u, _loop.runOnce(ms(10)));
+
+    char data[4];
+    input.read(data, 4);
+    EXPECT_EQ(0, std::memcmp(data, "0123", 4));
+    _loop.resumeRead(_fds[0]);
+    EXPECT_EQ(2u, calls);
+    input.read(data, 4);
+    EXPECT_EQ(0, std::memcmp(data, "4567", 4));
+    _loop.resumeRead(_fds[0]);
+    EXPECT_EQ(3u, calls);
+    ASSERT_EQ(2u, input.usedSpace());
+    input.read(data, 2);
+    EXPECT_EQ(0, std::memcmp(data, "89", 2));
+}
+
+TEST_F(EventLoopTest, stream_output)
+{
+    uint8_t storage[8];
+    RingBuffer output(storage, sizeof(storage));
+    ASSERT_TRUE(_loop.addStream(_fds[0], nullptr, &output, nullptr, [](int) {}));
+
+    output.write("abcdef", 6);
+    output.erase(4);
+    // wraps around the end of storage
+    output.write("ghijkl", 6);
+    _loop.flush(_fds[0]);
+    EXPECT_TRUE(output.isEmpty());
+    std::vector<uint8_t> data = receive();
+    EXPECT_EQ(std::vector<uint8_t>({'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l'}), data);
+}
+
+TEST_F(EventLoopTest, stream_output_waits_for_writable)
+{
+    int size = 4096;
+    ::setsockopt(_fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    std::vector<uint8_t> storage(1 << 20);
+    RingBuffer output(storage.data(), storage.size());
+    ASSERT_TRUE(_loop.addStream(_fds[0], nullptr, &output, nullptr, [](int) {}));
+
+    std::vector<uint8_t> data(storage.size());
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = uint8_t(i * 7);
+    }
+    output.write(data.data(), data.size());
+    _loop.flush(_fds[0]);
+    EXPECT_FALSE(output.isEmpty());
+
+    std::vector<uint8_t> received;
+    while (received.size() < data.size()) {
+        std::vector<uint8_t> chunk = receive();
+        received.insert(received.end(), chunk.begin(), chunk.end());
+        _loop.runOnce(ms(chunk.empty() ? 10 : 0));
+    }
+    EXPECT_TRUE(output.isEmpty());
+    EXPECT_EQ(data, received);
+}
+
+TEST_F(EventLoopTest, stream_close)
+{
+    uint8_t storage[16];
+    RingBuffer input(storage, sizeof(storage));
+    int closeError = -1;
+    std::size_t received = 0;
+    auto onInput = [&](RingBuffer* buf) {
+        received += buf->usedSpace();
+        buf->clear();
+    };
+    ASSERT_TRUE(_loop.addStream(_fds[0], &input, nullptr, onInput, [&](int error) { closeError = error; }));
+
+    send("abc", 3);
+    closeFd(1);
+    _loop.runOnce(ms(1000));
+    EXPECT_EQ(3u, received);
+    EXPECT_EQ(0, closeError);
+    EXPECT_FALSE(_loop.contains(_fds[0]));
+}
+
+TEST_F(EventLoopTest, remove_in_callback)
+{
+    uint8_t storage[16];
+    RingBuffer input(storage, sizeof(storage));
+    std::size_t calls = 0;
+    auto onInput = [&](RingBuffer*) {
+        calls++;
+        _loop.remove(_fds[0]);
+    };
+    ASSERT_TRUE(_loop.addStream(_fds[0], &input, nullptr, onInput, [](int) {}));
+
+    send("abc", 3);
+    _loop.runOnce(ms(1000));
+    send("def", 3);
+    _loop.runOnce(ms(10));
+    EXPECT_EQ(1u, calls);
+    EXPECT_EQ(3u, input.usedSpace());
+}
+
+TEST_F(EventLoopTest, timers)
+{
+    std::vector<int> fired;
+    _loop.addTimer(ms(20), [&]() { fired.push_back(2); });
+    _loop.addTimer(ms(5), [&]() { fired.push_back(1); });
+    EventLoop::TimerId canceled = _loop.addTimer(ms(10), [&]() { fired.push_back(3); });
+    EXPECT_TRUE(_loop.cancelTimer(canceled));
+    EXPECT_FALSE(_loop.cancelTimer(canceled));
+
+    auto start = EventLoop::Clock::now();
+    while (fired.size() < 2) {
+        _loop.runOnce(ms(1000));
+    }
+    EXPECT_GE(EventLoop::Clock::now() - start, ms(20));
+    EXPECT_EQ(std::vector<int>({1, 2}), fired);
+    EXPECT_EQ(0u, _loop.runOnce(ms(30)));
+}
+
+TEST_F(EventLoopTest, interval_timer)
+{
+    std::size_t count = 0;
+    EventLoop::TimerId id = 0;
+    id = _loop.addTimer(ms(1), [&]() {
+        count++;
+        if (count == 3) {
+            _loop.cancelTimer(id);
+        }
+    }, ms(2));
+    while (count < 3) {
+        _loop.runOnce(ms(1000));
+    }
+    EXPECT_EQ(0u, _loop.runOnce(ms(20)));
+    EXPECT_EQ(3u, count);
+}
+
+TEST_F(EventLoopTest, stop_from_other_thread)
+{
+    std::thread thread([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        _loop.stop();
+    });
+    _loop.run();
+    thread.join();
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include "bmcl/FileLogSink.h"
+#include "bmcl/FileUtils.h"
+#include "bmcl/Logging.h"
+#include "bmcl/Panic.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+using namespace bmcl;
+
+static const char* testLogPath = "filelogsink_test.log";
+
+static std::string readLog(const std::string& path)
+{
+    Result<std::string, int> data = readFileIntoString(path.c_str());
+    if (data.isErr()) {
+        return std::string();
+    }
+    return data.unwrap();
+}
+
+static bool fileExists(const std::string& path)
+{
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (file) {
+        std::fclose(file);
+    }
+    return file != nullptr;
+}
+
+class FileLogSinkTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        removeFiles();
+    }
+
+    void TearDown() override
+    {
+        setDefaulLogHandler();
+        removeFiles();
+    }
+
+    void removeFiles()
+    {
+        std::remove(testLogPath);
+        for (int i = 1; i < 5; i++) {
+            std::remove((std::string(testLogPath) + '.' + std::to_string(i)).c_str());
+        }
+    }
+};
+
+TEST_F(FileLogSinkTest, buffered)
+{
+    FileLogSinkConfig config(testLogPath);
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    sink.unwrap()->write(LogLevel::Info, "first");
+    sink.unwrap()->write(LogLevel::Warning, "second");
+    EXPECT_EQ("", readLog(testLogPath));
+
+    sink.unwrap()->flush();
+    std::string text = readLog(testLogPath);
+    EXPECT_EQ(text.size(), sink.unwrap()->fileSize());
+    ASSERT_EQ(2 * 20 + 10 + 6 + 10 + 7, text.size());
+    EXPECT_EQ("INFO:     first\n", text.substr(20, 16));
+    EXPECT_EQ("WARNING:  second\n", text.substr(56));
+}
+
+TEST_F(FileLogSinkTest, flushLevel)
+{
+    FileLogSinkConfig config(testLogPath);
+    config.flushLevel = LogLevel::Warning;
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    sink.unwrap()->write(LogLevel::Info, "buffered");
+    EXPECT_EQ("", readLog(testLogPath));
+    sink.unwrap()->write(LogLevel::Warning, "flushed");
+    EXPECT_NE(std::string::npos, readLog(testLogPath).find("buffered\n"));
+    EXPECT_NE(std::string::npos, readLog(testLogPath).find("flushed\n"));
+}
+
+TEST_F(FileLogSinkTest, appendsAndFlushesOnDestruction)
+{
+    {
+        auto sink = FileLogSink::open(FileLogSinkConfig(testLogPath));
+        ASSERT_TRUE(sink.isOk());
+        sink.unwrap()->write(LogLevel::Info, "one");
+    }
+    {
+        auto sink = FileLogSink::open(FileLogSinkConfig(testLogPath));
+        ASSERT_TRUE(sink.isOk());
+        EXPECT_EQ(34u, sink.unwrap()->fileSize());
+        sink.unwrap()->write(LogLevel::Info, "two");
+    }
+    std::string text = readLog(testLogPath);
+    EXPECT_EQ(68u, text.size());
+    EXPECT_TRUE(StringView(text).endsWith("INFO:     two\n"));
+}
+
+TEST_F(FileLogSinkTest, rotateBySize)
+{
+    FileLogSinkConfig config(testLogPath);
+    config.maxFileSize = 100;
+    config.maxRotatedFiles = 2;
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    // 3 lines of 40 bytes per file
+    for (int i = 0; i < 10; i++) {
+        sink.unwrap()->write(LogLevel::Info, ("message " + std::to_string(i)).c_str());
+    }
+    sink.unwrap()->flush();
+
+    std::string current = readLog(testLogPath);
+    std::string first = readLog(std::string(testLogPath) + ".1");
+    std::string second = readLog(std::string(testLogPath) + ".2");
+    EXPECT_FALSE(fileExists(std::string(testLogPath) + ".3"));
+    EXPECT_EQ(40u, current.size());
+    EXPECT_NE(std::string::npos, current.find("message 9\n"));
+    EXPECT_EQ(120u, first.size());
+    EXPECT_NE(std::string::npos, first.find("message 6\n"));
+    EXPECT_NE(std::string::npos, first.find("message 8\n"));
+    EXPECT_EQ(120u, second.size());
+    EXPECT_NE(std::string::npos, second.find("message 3\n"));
+}
+
+TEST_F(FileLogSinkTest, syncedWhenIdle)
+{
+    FileLogSinkConfig config(testLogPath);
+    config.syncInterval = std::chrono::milliseconds(20);
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    sink.unwrap()->write(LogLevel::Info, "idle");
+    for (int i = 0; i < 100 && readLog(testLogPath).empty(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(StringView(readLog(testLogPath)).endsWith("INFO:     idle\n"));
+}
+
+TEST_F(FileLogSinkTest, rotatedByAgeWhenIdle)
+{
+    FileLogSinkConfig config(testLogPath);
+    config.maxFileAge = std::chrono::seconds(1);
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    sink.unwrap()->write(LogLevel::Info, "aged");
+    std::string rotated = std::string(testLogPath) + ".1";
+    for (int i = 0; i < 300 && !fileExists(rotated); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(StringView(readLog(rotated)).endsWith("INFO:     aged\n"));
+    EXPECT_EQ(0u, sink.unwrap()->fileSize());
+}
+
+TEST_F(FileLogSinkTest, largeMessageBypassesBuffer)
+{
+    FileLogSinkConfig config(testLogPath);
+    config.bufferSize = 4096;
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    sink.unwrap()->write(LogLevel::Info, "small");
+    std::string large(10000, 'x');
+    sink.unwrap()->write(LogLevel::Info, large.c_str());
+    std::string text = readLog(testLogPath);
+    EXPECT_EQ(36u + 31u + large.size(), text.size());
+    EXPECT_NE(std::string::npos, text.find("small\n"));
+}
+
+TEST_F(FileLogSinkTest, logHandler)
+{
+    auto sink = setFileLogHandler(FileLogSinkConfig(testLogPath));
+    ASSERT_TRUE(sink.isOk());
+    BMCL_INFO() << "through " << "handler " << 42;
+    setLogLevel(LogLevel::Info);
+    BMCL_DEBUG() << "filtered";
+    log(LogLevel::Debug, "filtered");
+    setLogLevel(LogLevel::Debug);
+    flushFileLogSinks();
+    std::string text = readLog(testLogPath);
+    EXPECT_TRUE(StringView(text).endsWith("INFO:     through handler 42\n"));
+    EXPECT_EQ(std::string::npos, text.find("filtered"));
+}
+
+#if GTEST_HAS_DEATH_TEST && !BMCL_ASAN
+
+TEST_F(FileLogSinkTest, asyncLinesWrittenOnPanic)
+{
+    FileLogSinkConfig config(testLogPath);
+    config.flushLevel = LogLevel::None;
+    auto sink = FileLogSink::open(config);
+    ASSERT_TRUE(sink.isOk());
+    LogHandler handler = sink.unwrap()->handler();
+    ASSERT_DEATH(
+        {
+            setLogHandler(handler);
+            enableAsyncLogging();
+            log(LogLevel::Info, "queued before panic");
+            panic("sink panic\n");
+        },
+        "sink panic");
+    std::string text = readLog(testLogPath);
+    EXPECT_TRUE(StringView(text).endsWith("INFO:     queued before panic\n"));
+}
+
+#endif
+
+TEST_F(FileLogSinkTest, openError)
+{
+    auto sink = FileLogSink::open(FileLogSinkConfig("nonexistent_dir/file.log"));
+    ASSERT_TRUE(sink.isErr());
+    EXPECT_NE(0, sink.unwrapErr());
+}
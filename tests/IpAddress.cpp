@@ -0,0 +1,225 @@
+#include "bmcl/IpAddress.h"
+#include "bmcl/IpAddressHash.h"
+#include "bmcl/MemWriter.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <string>
+#include <unordered_set>
+
+#if defined(BMCL_PLATFORM_UNIX) || defined(BMCL_PLATFORM_APPLE)
+# include <arpa/inet.h>
+#endif
+
+using namespace bmcl;
+
+TEST(IpAddress, v4Values)
+{
+    Ipv4Address a(192, 168, 1, 20);
+    EXPECT_EQ(0xc0a80114u, a.toUint32());
+    std::array<uint8_t, 4> expected = {192, 168, 1, 20};
+    EXPECT_EQ(expected, a.toArray());
+    EXPECT_EQ(a, Ipv4Address(0xc0a80114u));
+    EXPECT_EQ(a, Ipv4Address(expected));
+    EXPECT_TRUE(Ipv4Address(10, 0, 0, 1) < Ipv4Address(10, 0, 1, 0));
+}
+
+TEST(IpAddress, v4Parse)
+{
+    auto rv = Ipv4Address::fromString("10.20.30.255");
+    ASSERT_TRUE(rv.isOk());
+    EXPECT_EQ(Ipv4Address(10, 20, 30, 255), rv.unwrap());
+    EXPECT_TRUE(Ipv4Address::fromString("0.0.0.0").isOk());
+
+    const char* invalid[] = {"", "1.2.3", "1.2.3.4.5", "256.1.1.1", "01.2.3.4", "1..2.3", "1.2.3.4 ", " 1.2.3.4",
+                             "1.2.3.", ".1.2.3", "a.b.c.d", "1.2.3.4444"};
+    for (const char* str : invalid) {
+        EXPECT_TRUE(Ipv4Address::fromString(str).isErr()) << str;
+    }
+}
+
+TEST(IpAddress, v4Format)
+{
+    EXPECT_EQ("0.0.0.0", Ipv4Address().toStdString());
+    EXPECT_EQ("255.255.255.255", Ipv4Address(255, 255, 255, 255).toStdString());
+    EXPECT_EQ("1.20.100.9", Ipv4Address(1, 20, 100, 9).toStdString());
+
+    uint8_t buf[64];
+    MemWriter writer(buf, sizeof(buf));
+    Ipv4Address(127, 0, 0, 1).format(&writer);
+    EXPECT_EQ("127.0.0.1", std::string((const char*)buf, writer.sizeUsed()));
+}
+
+static Ipv6Address v6(const char* str)
+{
+    auto rv = Ipv6Address::fromString(str);
+    EXPECT_TRUE(rv.isOk()) << str;
+    return rv.unwrapOr(Ipv6Address());
+}
+
+TEST(IpAddress, v6Parse)
+{
+    EXPECT_EQ(Ipv6Address(0x2001, 0xdb8, 0, 0, 0, 0, 0, 1), v6("2001:db8::1"));
+    EXPECT_EQ(Ipv6Address(0x2001, 0xdb8, 0, 0, 0, 0, 0, 1), v6("2001:0DB8:0:0:0:0:0:0001"));
+    EXPECT_EQ(Ipv6Address(), v6("::"));
+    EXPECT_EQ(Ipv6Address(0, 0, 0, 0, 0, 0, 0, 1), v6("::1"));
+    EXPECT_EQ(Ipv6Address(1, 0, 0, 0, 0, 0, 0, 0), v6("1::"));
+    EXPECT_EQ(Ipv6Address(1, 2, 3, 4, 5, 6, 7, 0), v6("1:2:3:4:5:6:7::"));
+    EXPECT_EQ(Ipv6Address(0, 2, 3, 4, 5, 6, 7, 8), v6("::2:3:4:5:6:7:8"));
+    EXPECT_EQ(Ipv6Address::fromV4Mapped(Ipv4Address(1, 2, 3, 4)), v6("::ffff:1.2.3.4"));
+    EXPECT_EQ(Ipv6Address(0x64, 0xff9b, 0, 0, 0, 0, 0xc000, 0x0221), v6("64:ff9b::192.0.2.33"));
+    EXPECT_EQ(Ipv6Address(1, 2, 3, 4, 5, 6, 0x102, 0x304), v6("1:2:3:4:5:6:1.2.3.4"));
+
+    const char* invalid[] = {"", ":", ":::", "1:2:3:4:5:6:7", "1:2:3:4:5:6:7:8:9", "1::2::3", "12345::", ":1::",
+                             "1::2:", "1:2:3:4:5:6:7:8::", "::1:2:3:4:5:6:7:8", "g::", "::1.2.3", "::1.2.3.4:5",
+                             "1:2:3:4:5:6:7:1.2.3.4", "[::1]", "::01.2.3.4", "1.2.3.4"};
+    for (const char* str : invalid) {
+        EXPECT_TRUE(Ipv6Address::fromString(str).isErr()) << str;
+    }
+}
+
+TEST(IpAddress, v6Format)
+{
+    // RFC 5952 section 4
+    EXPECT_EQ("2001:db8::1", Ipv6Address(0x2001, 0xdb8, 0, 0, 0, 0, 0, 1).toStdString());
+    EXPECT_EQ("2001:db8:0:1:1:1:1:1", Ipv6Address(0x2001, 0xdb8, 0, 1, 1, 1, 1, 1).toStdString());
+    EXPECT_EQ("2001:0:0:1::1", Ipv6Address(0x2001, 0, 0, 1, 0, 0, 0, 1).toStdString());
+    EXPECT_EQ("2001:db8::1:0:0:1", Ipv6Address(0x2001, 0xdb8, 0, 0, 1, 0, 0, 1).toStdString());
+    EXPECT_EQ("::", Ipv6Address().toStdString());
+    EXPECT_EQ("::1", Ipv6Address(0, 0, 0, 0, 0, 0, 0, 1).toStdString());
+    EXPECT_EQ("1::", Ipv6Address(1, 0, 0, 0, 0, 0, 0, 0).toStdString());
+    EXPECT_EQ("::ffff:10.0.0.1", Ipv6Address::fromV4Mapped(Ipv4Address(10, 0, 0, 1)).toStdString());
+    EXPECT_EQ("ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff",
+              Ipv6Address(0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff, 0xffff).toStdString());
+
+    uint8_t buf[64];
+    MemWriter writer(buf, sizeof(buf));
+    Ipv6Address(0xfe80, 0, 0, 0, 0xabc, 0, 0, 0).format(&writer);
+    EXPECT_EQ("fe80::abc:0:0:0", std::string((const char*)buf, writer.sizeUsed()));
+}
+
+TEST(IpAddress, v6Properties)
+{
+    EXPECT_TRUE(v6("::1").isLoopback());
+    EXPECT_TRUE(v6("::").isUnspecified());
+    EXPECT_FALSE(v6("::1").isUnspecified());
+    Ipv6Address mapped = v6("::ffff:192.168.0.1");
+    EXPECT_TRUE(mapped.isV4Mapped());
+    EXPECT_EQ(Ipv4Address(192, 168, 0, 1), mapped.toV4());
+    EXPECT_EQ(0xffffu, mapped.group(5));
+}
+
+#if defined(BMCL_PLATFORM_UNIX) || defined(BMCL_PLATFORM_APPLE)
+// compares with the system implementation over addresses built from interesting groups
+TEST(IpAddress, v6MatchesInet)
+{
+    const uint16_t groups[] = {0, 1, 0xffff, 0xabc};
+    char expected[INET6_ADDRSTRLEN];
+    for (unsigned i = 0; i < (1u << 16); i += 7) {
+        Ipv6Address::Data data;
+        for (unsigned j = 0; j < 8; j++) {
+            uint16_t group = groups[(i >> (j * 2)) & 3];
+            data[j * 2] = uint8_t(group >> 8);
+            data[j * 2 + 1] = uint8_t(group);
+        }
+        Ipv6Address address(data);
+        ASSERT_NE(nullptr, inet_ntop(AF_INET6, data.data(), expected, sizeof(expected)));
+        std::string str = address.toStdString();
+        if (!address.isV4Mapped()) {
+            // glibc also uses dotted form for deprecated v4 compatible addresses
+            if (std::string(expected).find('.') == std::string::npos) {
+                EXPECT_EQ(std::string(expected), str);
+            }
+        }
+        EXPECT_EQ(address, v6(str.c_str()));
+        EXPECT_EQ(address, v6(expected));
+    }
+}
+#endif
+
+TEST(IpAddress, socketV4)
+{
+    auto rv = SocketAddressV4::fromString("127.0.0.1:8080");
+    ASSERT_TRUE(rv.isOk());
+    EXPECT_EQ(SocketAddressV4(127, 0, 0, 1, 8080), rv.unwrap());
+    EXPECT_EQ(8080, rv.unwrap().port());
+    EXPECT_EQ("127.0.0.1:8080", rv.unwrap().toStdString());
+    EXPECT_EQ("255.255.255.255:65535", SocketAddressV4(255, 255, 255, 255, 65535).toStdString());
+
+    const char* invalid[] = {"127.0.0.1", "127.0.0.1:", ":80", "127.0.0.1:65536", "127.0.0.1:080", "127.0.0.1:8a",
+                             "127.0.0.1:-1", "[::1]:80"};
+    for (const char* str : invalid) {
+        EXPECT_TRUE(SocketAddressV4::fromString(str).isErr()) << str;
+    }
+}
+
+TEST(IpAddress, socketV6)
+{
+    auto rv = SocketAddressV6::fromString("[2001:db8::1]:443");
+    ASSERT_TRUE(rv.isOk());
+    EXPECT_EQ(SocketAddressV6(v6("2001:db8::1"), 443), rv.unwrap());
+    EXPECT_EQ("[2001:db8::1]:443", rv.unwrap().toStdString());
+
+    rv = SocketAddressV6::fromString("[fe80::1%3]:0");
+    ASSERT_TRUE(rv.isOk());
+    EXPECT_EQ(3u, rv.unwrap().scopeId());
+    EXPECT_EQ(0, rv.unwrap().port());
+    EXPECT_EQ("[fe80::1%3]:0", rv.unwrap().toStdString());
+
+    std::string longest = "[ffff:ffff:ffff:ffff:ffff:ffff:255.255.255.255%4294967295]:65535";
+    EXPECT_EQ(SocketAddressV6::formattedMaxSize, longest.size());
+    EXPECT_TRUE(SocketAddressV6::fromString(longest).isOk());
+
+    const char* invalid[] = {"::1:80", "[::1]", "[::1]:", "[::1]80", "[::1:80", "[::1%]:80", "[::1%eth0]:80",
+                             "[::1%4294967296]:80", "[::1]:65536", "[1.2.3.4]:80"};
+    for (const char* str : invalid) {
+        EXPECT_TRUE(SocketAddressV6::fromString(str).isErr()) << str;
+    }
+}
+
+TEST(IpAddress, socketAddress)
+{
+    auto v4 = SocketAddress::fromString("10.0.0.1:53");
+    ASSERT_TRUE(v4.isOk());
+    EXPECT_TRUE(v4.unwrap().isV4());
+    EXPECT_EQ(53, v4.unwrap().port());
+    EXPECT_EQ(SocketAddressV4(10, 0, 0, 1, 53), v4.unwrap().toV4());
+    EXPECT_EQ("10.0.0.1:53", v4.unwrap().toStdString());
+
+    auto v6 = SocketAddress::fromString("[::1]:53");
+    ASSERT_TRUE(v6.isOk());
+    EXPECT_TRUE(v6.unwrap().isV6());
+    EXPECT_EQ(IpVersion::V6, v6.unwrap().version());
+    EXPECT_EQ(53, v6.unwrap().port());
+    EXPECT_TRUE(v6.unwrap().toV6().address().isLoopback());
+    EXPECT_EQ("[::1]:53", v6.unwrap().toStdString());
+
+    EXPECT_NE(v4.unwrap(), v6.unwrap());
+    EXPECT_TRUE(SocketAddress::fromString("").isErr());
+    EXPECT_TRUE(SocketAddress::fromString("[::1]").isErr());
+    EXPECT_TRUE(SocketAddress::fromString("::1:53").isErr());
+
+    uint8_t buf[64];
+    MemWriter writer(buf, sizeof(buf));
+    v6.unwrap().format(&writer);
+    EXPECT_EQ("[::1]:53", std::string((const char*)buf, writer.sizeUsed()));
+}
+
+TEST(IpAddress, hash)
+{
+    std::unordered_set<SocketAddress> set;
+    for (unsigned i = 0; i < 1000; i++) {
+        set.insert(SocketAddressV4(10, 0, uint8_t(i >> 8), uint8_t(i), 80));
+        set.insert(SocketAddressV6(Ipv6Address(0xfe80, 0, 0, 0, 0, 0, 0, uint16_t(i)), 80));
+    }
+    set.insert(SocketAddressV4(10, 0, 0, 1, 80));
+    EXPECT_EQ(2000u, set.size());
+    EXPECT_EQ(1u, set.count(SocketAddressV6(v6("fe80::5"), 80)));
+    EXPECT_EQ(0u, set.count(SocketAddressV6(v6("fe80::5"), 81)));
+
+    EXPECT_EQ(std::hash<Ipv4Address>()(Ipv4Address(1, 2, 3, 4)), Ipv4Address(1, 2, 3, 4).hash());
+    EXPECT_NE(Ipv4Address(1, 2, 3, 4).hash(), Ipv4Address(1, 2, 3, 5).hash());
+    EXPECT_NE(v6("::1").hash(), v6("::2").hash());
+}
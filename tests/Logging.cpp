@@ -1,6 +1,11 @@
 #include "bmcl/Logging.h"
 
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
@@ -65,6 +70,201 @@ TEST_F(Logging, customLevel)
     expectMsg("criticaldebug");
 }
 
+TEST_F(Logging, disabledLevelSkipsArguments)
+{
+    int calls = 0;
+    auto arg = [&calls]() {
+        calls++;
+        return calls;
+    };
+    bmcl::setLogLevel(bmcl::LogLevel::Warning);
+    BMCL_DEBUG() << arg();
+    BMCL_INFO() << arg();
+    EXPECT_EQ(0, calls);
+    expectLastLevel(bmcl::LogLevel::None);
+    BMCL_WARNING() << arg();
+    EXPECT_EQ(1, calls);
+    bmcl::setLogLevel(bmcl::LogLevel::Debug);
+    expectLastLevel(bmcl::LogLevel::Warning);
+    expectMsg("1");
+}
+
+TEST_F(Logging, formatStateIsReset)
+{
+    BMCL_INFO() << std::hex << 255;
+    BMCL_INFO() << ' ' << 255;
+    expectMsg("ff 255");
+}
+
+struct NestedLog {
+};
+
+static std::ostream& operator<<(std::ostream& stream, const NestedLog&)
+{
+    BMCL_DEBUG() << "inner";
+    return stream << "outer";
+}
+
+TEST_F(Logging, nested)
+{
+    BMCL_INFO() << "1" << NestedLog() << "2";
+    expectLastLevel(bmcl::LogLevel::Info);
+    expectMsg("inner1outer2");
+}
+
+class AsyncLogging : public Logging {
+protected:
+    void TearDown() override
+    {
+        bmcl::disableAsyncLogging();
+        Logging::TearDown();
+    }
+};
+
+TEST_F(AsyncLogging, basic)
+{
+    bmcl::enableAsyncLogging();
+    EXPECT_TRUE(bmcl::isAsyncLoggingEnabled());
+    BMCL_INFO() << "test" << 1;
+    BMCL_WARNING() << "test" << 2;
+    bmcl::flushLog();
+    expectLastLevel(bmcl::LogLevel::Warning);
+    expectMsg("test1test2");
+    bmcl::disableAsyncLogging();
+    EXPECT_FALSE(bmcl::isAsyncLoggingEnabled());
+}
+
+TEST_F(AsyncLogging, handledOnWriterThread)
+{
+    std::thread::id handlerThread;
+    bmcl::setLogHandler([&handlerThread](bmcl::LogLevel, const char*) {
+        handlerThread = std::this_thread::get_id();
+    });
+    bmcl::enableAsyncLogging();
+    BMCL_INFO() << "async";
+    bmcl::flushLog();
+    EXPECT_NE(std::this_thread::get_id(), handlerThread);
+
+    bmcl::log(bmcl::LogLevel::Panic, "panic");
+    EXPECT_EQ(std::this_thread::get_id(), handlerThread);
+}
+
+TEST_F(AsyncLogging, disableHandlesQueued)
+{
+    bmcl::enableAsyncLogging();
+    for (int i = 0; i < 100; i++) {
+        bmcl::log(bmcl::LogLevel::Info, "x");
+    }
+    bmcl::disableAsyncLogging();
+    EXPECT_EQ(std::string(100, 'x'), buffer);
+}
+
+TEST_F(AsyncLogging, manyThreadsBlock)
+{
+    const std::size_t threadNum = 4;
+    const std::size_t msgNum = 5000;
+    std::vector<std::vector<std::size_t>> received(threadNum);
+    bmcl::setLogHandler([&received](bmcl::LogLevel, const char* msg) {
+        std::string str(msg);
+        std::size_t sep = str.find(':');
+        received[std::stoul(str.substr(0, sep))].push_back(std::stoul(str.substr(sep + 1)));
+    });
+    bmcl::enableAsyncLogging(4096, bmcl::LogOverflowPolicy::Block);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadNum; t++) {
+        threads.emplace_back([t, msgNum]() {
+            for (std::size_t i = 0; i < msgNum; i++) {
+                BMCL_INFO() << t << ':' << i;
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    bmcl::flushLog();
+    EXPECT_EQ(0u, bmcl::droppedLogMessages());
+    for (const std::vector<std::size_t>& r : received) {
+        ASSERT_EQ(msgNum, r.size());
+        for (std::size_t i = 0; i < msgNum; i++) {
+            EXPECT_EQ(i, r[i]);
+        }
+    }
+}
+
+TEST_F(AsyncLogging, disableWhileLogging)
+{
+    const std::size_t threadNum = 4;
+    const std::size_t msgNum = 20000;
+    std::mutex mutex;
+    std::size_t handled = 0;
+    // the handler runs on the writer thread or on threads logging synchronously after disable
+    bmcl::setLogHandler([&mutex, &handled](bmcl::LogLevel, const char*) {
+        std::lock_guard<std::mutex> lock(mutex);
+        handled++;
+    });
+    bmcl::enableAsyncLogging(4096, bmcl::LogOverflowPolicy::Block);
+    std::vector<std::thread> threads;
+    for (std::size_t t = 0; t < threadNum; t++) {
+        threads.emplace_back([msgNum]() {
+            for (std::size_t i = 0; i < msgNum; i++) {
+                bmcl::log(bmcl::LogLevel::Info, "x");
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    bmcl::disableAsyncLogging();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(threadNum * msgNum, handled);
+}
+
+TEST_F(AsyncLogging, handlerLogsOnWriterThread)
+{
+    std::vector<std::string> received;
+    bmcl::setLogHandler([&received](bmcl::LogLevel level, const char* msg) {
+        received.push_back(msg);
+        if (level == bmcl::LogLevel::Info) {
+            // would wait for the writer thread itself
+            bmcl::log(bmcl::LogLevel::Panic, "nested panic");
+            bmcl::flushLog();
+            bmcl::log(bmcl::LogLevel::Warning, "nested warning");
+        }
+    });
+    bmcl::enableAsyncLogging(4096, bmcl::LogOverflowPolicy::Block);
+    bmcl::log(bmcl::LogLevel::Info, "outer");
+    bmcl::flushLog();
+    ASSERT_EQ(3u, received.size());
+    EXPECT_EQ("outer", received[0]);
+    EXPECT_EQ("nested panic", received[1]);
+    EXPECT_EQ("nested warning", received[2]);
+}
+
+TEST_F(AsyncLogging, dropWhenFull)
+{
+    std::mutex mutex;
+    std::size_t handled = 0;
+    bmcl::setLogHandler([&mutex, &handled](bmcl::LogLevel, const char*) {
+        std::lock_guard<std::mutex> lock(mutex);
+        handled++;
+    });
+    uint64_t droppedBefore = bmcl::droppedLogMessages();
+    bmcl::enableAsyncLogging(4096, bmcl::LogOverflowPolicy::Drop);
+    std::string msg(100, 'a');
+    const std::size_t msgNum = 1000;
+    {
+        // stalls the writer thread inside the handler
+        std::lock_guard<std::mutex> lock(mutex);
+        for (std::size_t i = 0; i < msgNum; i++) {
+            bmcl::log(bmcl::LogLevel::Info, msg.c_str());
+        }
+    }
+    bmcl::flushLog();
+    uint64_t dropped = bmcl::droppedLogMessages() - droppedBefore;
+    EXPECT_LT(0u, dropped);
+    EXPECT_EQ(msgNum, handled + dropped);
+}
+
 #ifdef BMCL_HAVE_QT
 
 #include <QString>
@@ -38,3 +38,55 @@ TEST(MmapOpener, readOnes)
     ASSERT_TRUE(mmapFile.close());
     ASSERT_FALSE(mmapFile.isOpen());
 }
+
+TEST(MmapOpener, openOptions)
+{
+    const char* path = DATA_DIR"/ones";
+    bmcl::MmapOpenOptions options;
+    options.access = bmcl::MmapAccess::Sequential;
+    options.willNeed = true;
+    options.populate = true;
+    options.hugePages = true;
+    bmcl::MmapOpener mmapFile;
+    ASSERT_TRUE(mmapFile.open(path, options));
+    std::string expected(1024 * 1024, '1');
+    ASSERT_EQ(mmapFile.size(), expected.size());
+    EXPECT_EQ_MEM(mmapFile.data(), expected.data(), expected.size());
+}
+
+TEST(MmapOpener, prefetchAndEvict)
+{
+    const char* path = DATA_DIR"/ones";
+    bmcl::MmapOpener mmapFile;
+    EXPECT_FALSE(mmapFile.prefetch(0, 4096));
+    ASSERT_TRUE(mmapFile.open(path));
+    std::size_t size = mmapFile.size();
+#ifndef _WIN32
+    EXPECT_TRUE(mmapFile.prefetch(0, size));
+    EXPECT_TRUE(mmapFile.prefetch(1000, 10));
+    EXPECT_TRUE(mmapFile.prefetch(size - 1, 100));
+    EXPECT_TRUE(mmapFile.evict(5000, 100000));
+#endif
+    EXPECT_FALSE(mmapFile.prefetch(size, 100));
+    EXPECT_FALSE(mmapFile.evict(size + 4096, 100));
+
+    // evicted pages are read again from the file
+    std::string expected(size, '1');
+    EXPECT_EQ_MEM(mmapFile.data(), expected.data(), expected.size());
+}
+
+TEST(MmapOpener, readAhead)
+{
+    const char* path = DATA_DIR"/ones";
+    bmcl::MmapOpener mmapFile;
+    ASSERT_TRUE(mmapFile.open(path));
+    bmcl::MmapReadAhead readAhead(&mmapFile, 64 * 1024, true);
+    std::size_t sum = 0;
+    for (std::size_t i = 0; i < mmapFile.size(); i++) {
+        if ((i & 4095) == 0) {
+            readAhead.update(i);
+        }
+        sum += mmapFile.data()[i] - '0';
+    }
+    EXPECT_EQ(mmapFile.size(), sum);
+}
@@ -0,0 +1,141 @@
+#include "bmcl/MmapWindowReader.h"
+#include "bmcl/Bytes.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+using namespace bmcl;
+
+static const char* testPath = "mmapwindowreader_test.bin";
+// not a multiple of window size so that the last window is partial
+static const std::size_t testSize = 4 * 1024 * 1024 + 123;
+
+class MmapWindowReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        _data.resize(testSize);
+        for (std::size_t i = 0; i < testSize; i++) {
+            _data[i] = uint8_t(i * 7 + (i >> 12));
+        }
+        std::FILE* file = std::fopen(testPath, "wb");
+        ASSERT_NE(nullptr, file);
+        ASSERT_EQ(testSize, std::fwrite(_data.data(), 1, testSize, file));
+        std::fclose(file);
+    }
+
+    void TearDown() override
+    {
+        std::remove(testPath);
+    }
+
+    std::vector<uint8_t> _data;
+};
+
+TEST_F(MmapWindowReaderTest, openInvalid)
+{
+    MmapWindowReader reader;
+    EXPECT_FALSE(reader.isOpen());
+    EXPECT_FALSE(reader.open("mmapwindowreader_missing.bin"));
+    EXPECT_FALSE(reader.isOpen());
+}
+
+TEST_F(MmapWindowReaderTest, sequentialAcrossWindows)
+{
+    MmapWindowReader reader;
+    ASSERT_TRUE(reader.open(testPath, 64 * 1024, 2));
+    EXPECT_TRUE(reader.isOpen());
+    EXPECT_EQ(testSize, reader.size());
+    EXPECT_EQ(0u, reader.windowSize() % 4096);
+
+    // odd offset so that some reads straddle window boundaries
+    EXPECT_EQ(_data[0], reader.readUint8());
+    std::size_t pos = 1;
+    while (reader.sizeLeft() >= 4) {
+        uint32_t expected = _data[pos] | (_data[pos + 1] << 8) | (_data[pos + 2] << 16) | (uint32_t(_data[pos + 3]) << 24);
+        ASSERT_EQ(expected, reader.readUint32Le()) << pos;
+        pos += 4;
+        ASSERT_LE(reader.mappedWindows(), 2u);
+    }
+    EXPECT_EQ(pos, reader.position());
+    while (!reader.isEmpty()) {
+        ASSERT_EQ(_data[pos], reader.readUint8());
+        pos++;
+    }
+    EXPECT_EQ(testSize, pos);
+    EXPECT_TRUE(reader.close());
+    EXPECT_FALSE(reader.isOpen());
+}
+
+TEST_F(MmapWindowReaderTest, largeRead)
+{
+    MmapWindowReader reader;
+    ASSERT_TRUE(reader.open(testPath, 64 * 1024, 1));
+    reader.seek(1000);
+    std::vector<uint8_t> dest(1024 * 1024);
+    reader.read(dest.data(), dest.size());
+    EXPECT_EQ(1000u + dest.size(), reader.position());
+    EXPECT_TRUE(std::equal(dest.begin(), dest.end(), _data.begin() + 1000));
+    EXPECT_EQ(1u, reader.mappedWindows());
+}
+
+TEST_F(MmapWindowReaderTest, seekAndPeek)
+{
+    MmapWindowReader reader;
+    ASSERT_TRUE(reader.open(testPath, 64 * 1024, 3));
+    const std::size_t offsets[] = {testSize - 1, 0, 65535, 3 * 1024 * 1024 + 5, 65536, 131071, 70000};
+    for (std::size_t offset : offsets) {
+        reader.seek(offset);
+        EXPECT_EQ(offset, reader.position());
+        EXPECT_EQ(testSize - offset, reader.sizeLeft());
+        EXPECT_EQ(_data[offset], reader.readUint8());
+        ASSERT_LE(reader.mappedWindows(), 3u);
+    }
+
+    reader.seek(65530);
+    uint8_t dest[20];
+    reader.peek(dest, sizeof(dest), 2);
+    EXPECT_TRUE(std::equal(dest, dest + sizeof(dest), _data.begin() + 65532));
+    EXPECT_EQ(65530u, reader.position());
+    reader.skip(10);
+    EXPECT_EQ(65540u, reader.position());
+    EXPECT_EQ(_data[65540], reader.readUint8());
+
+    reader.seek(testSize);
+    EXPECT_TRUE(reader.isEmpty());
+}
+
+TEST_F(MmapWindowReaderTest, readableChunk)
+{
+    MmapWindowReader reader;
+    ASSERT_TRUE(reader.open(testPath, 64 * 1024, 2));
+    std::size_t pos = 0;
+    while (true) {
+        Bytes chunk = reader.readableChunk();
+        if (chunk.isEmpty()) {
+            break;
+        }
+        ASSERT_LE(chunk.size(), reader.windowSize());
+        ASSERT_TRUE(std::equal(chunk.begin(), chunk.end(), _data.begin() + pos));
+        pos += chunk.size();
+        reader.skip(chunk.size());
+    }
+    EXPECT_EQ(testSize, pos);
+}
+
+TEST_F(MmapWindowReaderTest, emptyFile)
+{
+    std::FILE* file = std::fopen(testPath, "wb");
+    ASSERT_NE(nullptr, file);
+    std::fclose(file);
+
+    MmapWindowReader reader;
+    ASSERT_TRUE(reader.open(testPath));
+    EXPECT_EQ(0u, reader.size());
+    EXPECT_TRUE(reader.isEmpty());
+    EXPECT_TRUE(reader.readableChunk().isEmpty());
+}
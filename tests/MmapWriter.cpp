@@ -0,0 +1,128 @@
+#include "bmcl/MmapWriter.h"
+#include "bmcl/MmapOpener.h"
+#include "bmcl/FileUtils.h"
+#include "bmcl/MemReader.h"
+#include "bmcl/Result.h"
+#include "bmcl/Buffer.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+using namespace bmcl;
+
+static const char* testPath = "mmapwriter_test.bin";
+
+class MmapWriterTest : public ::testing::Test {
+protected:
+    void TearDown() override
+    {
+        std::remove(testPath);
+    }
+};
+
+TEST_F(MmapWriterTest, writeAndTruncate)
+{
+    MmapWriter writer;
+    EXPECT_FALSE(writer.isOpen());
+    ASSERT_TRUE(writer.open(testPath, 4096));
+    EXPECT_TRUE(writer.isOpen());
+    EXPECT_EQ(0u, writer.size());
+
+    writer.writeUint32Le(0xdeadbeef);
+    writer.writeUint8(7);
+    writer.write("abc", 3);
+    EXPECT_EQ(8u, writer.size());
+    EXPECT_LE(4096u, writer.capacity());
+    EXPECT_EQ_MEM(writer.data() + 5, "abc", 3);
+    EXPECT_TRUE(writer.flush());
+    EXPECT_TRUE(writer.flushAsync(0, 8));
+    ASSERT_TRUE(writer.close());
+    EXPECT_FALSE(writer.isOpen());
+
+    Result<Buffer, int> data = readFileIntoBuffer(testPath);
+    ASSERT_TRUE(data.isOk());
+    ASSERT_EQ(8u, data.unwrap().size());
+    MemReader reader(data.unwrap());
+    EXPECT_EQ(0xdeadbeef, reader.readUint32Le());
+    EXPECT_EQ(7, reader.readUint8());
+}
+
+TEST_F(MmapWriterTest, grow)
+{
+    MmapWriter writer;
+    ASSERT_TRUE(writer.open(testPath, 4096));
+    std::string chunk(1000, 'x');
+    for (int i = 0; i < 100; i++) {
+        chunk[0] = char('0' + i % 10);
+        writer.write(chunk.data(), chunk.size());
+    }
+    // larger than the grow size at once
+    std::string large(20000, 'y');
+    writer.write(large.data(), large.size());
+    EXPECT_FALSE(writer.hasError());
+    EXPECT_EQ(120000u, writer.size());
+    EXPECT_LE(120000u, writer.capacity());
+    EXPECT_EQ('9', writer.data()[99000]);
+    ASSERT_TRUE(writer.close());
+
+    MmapOpener file;
+    ASSERT_TRUE(file.open(testPath));
+    ASSERT_EQ(120000u, file.size());
+    EXPECT_EQ('0', file.data()[0]);
+    EXPECT_EQ('5', file.data()[5000]);
+    EXPECT_EQ('x', file.data()[5001]);
+    EXPECT_EQ('y', file.data()[119999]);
+}
+
+TEST_F(MmapWriterTest, reserveAndAdvance)
+{
+    MmapWriter writer;
+    ASSERT_TRUE(writer.open(testPath, 4096));
+    uint8_t* dest = writer.reserve(10000);
+    ASSERT_NE(nullptr, dest);
+    std::memset(dest, 'z', 10000);
+    writer.advance(10000);
+    EXPECT_EQ(10000u, writer.size());
+    EXPECT_EQ(10000u, writer.writtenData().size());
+    ASSERT_TRUE(writer.close());
+
+    Result<std::string, int> data = readFileIntoString(testPath);
+    ASSERT_TRUE(data.isOk());
+    EXPECT_EQ(std::string(10000, 'z'), data.unwrap());
+}
+
+TEST_F(MmapWriterTest, emptyAndMove)
+{
+    MmapWriter writer;
+    ASSERT_TRUE(writer.open(testPath));
+    MmapWriter moved(std::move(writer));
+    EXPECT_FALSE(writer.isOpen());
+    EXPECT_FALSE(writer.close());
+    EXPECT_TRUE(moved.isOpen());
+    EXPECT_FALSE(writer.flush());
+    EXPECT_TRUE(moved.flush());
+    EXPECT_TRUE(moved.flushAsync(0, 8));
+    moved.writeUint16Le(1);
+
+    MmapWriter assigned;
+    assigned = std::move(moved);
+    EXPECT_EQ(2u, assigned.size());
+    ASSERT_TRUE(assigned.close());
+
+    Result<Buffer, int> data = readFileIntoBuffer(testPath);
+    ASSERT_TRUE(data.isOk());
+    EXPECT_EQ(2u, data.unwrap().size());
+}
+
+TEST_F(MmapWriterTest, openError)
+{
+    MmapWriter writer;
+    EXPECT_FALSE(writer.open("nonexistent_dir/file.bin"));
+    EXPECT_FALSE(writer.isOpen());
+}
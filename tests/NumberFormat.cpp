@@ -0,0 +1,248 @@
+#include "bmcl/NumberFormat.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/MemWriter.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+using namespace bmcl;
+
+static std::string intToString(int64_t value)
+{
+    char tmp[formatIntMaxSize];
+    return std::string(tmp, formatInt(value, tmp));
+}
+
+static std::string doubleToString(double value)
+{
+    char tmp[formatDoubleMaxSize];
+    return std::string(tmp, formatDouble(value, tmp));
+}
+
+static double bitsToDouble(uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint64_t doubleToBits(double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// number of significant digits of the shortest round trip representation
+static int shortestDigits(double value)
+{
+    for (int precision = 1; precision < 17; precision++) {
+        char tmp[64];
+        std::snprintf(tmp, sizeof(tmp), "%.*e", precision - 1, value);
+        if (std::strtod(tmp, nullptr) == value) {
+            return precision;
+        }
+    }
+    return 17;
+}
+
+static int significantDigits(const std::string& str)
+{
+    int count = 0;
+    int zeros = 0;
+    bool isLeading = true;
+    for (char c : str) {
+        if (c == 'e') {
+            break;
+        }
+        if (c < '0' || c > '9') {
+            continue;
+        }
+        if (c == '0') {
+            zeros += !isLeading;
+            continue;
+        }
+        isLeading = false;
+        count += zeros + 1;
+        zeros = 0;
+    }
+    return count;
+}
+
+TEST(FormatInt, values)
+{
+    EXPECT_EQ("0", intToString(0));
+    EXPECT_EQ("7", intToString(7));
+    EXPECT_EQ("-7", intToString(-7));
+    EXPECT_EQ("10", intToString(10));
+    EXPECT_EQ("99", intToString(99));
+    EXPECT_EQ("100", intToString(100));
+    EXPECT_EQ("-12345", intToString(-12345));
+    EXPECT_EQ("9223372036854775807", intToString(std::numeric_limits<int64_t>::max()));
+    EXPECT_EQ("-9223372036854775808", intToString(std::numeric_limits<int64_t>::min()));
+
+    char tmp[formatIntMaxSize];
+    EXPECT_EQ("18446744073709551615", std::string(tmp, formatUint(std::numeric_limits<uint64_t>::max(), tmp)));
+
+    uint64_t value = 1;
+    for (int i = 0; i < 20; i++) {
+        char expected[32];
+        std::snprintf(expected, sizeof(expected), "%llu", (unsigned long long)value);
+        EXPECT_EQ(expected, std::string(tmp, formatUint(value, tmp)));
+        std::snprintf(expected, sizeof(expected), "%llu", (unsigned long long)(value - 1));
+        EXPECT_EQ(expected, std::string(tmp, formatUint(value - 1, tmp)));
+        value *= 10;
+    }
+}
+
+TEST(FormatInt, writers)
+{
+    Buffer buf;
+    formatInt(-42, &buf);
+    formatUint(42, &buf);
+    formatDouble(0.5, &buf);
+    EXPECT_EQ("-42420.5", std::string((const char*)buf.begin(), buf.size()));
+
+    char dest[8] = {0};
+    MemWriter writer(dest, 7);
+    formatInt(123, &writer);
+    formatDouble(1.25, &writer);
+    EXPECT_TRUE(writer.isFull());
+    EXPECT_STREQ("1231.25", dest);
+
+    std::string str = "x=";
+    formatInt(5, &str);
+    formatDouble(-2.5, &str);
+    EXPECT_EQ("x=5-2.5", str);
+}
+
+TEST(FormatDouble, special)
+{
+    EXPECT_EQ("0", doubleToString(0.0));
+    EXPECT_EQ("-0", doubleToString(-0.0));
+    EXPECT_EQ("inf", doubleToString(std::numeric_limits<double>::infinity()));
+    EXPECT_EQ("-inf", doubleToString(-std::numeric_limits<double>::infinity()));
+    EXPECT_EQ("nan", doubleToString(std::numeric_limits<double>::quiet_NaN()));
+}
+
+TEST(FormatDouble, values)
+{
+    EXPECT_EQ("1", doubleToString(1.0));
+    EXPECT_EQ("-1", doubleToString(-1.0));
+    EXPECT_EQ("0.1", doubleToString(0.1));
+    EXPECT_EQ("0.3", doubleToString(0.3));
+    EXPECT_EQ("0.30000000000000004", doubleToString(0.1 + 0.2));
+    EXPECT_EQ("123.456", doubleToString(123.456));
+    EXPECT_EQ("1000000", doubleToString(1e6));
+    EXPECT_EQ("10000000000000000", doubleToString(1e16));
+    EXPECT_EQ("1e+17", doubleToString(1e17));
+    EXPECT_EQ("0.00001", doubleToString(1e-5));
+    EXPECT_EQ("1e-6", doubleToString(1e-6));
+    EXPECT_EQ("1.5e-7", doubleToString(1.5e-7));
+    EXPECT_EQ("9007199254740992", doubleToString(9007199254740992.0));
+    EXPECT_EQ("1.7976931348623157e+308", doubleToString(std::numeric_limits<double>::max()));
+    EXPECT_EQ("2.2250738585072014e-308", doubleToString(std::numeric_limits<double>::min()));
+    EXPECT_EQ("5e-324", doubleToString(std::numeric_limits<double>::denorm_min()));
+    EXPECT_EQ("-1.2345678901234567e+89", doubleToString(-1.2345678901234567e89));
+}
+
+TEST(FormatDouble, shortestRoundTrip)
+{
+    uint64_t state = 88172645463325252ull;
+    for (int i = 0; i < 100000; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double value = bitsToDouble(state);
+        if (std::isnan(value)) {
+            continue;
+        }
+        std::string str = doubleToString(value);
+        ASSERT_GE(formatDoubleMaxSize, str.size());
+        auto parsed = parseDouble(str);
+        ASSERT_TRUE(parsed.isOk()) << str;
+        ASSERT_EQ(doubleToBits(value), doubleToBits(parsed.unwrap())) << str;
+        ASSERT_EQ(shortestDigits(value), significantDigits(str)) << str;
+    }
+}
+
+TEST(ParseInt, values)
+{
+    EXPECT_EQ(0, parseInt("0").unwrap());
+    EXPECT_EQ(0, parseInt("-0").unwrap());
+    EXPECT_EQ(12, parseInt("+12").unwrap());
+    EXPECT_EQ(-12, parseInt("-012").unwrap());
+    EXPECT_EQ(std::numeric_limits<int64_t>::max(), parseInt("9223372036854775807").unwrap());
+    EXPECT_EQ(std::numeric_limits<int64_t>::min(), parseInt("-9223372036854775808").unwrap());
+    EXPECT_EQ(std::numeric_limits<uint64_t>::max(), parseUint("18446744073709551615").unwrap());
+}
+
+TEST(ParseInt, errors)
+{
+    EXPECT_EQ(NumberParseError::Empty, parseInt("").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseInt("-").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseInt(" 1").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseInt("1 ").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseInt("1a").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseInt("--1").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseUint("-1").unwrapErr());
+    EXPECT_EQ(NumberParseError::OutOfRange, parseInt("9223372036854775808").unwrapErr());
+    EXPECT_EQ(NumberParseError::OutOfRange, parseInt("-9223372036854775809").unwrapErr());
+    EXPECT_EQ(NumberParseError::OutOfRange, parseUint("18446744073709551616").unwrapErr());
+    EXPECT_EQ(NumberParseError::OutOfRange, parseUint("99999999999999999999999").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseUint("99999999999999999999999x").unwrapErr());
+}
+
+TEST(ParseDouble, values)
+{
+    EXPECT_EQ(0.0, parseDouble("0").unwrap());
+    EXPECT_TRUE(std::signbit(parseDouble("-0.0").unwrap()));
+    EXPECT_EQ(1.5, parseDouble("1.5").unwrap());
+    EXPECT_EQ(-1.5, parseDouble("-1.5").unwrap());
+    EXPECT_EQ(0.5, parseDouble(".5").unwrap());
+    EXPECT_EQ(5.0, parseDouble("5.").unwrap());
+    EXPECT_EQ(1e10, parseDouble("1E10").unwrap());
+    EXPECT_EQ(1.25e-3, parseDouble("+1.25e-3").unwrap());
+    EXPECT_EQ(0.1, parseDouble("0.1000000000000000000000000000000000001").unwrap());
+    EXPECT_EQ(123456789012345678901234567890.0, parseDouble("123456789012345678901234567890").unwrap());
+    EXPECT_EQ(std::numeric_limits<double>::max(), parseDouble("1.7976931348623157e308").unwrap());
+    EXPECT_EQ(std::numeric_limits<double>::denorm_min(), parseDouble("4.9406564584124654e-324").unwrap());
+    EXPECT_EQ(0.0, parseDouble("1e-400").unwrap());
+    EXPECT_EQ(0.0, parseDouble("0e999999999999").unwrap());
+    EXPECT_EQ(std::numeric_limits<double>::infinity(), parseDouble("inf").unwrap());
+    EXPECT_EQ(-std::numeric_limits<double>::infinity(), parseDouble("-Infinity").unwrap());
+    EXPECT_TRUE(std::isnan(parseDouble("NaN").unwrap()));
+
+    // halfway between 1 and the next double, rounds to even
+    EXPECT_EQ(1.0, parseDouble("1.00000000000000011102230246251565404236316680908203125").unwrap());
+    EXPECT_EQ(std::nextafter(1.0, 2.0),
+              parseDouble("1.00000000000000011102230246251565404236316680908203126").unwrap());
+    std::string longHalfway = "1.00000000000000011102230246251565404236316680908203125" + std::string(1000, '0') + "1";
+    EXPECT_EQ(std::nextafter(1.0, 2.0), parseDouble(longHalfway).unwrap());
+}
+
+TEST(ParseDouble, errors)
+{
+    EXPECT_EQ(NumberParseError::Empty, parseDouble("").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble(".").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("-").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("e5").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("1e").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("1e+").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("1.2.3").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("1,5").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble(" 1").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("infinit").unwrapErr());
+    EXPECT_EQ(NumberParseError::InvalidFormat, parseDouble("0x10").unwrapErr());
+    EXPECT_EQ(NumberParseError::OutOfRange, parseDouble("1e309").unwrapErr());
+    EXPECT_EQ(NumberParseError::OutOfRange, parseDouble("-1e309").unwrapErr());
+}
@@ -0,0 +1,216 @@
+#include "bmcl/PrefixTable.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
+
+#include "BmclTest.h"
+
+#include <random>
+#include <vector>
+
+using namespace bmcl;
+
+TEST(PrefixTable, v4Empty)
+{
+    Ipv4PrefixTable table;
+    EXPECT_TRUE(table.isEmpty());
+    EXPECT_TRUE(table.lookup(Ipv4Address(1, 2, 3, 4)).isNone());
+    EXPECT_FALSE(table.remove(Ipv4Address(1, 2, 3, 4), 8));
+}
+
+TEST(PrefixTable, v4Longest)
+{
+    Ipv4PrefixTable table;
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 0, 0, 0), 8, 1));
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 1, 0, 0), 16, 2));
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 1, 2, 0), 24, 3));
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 1, 2, 128), 25, 4));
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 1, 2, 7), 32, 5));
+    EXPECT_EQ(5u, table.size());
+
+    EXPECT_EQ(1u, table.lookup(Ipv4Address(10, 200, 0, 1)).unwrap());
+    EXPECT_EQ(2u, table.lookup(Ipv4Address(10, 1, 200, 1)).unwrap());
+    EXPECT_EQ(3u, table.lookup(Ipv4Address(10, 1, 2, 1)).unwrap());
+    EXPECT_EQ(4u, table.lookup(Ipv4Address(10, 1, 2, 200)).unwrap());
+    EXPECT_EQ(5u, table.lookup(Ipv4Address(10, 1, 2, 7)).unwrap());
+    EXPECT_TRUE(table.lookup(Ipv4Address(11, 0, 0, 0)).isNone());
+
+    // shorter prefix inserted after longer ones doesn't override them
+    EXPECT_TRUE(table.insert(Ipv4Address(0, 0, 0, 0), 0, 6));
+    EXPECT_EQ(6u, table.lookup(Ipv4Address(11, 0, 0, 0)).unwrap());
+    EXPECT_EQ(5u, table.lookup(Ipv4Address(10, 1, 2, 7)).unwrap());
+
+    EXPECT_TRUE(table.remove(Ipv4Address(10, 1, 2, 0), 24));
+    EXPECT_EQ(2u, table.lookup(Ipv4Address(10, 1, 2, 1)).unwrap());
+    EXPECT_EQ(4u, table.lookup(Ipv4Address(10, 1, 2, 200)).unwrap());
+    EXPECT_TRUE(table.remove(Ipv4Address(0, 0, 0, 0), 0));
+    EXPECT_TRUE(table.lookup(Ipv4Address(11, 0, 0, 0)).isNone());
+}
+
+TEST(PrefixTable, v4Replace)
+{
+    Ipv4PrefixTable table;
+    // host bits are ignored
+    EXPECT_TRUE(table.insert(Ipv4Address(192, 168, 1, 77), 24, 1));
+    EXPECT_TRUE(table.insert(Ipv4Address(192, 168, 1, 5), 32, 2));
+    EXPECT_FALSE(table.insert(Ipv4Address(192, 168, 1, 0), 24, 3));
+    EXPECT_EQ(2u, table.size());
+    EXPECT_EQ(3u, table.find(Ipv4Address(192, 168, 1, 0), 24).unwrap());
+    EXPECT_TRUE(table.find(Ipv4Address(192, 168, 1, 0), 23).isNone());
+    EXPECT_EQ(3u, table.lookup(Ipv4Address(192, 168, 1, 1)).unwrap());
+    EXPECT_EQ(2u, table.lookup(Ipv4Address(192, 168, 1, 5)).unwrap());
+}
+
+TEST(PrefixTable, v4ReplaceSameValueSiblings)
+{
+    Ipv4PrefixTable table;
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 0, 0, 0), 17, 5));
+    EXPECT_TRUE(table.insert(Ipv4Address(10, 0, 128, 0), 17, 7));
+    // both halves of the node now hold the same value but come from different prefixes
+    EXPECT_FALSE(table.insert(Ipv4Address(10, 0, 128, 0), 17, 5));
+    EXPECT_EQ(5u, table.lookup(Ipv4Address(10, 0, 1, 1)).unwrap());
+    EXPECT_EQ(5u, table.lookup(Ipv4Address(10, 0, 200, 1)).unwrap());
+
+    EXPECT_TRUE(table.remove(Ipv4Address(10, 0, 0, 0), 17));
+    EXPECT_TRUE(table.lookup(Ipv4Address(10, 0, 1, 1)).isNone());
+    EXPECT_EQ(5u, table.lookup(Ipv4Address(10, 0, 200, 1)).unwrap());
+    EXPECT_FALSE(table.insert(Ipv4Address(10, 0, 128, 0), 17, 9));
+    EXPECT_EQ(9u, table.lookup(Ipv4Address(10, 0, 200, 1)).unwrap());
+    EXPECT_TRUE(table.remove(Ipv4Address(10, 0, 128, 0), 17));
+    EXPECT_TRUE(table.isEmpty());
+    EXPECT_TRUE(table.lookup(Ipv4Address(10, 0, 200, 1)).isNone());
+}
+
+TEST(PrefixTable, v4NodesReused)
+{
+    Ipv4PrefixTable table;
+    std::size_t usedSize = 0;
+    for (int n = 0; n < 3; n++) {
+        for (unsigned i = 0; i < 64; i++) {
+            table.insert(Ipv4Address(10, uint8_t(i), 1, 1), 32, i);
+        }
+        for (unsigned i = 0; i < 64; i++) {
+            EXPECT_TRUE(table.remove(Ipv4Address(10, uint8_t(i), 1, 1), 32));
+        }
+        // nodes freed by removal are used again
+        if (n == 0) {
+            usedSize = table.memoryUsage();
+        }
+        EXPECT_EQ(usedSize, table.memoryUsage());
+    }
+    EXPECT_TRUE(table.isEmpty());
+    EXPECT_TRUE(table.lookup(Ipv4Address(10, 5, 1, 1)).isNone());
+    table.clear();
+    EXPECT_TRUE(table.isEmpty());
+}
+
+struct Route {
+    uint32_t address;
+    unsigned size;
+    uint32_t value;
+};
+
+static uint32_t maskV4(uint32_t address, unsigned size)
+{
+    return size == 0 ? 0 : address & (0xffffffffu << (32 - size));
+}
+
+static uint32_t referenceLookup(const std::vector<Route>& routes, uint32_t address)
+{
+    unsigned bestSize = 0;
+    uint32_t best = PrefixTrie::notFound;
+    for (const Route& route : routes) {
+        if (maskV4(address, route.size) == route.address && (best == PrefixTrie::notFound || route.size >= bestSize)) {
+            best = route.value;
+            bestSize = route.size;
+        }
+    }
+    return best;
+}
+
+TEST(PrefixTable, v4Random)
+{
+    std::mt19937 gen(1);
+    Ipv4PrefixTable table;
+    std::vector<Route> routes;
+    // few top bits so that prefixes nest
+    auto randomAddress = [&gen]() { return (uint32_t(gen()) & 0x0303ffff) | 0x0a000000; };
+    for (unsigned i = 0; i < 2000; i++) {
+        unsigned size = gen() % 33;
+        uint32_t address = maskV4(randomAddress(), size);
+        bool isNew = table.insert(Ipv4Address(address), size, i);
+        bool found = false;
+        for (Route& route : routes) {
+            if (route.address == address && route.size == size) {
+                route.value = i;
+                found = true;
+            }
+        }
+        EXPECT_EQ(!found, isNew);
+        if (!found) {
+            routes.push_back(Route{address, size, i});
+        }
+        if (i % 3 == 0) {
+            std::size_t index = gen() % routes.size();
+            EXPECT_TRUE(table.remove(Ipv4Address(routes[index].address), routes[index].size));
+            routes.erase(routes.begin() + index);
+        }
+    }
+    ASSERT_EQ(routes.size(), table.size());
+
+    std::vector<Ipv4Address> addresses;
+    for (unsigned i = 0; i < 5000; i++) {
+        addresses.push_back(Ipv4Address(randomAddress()));
+    }
+    std::vector<uint32_t> values(addresses.size());
+    std::size_t found = table.lookup(addresses.data(), addresses.size(), values.data());
+    std::size_t expectedFound = 0;
+    for (std::size_t i = 0; i < addresses.size(); i++) {
+        uint32_t expected = referenceLookup(routes, addresses[i].toUint32());
+        expectedFound += expected != PrefixTrie::notFound;
+        EXPECT_EQ(expected, values[i]);
+        EXPECT_EQ(expected, table.lookup(addresses[i]).unwrapOr(PrefixTrie::notFound));
+    }
+    EXPECT_EQ(expectedFound, found);
+
+    for (const Route& route : routes) {
+        EXPECT_TRUE(table.remove(Ipv4Address(route.address), route.size));
+    }
+    EXPECT_TRUE(table.isEmpty());
+    EXPECT_TRUE(table.lookup(addresses[0]).isNone());
+}
+
+static Ipv6Address v6(const char* str)
+{
+    return Ipv6Address::fromString(str).unwrap();
+}
+
+TEST(PrefixTable, v6Longest)
+{
+    Ipv6PrefixTable table;
+    EXPECT_TRUE(table.insert(v6("2001:db8::"), 32, 1));
+    EXPECT_TRUE(table.insert(v6("2001:db8:1::"), 48, 2));
+    EXPECT_TRUE(table.insert(v6("2001:db8:1:2::"), 63, 3));
+    EXPECT_TRUE(table.insert(v6("2001:db8:1:2::1"), 128, 4));
+    EXPECT_TRUE(table.insert(v6("::"), 0, 5));
+
+    EXPECT_EQ(1u, table.lookup(v6("2001:db8:5::1")).unwrap());
+    EXPECT_EQ(2u, table.lookup(v6("2001:db8:1:ff::1")).unwrap());
+    EXPECT_EQ(3u, table.lookup(v6("2001:db8:1:3::1")).unwrap());
+    EXPECT_EQ(2u, table.lookup(v6("2001:db8:1:4::1")).unwrap());
+    EXPECT_EQ(4u, table.lookup(v6("2001:db8:1:2::1")).unwrap());
+    EXPECT_EQ(3u, table.lookup(v6("2001:db8:1:2::2")).unwrap());
+    EXPECT_EQ(5u, table.lookup(v6("fe80::1")).unwrap());
+
+    Ipv6Address addresses[] = {v6("2001:db8:1:2::1"), v6("2001:db8:5::1"), v6("fe80::1")};
+    uint32_t values[3];
+    EXPECT_EQ(3u, table.lookup(addresses, 3, values));
+    EXPECT_EQ(4u, values[0]);
+    EXPECT_EQ(1u, values[1]);
+    EXPECT_EQ(5u, values[2]);
+
+    EXPECT_TRUE(table.remove(v6("2001:db8:1:2::1"), 128));
+    EXPECT_TRUE(table.remove(v6("::"), 0));
+    EXPECT_EQ(3u, table.lookup(v6("2001:db8:1:2::1")).unwrap());
+    EXPECT_TRUE(table.lookup(v6("fe80::1")).isNone());
+    EXPECT_EQ(3u, table.size());
+}
@@ -74,6 +74,8 @@ protected:
 
     void expectEmpty() { EXPECT_TRUE(_ringbuf->isEmpty()); }
 
+    RingBuffer* ringBuffer() { return _ringbuf; }
+
     template <std::size_t n, typename R>
     void expect(const R (&array)[n])
     {
@@ -237,3 +239,65 @@ TEST_F(RingBufferTest, clear)
     clear();
     expectEmpty();
 }
+
+TEST_F(RingBufferTest, readable_chunks)
+{
+    initRingBufferWithSize(8);
+    RingBuffer::Chunks chunks = ringBuffer()->readableChunks();
+    EXPECT_EQ(0u, chunks.first.size());
+    EXPECT_EQ(0u, chunks.second.size());
+
+    uint8_t data[6] = {1, 2, 3, 4, 5, 6};
+    append(data);
+    erase(2);
+    chunks = ringBuffer()->readableChunks();
+    ASSERT_EQ(4u, chunks.first.size());
+    EXPECT_EQ(3, chunks.first[0]);
+    EXPECT_EQ(0u, chunks.second.size());
+
+    // wraps
+    append(data);
+    chunks = ringBuffer()->readableChunks();
+    ASSERT_EQ(4u, chunks.first.size());
+    ASSERT_EQ(4u, chunks.second.size());
+    EXPECT_EQ(5, chunks.first[0]);
+    EXPECT_EQ(2, chunks.first[3]);
+    EXPECT_EQ(3, chunks.second[0]);
+    EXPECT_EQ(6, chunks.second[3]);
+    EXPECT_TRUE(ringBuffer()->isFull());
+}
+
+TEST_F(RingBufferTest, writable_chunks)
+{
+    initRingBufferWithSize(8);
+    RingBuffer::WritableChunks chunks = ringBuffer()->writableChunks();
+    EXPECT_EQ(8u, chunks.firstSize + chunks.secondSize);
+    EXPECT_EQ(ringBuffer()->data(), chunks.first);
+
+    uint8_t data[5] = {1, 2, 3, 4, 5};
+    append(data);
+    erase(3);
+    chunks = ringBuffer()->writableChunks();
+    ASSERT_EQ(3u, chunks.firstSize);
+    ASSERT_EQ(3u, chunks.secondSize);
+    EXPECT_EQ(ringBuffer()->data() + 5, chunks.first);
+    EXPECT_EQ(ringBuffer()->data(), chunks.second);
+
+    std::memset(chunks.first, 6, 3);
+    chunks.second[0] = 7;
+    ringBuffer()->advance(4);
+    EXPECT_EQ(6u, ringBuffer()->usedSpace());
+    uint8_t expected[6] = {4, 5, 6, 6, 6, 7};
+    uint8_t result[6];
+    ringBuffer()->read(result, 6);
+    EXPECT_EQ(0, std::memcmp(expected, result, 6));
+
+    chunks = ringBuffer()->writableChunks();
+    EXPECT_EQ(ringBuffer()->data() + 1, chunks.first);
+    EXPECT_EQ(7u, chunks.firstSize);
+    EXPECT_EQ(1u, chunks.secondSize);
+
+    ringBuffer()->advance(8);
+    chunks = ringBuffer()->writableChunks();
+    EXPECT_EQ(0u, chunks.firstSize + chunks.secondSize);
+}
@@ -0,0 +1,119 @@
+#include "bmcl/SmallString.h"
+#include "bmcl/NumberFormat.h"
+#include "bmcl/String.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+using namespace bmcl;
+
+TEST(SmallString, empty)
+{
+    SmallString<8> str;
+    EXPECT_TRUE(str.isEmpty());
+    EXPECT_TRUE(str.isInline());
+    EXPECT_EQ(0u, str.size());
+    EXPECT_EQ(8u, str.capacity());
+    EXPECT_STREQ("", str.cStr());
+}
+
+TEST(SmallString, inlineAndSpill)
+{
+    SmallString<8> str("12345678");
+    EXPECT_TRUE(str.isInline());
+    EXPECT_EQ(8u, str.size());
+    EXPECT_STREQ("12345678", str.cStr());
+
+    str.append('9');
+    EXPECT_FALSE(str.isInline());
+    EXPECT_EQ(9u, str.size());
+    EXPECT_STREQ("123456789", str.cStr());
+
+    str += "abc";
+    str += StringView("def");
+    EXPECT_STREQ("123456789abcdef", str.cStr());
+    EXPECT_EQ("123456789abcdef", str);
+}
+
+TEST(SmallString, stringViewConversion)
+{
+    SmallString<16> str(StringView("channel.name"));
+    StringView view = str;
+    EXPECT_EQ(str.data(), view.data());
+    EXPECT_EQ(12u, view.size());
+    EXPECT_TRUE(view.startsWith("channel"));
+    EXPECT_TRUE(str == "channel.name");
+    EXPECT_TRUE(str != "channel");
+    EXPECT_TRUE(str < "channel.namf");
+    EXPECT_FALSE(str < "channel");
+    EXPECT_TRUE(SmallString<4>("ab") < "abc");
+    EXPECT_EQ("channel.name", str.toStdString());
+}
+
+TEST(SmallString, copyAndMove)
+{
+    SmallString<4> small("abc");
+    SmallString<4> large("abcdefgh");
+
+    SmallString<4> copy1(small);
+    SmallString<4> copy2(large);
+    EXPECT_EQ("abc", copy1);
+    EXPECT_EQ("abcdefgh", copy2);
+    EXPECT_TRUE(copy1.isInline());
+    EXPECT_NE(large.data(), copy2.data());
+
+    const char* largeData = large.data();
+    SmallString<4> moved1(std::move(small));
+    SmallString<4> moved2(std::move(large));
+    EXPECT_EQ("abc", moved1);
+    EXPECT_EQ("abcdefgh", moved2);
+    EXPECT_EQ(largeData, moved2.data());
+    EXPECT_TRUE(large.isEmpty());
+    EXPECT_TRUE(large.isInline());
+
+    copy1 = moved2;
+    EXPECT_EQ("abcdefgh", copy1);
+    copy2 = "x";
+    EXPECT_EQ("x", copy2);
+    copy2 = std::move(copy1);
+    EXPECT_EQ("abcdefgh", copy2);
+    copy2 = copy2;
+    EXPECT_EQ("abcdefgh", copy2);
+}
+
+TEST(SmallString, resizeAndClear)
+{
+    SmallString<4> str("ab");
+    str.resize(6, 'x');
+    EXPECT_STREQ("abxxxx", str.cStr());
+    str.resize(1);
+    EXPECT_STREQ("a", str.cStr());
+    str.clear();
+    EXPECT_TRUE(str.isEmpty());
+    EXPECT_STREQ("", str.cStr());
+    str.reserve(100);
+    EXPECT_LE(100u, str.capacity());
+}
+
+TEST(SmallString, appendSelf)
+{
+    SmallString<4> str("abcd");
+    str.append(str.view());
+    EXPECT_EQ("abcdabcd", str);
+    str.append(StringView(str.data() + 2, 4));
+    EXPECT_EQ("abcdabcdcdab", str);
+}
+
+TEST(SmallString, writer)
+{
+    SmallString<32> str("value=");
+    formatInt(-15, &str);
+    str.append(' ');
+    uint8_t data[] = {0xde, 0xad};
+    appendHexLower(Bytes::fromStaticArray(data), &str);
+    EXPECT_EQ("value=-15 dead", str);
+    EXPECT_TRUE(str.isInline());
+}
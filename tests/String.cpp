@@ -1,4 +1,8 @@
 #include "bmcl/String.h"
+#include "bmcl/Buffer.h"
+#include "bmcl/MemWriter.h"
+#include "bmcl/Result.h"
+#include "bmcl/StringView.h"
 
 #include "BmclTest.h"
 
@@ -34,3 +38,120 @@ TEST(BytesToHex, upper)
     EXPECT_EQ(expected, bytesToHexStringUpper(data, 9));
 }
 
+
+TEST(Split, getlineCompatible)
+{
+    std::vector<std::string> expected = {"a", "", "bc"};
+    EXPECT_EQ(expected, split("a,,bc,", ','));
+    EXPECT_EQ(expected, split("a,,bc", ','));
+    EXPECT_TRUE(split("", ',').empty());
+    EXPECT_EQ(std::vector<std::string>({""}), split(",", ','));
+}
+
+static std::vector<uint8_t> makeBytes(std::size_t size)
+{
+    std::vector<uint8_t> data;
+    for (std::size_t i = 0; i < size; i++) {
+        data.push_back(uint8_t(i * 37 + 11));
+    }
+    return data;
+}
+
+static std::string referenceHex(const std::vector<uint8_t>& data, const char* chars)
+{
+    std::string str;
+    for (uint8_t byte : data) {
+        str.push_back(chars[byte >> 4]);
+        str.push_back(chars[byte & 0xf]);
+    }
+    return str;
+}
+
+TEST(BytesToHex, allSizes)
+{
+    for (std::size_t size = 0; size < 100; size++) {
+        std::vector<uint8_t> data = makeBytes(size);
+        EXPECT_EQ(referenceHex(data, "0123456789abcdef"), bytesToHexStringLower(data));
+        EXPECT_EQ(referenceHex(data, "0123456789ABCDEF"), bytesToHexStringUpper(data));
+    }
+}
+
+TEST(BytesToHex, appendString)
+{
+    uint8_t data[] = {0x01, 0xfe};
+    std::string str = "0x";
+    appendHexUpper(Bytes::fromStaticArray(data), &str);
+    appendHexLower(Bytes::fromStaticArray(data), &str);
+    EXPECT_EQ("0x01FE01fe", str);
+}
+
+TEST(BytesToHex, appendBuffer)
+{
+    uint8_t data[] = {0xab, 0x10};
+    Buffer buf;
+    buf.writeUint8('<');
+    appendHexLower(Bytes::fromStaticArray(data), &buf);
+    appendHexUpper(Bytes::fromStaticArray(data), &buf);
+    EXPECT_EQ("<ab10AB10", std::string((const char*)buf.data(), buf.size()));
+}
+
+TEST(BytesToHex, appendMemWriter)
+{
+    uint8_t data[] = {0xc0, 0xde};
+    char dest[9] = {0};
+    MemWriter writer(dest, 8);
+    appendHexUpper(Bytes::fromStaticArray(data), &writer);
+    appendHexLower(Bytes::fromStaticArray(data), &writer);
+    EXPECT_TRUE(writer.isFull());
+    EXPECT_STREQ("C0DEc0de", dest);
+}
+
+TEST(BytesToHex, appendGenericWriter)
+{
+    std::vector<uint8_t> data = makeBytes(1000);
+    char dest[2000];
+    MemWriter writer(dest, sizeof(dest));
+    appendHexLower(data, static_cast<Writer<MemWriter>*>(&writer));
+    EXPECT_EQ(referenceHex(data, "0123456789abcdef"), std::string(dest, sizeof(dest)));
+}
+
+TEST(HexToBytes, roundTrip)
+{
+    for (std::size_t size = 0; size < 100; size++) {
+        std::vector<uint8_t> data = makeBytes(size);
+        auto lower = hexToBytes(bytesToHexStringLower(data));
+        ASSERT_TRUE(lower.isOk());
+        EXPECT_EQ(data, std::vector<uint8_t>(lower.unwrap().begin(), lower.unwrap().end()));
+        auto upper = hexToBytes(bytesToHexStringUpper(data));
+        ASSERT_TRUE(upper.isOk());
+        EXPECT_EQ(data, std::vector<uint8_t>(upper.unwrap().begin(), upper.unwrap().end()));
+    }
+}
+
+TEST(HexToBytes, mixedCase)
+{
+    uint8_t expected[] = {0xab, 0xcd, 0xef, 0x09};
+    uint8_t dest[4];
+    EXPECT_TRUE(hexToBytes("aBcDEf09", dest));
+    EXPECT_EQ_ARRAYS(expected, dest);
+}
+
+TEST(HexToBytes, invalid)
+{
+    EXPECT_TRUE(hexToBytes("123").isErr());
+    EXPECT_TRUE(hexToBytes("0g").isErr());
+    EXPECT_TRUE(hexToBytes("/0").isErr());
+    EXPECT_TRUE(hexToBytes(":0").isErr());
+    EXPECT_TRUE(hexToBytes("@0").isErr());
+    EXPECT_TRUE(hexToBytes("G0").isErr());
+    EXPECT_TRUE(hexToBytes("`0").isErr());
+    std::string longHex(64, 'a');
+    EXPECT_TRUE(hexToBytes(longHex).isOk());
+    for (std::size_t i = 0; i < longHex.size(); i++) {
+        std::string bad = longHex;
+        bad[i] = 'x';
+        EXPECT_TRUE(hexToBytes(bad).isErr());
+        bad[i] = '\xe1';
+        EXPECT_TRUE(hexToBytes(bad).isErr());
+    }
+}
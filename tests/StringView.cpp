@@ -325,3 +325,72 @@ TYPED_TEST(StringViewEq, vieweNeqTypeContents)
     TypeParam ref2("1231235123123");
     EXPECT_NE(ref1, ref2);
 }
+
+template <typename R>
+static std::vector<std::string> collectPieces(const R& range)
+{
+    std::vector<std::string> pieces;
+    for (StringView piece : range) {
+        pieces.push_back(piece.toStdString());
+    }
+    return pieces;
+}
+
+typedef std::vector<std::string> Pieces;
+
+TEST(StringView, splitChar)
+{
+    EXPECT_EQ(Pieces({"a", "bc", "def"}), collectPieces(StringView("a,bc,def").split(',')));
+    EXPECT_EQ(Pieces({"", "a", "", "b", ""}), collectPieces(StringView(",a,,b,").split(',')));
+    EXPECT_EQ(Pieces({"abc"}), collectPieces(StringView("abc").split(',')));
+    EXPECT_EQ(Pieces({""}), collectPieces(StringView("").split(',')));
+    EXPECT_EQ(Pieces({"", ""}), collectPieces(StringView(",").split(',')));
+}
+
+TEST(StringView, splitCharPointsIntoSource)
+{
+    StringView ref("12;345;6");
+    auto range = ref.split(';');
+    auto it = range.begin();
+    EXPECT_EQ(ref.data(), it->data());
+    ++it;
+    EXPECT_EQ(ref.data() + 3, it->data());
+    EXPECT_EQ(3, it->size());
+    it++;
+    EXPECT_EQ("6", *it);
+    ++it;
+    EXPECT_TRUE(it == range.end());
+}
+
+TEST(StringView, splitString)
+{
+    EXPECT_EQ(Pieces({"a", "b", "c"}), collectPieces(StringView("a::b::c").split("::")));
+    EXPECT_EQ(Pieces({"a:b", "", "c:"}), collectPieces(StringView("a:b::::c:").split("::")));
+    EXPECT_EQ(Pieces({"", ""}), collectPieces(StringView("--").split("--")));
+    EXPECT_EQ(Pieces({"-"}), collectPieces(StringView("-").split("--")));
+    EXPECT_EQ(Pieces({"abc"}), collectPieces(StringView("abc").split("abcd")));
+}
+
+TEST(StringView, splitAnyOf)
+{
+    EXPECT_EQ(Pieces({"a", "b", "c", "d"}), collectPieces(StringView("a,b;c d").splitAnyOf(",; ")));
+    EXPECT_EQ(Pieces({"a", "b"}), collectPieces(StringView("a,b").splitAnyOf(",")));
+    EXPECT_EQ(Pieces({"a,b"}), collectPieces(StringView("a,b").splitAnyOf("")));
+    EXPECT_EQ(Pieces({"1", "2", "3", "4", "5", "6", "7", "8", "9", "0"}),
+              collectPieces(StringView("1a2b3c4d5e6f7g8h9i0").splitAnyOf("abcdefghi")));
+}
+
+TEST(StringView, splitAnyOfLong)
+{
+    std::string str;
+    Pieces expected;
+    for (int i = 0; i < 100; i++) {
+        std::string field(i % 23, 'x');
+        expected.push_back(field);
+        str += field;
+        str += "\t,;"[i % 3];
+    }
+    expected.push_back("");
+    EXPECT_EQ(expected, collectPieces(StringView(str).splitAnyOf(",;\t")));
+    EXPECT_EQ(expected, collectPieces(StringView(str).splitAnyOf(",;\t\t,")));
+}
@@ -0,0 +1,189 @@
+#include "bmcl/ThreadPool.h"
+
+#include "BmclTest.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace bmcl;
+
+TEST(ThreadPool, post)
+{
+    std::atomic<std::size_t> count(0);
+    {
+        ThreadPool pool(4);
+        EXPECT_EQ(4u, pool.threadCount());
+        for (std::size_t i = 0; i < 10000; i++) {
+            pool.post([&count]() {
+                count.fetch_add(1);
+            });
+        }
+    }
+    EXPECT_EQ(10000u, count.load());
+}
+
+TEST(ThreadPool, default_thread_count)
+{
+    ThreadPool pool;
+    EXPECT_LE(1u, pool.threadCount());
+}
+
+TEST(ThreadPool, submit)
+{
+    ThreadPool pool(2);
+    TaskHandle<int, std::string> ok = pool.submit([]() -> Result<int, std::string> {
+        return 42;
+    });
+    TaskHandle<int, std::string> err = pool.submit([]() -> Result<int, std::string> {
+        return std::string("failed");
+    });
+    TaskHandle<std::vector<int>, void> vec = pool.submit([]() -> Result<std::vector<int>, void> {
+        return std::vector<int>{1, 2, 3};
+    });
+
+    ASSERT_TRUE(ok.isValid());
+    Result<int, std::string> rv = ok.wait();
+    EXPECT_FALSE(ok.isValid());
+    ASSERT_TRUE(rv.isOk());
+    EXPECT_EQ(42, rv.unwrap());
+
+    rv = err.wait();
+    ASSERT_TRUE(rv.isErr());
+    EXPECT_EQ("failed", rv.unwrapErr());
+
+    Result<std::vector<int>, void> vecRv = vec.wait();
+    ASSERT_TRUE(vecRv.isOk());
+    EXPECT_EQ(std::vector<int>({1, 2, 3}), vecRv.unwrap());
+}
+
+static uint64_t fib(ThreadPool* pool, uint64_t n)
+{
+    if (n < 12) {
+        return n < 2 ? n : fib(pool, n - 1) + fib(pool, n - 2);
+    }
+    TaskHandle<uint64_t, void> left = pool->submit([pool, n]() -> Result<uint64_t, void> {
+        return fib(pool, n - 1);
+    });
+    uint64_t right = fib(pool, n - 2);
+    return left.wait().unwrap() + right;
+}
+
+TEST(ThreadPool, nested_submit)
+{
+    // waiting tasks run other tasks, so nesting doesn't deadlock even with one worker
+    for (std::size_t threads : {1, 4}) {
+        ThreadPool pool(threads);
+        TaskHandle<uint64_t, void> handle = pool.submit([&pool]() -> Result<uint64_t, void> {
+            return fib(&pool, 24);
+        });
+        EXPECT_EQ(46368u, handle.wait().unwrap());
+    }
+}
+
+TEST(ThreadPool, waiter_runs_tasks_posted_later)
+{
+    // the only worker waits for a task it posts after the caller started waiting, the caller has to steal it
+    ThreadPool pool(1);
+    std::atomic<bool> isStarted(false);
+    std::atomic<bool> isDepDone(false);
+    TaskHandle<int, void> handle = pool.submit([&pool, &isStarted, &isDepDone]() -> Result<int, void> {
+        isStarted.store(true);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        pool.post([&isDepDone]() {
+            isDepDone.store(true);
+        });
+        while (!isDepDone.load()) {
+            std::this_thread::yield();
+        }
+        return 1;
+    });
+    while (!isStarted.load()) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(1, handle.wait().unwrap());
+}
+
+TEST(ThreadPool, wait_from_many_threads)
+{
+    ThreadPool pool(2);
+    std::vector<std::thread> threads;
+    std::atomic<std::size_t> sum(0);
+    for (std::size_t i = 0; i < 4; i++) {
+        threads.emplace_back([&pool, &sum, i]() {
+            for (std::size_t j = 0; j < 1000; j++) {
+                TaskHandle<std::size_t, void> handle = pool.submit([i, j]() -> Result<std::size_t, void> {
+                    return i * 1000 + j;
+                });
+                sum.fetch_add(handle.wait().unwrap());
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(4000u * 3999u / 2, sum.load());
+}
+
+TEST(ThreadPool, parallel_for_indexes)
+{
+    ThreadPool pool(4);
+    std::vector<std::atomic<unsigned>> hits(1000);
+    for (std::size_t grain : {0, 1, 7, 100, 999, 1000, 5000}) {
+        for (std::atomic<unsigned>& hit : hits) {
+            hit.store(0);
+        }
+        std::atomic<std::size_t> chunks(0);
+        pool.parallelFor(10, 1000, grain, [&](std::size_t begin, std::size_t end) {
+            EXPECT_LT(begin, end);
+            EXPECT_LE(end - begin, std::max<std::size_t>(grain, 1));
+            for (std::size_t i = begin; i < end; i++) {
+                hits[i].fetch_add(1);
+            }
+            chunks.fetch_add(1);
+        });
+        for (std::size_t i = 0; i < hits.size(); i++) {
+            EXPECT_EQ(i < 10 ? 0u : 1u, hits[i].load());
+        }
+        std::size_t g = std::max<std::size_t>(grain, 1);
+        EXPECT_EQ((990 + g - 1) / g, chunks.load());
+    }
+
+    bool isCalled = false;
+    pool.parallelFor(5, 5, 1, [&](std::size_t, std::size_t) {
+        isCalled = true;
+    });
+    EXPECT_FALSE(isCalled);
+}
+
+TEST(ThreadPool, parallel_for_array_view)
+{
+    ThreadPool pool(4);
+    std::vector<uint64_t> data(100000);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = i;
+    }
+    std::atomic<uint64_t> sum(0);
+    pool.parallelFor(ArrayView<uint64_t>(data), 1024, [&sum](ArrayView<uint64_t> chunk) {
+        uint64_t local = 0;
+        for (uint64_t value : chunk) {
+            local += value;
+        }
+        sum.fetch_add(local);
+    });
+    EXPECT_EQ(uint64_t(99999) * 100000 / 2, sum.load());
+}
+
+TEST(ThreadPool, nested_parallel_for)
+{
+    ThreadPool pool(3);
+    std::atomic<std::size_t> count(0);
+    pool.parallelFor(0, 16, 1, [&](std::size_t, std::size_t) {
+        pool.parallelFor(0, 1000, 10, [&](std::size_t begin, std::size_t end) {
+            count.fetch_add(end - begin);
+        });
+    });
+    EXPECT_EQ(16000u, count.load());
+}
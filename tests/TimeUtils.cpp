@@ -0,0 +1,62 @@
+#include "bmcl/TimeUtils.h"
+
+#include "BmclTest.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <ctime>
+#include <string>
+
+using namespace bmcl;
+
+static std::string formatWithStrftime(std::time_t t)
+{
+    char str[32];
+    std::strftime(str, sizeof(str), "%Y-%m-%d %H:%M:%S", std::localtime(&t));
+    return str;
+}
+
+TEST(TimeUtils, cachedFormatterMatchesStrftime)
+{
+    CachedTimeFormatter formatter;
+    std::time_t start = 1500000000;
+    for (std::time_t t = start; t < start + 200; t += 7) {
+        EXPECT_EQ(formatWithStrftime(t), formatter.format(t));
+    }
+}
+
+TEST(TimeUtils, cachedFormatterRepeatedAndBackwards)
+{
+    CachedTimeFormatter formatter;
+    std::time_t t = 1600000059;
+    EXPECT_EQ(formatWithStrftime(t), formatter.format(t));
+    EXPECT_EQ(formatWithStrftime(t), formatter.format(t));
+    EXPECT_EQ(formatWithStrftime(t + 1), formatter.format(t + 1));
+    EXPECT_EQ(formatWithStrftime(t - 1), formatter.format(t - 1));
+    EXPECT_EQ(formatWithStrftime(t - 86400), formatter.format(t - 86400));
+    EXPECT_EQ(CachedTimeFormatter::formattedSize, std::string(formatter.format(t)).size());
+}
+
+TEST(TimeUtils, formatLocalTime)
+{
+    std::time_t t = std::time(nullptr);
+    EXPECT_EQ(formatWithStrftime(t), formatLocalTime(t));
+}
+
+TEST(TimeUtils, coarseMonotonicClock)
+{
+    EXPECT_LT(0, CoarseMonotonicClock::resolution().count());
+    EXPECT_GE(std::chrono::milliseconds(100), CoarseMonotonicClock::resolution());
+
+    // loops until the coarse clock advanced, the steady clock only guards against a stuck clock
+    CoarseTime start = CoarseMonotonicClock::now();
+    CoarseTime last = start;
+    auto guard = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (last - start < std::chrono::milliseconds(10) && std::chrono::steady_clock::now() < guard) {
+        CoarseTime now = CoarseMonotonicClock::now();
+        EXPECT_LE(last, now);
+        last = now;
+    }
+    EXPECT_LE(std::chrono::milliseconds(10), last - start);
+}
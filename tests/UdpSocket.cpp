@@ -0,0 +1,196 @@
+#include "bmcl/UdpSocket.h"
+#include "bmcl/Result.h"
+#include "bmcl/SharedBytes.h"
+
+#include "BmclTest.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace bmcl;
+
+static UdpSocket bindLoopback()
+{
+    auto rv = UdpSocket::bind(SocketAddressV4(127, 0, 0, 1, 0));
+    EXPECT_TRUE(rv.isOk());
+    return rv.take();
+}
+
+static SocketAddressV4 localAddress(const UdpSocket& socket)
+{
+    auto rv = socket.localAddress();
+    EXPECT_TRUE(rv.isOk());
+    return rv.unwrapOr(SocketAddressV4());
+}
+
+TEST(UdpSocket, bind)
+{
+    UdpSocket socket = bindLoopback();
+    ASSERT_TRUE(socket.isValid());
+    SocketAddressV4 address = localAddress(socket);
+    EXPECT_EQ(Ipv4Address(127, 0, 0, 1), address.address());
+    EXPECT_NE(0, address.port());
+
+    // the port is taken
+    EXPECT_TRUE(UdpSocket::bind(address).isErr());
+
+    UdpSocket moved = std::move(socket);
+    EXPECT_FALSE(socket.isValid());
+    EXPECT_TRUE(moved.isValid());
+    moved.close();
+    EXPECT_FALSE(moved.isValid());
+}
+
+TEST(UdpSocket, sendToReceiveFrom)
+{
+    UdpSocket a = bindLoopback();
+    UdpSocket b = bindLoopback();
+    const char msg[] = "hello";
+    auto sent = a.sendTo(Bytes((const uint8_t*)msg, 5), localAddress(b));
+    ASSERT_TRUE(sent.isOk());
+    EXPECT_EQ(5u, sent.unwrap());
+
+    char buf[16];
+    SocketAddressV4 src;
+    auto received = b.receiveFrom(buf, sizeof(buf), &src);
+    ASSERT_TRUE(received.isOk());
+    EXPECT_EQ(5u, received.unwrap());
+    EXPECT_EQ(0, std::memcmp(buf, msg, 5));
+    EXPECT_EQ(localAddress(a), src);
+}
+
+TEST(UdpSocket, nonBlocking)
+{
+    UdpSocket socket = bindLoopback();
+    ASSERT_TRUE(socket.setNonBlocking(true));
+    UdpBatch batch(4);
+    auto rv = socket.receive(&batch);
+    ASSERT_TRUE(rv.isErr());
+    EXPECT_TRUE(rv.unwrapErr() == EAGAIN || rv.unwrapErr() == EWOULDBLOCK);
+    EXPECT_TRUE(batch.isEmpty());
+}
+
+TEST(UdpSocket, batch)
+{
+    UdpSocket a = bindLoopback();
+    UdpSocket b = bindLoopback();
+    ASSERT_TRUE(b.setReceiveBufferSize(1 << 20));
+    SocketAddressV4 dest = localAddress(b);
+
+    // more than one recvmmsg chunk
+    const std::size_t count = 150;
+    UdpBatch out(count, 64);
+    for (std::size_t i = 0; i < count; i++) {
+        uint8_t* slot = out.reserve();
+        ASSERT_NE(nullptr, slot);
+        std::memset(slot, int(i), i % 64);
+        out.commit(i % 64, dest);
+    }
+    EXPECT_TRUE(out.isFull());
+    EXPECT_EQ(nullptr, out.reserve());
+    EXPECT_FALSE(out.append(Bytes(), dest));
+
+    auto sent = a.send(out);
+    ASSERT_TRUE(sent.isOk());
+    EXPECT_EQ(count, sent.unwrap());
+
+    UdpBatch in(200, 64);
+    std::size_t received = 0;
+    while (received < count) {
+        auto rv = b.receive(&in);
+        ASSERT_TRUE(rv.isOk());
+        ASSERT_EQ(rv.unwrap(), in.size());
+        for (std::size_t i = 0; i < in.size(); i++) {
+            std::size_t n = received + i;
+            ASSERT_EQ(n % 64, in.datagram(i).size());
+            EXPECT_EQ(localAddress(a), in.address(i));
+            EXPECT_FALSE(in.isTruncated(i));
+            EXPECT_EQ(0u, in.segmentSize(i));
+            for (uint8_t byte : in.datagram(i)) {
+                EXPECT_EQ(uint8_t(n), byte);
+            }
+        }
+        received += in.size();
+    }
+    EXPECT_EQ(count, received);
+}
+
+TEST(UdpSocket, sharedBytes)
+{
+    UdpSocket a = bindLoopback();
+    UdpSocket b = bindLoopback();
+    SharedBytes messages[3] = {SharedBytes::create((const uint8_t*)"one", 3), SharedBytes::create((const uint8_t*)"two", 3),
+                               SharedBytes::create((const uint8_t*)"three", 5)};
+    SocketAddressV4 addresses[3] = {localAddress(b), localAddress(b), localAddress(b)};
+    auto sent = a.send(messages, addresses, 3);
+    ASSERT_TRUE(sent.isOk());
+    EXPECT_EQ(3u, sent.unwrap());
+
+    UdpBatch in(8, 16);
+    std::size_t received = 0;
+    while (received < 3) {
+        ASSERT_TRUE(b.receive(&in).isOk());
+        for (std::size_t i = 0; i < in.size(); i++) {
+            EXPECT_EQ(messages[received + i].view(), in.datagram(i));
+        }
+        received += in.size();
+    }
+}
+
+TEST(UdpSocket, truncated)
+{
+    UdpSocket a = bindLoopback();
+    UdpSocket b = bindLoopback();
+    std::vector<uint8_t> data(100, 7);
+    ASSERT_TRUE(a.sendTo(Bytes(data.data(), data.size()), localAddress(b)).isOk());
+    UdpBatch in(1, 10);
+    auto rv = b.receive(&in);
+    ASSERT_TRUE(rv.isOk());
+    ASSERT_EQ(1u, rv.unwrap());
+    EXPECT_EQ(10u, in.datagram(0).size());
+#if defined(BMCL_PLATFORM_LINUX)
+    EXPECT_TRUE(in.isTruncated(0));
+#endif
+}
+
+// segments arrive as separate datagrams unless GRO coalesces them, in that case segmentSize() splits them back
+TEST(UdpSocket, segmented)
+{
+    UdpSocket a = bindLoopback();
+    UdpSocket b = bindLoopback();
+    ASSERT_TRUE(b.setReceiveBufferSize(4 << 20));
+    bool hasGro = b.setGroEnabled(true);
+
+    const std::size_t segmentSize = 1000;
+    std::vector<uint8_t> data(segmentSize * 100 + 123);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = uint8_t(i / segmentSize);
+    }
+    auto sent = a.sendSegmented(Bytes(data.data(), data.size()), segmentSize, localAddress(b));
+    ASSERT_TRUE(sent.isOk());
+    EXPECT_EQ(data.size(), sent.unwrap());
+
+    UdpBatch in(128, 65536);
+    std::vector<std::size_t> sizes;
+    std::size_t offset = 0;
+    while (offset < data.size()) {
+        ASSERT_TRUE(b.receive(&in).isOk());
+        for (std::size_t i = 0; i < in.size(); i++) {
+            Bytes datagram = in.datagram(i);
+            ASSERT_EQ(0, std::memcmp(datagram.data(), data.data() + offset, datagram.size()));
+            std::size_t step = in.segmentSize(i) ? in.segmentSize(i) : datagram.size();
+            if (!hasGro) {
+                EXPECT_EQ(0u, in.segmentSize(i));
+            }
+            for (std::size_t done = 0; done < datagram.size(); done += step) {
+                sizes.push_back(BMCL_MIN(step, datagram.size() - done));
+            }
+            offset += datagram.size();
+        }
+    }
+    ASSERT_EQ(101u, sizes.size());
+    for (std::size_t i = 0; i < 100; i++) {
+        EXPECT_EQ(segmentSize, sizes[i]);
+    }
+    EXPECT_EQ(123u, sizes[100]);
+}
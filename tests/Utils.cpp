@@ -1,12 +1,17 @@
 #include "bmcl/FileUtils.h"
 #include "bmcl/Result.h"
 #include "bmcl/Buffer.h"
+#include "bmcl/SharedBytes.h"
+#include "bmcl/ArrayView.h"
 
 #include "BmclTest.h"
 
 #include <gtest/gtest.h>
 
+#include <cerrno>
 #include <cstring>
+#include <string>
+#include <vector>
 
 TEST(Utils, readFile)
 {
@@ -23,3 +28,112 @@ TEST(Utils, readFileError)
     bmcl::Result<std::string, int> res = bmcl::readFileIntoString(path);
     ASSERT_TRUE(res.isErr());
 }
+
+TEST(Utils, readFileDir)
+{
+    bmcl::Result<bmcl::Buffer, int> res = bmcl::readFileIntoBuffer(DATA_DIR);
+    ASSERT_TRUE(res.isErr());
+    EXPECT_EQ(EISDIR, res.unwrapErr());
+}
+
+TEST(Utils, readFileTypes)
+{
+    bmcl::Result<bmcl::Buffer, int> buf = bmcl::readFileIntoBuffer(DATA_DIR"/test1");
+    ASSERT_TRUE(buf.isOk());
+    ASSERT_EQ(11u, buf.unwrap().size());
+    EXPECT_EQ_MEM(buf.unwrap().data(), "1234567890\n", 11);
+
+    bmcl::Result<bmcl::SharedBytes, int> bytes = bmcl::readFileIntoBytes(DATA_DIR"/ones");
+    ASSERT_TRUE(bytes.isOk());
+    ASSERT_EQ(1024u * 1024u, bytes.unwrap().size());
+    EXPECT_EQ('1', bytes.unwrap().data()[1024 * 1024 - 1]);
+}
+
+TEST(Utils, readFileReuseBuffer)
+{
+    bmcl::Buffer buf;
+    bmcl::Result<std::size_t, int> res = bmcl::readFileIntoBuffer(DATA_DIR"/ones", &buf);
+    ASSERT_TRUE(res.isOk());
+    EXPECT_EQ(1024u * 1024u, res.unwrap());
+    ASSERT_EQ(1024u * 1024u, buf.size());
+    EXPECT_EQ('1', buf.data()[12345]);
+    const uint8_t* data = buf.data();
+
+    res = bmcl::readFileIntoBuffer(DATA_DIR"/test1", &buf);
+    ASSERT_TRUE(res.isOk());
+    EXPECT_EQ(11u, res.unwrap());
+    ASSERT_EQ(11u, buf.size());
+    EXPECT_EQ_MEM(buf.data(), "1234567890\n", 11);
+    // capacity is reused
+    EXPECT_EQ(data, buf.data());
+    EXPECT_LE(1024u * 1024u, buf.capacity());
+
+    res = bmcl::readFileIntoBuffer(DATA_DIR"/_te_st1_", &buf);
+    ASSERT_TRUE(res.isErr());
+    EXPECT_EQ(ENOENT, res.unwrapErr());
+    EXPECT_EQ(0u, buf.size());
+}
+
+static std::vector<std::string> makeReadFilesPaths()
+{
+    std::vector<std::string> paths;
+    // more than one io_uring batch
+    for (int i = 0; i < 300; i++) {
+        paths.push_back(i % 3 == 2 ? DATA_DIR"/ones" : DATA_DIR"/test1");
+    }
+    paths[10] = DATA_DIR"/_te_st1_";
+    paths[200] = DATA_DIR;
+    return paths;
+}
+
+static void checkReadFiles(const std::vector<std::string>& paths, const std::vector<bmcl::Result<bmcl::SharedBytes, int>>& results)
+{
+    ASSERT_EQ(paths.size(), results.size());
+    for (std::size_t i = 0; i < paths.size(); i++) {
+        if (i == 10) {
+            ASSERT_TRUE(results[i].isErr());
+            EXPECT_EQ(ENOENT, results[i].unwrapErr());
+            continue;
+        }
+        if (i == 200) {
+            ASSERT_TRUE(results[i].isErr());
+            EXPECT_EQ(EISDIR, results[i].unwrapErr());
+            continue;
+        }
+        ASSERT_TRUE(results[i].isOk()) << i;
+        const bmcl::SharedBytes& data = results[i].unwrap();
+        if (i % 3 == 2) {
+            ASSERT_EQ(1024u * 1024u, data.size());
+            EXPECT_EQ('1', data.data()[0]);
+            EXPECT_EQ('1', data.data()[data.size() - 1]);
+        } else {
+            ASSERT_EQ(11u, data.size());
+            EXPECT_EQ_MEM(data.data(), "1234567890\n", 11);
+        }
+    }
+}
+
+TEST(Utils, readFiles)
+{
+    std::vector<std::string> paths = makeReadFilesPaths();
+    checkReadFiles(paths, bmcl::readFilesIntoBytes(paths));
+}
+
+TEST(Utils, readFilesThreaded)
+{
+    std::vector<std::string> paths = makeReadFilesPaths();
+    checkReadFiles(paths, bmcl::readFilesIntoBytesThreaded(paths, 4));
+    checkReadFiles(paths, bmcl::readFilesIntoBytesThreaded(paths, 1));
+}
+
+TEST(Utils, readFilesAsync)
+{
+    std::vector<std::string> paths = makeReadFilesPaths();
+    std::future<std::vector<bmcl::Result<bmcl::SharedBytes, int>>> future = bmcl::readFilesIntoBytesAsync(paths);
+    checkReadFiles(paths, future.get());
+}
+
+TEST(Utils, readFilesEmpty)
+{
+    EXPECT_TRUE(bmcl::readFilesIntoBytes(bmcl::ArrayView<std::string>()).empty());
+}
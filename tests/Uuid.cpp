@@ -9,6 +9,9 @@
 
 #include "BmclTest.h"
 
+#include <string>
+#include <vector>
+
 using namespace bmcl;
 
 TEST(Uuid, nil)
@@ -107,6 +110,58 @@ TEST(Uuid, fromToString)
     EXPECT_EQ(u, rv.unwrap());
 }
 
+TEST(Uuid, toStringRepr)
+{
+    Uuid u(0x4d2f9a30, 0x8c74, 0x9012, 0x9ed9f03d34df7a58);
+    UuidStringRepr repr = u.toStringRepr();
+    EXPECT_EQ("{4d2f9a30-8c74-9012-9ed9-f03d34df7a58}", repr.view());
+    EXPECT_EQ('\0', repr.c_str()[repr.size()]);
+}
+
+TEST(Uuid, fromStringInvalidChars)
+{
+    const char* valid = "{4d2f9a30-8c74-9012-9ed9-f03d34df7a58}";
+    ASSERT_TRUE(Uuid::createFromString(valid).isOk());
+    for (std::size_t i = 0; i < 38; i++) {
+        const char replacements[] = {'g', 'G', '/', ':', '@', '`', '-', '{', ' ', '\x80'};
+        for (char c : replacements) {
+            std::string str = valid;
+            if (str[i] == c) {
+                continue;
+            }
+            str[i] = c;
+            EXPECT_TRUE(Uuid::createFromString(str).isErr()) << str;
+        }
+    }
+}
+
+TEST(Uuid, parseFormatMany)
+{
+    std::vector<Uuid> uuids;
+    for (int i = 0; i < 100; i++) {
+        uuids.push_back(Uuid::createV4());
+    }
+    std::string text(uuids.size() * UuidStringRepr::size(), ' ');
+    Uuid::formatMany(uuids.data(), uuids.size(), &text[0]);
+
+    std::vector<bmcl::StringView> views;
+    for (std::size_t i = 0; i < uuids.size(); i++) {
+        bmcl::StringView view(text.data() + i * UuidStringRepr::size(), UuidStringRepr::size());
+        EXPECT_EQ(uuids[i].toStringRepr().view(), view);
+        views.push_back(view);
+    }
+    // other accepted formats
+    std::string noBraces = uuids[1].toStdString().substr(1, 36);
+    views[1] = noBraces;
+
+    std::vector<Uuid> parsed(uuids.size(), Uuid::createNil());
+    EXPECT_EQ(uuids.size(), Uuid::parseMany(views.data(), views.size(), parsed.data()));
+    EXPECT_EQ(uuids, parsed);
+
+    views[50] = "not a uuid";
+    EXPECT_EQ(50u, Uuid::parseMany(views.data(), views.size(), parsed.data()));
+}
+
 #ifdef BMCL_HAVE_QT
 
 TEST(Uuid, fromToQString)
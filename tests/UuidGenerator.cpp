@@ -0,0 +1,156 @@
+#include "bmcl/UuidGenerator.h"
+#include "bmcl/Uuid.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if defined(BMCL_PLATFORM_UNIX)
+# include <sys/wait.h>
+# include <unistd.h>
+#endif
+
+using namespace bmcl;
+
+static void expectVariant(const Uuid& u)
+{
+    EXPECT_EQ(0x80, u.data()[8] & 0xc0);
+}
+
+TEST(UuidGenerator, v4)
+{
+    UuidGenerator gen;
+    std::set<Uuid> uuids;
+    for (int i = 0; i < 10000; i++) {
+        Uuid u = gen.createV4();
+        EXPECT_EQ(4u, u.version());
+        expectVariant(u);
+        uuids.insert(u);
+    }
+    EXPECT_EQ(10000u, uuids.size());
+}
+
+TEST(UuidGenerator, v4Batch)
+{
+    UuidGenerator gen;
+    std::vector<Uuid> uuids(1000, Uuid::createNil());
+    gen.createV4(uuids.data(), uuids.size());
+    std::set<Uuid> unique(uuids.begin(), uuids.end());
+    EXPECT_EQ(1000u, unique.size());
+    for (const Uuid& u : uuids) {
+        EXPECT_EQ(4u, u.version());
+        expectVariant(u);
+    }
+}
+
+TEST(UuidGenerator, v4Bits)
+{
+    // every random bit should be set in some uuids and cleared in others
+    UuidGenerator gen;
+    Uuid::Data ored;
+    Uuid::Data anded;
+    ored.fill(0);
+    anded.fill(0xff);
+    for (int i = 0; i < 1000; i++) {
+        Uuid u = gen.createV4();
+        for (std::size_t j = 0; j < 16; j++) {
+            ored[j] |= u.data()[j];
+            anded[j] &= u.data()[j];
+        }
+    }
+    for (std::size_t j = 0; j < 16; j++) {
+        if (j == 6) {
+            EXPECT_EQ(0x4f, ored[j]);
+            EXPECT_EQ(0x40, anded[j]);
+        } else if (j == 8) {
+            EXPECT_EQ(0xbf, ored[j]);
+            EXPECT_EQ(0x80, anded[j]);
+        } else {
+            EXPECT_EQ(0xff, ored[j]);
+            EXPECT_EQ(0x00, anded[j]);
+        }
+    }
+}
+
+TEST(UuidGenerator, independentGenerators)
+{
+    UuidGenerator gen1;
+    UuidGenerator gen2;
+    EXPECT_NE(gen1.createV4(), gen2.createV4());
+}
+
+TEST(UuidGenerator, v7Ordered)
+{
+    UuidGenerator gen;
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch());
+    Uuid prev = gen.createV7();
+    uint64_t timestamp = prev.part1();
+    timestamp = (timestamp << 16) | prev.part2();
+    EXPECT_LE(uint64_t(now.count()), timestamp);
+    EXPECT_GE(uint64_t(now.count()) + 1000, timestamp);
+    for (int i = 0; i < 100000; i++) {
+        Uuid u = gen.createV7();
+        EXPECT_EQ(7u, u.version());
+        expectVariant(u);
+        ASSERT_LT(prev, u);
+        prev = u;
+    }
+}
+
+TEST(UuidGenerator, v7Batch)
+{
+    UuidGenerator gen;
+    // more than the 12 bit counter can hold within one millisecond
+    std::vector<Uuid> uuids(10000, Uuid::createNil());
+    gen.createV7(uuids.data(), uuids.size());
+    for (std::size_t i = 1; i < uuids.size(); i++) {
+        EXPECT_EQ(7u, uuids[i].version());
+        ASSERT_LT(uuids[i - 1], uuids[i]);
+    }
+}
+
+TEST(UuidGenerator, threads)
+{
+    std::vector<Uuid> uuids(4000, Uuid::createNil());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&uuids, t]() {
+            for (int i = 0; i < 1000; i++) {
+                uuids[t * 1000 + i] = i % 2 ? Uuid::createV4() : Uuid::createV7();
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::set<Uuid> unique(uuids.begin(), uuids.end());
+    EXPECT_EQ(4000u, unique.size());
+}
+
+#if defined(BMCL_PLATFORM_UNIX)
+TEST(UuidGenerator, fork)
+{
+    UuidGenerator& gen = threadUuidGenerator();
+    gen.createV4();
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    pid_t pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+        Uuid u = gen.createV4();
+        ssize_t rv = write(fds[1], u.data().data(), 16);
+        _exit(rv == 16 ? 0 : 1);
+    }
+    Uuid parent = gen.createV4();
+    Uuid::Data data;
+    ASSERT_EQ(16, read(fds[0], data.data(), 16));
+    int status;
+    waitpid(pid, &status, 0);
+    close(fds[0]);
+    close(fds[1]);
+    EXPECT_NE(parent, Uuid(data));
+}
+#endif
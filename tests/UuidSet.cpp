@@ -0,0 +1,165 @@
+#include "bmcl/UuidSet.h"
+#include "bmcl/UuidGenerator.h"
+
+#include <gtest/gtest.h>
+
+#include <set>
+#include <unordered_set>
+#include <vector>
+
+using namespace bmcl;
+
+static std::vector<Uuid> makeUuids(std::size_t count)
+{
+    std::vector<Uuid> uuids(count, Uuid::createNil());
+    threadUuidGenerator().createV4(uuids.data(), uuids.size());
+    return uuids;
+}
+
+TEST(UuidSet, empty)
+{
+    UuidSet set;
+    EXPECT_TRUE(set.isEmpty());
+    EXPECT_EQ(0u, set.size());
+    EXPECT_EQ(0u, set.capacity());
+    EXPECT_FALSE(set.contains(Uuid::createNil()));
+    EXPECT_FALSE(set.remove(Uuid::createNil()));
+}
+
+TEST(UuidSet, insertContains)
+{
+    UuidSet set;
+    EXPECT_TRUE(set.insert(Uuid::createNil()));
+    EXPECT_FALSE(set.insert(Uuid::createNil()));
+    EXPECT_TRUE(set.contains(Uuid::createNil()));
+
+    std::vector<Uuid> uuids = makeUuids(10000);
+    for (const Uuid& u : uuids) {
+        EXPECT_TRUE(set.insert(u));
+    }
+    EXPECT_EQ(10001u, set.size());
+    for (const Uuid& u : uuids) {
+        EXPECT_TRUE(set.contains(u));
+        EXPECT_FALSE(set.insert(u));
+    }
+    for (const Uuid& u : makeUuids(1000)) {
+        EXPECT_FALSE(set.contains(u));
+    }
+    EXPECT_LE(set.size(), set.capacity() / 8 * 7);
+    EXPECT_EQ(set.capacity() * 17, set.memoryUsage());
+}
+
+TEST(UuidSet, sequentialV7)
+{
+    UuidSet set;
+    std::vector<Uuid> uuids(50000, Uuid::createNil());
+    threadUuidGenerator().createV7(uuids.data(), uuids.size());
+    EXPECT_EQ(uuids.size(), set.insert(uuids.data(), uuids.size()));
+    for (const Uuid& u : uuids) {
+        ASSERT_TRUE(set.contains(u));
+    }
+}
+
+TEST(UuidSet, bulk)
+{
+    std::vector<Uuid> uuids = makeUuids(5000);
+    UuidSet set;
+    EXPECT_EQ(2500u, set.insert(uuids.data(), 2500));
+    // half are duplicates
+    EXPECT_EQ(2500u, set.insert(uuids.data(), uuids.size()));
+    EXPECT_EQ(5000u, set.size());
+
+    std::vector<Uuid> queries = makeUuids(100);
+    queries.insert(queries.end(), uuids.begin(), uuids.begin() + 100);
+    bool found[200];
+    EXPECT_EQ(100u, set.contains(queries.data(), queries.size(), found));
+    for (std::size_t i = 0; i < 200; i++) {
+        EXPECT_EQ(i >= 100, found[i]);
+    }
+}
+
+TEST(UuidSet, remove)
+{
+    std::vector<Uuid> uuids = makeUuids(20000);
+    UuidSet set;
+    set.insert(uuids.data(), uuids.size());
+    for (std::size_t i = 0; i < uuids.size(); i += 2) {
+        EXPECT_TRUE(set.remove(uuids[i]));
+        EXPECT_FALSE(set.remove(uuids[i]));
+    }
+    EXPECT_EQ(10000u, set.size());
+    for (std::size_t i = 0; i < uuids.size(); i++) {
+        EXPECT_EQ(i % 2 == 1, set.contains(uuids[i]));
+    }
+
+    // reinserting after removal reuses deleted slots
+    std::size_t capacity = set.capacity();
+    for (int round = 0; round < 10; round++) {
+        for (std::size_t i = 0; i < uuids.size(); i += 2) {
+            EXPECT_TRUE(set.insert(uuids[i]));
+        }
+        for (std::size_t i = 0; i < uuids.size(); i += 2) {
+            EXPECT_TRUE(set.remove(uuids[i]));
+        }
+    }
+    EXPECT_EQ(capacity, set.capacity());
+    EXPECT_EQ(10000u, set.size());
+}
+
+TEST(UuidSet, randomOps)
+{
+    std::vector<Uuid> pool = makeUuids(3000);
+    UuidSet set;
+    std::set<Uuid> expected;
+    std::uint32_t state = 12345;
+    for (int i = 0; i < 100000; i++) {
+        state = state * 1103515245 + 12345;
+        const Uuid& u = pool[(state >> 8) % pool.size()];
+        if ((state >> 4) % 3 == 0) {
+            EXPECT_EQ(expected.erase(u) == 1, set.remove(u));
+        } else {
+            EXPECT_EQ(expected.insert(u).second, set.insert(u));
+        }
+    }
+    EXPECT_EQ(expected.size(), set.size());
+    std::set<Uuid> contents;
+    set.forEach([&contents](const Uuid& u) {
+        contents.insert(u);
+    });
+    EXPECT_EQ(expected, contents);
+}
+
+TEST(UuidSet, copyMove)
+{
+    std::vector<Uuid> uuids = makeUuids(100);
+    UuidSet set;
+    set.insert(uuids.data(), uuids.size());
+
+    UuidSet copy(set);
+    EXPECT_EQ(100u, copy.size());
+    EXPECT_TRUE(copy.contains(uuids[50]));
+    copy.remove(uuids[50]);
+    EXPECT_TRUE(set.contains(uuids[50]));
+
+    UuidSet moved(std::move(set));
+    EXPECT_EQ(100u, moved.size());
+    EXPECT_TRUE(set.isEmpty());
+    EXPECT_TRUE(moved.contains(uuids[50]));
+
+    set = copy;
+    EXPECT_EQ(99u, set.size());
+    set.clear();
+    EXPECT_TRUE(set.isEmpty());
+    EXPECT_FALSE(set.contains(uuids[0]));
+}
+
+TEST(UuidSet, reserve)
+{
+    UuidSet set;
+    set.reserve(1000);
+    std::size_t capacity = set.capacity();
+    EXPECT_LE(1000u, capacity / 8 * 7);
+    std::vector<Uuid> uuids = makeUuids(1000);
+    set.insert(uuids.data(), uuids.size());
+    EXPECT_EQ(capacity, set.capacity());
+}
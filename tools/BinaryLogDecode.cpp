@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2014 CPB9 team. See the COPYRIGHT file at the top-level directory.
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+
+#include <bmcl/BinaryLog.h>
+#include <bmcl/Buffer.h>
+#include <bmcl/FileUtils.h>
+#include <bmcl/Result.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// converts files written by startBinaryLog() to text
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <binary log> [binary log ...]\n", argv[0]);
+        return 1;
+    }
+    int rv = 0;
+    for (int i = 1; i < argc; i++) {
+        bmcl::Result<bmcl::Buffer, int> data = bmcl::readFileIntoBuffer(argv[i]);
+        if (data.isErr()) {
+            std::fprintf(stderr, "%s: %s\n", argv[i], std::strerror(data.unwrapErr()));
+            rv = 1;
+            continue;
+        }
+        std::string text;
+        bool isOk = bmcl::decodeBinaryLog(data.unwrap(), &text);
+        if (std::fwrite(text.data(), 1, text.size(), stdout) != text.size()) {
+            std::fprintf(stderr, "%s: failed to write output: %s\n", argv[i], std::strerror(errno));
+            return 1;
+        }
+        if (!isOk) {
+            std::fprintf(stderr, "%s: truncated or invalid binary log\n", argv[i]);
+            rv = 1;
+        }
+    }
+    if (std::fflush(stdout) != 0) {
+        std::fprintf(stderr, "failed to write output: %s\n", std::strerror(errno));
+        return 1;
+    }
+    return rv;
+}